@@ -0,0 +1,159 @@
+/* Throughput of the fm demodulators.
+ *
+ * A synthetic FM signal (a few tones at 75 KHz deviation, with a slowly
+ * varying amplitude) is demodulated by each of the decoders, both as
+ * sample blocks (separate I and Q arrays, as used by the fmProcessor)
+ * and through the one-sample-at-a-time call. The output is
+ * compared against the modulating signal, so that a fast but broken
+ * block decoder shows up as a low SNR, and the single sample output
+ * against the block output, as the largest difference between them.
+ * The first line is a plain double precision discriminator, the SNR
+ * any of the decoders could reach.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "fm-constants.h"
+#include "fm-demodulator.h"
+#include "sample-block.h"
+
+#define RATE 176400
+#define DEVIATION 75000
+#define SAMPLES (RATE * 4)
+#define BLOCK 2730
+#define SKIP (RATE / 2)
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void
+make_signal (DSPCOMPLEX *iq, DSPFLOAT *message, int n)
+{
+  double phase = 0;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    double t = (double) i / RATE;
+    double m = 0.5 * sin (2 * M_PI * 1000 * t)
+        + 0.3 * sin (2 * M_PI * 5000 * t)
+        + 0.1 * sin (2 * M_PI * 19000 * t);
+    double amplitude = 0.8 + 0.6 * sin (2 * M_PI * 3 * t);
+
+    message[i] = m;
+    phase += 2 * M_PI * DEVIATION * m / RATE;
+    iq[i] = DSPCOMPLEX (amplitude * cos (phase), amplitude * sin (phase));
+  }
+}
+
+/* the phase difference between successive samples, in doubles */
+static void
+reference (const DSPCOMPLEX *iq, DSPFLOAT *out, int n)
+{
+  int i;
+
+  out[0] = 0;
+  for (i = 1; i < n; i++) {
+    double re = (double) real (iq[i]) * real (iq[i - 1])
+        + (double) imag (iq[i]) * imag (iq[i - 1]);
+    double im = (double) imag (iq[i]) * real (iq[i - 1])
+        - (double) real (iq[i]) * imag (iq[i - 1]);
+    out[i] = atan2 (im, re);
+  }
+}
+
+/* fit out = g * message, the SNR is the power of the fit against the
+ * power of the residue */
+static double
+snr (const DSPFLOAT *out, const DSPFLOAT *message, int n)
+{
+  double xy = 0, xx = 0, err = 0, g;
+  int i;
+
+  for (i = SKIP; i < n; i++) {
+    xy += out[i] * message[i];
+    xx += message[i] * message[i];
+  }
+  g = xy / xx;
+  for (i = SKIP; i < n; i++)
+    err += (out[i] - g * message[i]) * (out[i] - g * message[i]);
+
+  return 10 * log10 (g * g * xx / (err + 1e-30));
+}
+
+int
+main (int argc, char **argv)
+{
+  static const int decoders[] = {
+    fm_Demodulator::FM1DECODER, fm_Demodulator::FM2DECODER,
+    fm_Demodulator::FM3DECODER, fm_Demodulator::FM4DECODER,
+    fm_Demodulator::FM5DECODER
+  };
+  DSPCOMPLEX *iq = new DSPCOMPLEX[SAMPLES];
+  sampleBlock *blocks[(SAMPLES + BLOCK - 1) / BLOCK];
+  DSPFLOAT *message = new DSPFLOAT[SAMPLES];
+  DSPFLOAT *out = new DSPFLOAT[SAMPLES];
+  DSPFLOAT *single_out = new DSPFLOAT[SAMPLES];
+  SinCos sinCos (RATE);
+  /* as computed by the fmProcessor */
+  DSPFLOAT K_FM = 4 * (2 * M_PI / RATE * (2 * (90000 + 60000) / 2 - 60000));
+  unsigned d;
+  int i;
+
+  make_signal (iq, message, SAMPLES);
+  for (i = 0; i < SAMPLES; i += BLOCK) {
+    blocks[i / BLOCK] = new sampleBlock (BLOCK);
+    blocks[i / BLOCK]->fromInterleaved (&iq[i],
+        SAMPLES - i < BLOCK ? SAMPLES - i : BLOCK);
+  }
+
+  printf ("%-24s %12s %12s %10s %8s %10s\n", "decoder", "block ns/S",
+      "single ns/S", "block MS/s", "SNR dB", "max diff");
+
+  double start = now ();
+  reference (iq, out, SAMPLES);
+  double reference_time = now () - start;
+  printf ("%-24s %12s %12.2f %10s %8.1f %10s\n", "double reference", "-",
+      reference_time * 1e9 / SAMPLES, "-", snr (out, message, SAMPLES), "-");
+
+  for (d = 0; d < sizeof (decoders) / sizeof (decoders[0]); d++) {
+    fm_Demodulator block (RATE, &sinCos, K_FM);
+    fm_Demodulator single (RATE, &sinCos, K_FM);
+    double block_time, single_time;
+    DSPFLOAT diff = 0;
+
+    block.setDecoder (decoders[d]);
+    single.setDecoder (decoders[d]);
+
+    start = now ();
+    for (i = 0; i < SAMPLES; i += BLOCK)
+      block.demodulate (blocks[i / BLOCK], &out[i]);
+    block_time = now () - start;
+
+    start = now ();
+    for (i = 0; i < SAMPLES; i++)
+      single_out[i] = single.demodulate (iq[i]);
+    single_time = now () - start;
+
+    for (i = 0; i < SAMPLES; i++)
+      if (fabs (out[i] - single_out[i]) > diff)
+        diff = fabs (out[i] - single_out[i]);
+
+    printf ("%-24s %12.2f %12.2f %10.2f %8.1f %10.2g\n",
+        block.nameofDecoder (), block_time * 1e9 / SAMPLES,
+        single_time * 1e9 / SAMPLES, SAMPLES / block_time * 1e-6,
+        snr (out, message, SAMPLES), diff);
+  }
+
+  for (i = 0; i < SAMPLES; i += BLOCK)
+    delete blocks[i / BLOCK];
+  delete[] iq;
+  delete[] message;
+  delete[] out;
+  delete[] single_out;
+  return 0;
+}
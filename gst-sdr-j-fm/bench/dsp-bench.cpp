@@ -0,0 +1,715 @@
+/* Speed and accuracy of the DSP primitives, one by one.
+ *
+ * Every primitive of src/various is run on a synthetic input at the
+ * sizes the fmProcessor actually uses (and a few larger ones), timed,
+ * and compared against a plain double precision implementation of
+ * what it is meant to compute:
+ *   the FIR filters against a direct convolution with their own taps,
+ *   with every dot product kernel set the cpu supports;
+ *   the FFT filters against a direct convolution with the kernel they
+ *   were designed from;
+ *   the IIR filters against the same biquad cascade in doubles;
+ *   the pll against the same loop in doubles, with exact sin, cos and
+ *   atan2;
+ *   the sincos tables and the atan2 approximations against libm;
+ *   the resamplers against the ideal output;
+ *   the dsp kernels against their definition.
+ *
+ * A line is printed per primitive and configuration with the time per
+ * sample and the error: relative to the reference in dB for signals,
+ * the largest absolute difference for functions. The error has to stay
+ * below the limit given on the same line; if it does not for any of
+ * them, the benchmark fails. A faster replacement for any of these
+ * should therefore keep the same limits.
+ *
+ * The fm demodulators are measured by demod-bench.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <complex>
+#include "fm-constants.h"
+#include "fir-filters.h"
+#include "fft-filters.h"
+#include "iir-filters.h"
+#include "pllC.h"
+#include "sincos.h"
+#include "Xtan2.h"
+#include "resampler.h"
+#include "dsp-kernels.h"
+#include <gst/gst.h>
+
+/* the sources log through this category, as gst_init is never
+ * called, all logging is off */
+GST_DEBUG_CATEGORY (sdrjfm_debug);
+
+/* the rates as set up by the RadioInterface and the fmProcessor */
+#define INPUT_RATE 1058400
+#define FM_RATE 176400
+#define RDS_RATE (FM_RATE / 8)
+#define SAMPLES (1 << 20)
+
+typedef std::complex<double> dcomplex;
+
+static const char *kernelSets[] = { "scalar", "sse2", "avx2", "neon" };
+
+static int failures;
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* a reproducible, white, input in [-1, 1) */
+static uint32_t seed = 1;
+
+static double
+noise (void)
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed / 2147483648.0 - 1;
+}
+
+/* the power of out - ref relative to that of ref, in dB */
+static double
+error_db (const DSPCOMPLEX *out, const dcomplex *ref, int n)
+{
+  double err = 0, power = 0;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    dcomplex d = dcomplex (real (out[i]), imag (out[i])) - ref[i];
+    err += norm (d);
+    power += norm (ref[i]);
+  }
+  return 10 * log10 ((err + 1e-30 * power) / (power + 1e-300));
+}
+
+/* errors in dB are relative, the others absolute */
+static void
+report (const char *primitive, const char *config, double seconds, int n,
+    double error, double limit, bool db)
+{
+  bool ok = error <= limit;
+  char e[32], l[32];
+
+  if (db) {
+    snprintf (e, sizeof (e), "%.1f dB", error);
+    snprintf (l, sizeof (l), "%.1f dB", limit);
+  } else {
+    snprintf (e, sizeof (e), "%.2e", error);
+    snprintf (l, sizeof (l), "%.2e", limit);
+  }
+  printf ("%-14s %-28s %10.2f %10.2f %12s %12s %s\n", primitive, config,
+      seconds * 1e9 / n, n / seconds * 1e-6, e, l, ok ? "ok" : "FAIL");
+  fflush (stdout);
+  if (!ok)
+    failures++;
+}
+
+/* y [n] = sum h [k] x [n - k] */
+static void
+convolve (const dcomplex *h, int taps, const DSPCOMPLEX *x, dcomplex *y,
+    int n)
+{
+  int i, k;
+
+  for (i = 0; i < n; i++) {
+    dcomplex sum = 0;
+    for (k = 0; k < taps && k <= i; k++)
+      sum += h[k] * dcomplex (real (x[i - k]), imag (x[i - k]));
+    y[i] = sum;
+  }
+}
+
+/* The real tap filters, as used for the decimation of the input, the
+ * RDS and the audio, with each of the dot product kernels */
+static void
+bench_real_fir (const DSPCOMPLEX *x, DSPCOMPLEX *out, dcomplex *ref)
+{
+  static const int sizes[] = { 11, 15, 21, 63, 127 };
+  static const int factors[] = { 4, 6, 8 };
+  dcomplex h[128];
+  dcomplex *real_ref = new dcomplex[SAMPLES];
+  char config[64];
+  unsigned s, k, f;
+  int i;
+
+  for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++) {
+    LowPassRealFIR design (sizes[s], 15000, FM_RATE);
+    for (i = 0; i < sizes[s]; i++)
+      h[i] = design.filterKernel[i];
+    convolve (h, sizes[s], x, ref, SAMPLES);
+
+    for (k = 0; k < sizeof (kernelSets) / sizeof (kernelSets[0]); k++) {
+      const dspKernels *kernels = getKernels (kernelSets[k]);
+      if (kernels == NULL)
+        continue;
+
+      LowPassRealFIR filter (sizes[s], 15000, FM_RATE);
+      filter.kernels = kernels;
+      double start = now ();
+      for (i = 0; i < SAMPLES; i++)
+        out[i] = filter.Pass (x[i]);
+      double t = now () - start;
+      snprintf (config, sizeof (config), "%d taps, complex, %s",
+          sizes[s], kernels->name);
+      report ("fir", config, t, SAMPLES, error_db (out, ref, SAMPLES),
+          -100, true);
+
+      LowPassRealFIR rfilter (sizes[s], 15000, FM_RATE);
+      rfilter.kernels = kernels;
+      start = now ();
+      for (i = 0; i < SAMPLES; i++)
+        out[i] = DSPCOMPLEX (rfilter.Pass (real (x[i])), 0);
+      t = now () - start;
+      for (i = 0; i < SAMPLES; i++)
+        real_ref[i] = real (ref[i]);
+      snprintf (config, sizeof (config), "%d taps, real, %s",
+          sizes[s], kernels->name);
+      report ("fir", config, t, SAMPLES,
+          error_db (out, real_ref, SAMPLES),
+          -100, true);
+    }
+  }
+
+  /* the block interface of the decimating filter, only every
+   * factor'th output is computed (and compared) */
+  for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    for (f = 0; f < sizeof (factors) / sizeof (factors[0]); f++) {
+      DecimatingRealFIR filter (sizes[s], FM_RATE / 2, INPUT_RATE,
+          factors[f]);
+      sampleBlock in (16384), block (16384 / factors[f] + 1);
+      int n = 0;
+
+      for (i = 0; i < sizes[s]; i++)
+        h[i] = filter.filterKernel[i];
+      convolve (h, sizes[s], x, ref, SAMPLES);
+
+      double start = now ();
+      for (i = 0; i < SAMPLES; i += 16384) {
+        in.fromInterleaved (&x[i], 16384);
+        filter.Pass (&in, &block);
+        for (int j = 0; j < block.count; j++)
+          out[n++] = DSPCOMPLEX (block.I[j], block.Q[j]);
+      }
+      double t = now () - start;
+      for (i = 0; i < n; i++)
+        ref[i] = ref[(i + 1) * factors[f] - 1];
+      snprintf (config, sizeof (config), "%d taps, 1/%d, blocks",
+          sizes[s], factors[f]);
+      report ("decimating fir", config, t, SAMPLES,
+          error_db (out, ref, n), -100, true);
+    }
+
+  delete[] real_ref;
+}
+
+/* The general, complex tap, filters; they compute the fft filter
+ * kernels and are used where speed does not matter */
+static void
+bench_complex_fir (const DSPCOMPLEX *x, DSPCOMPLEX *out, dcomplex *ref)
+{
+  static const int sizes[] = { 15, 39, 49, 127 };
+  dcomplex h[128];
+  char config[64];
+  unsigned s;
+  int i;
+
+  for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++) {
+    BandPassFIR filter (sizes[s], 56000, 58000, FM_RATE);
+    DSPCOMPLEX *kernel = filter.getKernel ();
+
+    for (i = 0; i < sizes[s]; i++)
+      h[i] = dcomplex (real (kernel[i]), imag (kernel[i]));
+    convolve (h, sizes[s], x, ref, SAMPLES);
+
+    double start = now ();
+    for (i = 0; i < SAMPLES; i++)
+      out[i] = filter.Pass (x[i]);
+    double t = now () - start;
+    snprintf (config, sizeof (config), "%d taps, band pass", sizes[s]);
+    report ("complex fir", config, t, SAMPLES,
+        error_db (out, ref, SAMPLES), -100, true);
+  }
+}
+
+/* The overlap-add filters. A block of fftSize - degree samples is
+ * output one block late, the real version is scaled by 3 */
+static void
+bench_fft_filter (const DSPCOMPLEX *x, DSPCOMPLEX *out, dcomplex *ref)
+{
+  static const struct {
+    int size, degree;
+  } shapes[] = {
+    { 256, 39 }, { 256, 49 }, { 512, 127 }, { 1024, 127 }, { 2048, 255 }
+  };
+  dcomplex h[256];
+  char config[64];
+  unsigned s;
+  int i;
+
+  for (s = 0; s < sizeof (shapes) / sizeof (shapes[0]); s++) {
+    int size = shapes[s].size, degree = shapes[s].degree;
+    int delay = size - degree;
+    BandPassFIR design (degree, 18500, 19500, FM_RATE);
+    fftFilter filter (size, degree);
+    fftFilter rfilter (size, degree);
+    DSPCOMPLEX *kernel = design.getKernel ();
+
+    filter.setBand (18500, 19500, FM_RATE);
+    rfilter.setBand (18500, 19500, FM_RATE);
+    for (i = 0; i < degree; i++)
+      h[i] = dcomplex (real (kernel[i]), imag (kernel[i]));
+    convolve (h, degree, x, ref, SAMPLES - delay);
+
+    double start = now ();
+    for (i = 0; i < SAMPLES; i++)
+      out[i] = filter.Pass (x[i]);
+    double t = now () - start;
+    snprintf (config, sizeof (config), "%d points, %d taps, complex",
+        size, degree);
+    report ("fft filter", config, t, SAMPLES,
+        error_db (&out[delay], ref, SAMPLES - delay), -90, true);
+
+    for (i = 0; i < degree; i++)
+      h[i] = 3.0 * real (h[i]);
+    for (i = 0; i < SAMPLES; i++)
+      out[i] = DSPCOMPLEX (real (x[i]), 0);
+    convolve (h, degree, out, ref, SAMPLES - delay);
+
+    start = now ();
+    for (i = 0; i < SAMPLES; i++)
+      out[i] = rfilter.Pass (real (x[i]));
+    t = now () - start;
+    snprintf (config, sizeof (config), "%d points, %d taps, real",
+        size, degree);
+    report ("fft filter", config, t, SAMPLES,
+        error_db (&out[delay], ref, SAMPLES - delay), -90, true);
+  }
+}
+
+/* Basic_IIR::Pass in doubles, the coefficients as computed by the
+ * filter */
+static void
+iir_reference (const Basic_IIR *filter, const DSPCOMPLEX *x, dcomplex *y,
+    int n)
+{
+  dcomplex m1[64], m2[64];
+  int i, q;
+
+  for (q = 0; q < filter->numofQuads; q++)
+    m1[q] = m2[q] = 0;
+  for (i = 0; i < n; i++) {
+    dcomplex o = dcomplex (real (x[i]), imag (x[i])) * (double) filter->gain;
+    for (q = 0; q < filter->numofQuads; q++) {
+      const element *quad = &filter->Quads[q];
+      dcomplex w = o - m1[q] * (double) quad->B1 - m2[q] * (double) quad->B2;
+      o = w + m1[q] * (double) quad->A1 + m2[q] * (double) quad->A2;
+      m2[q] = m1[q];
+      m1[q] = w;
+    }
+    y[i] = o;
+  }
+}
+
+static void
+bench_iir (const DSPCOMPLEX *x, DSPCOMPLEX *out, dcomplex *ref)
+{
+  static const int orders[] = { 2, 4, 8 };
+  char config[64];
+  unsigned o;
+  int i;
+
+  for (o = 0; o < sizeof (orders) / sizeof (orders[0]); o++) {
+    LowPassIIR filter (orders[o], 15000, FM_RATE, S_BUTTERWORTH);
+    iir_reference (&filter, x, ref, SAMPLES);
+
+    double start = now ();
+    for (i = 0; i < SAMPLES; i++)
+      out[i] = filter.Pass (x[i]);
+    double t = now () - start;
+    snprintf (config, sizeof (config), "order %d, low pass", orders[o]);
+    report ("iir", config, t, SAMPLES, error_db (out, ref, SAMPLES),
+        -100, true);
+  }
+
+  /* the sharp filter of the RDS decoder, a narrow band pass at the
+   * RDS bit clock, on a real input */
+  BandPassIIR filter (6, 1187 - 3, 1187 + 3, RDS_RATE, S_CHEBYSHEV);
+  for (i = 0; i < SAMPLES; i++)
+    out[i] = DSPCOMPLEX (real (x[i]), 0);
+  iir_reference (&filter, out, ref, SAMPLES);
+
+  double start = now ();
+  for (i = 0; i < SAMPLES; i++)
+    out[i] = filter.Pass (real (out[i]));
+  double t = now () - start;
+  report ("iir", "order 6, RDS band pass, real", t, SAMPLES,
+      error_db (out, ref, SAMPLES), -60, true);
+}
+
+/* pllC::do_pll in doubles */
+struct refPll {
+  double phase, incr, lo, hi, alpha, beta;
+
+  refPll (double rate, double freq, double lofreq, double hifreq,
+      double bandwidth)
+  {
+    double fac = 2 * M_PI / rate;
+    phase = 0;
+    incr = freq * fac;
+    lo = lofreq * fac;
+    hi = hifreq * fac;
+    alpha = 0.125 * bandwidth * fac;
+    beta = alpha * alpha / 2;
+  }
+
+  void step (dcomplex signal)
+  {
+    dcomplex d = std::polar (1.0, phase) * signal;
+    double error = -atan2 (imag (d), real (d));
+    incr += beta * error;
+    if (incr < lo)
+      incr = lo;
+    if (incr > hi)
+      incr = hi;
+    phase = fmod (phase + incr + alpha * error, 2 * M_PI);
+  }
+};
+
+/* The RDS carrier pll, as set up by the fmProcessor, locking on a
+ * carrier slightly off, in noise. The nco phases of both are compared
+ * once locked, they should not differ by more than a step of the
+ * table */
+static void
+bench_pll (void)
+{
+  static const int rates[] = { FM_RATE, 1 << 16 };
+  DSPCOMPLEX *x = new DSPCOMPLEX[SAMPLES];
+  char config[64];
+  unsigned r;
+  int i;
+
+  for (i = 0; i < SAMPLES; i++) {
+    double p = 2 * M_PI * 57020.0 * i / FM_RATE;
+    x[i] = DSPCOMPLEX (cos (p) + 0.1 * noise (), -sin (p) + 0.1 * noise ());
+  }
+
+  for (r = 0; r < sizeof (rates) / sizeof (rates[0]); r++) {
+    SinCos table (rates[r]);
+    pllC pll (FM_RATE, 57000, 57000 - 50, 57000 + 50, 200, &table);
+    refPll ref (FM_RATE, 57000, 57000 - 50, 57000 + 50, 200);
+    double err = 0;
+
+    for (i = 0; i < SAMPLES; i++) {
+      pll.do_pll (x[i]);
+      ref.step (dcomplex (real (x[i]), imag (x[i])));
+      if (i >= FM_RATE / 4) {
+        double d = remainder (pll.getNco () - ref.phase, 2 * M_PI);
+        if (fabs (d) > err)
+          err = fabs (d);
+      }
+    }
+
+    pllC timed (FM_RATE, 57000, 57000 - 50, 57000 + 50, 200, &table);
+    double start = now ();
+    for (i = 0; i < SAMPLES; i++)
+      timed.do_pll (x[i]);
+    double t = now () - start;
+
+    snprintf (config, sizeof (config), "table of %d, nco phase",
+        rates[r]);
+    report ("pll", config, t, SAMPLES, err, 2 * M_PI / rates[r], false);
+  }
+  delete[] x;
+}
+
+/* The tables are looked up by truncation, so the error is at most one
+ * step of the table (and the rounding of the float result) */
+static void
+bench_sincos (void)
+{
+  static const int rates[] = { FM_RATE, 1 << 16 };
+  DSPPHASE *phases = new DSPPHASE[SAMPLES];
+  DSPFLOAT *radians = new DSPFLOAT[SAMPLES];
+  DSPCOMPLEX *out = new DSPCOMPLEX[SAMPLES];
+  char config[64];
+  unsigned r;
+  int i;
+
+  for (i = 0; i < SAMPLES; i++) {
+    phases[i] = (DSPPHASE) (seed = seed * 1664525 + 1013904223);
+    radians[i] = 4 * M_PI * noise ();
+  }
+
+  for (r = 0; r < sizeof (rates) / sizeof (rates[0]); r++) {
+    SinCos table (rates[r]);
+    double limit = 2 * M_PI / rates[r] + 1e-6;
+    double err = 0;
+
+    double start = now ();
+    for (i = 0; i < SAMPLES; i++)
+      out[i] = table.getComplex (phases[i]);
+    double t = now () - start;
+    for (i = 0; i < SAMPLES; i++) {
+      dcomplex e = std::polar (1.0, phases[i] / PHASE_TURN * 2 * M_PI);
+      err = std::max (err, abs (dcomplex (real (out[i]), imag (out[i])) - e));
+    }
+    snprintf (config, sizeof (config), "table of %d, fixed point",
+        rates[r]);
+    report ("sincos", config, t, SAMPLES, err, limit, false);
+
+    err = 0;
+    start = now ();
+    for (i = 0; i < SAMPLES; i++)
+      out[i] = table.getComplex (radians[i]);
+    t = now () - start;
+    for (i = 0; i < SAMPLES; i++) {
+      dcomplex e = std::polar (1.0, (double) radians[i]);
+      err = std::max (err, abs (dcomplex (real (out[i]), imag (out[i])) - e));
+    }
+    snprintf (config, sizeof (config), "table of %d, radians", rates[r]);
+    report ("sincos", config, t, SAMPLES, err, limit, false);
+  }
+
+  delete[] phases;
+  delete[] radians;
+  delete[] out;
+}
+
+static void
+bench_atan2 (void)
+{
+  DSPFLOAT *x = new DSPFLOAT[SAMPLES];
+  DSPFLOAT *y = new DSPFLOAT[SAMPLES];
+  DSPFLOAT *out = new DSPFLOAT[SAMPLES];
+  compAtan table;
+  double err, start, t;
+  unsigned k;
+  int i;
+
+  for (i = 0; i < SAMPLES; i++) {
+    x[i] = noise ();
+    y[i] = noise ();
+  }
+
+  start = now ();
+  for (i = 0; i < SAMPLES; i++)
+    out[i] = fastAtan2 (y[i], x[i]);
+  t = now () - start;
+  for (err = 0, i = 0; i < SAMPLES; i++)
+    err = std::max (err, fabs (out[i] - atan2 ((double) y[i], x[i])));
+  report ("atan2", "fastAtan2", t, SAMPLES, err, 4e-6, false);
+
+  start = now ();
+  for (i = 0; i < SAMPLES; i++)
+    out[i] = table.atan2 (y[i], x[i]);
+  t = now () - start;
+  for (err = 0, i = 0; i < SAMPLES; i++)
+    err = std::max (err, fabs (out[i] - atan2 ((double) y[i], x[i])));
+  report ("atan2", "compAtan table", t, SAMPLES, err, 1e-3, false);
+
+  for (k = 0; k < sizeof (kernelSets) / sizeof (kernelSets[0]); k++) {
+    const dspKernels *kernels = getKernels (kernelSets[k]);
+    char config[64];
+    if (kernels == NULL)
+      continue;
+    start = now ();
+    kernels->atan2 (y, x, out, SAMPLES);
+    t = now () - start;
+    for (err = 0, i = 0; i < SAMPLES; i++)
+      err = std::max (err, fabs (out[i] - atan2 ((double) y[i], x[i])));
+    snprintf (config, sizeof (config), "kernel, %s", kernels->name);
+    report ("atan2", config, t, SAMPLES, err, 4e-6, false);
+  }
+
+  delete[] x;
+  delete[] y;
+  delete[] out;
+}
+
+/* The integer decimator just drops samples; the fractional one is
+ * compared by fitting the tone it is given to its output */
+static void
+bench_resampler (void)
+{
+  DSPCOMPLEX *x = new DSPCOMPLEX[SAMPLES];
+  DSPCOMPLEX *out = new DSPCOMPLEX[SAMPLES];
+  dcomplex *ref = new dcomplex[SAMPLES];
+  DSPCOMPLEX buffer[65536];
+  int32_t amount;
+  int i, j, n;
+
+  for (i = 0; i < SAMPLES; i++)
+    x[i] = DSPCOMPLEX (noise (), noise ());
+
+  reSampler decimator (INPUT_RATE, FM_RATE, 16384);
+  n = 0;
+  double start = now ();
+  for (i = 0; i < SAMPLES; i++)
+    if (decimator.doResample (x[i], buffer, &amount))
+      for (j = 0; j < amount; j++)
+        out[n++] = buffer[j];
+  double t = now () - start;
+  int ratio = INPUT_RATE / FM_RATE;
+  for (i = 0; i < n; i++)
+    ref[i] = dcomplex (real (x[(i + 1) * ratio - 1]),
+        imag (x[(i + 1) * ratio - 1]));
+  report ("resampler", "1058400 -> 176400", t, SAMPLES,
+      error_db (out, ref, n), -140, true);
+
+  double omega = 2 * M_PI * 3000 / FM_RATE;
+  for (i = 0; i < SAMPLES; i++)
+    x[i] = std::polar (0.5, omega * i);
+  reSampler converter (FM_RATE, 48000, 16384);
+  n = 0;
+  start = now ();
+  for (i = 0; i < SAMPLES; i++)
+    if (converter.doResample (x[i], buffer, &amount))
+      for (j = 0; j < amount; j++)
+        out[n++] = buffer[j];
+  t = now () - start;
+
+  /* the delay of the converter is not known, fit the phase and
+   * amplitude of the tone, after the start */
+  int skip = 48000 / 10;
+  dcomplex fit = 0;
+  omega = 2 * M_PI * 3000 / 48000;
+  for (i = skip; i < n; i++)
+    fit += dcomplex (real (out[i]), imag (out[i]))
+        * std::polar (1.0, -omega * i);
+  fit /= (double) (n - skip);
+  for (i = skip; i < n; i++)
+    ref[i] = fit * std::polar (1.0, omega * i);
+  report ("resampler", "176400 -> 48000, 3 KHz tone", t, SAMPLES,
+      error_db (&out[skip], &ref[skip], n - skip), -40, true);
+
+  delete[] x;
+  delete[] out;
+  delete[] ref;
+}
+
+/* The remaining kernels, element by element against their
+ * definition, on blocks of the size the fmProcessor uses */
+static void
+bench_kernels (void)
+{
+  const int n = 16384, rounds = SAMPLES / n;
+  DSPFLOAT *I = new DSPFLOAT[n], *Q = new DSPFLOAT[n];
+  DSPFLOAT *c = new DSPFLOAT[n], *s = new DSPFLOAT[n];
+  DSPFLOAT *oI = new DSPFLOAT[n], *oQ = new DSPFLOAT[n];
+  uint8_t *bytes = new uint8_t[2 * n];
+  char config[64];
+  unsigned k;
+  int i, r;
+
+  for (i = 0; i < n; i++) {
+    I[i] = noise ();
+    Q[i] = noise ();
+    c[i] = cos (0.01 * i);
+    s[i] = sin (0.01 * i);
+    bytes[2 * i] = seed >> 8;
+    bytes[2 * i + 1] = seed >> 16;
+    noise ();
+  }
+
+  for (k = 0; k < sizeof (kernelSets) / sizeof (kernelSets[0]); k++) {
+    const dspKernels *kernels = getKernels (kernelSets[k]);
+    double start, t, err;
+    if (kernels == NULL)
+      continue;
+
+    start = now ();
+    for (r = 0; r < rounds; r++) {
+      memcpy (oI, I, n * sizeof (DSPFLOAT));
+      memcpy (oQ, Q, n * sizeof (DSPFLOAT));
+      kernels->rotate (oI, oQ, c, s, n);
+    }
+    t = now () - start;
+    for (err = 0, i = 0; i < n; i++) {
+      dcomplex e = dcomplex (I[i], Q[i]) * dcomplex (c[i], s[i]);
+      err = std::max (err, abs (dcomplex (oI[i], oQ[i]) - e));
+    }
+    snprintf (config, sizeof (config), "rotate, %s", kernels->name);
+    report ("kernels", config, t, rounds * n, err, 1e-6, false);
+
+    start = now ();
+    for (r = 0; r < rounds; r++)
+      kernels->magnitude (I, Q, oI, n);
+    t = now () - start;
+    for (err = 0, i = 0; i < n; i++)
+      err = std::max (err, fabs (oI[i] - hypot ((double) I[i], Q[i])));
+    snprintf (config, sizeof (config), "magnitude, %s", kernels->name);
+    report ("kernels", config, t, rounds * n, err, 1e-6, false);
+
+    start = now ();
+    for (r = 0; r < rounds; r++)
+      kernels->u8ToFloat (bytes, oI, oQ, n);
+    t = now () - start;
+    for (err = 0, i = 0; i < n; i++)
+      err = std::max (err, std::max (fabs (oI[i] - (bytes[2 * i] - 128) / 128.0),
+          fabs (oQ[i] - (bytes[2 * i + 1] - 128) / 128.0)));
+    snprintf (config, sizeof (config), "u8ToFloat, %s", kernels->name);
+    report ("kernels", config, t, rounds * n, err, 0, false);
+
+    start = now ();
+    for (r = 0; r < rounds; r++)
+      kernels->window (c, I, oI, n);
+    t = now () - start;
+    for (err = 0, i = 0; i < n; i++)
+      err = std::max (err, fabs (oI[i] - (double) c[i] * I[i]));
+    snprintf (config, sizeof (config), "window, %s", kernels->name);
+    report ("kernels", config, t, rounds * n, err, 1e-7, false);
+  }
+
+  delete[] I;
+  delete[] Q;
+  delete[] c;
+  delete[] s;
+  delete[] oI;
+  delete[] oQ;
+  delete[] bytes;
+}
+
+int
+main (int argc, char **argv)
+{
+  DSPCOMPLEX *x = new DSPCOMPLEX[SAMPLES];
+  DSPCOMPLEX *out = new DSPCOMPLEX[SAMPLES];
+  dcomplex *ref = new dcomplex[SAMPLES];
+  int i;
+
+  for (i = 0; i < SAMPLES; i++)
+    x[i] = DSPCOMPLEX (noise (), noise ());
+
+  printf ("%-14s %-28s %10s %10s %12s %12s\n", "primitive", "configuration",
+      "ns/S", "MS/s", "error", "limit");
+
+  bench_real_fir (x, out, ref);
+  bench_complex_fir (x, out, ref);
+  bench_fft_filter (x, out, ref);
+  bench_iir (x, out, ref);
+  bench_pll ();
+  bench_sincos ();
+  bench_atan2 ();
+  bench_resampler ();
+  bench_kernels ();
+
+  delete[] x;
+  delete[] out;
+  delete[] ref;
+
+  if (failures > 0) {
+    fprintf (stderr, "%d primitives are less accurate than required\n",
+        failures);
+    return 1;
+  }
+  return 0;
+}
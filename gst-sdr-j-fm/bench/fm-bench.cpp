@@ -0,0 +1,297 @@
+/* End to end throughput and latency of the fmProcessor.
+ *
+ * A few seconds of input (generated, or read from a recording) are
+ * loaded into memory once, and then played, as fast as the processor
+ * takes them, through a fmProcessor in every combination of
+ * stereo/mono, RDS1/RDS2/no RDS, the five FM decoders and squelch
+ * on/off. Every combination runs in a child process of its own, so the
+ * peak RSS reported is that of the combination (the input, shared with
+ * the parent, included).
+ *
+ * One JSON object per line is written per combination:
+ *   throughput in MS/s, the real time factor (seconds of input
+ *   per second of processing), percentiles of the time taken by the
+ *   processor per input block, the mean time per block of each of
+ *   its stages (as kept by its stageProfile) and the peak RSS in KiB.
+ *
+ * usage: fm-bench [-s seconds] [-i recording | -g generator-spec]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "fm-constants.h"
+#include "fm-processor.h"
+#include "fm-demodulator.h"
+#include "rds-decoder.h"
+#include "audiosink.h"
+#include "sample-block.h"
+#include "virtual-input.h"
+#include "file-reader.h"
+#include "signal-generator.h"
+#include <gst/gst.h>
+
+/* the sources log through this category, as gst_init is never
+ * called, all logging is off */
+GST_DEBUG_CATEGORY (sdrjfm_debug);
+
+/* the rates as set up by the RadioInterface */
+#define AUDIO_RATE 44100
+#define INPUT_RATE (24 * AUDIO_RATE)
+#define FM_RATE (4 * AUDIO_RATE)
+#define BLOCK 16384
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Hands out the samples loaded in memory, as fast as they are asked
+ * for, and notes when the processor asks for them: the time between
+ * handing out a block and asking for the next one is the time the
+ * processor took for it. */
+class benchInput : public virtualInput
+{
+public:
+  benchInput (const DSPFLOAT *I, const DSPFLOAT *Q, int32_t n,
+      audioSink *sink)
+    : I (I), Q (Q), total (n), current (0), sink (sink),
+      lastOut (0), finished (false)
+  {
+    latencies.reserve (n / BLOCK + 1);
+  }
+
+  int32_t Samples (void)
+  {
+    if (current >= total && !finished) {
+      record ();
+      finished = true;
+      /* wake up the reader of the audio */
+      sink->cancelGet ();
+    }
+    return total - current;
+  }
+
+  int32_t getSamples (sampleBlock *b, int32_t size, uint8_t M)
+  {
+    (void) M;
+    record ();
+    if (size > b->size)
+      size = b->size;
+    if (size > total - current)
+      size = total - current;
+    memcpy (b->I, I + current, size * sizeof (DSPFLOAT));
+    memcpy (b->Q, Q + current, size * sizeof (DSPFLOAT));
+    b->count = size;
+    current += size;
+    lastOut = now ();
+    return size;
+  }
+
+  bool done (void)
+  {
+    return finished;
+  }
+
+  std::vector<double> latencies;
+  double first, last;
+
+private:
+  void record (void)
+  {
+    double t = now ();
+    if (lastOut == 0)
+      first = t;
+    else
+      latencies.push_back (t - lastOut);
+    last = t;
+  }
+
+  const DSPFLOAT *I, *Q;
+  int32_t total;
+  int32_t current;
+  audioSink *sink;
+  double lastOut;
+  volatile bool finished;
+};
+
+static double
+percentile (std::vector<double> &v, double p)
+{
+  if (v.empty ())
+    return 0;
+  size_t k = (size_t) (p / 100 * (v.size () - 1) + 0.5);
+  std::nth_element (v.begin (), v.begin () + k, v.end ());
+  return v[k];
+}
+
+static const char *
+rds_name (int rds)
+{
+  switch (rds) {
+    case rdsDecoder::RDS1: return "rds1";
+    case rdsDecoder::RDS2: return "rds2";
+    default: return "none";
+  }
+}
+
+static void
+run (const DSPFLOAT *I, const DSPFLOAT *Q, int32_t n, bool stereo,
+    int rds, int decoder, bool squelch)
+{
+  audioSink sink;
+  benchInput input (I, Q, n, &sink);
+  fmProcessor processor (&input, NULL, &sink, INPUT_RATE, FM_RATE,
+      AUDIO_RATE, 20);
+  DSPFLOAT audio[4096];
+  struct rusage usage;
+  stageProfile::snapshot profile;
+  std::string stages;
+  const char *name;
+  char mean[64];
+  int s;
+
+  processor.setfmMode (stereo);	/* a boolean, not the Mode */
+  processor.setfmRdsSelector (rds);
+  processor.setFMdecoder (decoder);
+  processor.set_squelchMode (squelch);
+  processor.set_squelchValue (50);
+  name = processor.nameofDecoder ();
+
+  processor.start ();
+  while (!input.done ())
+    sink.getSamples (audio, 4096);
+  processor.stop ();
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  processor.getProfile (&profile);
+  for (s = 0; s < stageProfile::STAGES; s++) {
+    const stageProfile::histogram *h = &profile.stage[s];
+    if (h->count == 0)
+      continue;
+    snprintf (mean, sizeof (mean), "%s\"%s\": %.1f",
+        stages.empty () ? "" : ", ",
+        stageProfile::name (s), h->total / (double) h->count * 1e-3);
+    stages += mean;
+  }
+
+  double elapsed = input.last - input.first;
+  printf ("{\"mode\": \"%s\", \"rds\": \"%s\", \"decoder\": \"%s\", "
+      "\"squelch\": %s, \"samples\": %d, \"seconds\": %.4f, "
+      "\"msps\": %.3f, \"realtime\": %.2f, "
+      "\"block_us\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+      "\"max\": %.1f}, \"stages_us\": {%s}, \"peak_rss_kib\": %ld}\n",
+      stereo ? "stereo" : "mono", rds_name (rds), name,
+      squelch ? "true" : "false", n, elapsed,
+      n / elapsed * 1e-6, n / (double) INPUT_RATE / elapsed,
+      percentile (input.latencies, 50) * 1e6,
+      percentile (input.latencies, 90) * 1e6,
+      percentile (input.latencies, 99) * 1e6,
+      percentile (input.latencies, 100) * 1e6,
+      stages.c_str (), usage.ru_maxrss);
+  fflush (stdout);
+}
+
+/* read the input into the I and Q arrays, from a recording or from
+ * the generator */
+static bool
+load (virtualInput *source, DSPFLOAT *I, DSPFLOAT *Q, int32_t n)
+{
+  sampleBlock block (BLOCK);
+  int32_t i, got;
+
+  source->restartReader ();
+  for (i = 0; i < n; i += got) {
+    got = source->getSamples (&block, n - i < BLOCK ? n - i : BLOCK, 0);
+    if (got <= 0)
+      return false;
+    memcpy (&I[i], block.I, got * sizeof (DSPFLOAT));
+    memcpy (&Q[i], block.Q, got * sizeof (DSPFLOAT));
+  }
+  return true;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const int decoders[] = {
+    fm_Demodulator::FM1DECODER, fm_Demodulator::FM2DECODER,
+    fm_Demodulator::FM3DECODER, fm_Demodulator::FM4DECODER,
+    fm_Demodulator::FM5DECODER
+  };
+  static const int rdsModes[] = {
+    rdsDecoder::NO_RDS, rdsDecoder::RDS1, rdsDecoder::RDS2
+  };
+  const char *recording = NULL;
+  std::string spec = "ps=BENCH;rt=Throughput and latency";
+  double seconds = 4;
+  virtualInput *source;
+  bool ok;
+  int opt, stereo, squelch;
+  unsigned r, d;
+
+  while ((opt = getopt (argc, argv, "s:i:g:")) != -1) {
+    switch (opt) {
+      case 's':
+        seconds = atof (optarg);
+        break;
+      case 'i':
+        recording = optarg;
+        break;
+      case 'g':
+        spec = optarg;
+        break;
+      default:
+        fprintf (stderr,
+            "usage: %s [-s seconds] [-i recording | -g generator-spec]\n",
+            argv[0]);
+        return 1;
+    }
+  }
+
+  /* the processor only reads whole blocks */
+  int32_t n = (int32_t) (seconds * INPUT_RATE) / BLOCK * BLOCK;
+  DSPFLOAT *I = new DSPFLOAT[n];
+  DSPFLOAT *Q = new DSPFLOAT[n];
+
+  if (recording != NULL)
+    source = new fileReader (recording, INPUT_RATE, false, &ok);
+  else
+    source = new signalGenerator (spec + ";paced=0", INPUT_RATE, &ok);
+  if (!ok || !load (source, I, Q, n)) {
+    fprintf (stderr, "Could not load %.1f seconds of input\n", seconds);
+    return 1;
+  }
+  delete source;
+
+  for (stereo = 1; stereo >= 0; stereo--)
+    for (r = 0; r < sizeof (rdsModes) / sizeof (rdsModes[0]); r++)
+      for (d = 0; d < sizeof (decoders) / sizeof (decoders[0]); d++)
+        for (squelch = 0; squelch <= 1; squelch++) {
+          pid_t child = fork ();
+          if (child == 0) {
+            run (I, Q, n, stereo, rdsModes[r], decoders[d], squelch);
+            _exit (0);
+          }
+          int status;
+          if (child < 0 || waitpid (child, &status, 0) < 0 ||
+              !WIFEXITED (status) || WEXITSTATUS (status) != 0) {
+            fprintf (stderr, "Benchmark run failed\n");
+            return 1;
+          }
+        }
+
+  delete[] I;
+  delete[] Q;
+  return 0;
+}
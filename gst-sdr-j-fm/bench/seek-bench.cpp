@@ -0,0 +1,600 @@
+/* Seek quality and seek time of the station scanner, offline.
+ *
+ * A set of captures (recordings at the input rate, each centred on a
+ * known frequency) is played through a fake tuner: tuning selects the
+ * capture nearest to the frequency and shifts it, as the stick would,
+ * so a few captures cover a whole band. A retune is not instantaneous:
+ * the samples still in flight from the old frequency come first, then
+ * those of the new one, while the tuner's pll settles from an offset.
+ *
+ * The fmProcessor's scanner runs on this, with the seek stepping done
+ * as RadioInterface::seek does it, but in sample time rather than on
+ * the system clock, so that it runs as fast as the processor allows and
+ * gives the same result every time. From every frequency of the band a
+ * seek upwards is done, for every combination of threshold and interval
+ * given. A seek should stop on the first station above where it
+ * started; it is a false positive if it stops where there is no
+ * station, and a false negative if it passes the station by, or gives
+ * up after a full turn of the band.
+ *
+ * One JSON object per line is written per combination: the outcome of
+ * the seeks, the latency (in sample time) of those that stopped
+ * somewhere, the correct stops per second of seeking and the real time
+ * factor of the replay.
+ *
+ * The capture set is described by a file with lines
+ *   capture <centre frequency> <recording>
+ *   station <frequency>
+ * Without one, the captures are generated, with stations at the given
+ * frequencies and signal to noise ratio.
+ *
+ * usage: seek-bench [-c capture-set | -x station:station:... -n snr]
+ *                   [-m minimum] [-M maximum] [-f step]
+ *                   [-t threshold,...] [-i interval,...] [-s seconds]
+ *                   [-S stale-ms] [-G settle-ms] [-v]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "fm-constants.h"
+#include "fm-processor.h"
+#include "audiosink.h"
+#include "sample-block.h"
+#include "virtual-input.h"
+#include "file-reader.h"
+#include "signal-generator.h"
+#include <gst/gst.h>
+
+/* the sources log through this category, as gst_init is never
+ * called, all logging is off */
+GST_DEBUG_CATEGORY (sdrjfm_debug);
+
+/* the rates as set up by the RadioInterface */
+#define AUDIO_RATE 44100
+#define INPUT_RATE (24 * AUDIO_RATE)
+#define FM_RATE (4 * AUDIO_RATE)
+#define BLOCK 16384
+/* a capture can be shifted this far before the fm band around the
+ * tuned frequency no longer fits in it */
+#define MAX_SHIFT (INPUT_RATE / 2 - FM_RATE / 2)
+/* the offset the tuner's pll settles from, after a retune */
+#define SETTLE_OFFSET 20000
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct capture {
+  int32_t centre;
+  std::vector<DSPCOMPLEX> iq;
+};
+
+enum outcome { HIT, FALSE_POSITIVE, SKIPPED, NOT_FOUND };
+
+struct seekResult {
+  int32_t start;
+  int32_t found;
+  int64_t latency;      /* in samples */
+  outcome result;
+};
+
+/* Plays the captures as tuned to, and runs the seeks: every
+ * seek starts from a settled tuner, a seek gives up after a full turn
+ * of the band */
+class replayTuner : public virtualInput
+{
+public:
+  replayTuner (const std::vector<capture> &captures, int32_t minimum,
+      int32_t maximum, int32_t step, int32_t stale, int32_t settle,
+      audioSink *sink)
+    : captures (captures), minimum (minimum), maximum (maximum),
+      step (step), stale (stale), settle (settle), sink (sink),
+      processor (NULL), position (0), retunedAt (-stale - settle),
+      settlePhase (0), seeking (false), preroll (0), found (-1),
+      finished (false)
+  {
+    int32_t i;
+
+    /* exp (-j 2 pi k / rate), the shift of a capture by a whole
+     * number of Hz is periodic in the rate */
+    rotation.resize (INPUT_RATE);
+    for (i = 0; i < INPUT_RATE; i++)
+      rotation[i] = DSPCOMPLEX (cos (2 * M_PI * i / INPUT_RATE),
+          -sin (2 * M_PI * i / INPUT_RATE));
+    frequency = oldFrequency = minimum;
+    tuning = oldTuning = nearest (minimum);
+  }
+
+  void setVFOFrequency (int32_t f)
+  {
+    oldFrequency = frequency;
+    oldTuning = tuning;
+    frequency = f;
+    tuning = nearest (f);
+    retunedAt = position;
+    settlePhase = 0;
+  }
+
+  int32_t getVFOFrequency (void)
+  {
+    return frequency;
+  }
+
+  /* a seek from every frequency of the band */
+  void run (fmProcessor *p, int16_t t, int32_t interval)
+  {
+    int32_t f;
+
+    processor = p;
+    threshold = t;
+    intervalSamples = (int64_t) interval * INPUT_RATE / 1000;
+    for (f = minimum; f <= maximum; f += step)
+      starts.push_back (f);
+    next = 0;
+    begin ();
+  }
+
+  int32_t Samples (void)
+  {
+    if (finished) {
+      sink->cancelGet ();
+      return 0;
+    }
+    return BLOCK;
+  }
+
+  int32_t getSamples (sampleBlock *b, int32_t size, uint8_t M)
+  {
+    int32_t i;
+
+    (void) M;
+    if (size > b->size)
+      size = b->size;
+    for (i = 0; i < size; i++) {
+      schedule ();
+      DSPCOMPLEX z = sample ();
+      b->I[i] = real (z);
+      b->Q[i] = imag (z);
+      position++;
+    }
+    b->count = size;
+    return size;
+  }
+
+  bool done (void)
+  {
+    return finished;
+  }
+
+  int64_t samplesPlayed (void)
+  {
+    return position;
+  }
+
+  static void stationFound (int32_t frequency, void *userdata)
+  {
+    replayTuner *tuner = static_cast<replayTuner *> (userdata);
+    tuner->found = frequency;
+  }
+
+  std::vector<seekResult> results;
+  int64_t seekingSamples;
+
+private:
+  int32_t nearest (int32_t f)
+  {
+    int32_t i, best = 0;
+
+    for (i = 1; i < (int32_t) captures.size (); i++)
+      if (abs (captures[i].centre - f) < abs (captures[best].centre - f))
+        best = i;
+    return best;
+  }
+
+  DSPCOMPLEX shifted (int32_t c, int32_t f)
+  {
+    const capture &cap = captures[c];
+    int64_t shift = (int64_t) f - cap.centre;
+    int64_t k = (shift * (position % INPUT_RATE)) % INPUT_RATE;
+
+    if (k < 0)
+      k += INPUT_RATE;
+    return cap.iq[position % cap.iq.size ()] * rotation[k];
+  }
+
+  DSPCOMPLEX sample (void)
+  {
+    int64_t since = position - retunedAt;
+
+    if (since < stale)
+      return shifted (oldTuning, oldFrequency);
+    if (since < stale + settle) {
+      double offset = SETTLE_OFFSET *
+          exp (-5.0 * (since - stale) / settle);
+      settlePhase += 2 * M_PI * offset / INPUT_RATE;
+      return shifted (tuning, frequency) *
+          DSPCOMPLEX (cos (settlePhase), sin (settlePhase));
+    }
+    return shifted (tuning, frequency);
+  }
+
+  /* as RadioInterface::iterateSeekFrequency */
+  void iterate (void)
+  {
+    int32_t f = frequency + step;
+
+    if (f > maximum)
+      f = minimum;
+    else if (f < minimum)
+      f = maximum;
+    setVFOFrequency (f);
+    steps++;
+    lastStep = position;
+  }
+
+  void begin (void)
+  {
+    if (next >= starts.size ()) {
+      finished = true;
+      return;
+    }
+    setVFOFrequency (starts[next++]);
+    /* the tuner has settled, and the scanner has seen it, before the
+     * seek starts */
+    preroll = position + stale + settle + 4 * BLOCK;
+  }
+
+  void finish (int32_t f)
+  {
+    seekResult r;
+
+    r.start = seekStart;
+    r.found = f;
+    r.latency = position - seekBegan;
+    r.result = NOT_FOUND;
+    results.push_back (r);
+    seekingSamples += position - seekBegan;
+    seeking = false;
+    begin ();
+  }
+
+  void schedule (void)
+  {
+    if (finished)
+      return;
+    if (!seeking) {
+      if (position < preroll)
+        return;
+      seeking = true;
+      seekStart = frequency;
+      seekBegan = position;
+      steps = 0;
+      found = -1;
+      iterate ();
+      processor->startScanning (&replayTuner::stationFound, this,
+          threshold);
+      return;
+    }
+    if (found != -1) {
+      finish (found);
+      return;
+    }
+    if (position - lastStep < intervalSamples)
+      return;
+    if (steps > (maximum - minimum) / step) {
+      processor->stopScanning ();
+      finish (-1);
+      return;
+    }
+    iterate ();
+  }
+
+  const std::vector<capture> &captures;
+  std::vector<DSPCOMPLEX> rotation;
+  int32_t minimum, maximum, step;
+  int32_t stale, settle;
+  audioSink *sink;
+  fmProcessor *processor;
+  int16_t threshold;
+  int64_t intervalSamples;
+
+  int64_t position;
+  int32_t frequency, oldFrequency;
+  int32_t tuning, oldTuning;
+  int64_t retunedAt;
+  double settlePhase;
+
+  std::vector<int32_t> starts;
+  size_t next;
+  bool seeking;
+  int64_t preroll;
+  int32_t seekStart;
+  int64_t seekBegan;
+  int64_t lastStep;
+  int32_t steps;
+  volatile int32_t found;
+  volatile bool finished;
+};
+
+/* the station, if any, within half a step of f */
+static int32_t
+station_at (const std::vector<int32_t> &stations, int32_t f, int32_t step)
+{
+  for (size_t i = 0; i < stations.size (); i++)
+    if (abs (stations[i] - f) <= step / 2)
+      return stations[i];
+  return -1;
+}
+
+/* the first station above f, wrapping at the end of the band */
+static int32_t
+expected_station (const std::vector<int32_t> &stations, int32_t f,
+    int32_t step)
+{
+  for (size_t i = 0; i < stations.size (); i++)
+    if (stations[i] >= f + step / 2)
+      return stations[i];
+  return stations.empty () ? -1 : stations[0];
+}
+
+static double
+percentile (std::vector<double> v, double p)
+{
+  if (v.empty ())
+    return 0;
+  size_t k = (size_t) (p / 100 * (v.size () - 1) + 0.5);
+  std::nth_element (v.begin (), v.begin () + k, v.end ());
+  return v[k];
+}
+
+static void
+run (const std::vector<capture> &captures,
+    const std::vector<int32_t> &stations, int32_t minimum, int32_t maximum,
+    int32_t step, int16_t threshold, int32_t interval, int32_t stale,
+    int32_t settle, bool verbose)
+{
+  audioSink sink;
+  replayTuner tuner (captures, minimum, maximum, step, stale, settle, &sink);
+  fmProcessor processor (&tuner, NULL, &sink, INPUT_RATE, FM_RATE,
+      AUDIO_RATE, threshold);
+  std::vector<double> latencies;
+  int counts[4] = { 0, 0, 0, 0 };
+  size_t i;
+
+  tuner.seekingSamples = 0;
+  tuner.run (&processor, threshold, interval);
+  double start = now ();
+  processor.start ();
+  while (!tuner.done ())
+    usleep (10000);
+  processor.stop ();
+  double elapsed = now () - start;
+
+  for (i = 0; i < tuner.results.size (); i++) {
+    seekResult &r = tuner.results[i];
+    int32_t expected = expected_station (stations, r.start, step);
+
+    if (r.found == -1)
+      r.result = NOT_FOUND;
+    else if (station_at (stations, r.found, step) == -1)
+      r.result = FALSE_POSITIVE;
+    else if (station_at (stations, r.found, step) == expected)
+      r.result = HIT;
+    else
+      r.result = SKIPPED;
+    counts[r.result]++;
+    if (r.found != -1)
+      latencies.push_back (r.latency * 1000.0 / INPUT_RATE);
+    if (verbose)
+      fprintf (stderr, "threshold %d, interval %d: from %d expected %d "
+          "found %d after %.1f ms\n", threshold, interval, r.start,
+          expected, r.found, r.latency * 1000.0 / INPUT_RATE);
+  }
+
+  int seeks = tuner.results.size ();
+  double seconds = tuner.seekingSamples / (double) INPUT_RATE;
+  printf ("{\"threshold\": %d, \"interval_ms\": %d, \"seeks\": %d, "
+      "\"hits\": %d, \"false_positives\": %d, \"skipped\": %d, "
+      "\"not_found\": %d, \"fp_rate\": %.3f, \"fn_rate\": %.3f, "
+      "\"latency_ms\": {\"p50\": %.1f, \"p90\": %.1f, \"max\": %.1f}, "
+      "\"stations_per_second\": %.3f, \"realtime\": %.2f}\n",
+      threshold, interval, seeks, counts[HIT], counts[FALSE_POSITIVE],
+      counts[SKIPPED], counts[NOT_FOUND],
+      seeks ? (double) counts[FALSE_POSITIVE] / seeks : 0,
+      seeks ? (double) (counts[SKIPPED] + counts[NOT_FOUND]) / seeks : 0,
+      percentile (latencies, 50), percentile (latencies, 90),
+      percentile (latencies, 100),
+      seconds > 0 ? counts[HIT] / seconds : 0,
+      tuner.samplesPlayed () / (double) INPUT_RATE / elapsed);
+  fflush (stdout);
+}
+
+/* up to n samples of a recording, or of the generator */
+static bool
+load (virtualInput *source, std::vector<DSPCOMPLEX> &iq, int32_t n)
+{
+  sampleBlock block (BLOCK);
+  int32_t i, got, j;
+
+  iq.clear ();
+  source->restartReader ();
+  for (i = 0; i < n; i += got) {
+    got = source->getSamples (&block, n - i < BLOCK ? n - i : BLOCK, 0);
+    if (got <= 0)
+      break;
+    for (j = 0; j < got; j++)
+      iq.push_back (DSPCOMPLEX (block.I[j], block.Q[j]));
+  }
+  return iq.size () >= BLOCK;
+}
+
+static bool
+read_capture_set (const char *name, int32_t n, std::vector<capture> &captures,
+    std::vector<int32_t> &stations)
+{
+  FILE *f = fopen (name, "r");
+  char line[1024], file[1024];
+  int frequency;
+  bool ok = true;
+
+  if (f == NULL) {
+    fprintf (stderr, "Could not open %s\n", name);
+    return false;
+  }
+  while (ok && fgets (line, sizeof (line), f) != NULL) {
+    if (sscanf (line, "capture %d %1023s", &frequency, file) == 2) {
+      capture c;
+      fileReader reader (file, INPUT_RATE, false, &ok);
+      c.centre = frequency;
+      if (!ok || !load (&reader, c.iq, n)) {
+        fprintf (stderr, "Could not load %s\n", file);
+        ok = false;
+      }
+      captures.push_back (c);
+    }
+    else if (sscanf (line, "station %d", &frequency) == 1)
+      stations.push_back (frequency);
+  }
+  fclose (f);
+  return ok;
+}
+
+/* captures every 500 KHz over the band; the generator sends the
+ * first station as the main one, in stereo, the others as adjacent
+ * ones, each with a mono tone */
+static bool
+generate_capture_set (int32_t minimum, int32_t maximum, int32_t snr,
+    int32_t n, std::vector<capture> &captures,
+    const std::vector<int32_t> &stations)
+{
+  char spec[1024];
+  int32_t centre;
+  size_t i;
+  bool ok;
+
+  snprintf (spec, sizeof (spec), "frequency=%d;snr=%d;rds=0;paced=0;adjacent=",
+      stations[0], snr);
+  for (i = 1; i < stations.size (); i++)
+    snprintf (spec + strlen (spec), sizeof (spec) - strlen (spec), "%s%d",
+        i > 1 ? ":" : "", stations[i] - stations[0]);
+
+  for (centre = minimum; centre < maximum + 250000; centre += 500000) {
+    signalGenerator generator (spec, INPUT_RATE, &ok);
+    capture c;
+    if (!ok)
+      return false;
+    generator.setVFOFrequency (centre);
+    c.centre = centre;
+    if (!load (&generator, c.iq, n))
+      return false;
+    captures.push_back (c);
+  }
+  return true;
+}
+
+static void
+parse_list (const char *s, char separator, std::vector<int32_t> &list)
+{
+  char *end;
+
+  list.clear ();
+  while (*s != 0) {
+    list.push_back (strtol (s, &end, 10));
+    if (*end != separator)
+      break;
+    s = end + 1;
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *captureSet = NULL;
+  std::vector<capture> captures;
+  std::vector<int32_t> stations, thresholds, intervals;
+  int32_t minimum = 96000000, maximum = 99000000, step = 100000;
+  int32_t snr = 30;
+  double seconds = 1, stale = 15, settle = 5;
+  bool verbose = false;
+  size_t t, i;
+  int opt;
+
+  parse_list ("96400000:97100000:97500000:98300000:98800000", ':',
+      stations);
+  parse_list ("15,20,25,30", ',', thresholds);
+  parse_list ("20,50,100", ',', intervals);
+
+  while ((opt = getopt (argc, argv, "c:x:n:m:M:f:t:i:s:S:G:v")) != -1) {
+    switch (opt) {
+      case 'c': captureSet = optarg; break;
+      case 'x': parse_list (optarg, ':', stations); break;
+      case 'n': snr = atoi (optarg); break;
+      case 'm': minimum = atoi (optarg); break;
+      case 'M': maximum = atoi (optarg); break;
+      case 'f': step = atoi (optarg); break;
+      case 't': parse_list (optarg, ',', thresholds); break;
+      case 'i': parse_list (optarg, ',', intervals); break;
+      case 's': seconds = atof (optarg); break;
+      case 'S': stale = atof (optarg); break;
+      case 'G': settle = atof (optarg); break;
+      case 'v': verbose = true; break;
+      default:
+        fprintf (stderr, "usage: %s [-c capture-set | -x station:... -n snr]"
+            " [-m minimum] [-M maximum] [-f step]\n"
+            "          [-t threshold,...] [-i interval,...] [-s seconds]"
+            " [-S stale-ms] [-G settle-ms] [-v]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  int32_t n = (int32_t) (seconds * INPUT_RATE);
+  if (captureSet != NULL) {
+    stations.clear ();
+    if (!read_capture_set (captureSet, n, captures, stations))
+      return 1;
+  }
+  else if (stations.empty () ||
+      !generate_capture_set (minimum, maximum, snr, n, captures, stations)) {
+    fprintf (stderr, "Could not generate the captures\n");
+    return 1;
+  }
+  /* only the stations in the band can be found */
+  std::sort (stations.begin (), stations.end ());
+  for (i = 0; i < stations.size (); )
+    if (stations[i] < minimum || stations[i] > maximum)
+      stations.erase (stations.begin () + i);
+    else
+      i++;
+
+  if (captures.empty () || step <= 0 || maximum < minimum) {
+    fprintf (stderr, "Nothing to seek through\n");
+    return 1;
+  }
+  /* every frequency of the band has to be within reach of a capture */
+  for (int32_t f = minimum; f <= maximum; f += step) {
+    for (i = 0; i < captures.size (); i++)
+      if (abs (captures[i].centre - f) <= MAX_SHIFT)
+        break;
+    if (i == captures.size ()) {
+      fprintf (stderr, "No capture covers %d Hz\n", f);
+      return 1;
+    }
+  }
+
+  for (t = 0; t < thresholds.size (); t++)
+    for (i = 0; i < intervals.size (); i++)
+      run (captures, stations, minimum, maximum, step, thresholds[t],
+          intervals[i], stale * INPUT_RATE / 1000,
+          settle * INPUT_RATE / 1000, verbose);
+  return 0;
+}
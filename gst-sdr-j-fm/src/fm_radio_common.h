@@ -36,3 +36,4 @@
 #define SIGNAL_ON_RDS_CLEAR         "onrdsclear"
 #define SIGNAL_ON_RDS_CHANGE        "onrdschange"
 #define SIGNAL_ON_RDS_COMPLETE      "onrdscomplete"
+#define SIGNAL_ON_RECEPTION         "onreception"
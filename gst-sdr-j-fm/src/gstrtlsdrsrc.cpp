@@ -0,0 +1,343 @@
+/* GStreamer
+ * Copyright (C) Collabora Ltd. <info@collabora.com>
+ *
+ * gstrtlsdrsrc.cpp:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-rtlsdrsrc
+ *
+ * This element captures the I/Q samples of an RTL-SDR dongle.
+ *
+ * <refsect2>
+ * <title>Example pipelines</title>
+ * |[
+ * gst-launch-1.0 rtlsdrsrc frequency=97700000 ! queue ! sdrjfmdemod ! pulsesink
+ * ]| will playback live FM radio channel 97.7.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstrtlsdrsrc.h"
+#include "gstsdrjfmdemod.h"
+#include "fm_radio_common.h"
+#include "dabstick-dll.h"
+
+GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
+#define GST_CAT_DEFAULT sdrjfm_debug
+
+/* the samples pushed at a time, a block of the fmProcessor */
+#define BLOCK_SAMPLES               16384
+/* the capture times take this fraction of their offset from the
+ * times the samples come in at each block, all of it after a stall */
+#define CAPTURE_SLEW                  256
+#define CAPTURE_RESYNC          (50 * GST_MSECOND)
+
+enum
+{
+  PROP_0,
+  PROP_FREQUENCY
+};
+
+#define gst_rtlsdr_src_parent_class parent_class
+
+extern "C" {
+G_DEFINE_TYPE (GstRtlsdrSrc, gst_rtlsdr_src, GST_TYPE_PUSH_SRC);
+}
+
+static GstStaticPadTemplate rtlsdrsrc_src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-iq, "
+        "format = (string) " GST_AUDIO_NE (F32) ", "
+        "rate = (int) 1058400")
+    );
+
+/* Called on the USB thread of the dongle after each transfer */
+static void
+gst_rtlsdr_src_samples_arrived (void *user_data)
+{
+  GstRtlsdrSrc *self = GST_RTLSDR_SRC (user_data);
+
+  g_mutex_lock (&self->samples_lock);
+  g_cond_broadcast (&self->samples_cond);
+  g_mutex_unlock (&self->samples_lock);
+}
+
+/* The duration of \a samples of the dongle, in ns */
+static gint64
+gst_rtlsdr_src_capture_ns (gint64 samples)
+{
+  return gst_util_uint64_scale_int (samples, GST_SECOND, SDRJFM_INPUT_RATE);
+}
+
+/* The running time capture index \a position was captured at, or
+ * GST_CLOCK_TIME_NONE.  The count of the samples captured follows the
+ * monotonic time they come in at, as in sdrjfmsrc, and goes with the
+ * clock of the element from there. */
+static GstClockTime
+gst_rtlsdr_src_capture_timestamp (GstRtlsdrSrc * self, gint64 position)
+{
+  GstClock *clock;
+  GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+  gint64 captured, arrived, base, capture;
+
+  if (!self->stick->captureTime (&captured, &arrived))
+    return GST_CLOCK_TIME_NONE;
+  clock = gst_element_get_clock (GST_ELEMENT (self));
+  if (!clock)
+    return GST_CLOCK_TIME_NONE;
+
+  base = arrived - gst_rtlsdr_src_capture_ns (captured);
+  if (self->capture_base == G_MININT64
+      || ABS (base - self->capture_base) > (gint64) CAPTURE_RESYNC)
+    self->capture_base = base;
+  else
+    self->capture_base += (base - self->capture_base) / CAPTURE_SLEW;
+
+  capture = self->capture_base + gst_rtlsdr_src_capture_ns (position)
+      + (gint64) gst_clock_get_time (clock) - g_get_monotonic_time () * 1000
+      - (gint64) gst_element_get_base_time (GST_ELEMENT (self));
+  if (capture >= 0)
+    timestamp = capture;
+  gst_object_unref (clock);
+
+  return timestamp;
+}
+
+static GstFlowReturn
+gst_rtlsdr_src_create (GstPushSrc * src, GstBuffer ** buf)
+{
+  GstRtlsdrSrc *self = GST_RTLSDR_SRC (src);
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint64 position;
+  gint n;
+
+  g_mutex_lock (&self->samples_lock);
+  while (self->stick->Samples () < BLOCK_SAMPLES && !self->flushing)
+    g_cond_wait (&self->samples_cond, &self->samples_lock);
+  if (self->flushing)
+    {
+      g_mutex_unlock (&self->samples_lock);
+      return GST_FLOW_FLUSHING;
+    }
+  g_mutex_unlock (&self->samples_lock);
+
+  buffer = gst_buffer_new_allocate (NULL,
+      BLOCK_SAMPLES * sizeof (DSPCOMPLEX), NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  position = self->stick->capturePosition ();
+  n = self->stick->getSamples ((DSPCOMPLEX *) map.data, BLOCK_SAMPLES);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_set_size (buffer, n * sizeof (DSPCOMPLEX));
+
+  GST_BUFFER_PTS (buffer) = gst_rtlsdr_src_capture_timestamp (self, position);
+  GST_BUFFER_DURATION (buffer) = gst_rtlsdr_src_capture_ns (n);
+  GST_BUFFER_OFFSET (buffer) = position;
+  GST_BUFFER_OFFSET_END (buffer) = position + n;
+  /* the samples the dongle dropped move the position on */
+  if (position != self->next_offset)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  self->next_offset = position + n;
+
+  *buf = buffer;
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_rtlsdr_src_start (GstBaseSrc * src)
+{
+  GstRtlsdrSrc *self = GST_RTLSDR_SRC (src);
+  bool success;
+
+  GST_DEBUG_OBJECT (self, "Opening the dongle...");
+  self->stick = new dabstick_dll (SDRJFM_INPUT_RATE, &success);
+  if (!success)
+    {
+      delete self->stick;
+      self->stick = NULL;
+      GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ,
+          ("Could not open the dongle"), (NULL));
+      return FALSE;
+    }
+
+  GST_OBJECT_LOCK (self);
+  self->stick->setVFOFrequency (self->frequency);
+  GST_OBJECT_UNLOCK (self);
+
+  self->stick->setSamplesCallback (gst_rtlsdr_src_samples_arrived, self);
+  if (!self->stick->restartReader ())
+    {
+      delete self->stick;
+      self->stick = NULL;
+      GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ,
+          ("Could not start reading the dongle"), (NULL));
+      return FALSE;
+    }
+
+  self->capture_base = G_MININT64;
+  self->next_offset = -1;
+  return TRUE;
+}
+
+static gboolean
+gst_rtlsdr_src_stop (GstBaseSrc * src)
+{
+  GstRtlsdrSrc *self = GST_RTLSDR_SRC (src);
+
+  GST_DEBUG_OBJECT (self, "Closing the dongle...");
+  self->stick->stopReader ();
+
+  GST_OBJECT_LOCK (self);
+  delete self->stick;
+  self->stick = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtlsdr_src_unlock (GstBaseSrc * src)
+{
+  GstRtlsdrSrc *self = GST_RTLSDR_SRC (src);
+
+  g_mutex_lock (&self->samples_lock);
+  self->flushing = TRUE;
+  g_cond_broadcast (&self->samples_cond);
+  g_mutex_unlock (&self->samples_lock);
+  return TRUE;
+}
+
+static gboolean
+gst_rtlsdr_src_unlock_stop (GstBaseSrc * src)
+{
+  GstRtlsdrSrc *self = GST_RTLSDR_SRC (src);
+
+  g_mutex_lock (&self->samples_lock);
+  self->flushing = FALSE;
+  g_mutex_unlock (&self->samples_lock);
+  return TRUE;
+}
+
+static void
+gst_rtlsdr_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtlsdrSrc *self = GST_RTLSDR_SRC (object);
+
+  GST_OBJECT_LOCK (self);
+
+  switch (prop_id) {
+    case PROP_FREQUENCY:
+      self->frequency = g_value_get_int (value);
+      if (self->stick)
+        self->stick->setVFOFrequency (self->frequency);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_rtlsdr_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtlsdrSrc *self = GST_RTLSDR_SRC (object);
+
+  GST_OBJECT_LOCK (self);
+
+  switch (prop_id) {
+    case PROP_FREQUENCY:
+      g_value_set_int (value, self->frequency);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_rtlsdr_src_finalize (GstRtlsdrSrc * self)
+{
+  g_cond_clear (&self->samples_cond);
+  g_mutex_clear (&self->samples_lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (self));
+}
+
+static void
+gst_rtlsdr_src_init (GstRtlsdrSrc * self)
+{
+  self->stick = NULL;
+  self->frequency = FM_RADIO_SERVICE_DEF_FREQ;
+  self->flushing = FALSE;
+  g_mutex_init (&self->samples_lock);
+  g_cond_init (&self->samples_cond);
+  self->capture_base = G_MININT64;
+  self->next_offset = -1;
+
+  gst_base_src_set_live (GST_BASE_SRC (self), TRUE);
+  gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
+}
+
+static void
+gst_rtlsdr_src_class_init (GstRtlsdrSrcClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseSrcClass *gstbasesrc_class;
+  GstPushSrcClass *gstpushsrc_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gstelement_class = (GstElementClass *) klass;
+  gstbasesrc_class = (GstBaseSrcClass *) klass;
+  gstpushsrc_class = (GstPushSrcClass *) klass;
+
+  gobject_class->get_property = gst_rtlsdr_src_get_property;
+  gobject_class->set_property = gst_rtlsdr_src_set_property;
+  gobject_class->finalize = (GObjectFinalizeFunc) gst_rtlsdr_src_finalize;
+
+  gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_rtlsdr_src_start);
+  gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_rtlsdr_src_stop);
+  gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_rtlsdr_src_unlock);
+  gstbasesrc_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_rtlsdr_src_unlock_stop);
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_rtlsdr_src_create);
+
+  g_object_class_install_property (gobject_class, PROP_FREQUENCY,
+      g_param_spec_int ("frequency", "Frequency",
+          "Frequency to receive", 0, G_MAXINT, FM_RADIO_SERVICE_DEF_FREQ,
+    static_cast<GParamFlags>(G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING | G_PARAM_STATIC_STRINGS)));
+
+  gst_element_class_set_static_metadata (gstelement_class, "RTL-SDR Source",
+      "Source/Hardware",
+      "Capture the I/Q samples of an RTL-SDR dongle",
+      "Collabora <info@collabora.com>");
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&rtlsdrsrc_src_factory));
+}
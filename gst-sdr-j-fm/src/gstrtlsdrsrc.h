@@ -0,0 +1,76 @@
+/* GStreamer
+ * Copyright (C) Collabora Ltd. <info@collabora.com>
+ *
+ * gstrtlsdrsrc.h:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTLSDR_SRC_H__
+#define __GST_RTLSDR_SRC_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstpushsrc.h>
+
+class dabstick_dll;
+
+typedef struct _GstRtlsdrSrcClass GstRtlsdrSrcClass;
+
+/** \brief The RTL-SDR I/Q source element.
+ *
+ * Captures the I/Q samples of the dongle, tuned to a frequency, at
+ * the input rate of `sdrjfmdemod`.  The samples are pushed as native
+ * endian floats, in buffers of 16384 pairs, timestamped with the
+ * running time they are captured at, as found from the dongle's count
+ * of them.  The offsets of the buffers are in that count, a buffer
+ * after samples the dongle dropped is marked DISCONT.  The correction
+ * of the dongle's crystal that `sdrjfmsrc` found and stored is
+ * applied.
+ */
+struct GstRtlsdrSrc {
+  GstPushSrc parent;
+
+  dabstick_dll *stick;
+  gint frequency;
+  /** Signalled by the dongle as samples come in, and on unlock */
+  GCond samples_cond;
+  /** Set while unlocked, to give up waiting for the samples.  Under
+   * `samples_lock`, as the wait is. */
+  gboolean flushing;
+  GMutex samples_lock;
+  /** The monotonic time, in ns, of capture index 0, following the
+   * times the samples come in at; G_MININT64 until found */
+  gint64 capture_base;
+  /** The capture index the next buffer starts at if none is dropped,
+   * -1 before the first */
+  gint64 next_offset;
+};
+
+struct _GstRtlsdrSrcClass {
+  GstPushSrcClass parent_class;
+};
+
+extern "C" {
+
+#define GST_TYPE_RTLSDR_SRC           (gst_rtlsdr_src_get_type())
+#define GST_RTLSDR_SRC(obj)           (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RTLSDR_SRC,GstRtlsdrSrc))
+#define GST_IS_RTLSDR_SRC(obj)        (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RTLSDR_SRC))
+
+GType gst_rtlsdr_src_get_type(void);
+
+}
+
+#endif /* __GST_RTLSDR_SRC_H__ */
@@ -22,6 +22,10 @@
 #endif
 
 #include "gstsdrjfmsrc.h"
+#include "gstsdrjfmdemod.h"
+#include "gstrtlsdrsrc.h"
+#include "gstsdrjfmtracer.h"
+#include "dsp-kernels.h"
 
 extern "C" {
 
@@ -34,8 +38,26 @@ plugin_init (GstPlugin * plugin)
           GST_TYPE_SDRJFM_SRC))
     return FALSE;
 
+  /* the same radio split in two, to put elements in between */
+  if (!gst_element_register (plugin, "rtlsdrsrc", GST_RANK_NONE,
+          GST_TYPE_RTLSDR_SRC))
+    return FALSE;
+
+  if (!gst_element_register (plugin, "sdrjfmdemod", GST_RANK_NONE,
+          GST_TYPE_SDRJFM_DEMOD))
+    return FALSE;
+
+#if GST_CHECK_VERSION(1, 8, 0)
+  /* GST_TRACERS=sdrjfm times the stages of the demodulation */
+  if (!gst_tracer_register (plugin, "sdrjfm", GST_TYPE_SDRJFM_TRACER))
+    return FALSE;
+#endif
+
   GST_DEBUG_CATEGORY_INIT (sdrjfm_debug, "sdrjfm", 0, "SDR-J FM plugin");
 
+  /* Pick the DSP kernels for this CPU now rather than on first use */
+  GST_CAT_INFO (sdrjfm_debug, "Using %s DSP kernels", getKernels ()->name);
+
   return TRUE;
 }
 
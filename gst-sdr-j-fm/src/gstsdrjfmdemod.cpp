@@ -0,0 +1,592 @@
+/* GStreamer
+ * Copyright (C) Collabora Ltd. <info@collabora.com>
+ *
+ * gstsdrjfmdemod.cpp:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-sdrjfmdemod
+ *
+ * This element demodulates the I/Q samples of an FM station.
+ *
+ * <refsect2>
+ * <title>Example pipelines</title>
+ * |[
+ * gst-launch-1.0 filesrc location=station.cu8 ! audio/x-iq,format=U8,rate=1058400 ! sdrjfmdemod ! wavenc ! filesink location=station.wav
+ * ]| will demodulate a recording of the dongle as fast as it can.
+ * |[
+ * gst-launch-1.0 rtlsdrsrc frequency=97700000 ! queue ! sdrjfmdemod ! pulsesink
+ * ]| will playback live FM radio channel 97.7, the capture and the
+ * demodulation on threads of their own.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstsdrjfmdemod.h"
+#include "fm-processor.h"
+#include "audiosink.h"
+#include "ringbuffer.h"
+#include "sample-block.h"
+#include "virtual-input.h"
+
+GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
+#define GST_CAT_DEFAULT sdrjfm_debug
+
+#define DEFAULT_STEREO               TRUE
+
+/* the samples the fmProcessor takes at a time */
+#define PROCESSOR_BLOCK             16384
+/* the samples waiting for the processor, four of its blocks */
+#define INPUT_SIZE                  (4 * PROCESSOR_BLOCK)
+/* the frames of audio pushed at a time, at most */
+#define DRAIN_FRAMES                 4096
+/* the latency added: a block is filled before it is demodulated, and
+ * its audio is pushed once the next one is in, at most four blocks
+ * wait for the processor next to the one it has */
+#define MIN_LATENCY     (gst_util_uint64_scale_int (2 * PROCESSOR_BLOCK, \
+                             GST_SECOND, SDRJFM_INPUT_RATE))
+#define MAX_LATENCY     (gst_util_uint64_scale_int (INPUT_SIZE + \
+                             PROCESSOR_BLOCK, GST_SECOND, SDRJFM_INPUT_RATE))
+
+enum
+{
+  PROP_0,
+  PROP_STEREO
+};
+
+/* The input of the processor, filled by the streaming thread.  The
+ * processor asks for the samples available before each block, when
+ * all audio of the previous one is in the sink, and sleeps while
+ * there is less than a block.  While flushing it is told there is
+ * none. */
+class demodInput : public virtualInput
+{
+public:
+  demodInput (void)
+    : samples (INPUT_SIZE), starved (false), flushing (false)
+  {
+    g_mutex_init (&lock);
+    g_cond_init (&cond);
+  }
+
+  ~demodInput (void)
+  {
+    g_mutex_clear (&lock);
+    g_cond_clear (&cond);
+  }
+
+  /* Puts the samples in, waiting for room while not flushing.  False
+   * when flushing. */
+  bool put (const DSPCOMPLEX *v, gint n)
+  {
+    gint room;
+
+    g_mutex_lock (&lock);
+    while (n > 0 && !flushing)
+      {
+        room = samples.GetRingBufferWriteAvailable ();
+        if (room == 0)
+          {
+            g_cond_wait (&cond, &lock);
+            continue;
+          }
+        if (room > n)
+          room = n;
+        samples.putDataIntoBuffer (v, room);
+        starved = false;
+        v += room;
+        n -= room;
+      }
+    g_mutex_unlock (&lock);
+
+    return n == 0;
+  }
+
+  /* Waits for the processor to have taken all whole blocks and to be
+   * done with them. False when flushing. */
+  bool finish (void)
+  {
+    bool done;
+
+    g_mutex_lock (&lock);
+    while (!starved && !flushing)
+      g_cond_wait (&cond, &lock);
+    done = !flushing;
+    g_mutex_unlock (&lock);
+
+    return done;
+  }
+
+  void setFlushing (bool f)
+  {
+    g_mutex_lock (&lock);
+    flushing = f;
+    g_cond_broadcast (&cond);
+    g_mutex_unlock (&lock);
+  }
+
+  /* Ends the flushing: waits for the processor to be done with the
+   * block it has, so that all of its audio is in the sink, and throws
+   * the samples still waiting away. */
+  void flush (void)
+  {
+    g_mutex_lock (&lock);
+    starved = false;
+    while (!starved)
+      g_cond_wait (&cond, &lock);
+    samples.FlushRingBuffer ();
+    flushing = false;
+    g_cond_broadcast (&cond);
+    g_mutex_unlock (&lock);
+  }
+
+  int32_t Samples (void)
+  {
+    int32_t n;
+
+    g_mutex_lock (&lock);
+    n = flushing ? 0 : samples.GetRingBufferReadAvailable ();
+    if (n < PROCESSOR_BLOCK)
+      {
+        starved = true;
+        g_cond_broadcast (&cond);
+      }
+    g_mutex_unlock (&lock);
+
+    return n;
+  }
+
+  int32_t getSamples (sampleBlock *b, int32_t size, uint8_t mode)
+  {
+    DSPCOMPLEX v[PROCESSOR_BLOCK];
+
+    (void) mode;
+    if (size > b->size)
+      size = b->size;
+    if (size > PROCESSOR_BLOCK)
+      size = PROCESSOR_BLOCK;
+
+    /* there is room for the streaming thread again */
+    g_mutex_lock (&lock);
+    size = samples.getDataFromBuffer (v, size);
+    g_cond_broadcast (&cond);
+    g_mutex_unlock (&lock);
+
+    b->fromInterleaved (v, size);
+
+    return size;
+  }
+
+private:
+  RingBuffer<DSPCOMPLEX> samples;
+  GMutex lock;
+  GCond cond;
+  /* the processor found less than a block since the last put */
+  bool starved;
+  bool flushing;
+};
+
+#define gst_sdrjfm_demod_parent_class parent_class
+
+extern "C" {
+G_DEFINE_TYPE (GstSdrjfmDemod, gst_sdrjfm_demod, GST_TYPE_ELEMENT);
+}
+
+static GstStaticPadTemplate sdrjfmdemod_sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (SDRJFM_IQ_CAPS)
+    );
+
+static GstStaticPadTemplate sdrjfmdemod_src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-raw, "
+        "format = (string) " GST_AUDIO_NE(F32) ", "
+        "layout = (string) interleaved, "
+        "rate = (int) 44100, "
+        "channels = (int) 2; ")
+    );
+
+/* Pushes the audio the processor has put in the sink so far */
+static GstFlowReturn
+gst_sdrjfm_demod_drain (GstSdrjfmDemod * self)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buffer;
+  gint n;
+
+  if (self->segment_pending)
+    {
+      gst_pad_push_event (self->srcpad,
+          gst_event_new_segment (&self->segment));
+      self->segment_pending = FALSE;
+    }
+
+  while (ret == GST_FLOW_OK && self->sink->waiting () > 0)
+    {
+      n = self->sink->getSamples (self->audio, 2 * DRAIN_FRAMES) / 2;
+      if (n <= 0)
+        break;
+
+      buffer = gst_buffer_new_allocate (NULL, 2 * n * sizeof (gfloat), NULL);
+      gst_buffer_fill (buffer, 0, self->audio, 2 * n * sizeof (gfloat));
+      /* the input rate is a multiple of the audio rate, the audio goes
+       * with the input counted from its first sample */
+      GST_BUFFER_PTS (buffer) = self->base_pts +
+          gst_util_uint64_scale (self->frames, GST_SECOND, SDRJFM_AUDIO_RATE);
+      GST_BUFFER_DURATION (buffer) = self->base_pts +
+          gst_util_uint64_scale (self->frames + n, GST_SECOND,
+          SDRJFM_AUDIO_RATE) - GST_BUFFER_PTS (buffer);
+      GST_BUFFER_OFFSET (buffer) = self->frames;
+      GST_BUFFER_OFFSET_END (buffer) = self->frames + n;
+      if (self->frames == 0)
+        GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+      self->frames += n;
+
+      ret = gst_pad_push (self->srcpad, buffer);
+    }
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_sdrjfm_demod_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstSdrjfmDemod *self = GST_SDRJFM_DEMOD (parent);
+  DSPCOMPLEX v[PROCESSOR_BLOCK];
+  GstMapInfo map;
+  gsize i, n, done, size;
+  gboolean put = TRUE;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  /* the audio is timestamped from the first sample since starting or
+   * flushing, or from the start of the segment if it has none */
+  if (!GST_CLOCK_TIME_IS_VALID (self->base_pts))
+    self->base_pts = GST_BUFFER_PTS_IS_VALID (buffer) ?
+        GST_BUFFER_PTS (buffer) : self->segment.start;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  size = self->float_samples ? sizeof (DSPCOMPLEX) : 2;
+  n = map.size / size;
+
+  for (done = 0; put && ret == GST_FLOW_OK && done < n; done += i)
+    {
+      if (self->float_samples)
+        {
+          i = MIN (n - done, PROCESSOR_BLOCK);
+          memcpy (v, map.data + done * size, i * size);
+        }
+      else
+        for (i = 0; i < n - done && i < PROCESSOR_BLOCK; i++)
+          {
+            const guint8 *p = map.data + (done + i) * size;
+            v[i] = DSPCOMPLEX ((float (p[0] - 128)) / 128.0,
+                (float (p[1] - 128)) / 128.0);
+          }
+      put = self->input->put (v, i);
+      /* a large buffer does not fill the sink */
+      if (put)
+        ret = gst_sdrjfm_demod_drain (self);
+    }
+
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  if (!put)
+    return GST_FLOW_FLUSHING;
+
+  return ret;
+}
+
+static gboolean
+gst_sdrjfm_demod_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstSdrjfmDemod *self = GST_SDRJFM_DEMOD (parent);
+
+  switch (GST_EVENT_TYPE (event))
+    {
+    case GST_EVENT_CAPS:
+      {
+        GstCaps *caps;
+        const gchar *format;
+
+        gst_event_parse_caps (event, &caps);
+        format = gst_structure_get_string (gst_caps_get_structure (caps, 0),
+            "format");
+        self->float_samples = g_strcmp0 (format, "U8") != 0;
+        gst_event_unref (event);
+
+        caps = gst_static_pad_template_get_caps (&sdrjfmdemod_src_factory);
+        gst_pad_push_event (self->srcpad, gst_event_new_caps (caps));
+        gst_caps_unref (caps);
+        return TRUE;
+      }
+
+    case GST_EVENT_SEGMENT:
+      {
+        GstSegment segment;
+
+        /* the audio is timestamped in a time segment, the bytes of a
+         * recording start it at 0 */
+        gst_event_copy_segment (event, &segment);
+        if (segment.format == GST_FORMAT_TIME)
+          self->segment = segment;
+        else
+          gst_segment_init (&self->segment, GST_FORMAT_TIME);
+        self->segment_pending = TRUE;
+        gst_event_unref (event);
+        return TRUE;
+      }
+
+    case GST_EVENT_EOS:
+      /* the audio of the last whole block goes out ahead of the eos */
+      if (self->input->finish ())
+        gst_sdrjfm_demod_drain (self);
+      break;
+
+    case GST_EVENT_FLUSH_START:
+      self->input->setFlushing (true);
+      break;
+
+    case GST_EVENT_FLUSH_STOP:
+      /* the samples and the audio from before are thrown away, the
+       * stream starts again with the next segment */
+      self->input->flush ();
+      self->sink->flush ();
+      self->frames = 0;
+      self->base_pts = GST_CLOCK_TIME_NONE;
+      gst_segment_init (&self->segment, GST_FORMAT_TIME);
+      self->segment_pending = TRUE;
+      break;
+
+    default:
+      break;
+    }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+/* Adds the time the samples wait for the processor to the latency */
+static gboolean
+gst_sdrjfm_demod_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstSdrjfmDemod *self = GST_SDRJFM_DEMOD (parent);
+  GstClockTime min, max;
+  gboolean live;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_LATENCY)
+    return gst_pad_query_default (pad, parent, query);
+
+  if (!gst_pad_peer_query (self->sinkpad, query))
+    return FALSE;
+
+  gst_query_parse_latency (query, &live, &min, &max);
+  min += MIN_LATENCY;
+  if (GST_CLOCK_TIME_IS_VALID (max))
+    max += MAX_LATENCY;
+  gst_query_set_latency (query, live, min, max);
+
+  return TRUE;
+}
+
+static void
+gst_sdrjfm_demod_start (GstSdrjfmDemod * self)
+{
+  self->input = new demodInput ();
+  self->sink = new audioSink ();
+  self->processor = new fmProcessor (self->input, NULL, self->sink,
+      SDRJFM_INPUT_RATE, SDRJFM_FM_RATE, SDRJFM_AUDIO_RATE, 20);
+  self->processor->setfmMode (self->stereo);
+  self->frames = 0;
+  self->base_pts = GST_CLOCK_TIME_NONE;
+  gst_segment_init (&self->segment, GST_FORMAT_TIME);
+  self->segment_pending = TRUE;
+
+  GST_DEBUG_OBJECT (self, "Starting processor...");
+  self->processor->start ();
+}
+
+static void
+gst_sdrjfm_demod_stop (GstSdrjfmDemod * self)
+{
+  GST_DEBUG_OBJECT (self, "Stopping processor...");
+  self->processor->stop ();
+
+  delete self->processor;
+  delete self->sink;
+  delete self->input;
+  self->processor = NULL;
+  self->sink = NULL;
+  self->input = NULL;
+}
+
+static GstStateChangeReturn
+gst_sdrjfm_demod_change_state (GstElement * element, GstStateChange transition)
+{
+  GstSdrjfmDemod *self = GST_SDRJFM_DEMOD (element);
+  GstStateChangeReturn ret;
+
+  switch (transition)
+    {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_sdrjfm_demod_start (self);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* a chain waiting for room gives up */
+      self->input->setFlushing (true);
+      break;
+    default:
+      break;
+    }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition)
+    {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_sdrjfm_demod_stop (self);
+      break;
+    default:
+      break;
+    }
+
+  return ret;
+}
+
+static void
+gst_sdrjfm_demod_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSdrjfmDemod *self = GST_SDRJFM_DEMOD (object);
+
+  GST_OBJECT_LOCK (self);
+
+  switch (prop_id) {
+    case PROP_STEREO:
+      self->stereo = g_value_get_boolean (value);
+      if (self->processor)
+        self->processor->setfmMode (self->stereo);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_sdrjfm_demod_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSdrjfmDemod *self = GST_SDRJFM_DEMOD (object);
+
+  GST_OBJECT_LOCK (self);
+
+  switch (prop_id) {
+    case PROP_STEREO:
+      g_value_set_boolean (value, self->stereo);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_sdrjfm_demod_finalize (GstSdrjfmDemod * self)
+{
+  g_free (self->audio);
+
+  G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (self));
+}
+
+static void
+gst_sdrjfm_demod_init (GstSdrjfmDemod * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sdrjfmdemod_sink_factory,
+      "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_sdrjfm_demod_chain));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_sdrjfm_demod_sink_event));
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template (&sdrjfmdemod_src_factory,
+      "src");
+  gst_pad_use_fixed_caps (self->srcpad);
+  gst_pad_set_query_function (self->srcpad,
+      GST_DEBUG_FUNCPTR (gst_sdrjfm_demod_src_query));
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->float_samples = FALSE;
+  self->stereo = DEFAULT_STEREO;
+  self->input = NULL;
+  self->sink = NULL;
+  self->processor = NULL;
+  self->audio = g_new (gfloat, 2 * DRAIN_FRAMES);
+  self->frames = 0;
+  self->base_pts = GST_CLOCK_TIME_NONE;
+  gst_segment_init (&self->segment, GST_FORMAT_TIME);
+  self->segment_pending = TRUE;
+}
+
+static void
+gst_sdrjfm_demod_class_init (GstSdrjfmDemodClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gstelement_class = (GstElementClass *) klass;
+
+  gobject_class->finalize = (GObjectFinalizeFunc) gst_sdrjfm_demod_finalize;
+  gobject_class->get_property = gst_sdrjfm_demod_get_property;
+  gobject_class->set_property = gst_sdrjfm_demod_set_property;
+
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_sdrjfm_demod_change_state);
+
+  g_object_class_install_property (gobject_class, PROP_STEREO,
+      g_param_spec_boolean ("stereo", "Stereo",
+			    "Decode stereo when the pilot is found",
+			    DEFAULT_STEREO,
+			    static_cast<GParamFlags>(G_PARAM_READWRITE
+						     | GST_PARAM_MUTABLE_PLAYING
+						     | G_PARAM_STATIC_STRINGS)));
+
+  gst_element_class_set_static_metadata (gstelement_class, "FM Demodulator (SDR-J)",
+      "Filter/Demuxer/Audio",
+      "Demodulate the I/Q samples of an FM station",
+      "Collabora <info@collabora.com>");
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sdrjfmdemod_sink_factory));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sdrjfmdemod_src_factory));
+}
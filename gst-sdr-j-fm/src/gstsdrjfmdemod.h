@@ -0,0 +1,102 @@
+/* GStreamer
+ * Copyright (C) Collabora Ltd. <info@collabora.com>
+ *
+ * gstsdrjfmdemod.h:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_SDRJFM_DEMOD_H__
+#define __GST_SDRJFM_DEMOD_H__
+
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+
+/* the rates as set up by the RadioInterface */
+#define SDRJFM_AUDIO_RATE     44100
+#define SDRJFM_INPUT_RATE     (24 * SDRJFM_AUDIO_RATE)
+#define SDRJFM_FM_RATE        (4 * SDRJFM_AUDIO_RATE)
+
+/** The caps of the I/Q samples, as taken by `sdrjfmdemod` and given
+ * by `rtlsdrsrc`: pairs of unsigned 8-bit samples as they come from
+ * the dongle or of native endian floats, at the input rate of the
+ * demodulator
+ */
+#define SDRJFM_IQ_CAPS "audio/x-iq, " \
+    "format = (string) { U8, " GST_AUDIO_NE (F32) " }, " \
+    "rate = (int) 1058400"
+
+class demodInput;
+class audioSink;
+class fmProcessor;
+
+typedef struct _GstSdrjfmDemodClass GstSdrjfmDemodClass;
+
+/** \brief The SDR-J FM demodulator element.
+ *
+ * Demodulates the I/Q samples of an FM station, as recorded from the
+ * dongle or given by `rtlsdrsrc`, into stereo audio.  The fmProcessor
+ * runs on a thread of its own, so the demodulation runs next to the
+ * streaming thread that feeds it, and a recording is demodulated as
+ * fast as that thread goes.  The audio is timestamped from the first
+ * sample since starting or flushing, in the segment of the samples,
+ * and counted from it: it is as late as the samples are.
+ *
+ * The processor takes the samples in blocks of 16384, the last
+ * incomplete one at the end of the stream is not demodulated.
+ */
+struct GstSdrjfmDemod {
+  GstElement element;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+
+  /** Whether the samples are floats, rather than bytes */
+  gboolean float_samples;
+  /** Whether stereo is decoded, when the pilot is found */
+  gboolean stereo;
+
+  demodInput *input;
+  audioSink *sink;
+  fmProcessor *processor;
+  /** The audio taken from the sink, to be pushed */
+  gfloat *audio;
+  /** The audio frames pushed since starting or flushing */
+  guint64 frames;
+  /** The timestamp of the first sample since starting or flushing,
+   * none until it comes in */
+  GstClockTime base_pts;
+  /** The segment of the samples, as a time segment */
+  GstSegment segment;
+  /** Whether the segment is still to be pushed */
+  gboolean segment_pending;
+};
+
+struct _GstSdrjfmDemodClass {
+  GstElementClass parent_class;
+};
+
+extern "C" {
+
+#define GST_TYPE_SDRJFM_DEMOD           (gst_sdrjfm_demod_get_type())
+#define GST_SDRJFM_DEMOD(obj)           (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SDRJFM_DEMOD,GstSdrjfmDemod))
+#define GST_IS_SDRJFM_DEMOD(obj)        (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SDRJFM_DEMOD))
+
+GType gst_sdrjfm_demod_get_type(void);
+
+}
+
+#endif /* __GST_SDRJFM_DEMOD_H__ */
@@ -46,6 +46,8 @@
 #include "gstsdrjfmsrc.h"
 #include "fm_radio_common.h"
 
+#include <gst/audio/gstaudioclock.h>
+
 GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 #define GST_CAT_DEFAULT sdrjfm_debug
 
@@ -53,6 +55,39 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 #define DEFAULT_FREQUENCY_STEP     100000
 #define DEFAULT_INTERVAL              100
 #define DEFAULT_THRESHOLD              30
+#define DEFAULT_INPUT_PACED          TRUE
+#define DEFAULT_HEALTH_INTERVAL      1000
+#define DEFAULT_TELEMETRY_INTERVAL    250
+#define DEFAULT_RDS_WINDOW            100
+#define DEFAULT_AUDIO_RATE          44100
+#define DEFAULT_AUDIO_DEPTH           100
+
+/* RDS groups waiting for their audio to be pushed, about 20 seconds */
+#define RDS_GROUPS                    256
+/* 104 bits at 1187.5 bits per second */
+#define RDS_GROUP_DURATION  (GST_SECOND * 208 / 2375)
+/* blocks of multiplex waiting for their audio to be pushed, about
+ * a second and a half */
+#define MPX_BLOCKS                    256
+/* the audio frames a block of multiplex may start off from where the
+ * one before it ended, the radio dropping one is a gap of tens to
+ * hundreds of them */
+#define MPX_SLACK                       8
+/* the audio is timestamped as captured, it then waits for the input
+ * block the radio demodulates at once, and in the radio for
+ * audio-depth */
+#define CAPTURE_LATENCY         (40 * GST_MSECOND)
+/* the capture times take this fraction of their offset from the
+ * times the samples come in at each read, all of it after a stall */
+#define CAPTURE_SLEW                  256
+#define CAPTURE_RESYNC          (50 * GST_MSECOND)
+/* the samples in a USB transfer of the dongle */
+#define CAPTURE_TRANSFER             4096
+
+#define TAG_RDS_PROGRAMME_IDENTIFICATION "rds-programme-identification"
+#define TAG_RDS_PROGRAMME_TYPE           "rds-programme-type"
+#define TAG_RDS_STATION_LABEL            "rds-station-label"
+#define TAG_RDS_RADIO_TEXT               "rds-radio-text"
 
 const char DEFAULT_STATION_LABEL[9] = { '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0' };
 const char DEFAULT_RADIO_TEXT[65] = { '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0',
@@ -75,7 +110,17 @@ enum
   PROP_INTERVAL,
   PROP_THRESHOLD,
   PROP_STATION_LABEL,
-  PROP_RADIO_TEXT
+  PROP_RADIO_TEXT,
+  PROP_INPUT_LOCATION,
+  PROP_INPUT_PACED,
+  PROP_IQ_RECORD_LOCATION,
+  PROP_IQ_RECORD_DROPPED,
+  PROP_INPUT_GENERATOR,
+  PROP_HEALTH,
+  PROP_HEALTH_INTERVAL,
+  PROP_TELEMETRY_INTERVAL,
+  PROP_RDS_WINDOW,
+  PROP_AUDIO_DEPTH
 };
 
 /* signals and args */
@@ -97,15 +142,58 @@ G_DEFINE_TYPE (GstSdrjfmSrc, gst_sdrjfm_src, GST_TYPE_AUDIO_SRC);
 static GstStaticPadTemplate sdrjfmsrc_src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-raw, "
+        "format = (string) { " GST_AUDIO_NE(F32) ", " GST_AUDIO_NE(S16) " }, "
+        "layout = (string) interleaved, "
+        "rate = (int) { 44100, 48000, 32000 }, "
+        "channels = (int) [ 1, 2 ]; ")
+    );
+
+static GstStaticPadTemplate sdrjfmsrc_rds_factory = GST_STATIC_PAD_TEMPLATE ("rds",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS ("application/x-rds")
+    );
+
+static GstStaticPadTemplate sdrjfmsrc_mpx_factory = GST_STATIC_PAD_TEMPLATE ("mpx",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
     GST_STATIC_CAPS ("audio/x-raw, "
         "format = (string) " GST_AUDIO_NE(F32) ", "
         "layout = (string) interleaved, "
-        "rate = (int) 44100, "
-        "channels = (int) 2; ")
+        "rate = (int) [ 1, MAX ], "
+        "channels = (int) 1; ")
     );
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+/* The health counters of the radio, as a sdrjfmsrc-health structure.
+ * Called with the object lock held. */
+static GstStructure *
+gst_sdrjfm_src_health (GstSdrjfmSrc * self)
+{
+  healthCounters h;
+
+  if (self->radio)
+    self->radio->getHealth (&h);
+  else
+    memset (&h, 0, sizeof (h));
+
+  return gst_structure_new ("sdrjfmsrc-health",
+      "usb-short-transfers", G_TYPE_UINT64, (guint64) h.usbShortTransfers,
+      "usb-dropped-samples", G_TYPE_UINT64, (guint64) h.usbDroppedSamples,
+      "audio-dropped-frames", G_TYPE_UINT64, (guint64) h.audioDroppedFrames,
+      "audio-underruns", G_TYPE_UINT64, (guint64) h.audioUnderruns,
+      "recorder-dropped-blocks", G_TYPE_UINT64, (guint64) h.recorderDroppedBlocks,
+      "input-fill", G_TYPE_INT, h.inputFill,
+      "input-size", G_TYPE_INT, h.inputSize,
+      "audio-fill", G_TYPE_INT, h.audioFill,
+      "audio-size", G_TYPE_INT, h.audioSize,
+      "audio-rate-correction", G_TYPE_DOUBLE, (gdouble) h.audioRateCorrection,
+      "crystal-correction", G_TYPE_INT, h.crystalCorrection,
+      NULL);
+}
+
 static void
  gst_sdrjfm_src_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -139,6 +227,33 @@ static void
     case PROP_THRESHOLD:
       self->threshold = g_value_get_int (value);
       break;
+    case PROP_INPUT_LOCATION:
+      g_free (self->input_location);
+      self->input_location = g_value_dup_string (value);
+      break;
+    case PROP_INPUT_PACED:
+      self->input_paced = g_value_get_boolean (value);
+      break;
+    case PROP_IQ_RECORD_LOCATION:
+      g_free (self->iq_record_location);
+      self->iq_record_location = g_value_dup_string (value);
+      break;
+    case PROP_INPUT_GENERATOR:
+      g_free (self->input_generator);
+      self->input_generator = g_value_dup_string (value);
+      break;
+    case PROP_HEALTH_INTERVAL:
+      self->health_interval = g_value_get_uint (value);
+      break;
+    case PROP_TELEMETRY_INTERVAL:
+      self->telemetry_interval = g_value_get_uint (value);
+      break;
+    case PROP_RDS_WINDOW:
+      self->rds_window = g_value_get_uint (value);
+      break;
+    case PROP_AUDIO_DEPTH:
+      self->audio_depth = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -181,6 +296,36 @@ gst_sdrjfm_src_get_property (GObject * object, guint prop_id,
     case PROP_RADIO_TEXT:
       g_value_set_string (value, self->radio_text);
       break;
+    case PROP_INPUT_LOCATION:
+      g_value_set_string (value, self->input_location);
+      break;
+    case PROP_INPUT_PACED:
+      g_value_set_boolean (value, self->input_paced);
+      break;
+    case PROP_IQ_RECORD_LOCATION:
+      g_value_set_string (value, self->iq_record_location);
+      break;
+    case PROP_IQ_RECORD_DROPPED:
+      g_value_set_int (value, self->radio ? self->radio->recordingDropped () : 0);
+      break;
+    case PROP_INPUT_GENERATOR:
+      g_value_set_string (value, self->input_generator);
+      break;
+    case PROP_HEALTH:
+      g_value_take_boxed (value, gst_sdrjfm_src_health (self));
+      break;
+    case PROP_HEALTH_INTERVAL:
+      g_value_set_uint (value, self->health_interval);
+      break;
+    case PROP_TELEMETRY_INTERVAL:
+      g_value_set_uint (value, self->telemetry_interval);
+      break;
+    case PROP_RDS_WINDOW:
+      g_value_set_uint (value, self->rds_window);
+      break;
+    case PROP_AUDIO_DEPTH:
+      g_value_set_uint (value, self->audio_depth);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -229,16 +374,6 @@ gst_sdrjfm_src_send_bus_message(GstSdrjfmSrc *self, const char *name,
   gst_sdrjfm_src_send_bus_message (self, s);
 }
 
-static void
-gst_sdrjfm_src_send_bus_message_empty(GstSdrjfmSrc * self, const char *name)
-{
-  GstStructure *s;
-
-  s = gst_structure_new_empty (name);
-
-  gst_sdrjfm_src_send_bus_message (self, s);
-}
-
 static void
 gst_sdrjfm_src_frequency_changed (void *user_data, int32_t frequency)
 {
@@ -247,67 +382,113 @@ gst_sdrjfm_src_frequency_changed (void *user_data, int32_t frequency)
 				   "frequency", G_TYPE_INT, frequency);
 }
 
-static void
-gst_sdrjfm_src_send_bus_message_string(GstSdrjfmSrc * self, const char *name,
-				       const gchar * field_name, const gchar * field_value)
-{
-  gst_sdrjfm_src_send_bus_message (self, name,
-				   field_name, G_TYPE_STRING, field_value);
-}
-
-static void
-gst_sdrjfm_src_send_bus_message_rds_string(GstSdrjfmSrc * self, const char *event,
-					   const gchar * field_name, const gchar * field_value)
+/* The fields of the RDS events, as indexes of rds_events */
+enum
 {
-  GString * message_name = g_string_new(NULL);
-  g_string_printf(message_name, "sdrjfmsrc-rds-%s-%s", field_name, event);
-
-  gst_sdrjfm_src_send_bus_message (self, message_name->str,
-				   field_name, G_TYPE_STRING, field_value);
-
-  g_string_free (message_name, TRUE);
-}
+  RDS_STATION_LABEL,
+  RDS_RADIO_TEXT,
+  RDS_FIELDS
+};
 
-static void
-gst_sdrjfm_src_send_bus_message_rds_empty(GstSdrjfmSrc * self, const char *event,
-					  const char *field_name)
+static const struct
 {
-  GString * name = g_string_new(NULL);
-  g_string_printf(name, "sdrjfmsrc-rds-%s-%s", field_name, event);
-
-  gst_sdrjfm_src_send_bus_message_empty (self, name->str);
-
-  g_string_free (name, TRUE);
-}
+  const gchar *name;		/* of the field in the messages */
+  const gchar *clear;		/* the names of the messages */
+  const gchar *change;
+  const gchar *complete;
+  gsize size;			/* of the field, with its NUL */
+  glong offset;			/* of the property in the element */
+} rds_fields[RDS_FIELDS] = {
+  { "station-label", "sdrjfmsrc-rds-station-label-clear",
+    "sdrjfmsrc-rds-station-label-change",
+    "sdrjfmsrc-rds-station-label-complete",
+    sizeof (DEFAULT_STATION_LABEL),
+    G_STRUCT_OFFSET (GstSdrjfmSrc, station_label) },
+  { "radio-text", "sdrjfmsrc-rds-radio-text-clear",
+    "sdrjfmsrc-rds-radio-text-change",
+    "sdrjfmsrc-rds-radio-text-complete",
+    sizeof (DEFAULT_RADIO_TEXT),
+    G_STRUCT_OFFSET (GstSdrjfmSrc, radio_text) }
+};
 
-static void
-gst_sdrjfm_src_rds_clear(GstSdrjfmSrc * self, char *field, size_t field_len,
-			 const char * default_value,
-			 const char * field_name)
+/* Posts the RDS events since the last time, a clear once and only the
+ * last change and complete of each field, and sets the station-label
+ * and radio-text properties.  Runs as the rds_source, which is set to
+ * run rds-window ms after the first event it has not seen. */
+static gboolean
+gst_sdrjfm_src_rds_post (gpointer user_data)
 {
-  GST_OBJECT_LOCK (self);
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (user_data);
+  GstSdrjfmRdsEvents events, *posted;
+  GstStructure *s;
+  gint field;
 
-  strncpy (field, default_value, field_len);
+  /* events from now on set the source to run again */
+  g_source_set_ready_time (self->rds_source, -1);
+  g_atomic_int_set (&self->rds_due, FALSE);
 
-  gst_sdrjfm_src_send_bus_message_rds_empty(self, "clear", field_name);
+  for (field = 0; field < RDS_FIELDS; field++)
+    {
+      self->rds_events[field].read (&events);
+      posted = &self->rds_posted[field];
+
+      if (events.clears != posted->clears)
+	gst_element_post_message (GST_ELEMENT (self),
+	    gst_message_new_element (GST_OBJECT (self),
+		gst_structure_new_empty (rds_fields[field].clear)));
+
+      /* changes and completes before a clear are not posted */
+      if (events.changes != posted->changes
+	  && events.changes != events.changes_at_clear)
+	{
+	  s = gst_structure_new (rds_fields[field].change,
+	      rds_fields[field].name, G_TYPE_STRING, events.text, NULL);
+	  gst_element_post_message (GST_ELEMENT (self),
+	      gst_message_new_element (GST_OBJECT (self), s));
+	}
+
+      if (events.completes != posted->completes
+	  && events.completes != events.completes_at_clear)
+	{
+	  s = gst_structure_new (rds_fields[field].complete,
+	      rds_fields[field].name, G_TYPE_STRING, events.complete, NULL);
+	  gst_element_post_message (GST_ELEMENT (self),
+	      gst_message_new_element (GST_OBJECT (self), s));
+	}
+
+      *posted = events;
+
+      GST_OBJECT_LOCK (self);
+      strncpy ((gchar *) G_STRUCT_MEMBER_P (self, rds_fields[field].offset),
+	  events.text, rds_fields[field].size);
+      GST_OBJECT_UNLOCK (self);
+    }
 
-  GST_OBJECT_UNLOCK (self);
+  return G_SOURCE_CONTINUE;
 }
 
-static void
-gst_sdrjfm_src_rds_station_label_clear(void * user_data)
+static gboolean
+gst_sdrjfm_src_rds_source_dispatch (GSource * source, GSourceFunc callback,
+    gpointer user_data)
 {
-  GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
-  gst_sdrjfm_src_rds_clear(self, self->station_label, sizeof (self->station_label),
-			   DEFAULT_STATION_LABEL, "station-label");
+  return callback (user_data);
 }
 
+/* A source with neither a file descriptor nor a timeout, it runs when
+ * its ready time is set and reached */
+static GSourceFuncs rds_source_funcs = {
+  NULL, NULL, gst_sdrjfm_src_rds_source_dispatch, NULL
+};
+
+/* Called by the radio after each RDS event, from its own thread or the
+ * one tuning it.  Only the first event since the last posting sets the
+ * source to run, so there is one posting per rds-window at most. */
 static void
-gst_sdrjfm_src_rds_radio_text_clear(void * user_data)
+gst_sdrjfm_src_rds_wake (GstSdrjfmSrc * self)
 {
-  GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
-  gst_sdrjfm_src_rds_clear(self, self->radio_text, sizeof (self->radio_text),
-			   DEFAULT_RADIO_TEXT, "radio-text");
+  if (g_atomic_int_compare_and_exchange (&self->rds_due, FALSE, TRUE))
+    g_source_set_ready_time (self->rds_source, g_get_monotonic_time ()
+	+ (gint64) self->rds_window * G_TIME_SPAN_MILLISECOND);
 }
 
 static void
@@ -329,44 +510,69 @@ gst_sdrjfm_src_rds_set(const char *string,
 }
 
 static void
-gst_sdrjfm_src_rds_change(GstSdrjfmSrc * self, const char *string, char *dest,
-			  size_t dest_len, const char *field_name)
+gst_sdrjfm_src_rds_clear(GstSdrjfmSrc * self, gint field)
 {
-  GST_OBJECT_LOCK (self);
+  GstSdrjfmRdsEvents *events = self->rds_events[field].beginWrite ();
 
-  gst_sdrjfm_src_rds_set(string, dest, dest_len);
+  events->clears++;
+  events->changes_at_clear = events->changes;
+  events->completes_at_clear = events->completes;
+  memset (events->text, 0, sizeof (events->text));
+  self->rds_events[field].endWrite ();
 
-  gst_sdrjfm_src_send_bus_message_rds_string(self, "change", field_name, dest);
+  gst_sdrjfm_src_rds_wake (self);
+}
 
-  GST_OBJECT_UNLOCK (self);
+static void
+gst_sdrjfm_src_rds_station_label_clear(void * user_data)
+{
+  GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
+  gst_sdrjfm_src_rds_clear(self, RDS_STATION_LABEL);
+}
+
+static void
+gst_sdrjfm_src_rds_radio_text_clear(void * user_data)
+{
+  GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
+  gst_sdrjfm_src_rds_clear(self, RDS_RADIO_TEXT);
+}
+
+static void
+gst_sdrjfm_src_rds_change(GstSdrjfmSrc * self, const char *string, gint field)
+{
+  GstSdrjfmRdsEvents *events = self->rds_events[field].beginWrite ();
+
+  events->changes++;
+  gst_sdrjfm_src_rds_set(string, events->text, rds_fields[field].size);
+  self->rds_events[field].endWrite ();
+
+  gst_sdrjfm_src_rds_wake (self);
 }
 
 static void
 gst_sdrjfm_src_rds_station_label_change(const char *label, void *user_data)
 {
   GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
-  gst_sdrjfm_src_rds_change(self, label, &self->station_label[0], sizeof (self->station_label),
-			    "station-label");
+  gst_sdrjfm_src_rds_change(self, label, RDS_STATION_LABEL);
 }
 static void
 gst_sdrjfm_src_rds_radio_text_change(const char *text, void *user_data)
 {
   GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
-  gst_sdrjfm_src_rds_change(self, text, &self->radio_text[0], sizeof (self->radio_text),
-			    "radio-text");
+  gst_sdrjfm_src_rds_change(self, text, RDS_RADIO_TEXT);
 }
 
 static void
-gst_sdrjfm_src_rds_complete(GstSdrjfmSrc *self, const char *string, const char *field_name,
-			    char *field, size_t field_len)
+gst_sdrjfm_src_rds_complete(GstSdrjfmSrc *self, const char *string, gint field)
 {
-  GST_OBJECT_LOCK (self);
-
-  gst_sdrjfm_src_rds_set(string, field, field_len);
+  GstSdrjfmRdsEvents *events = self->rds_events[field].beginWrite ();
 
-  gst_sdrjfm_src_send_bus_message_rds_string(self, "complete", field_name, field);
+  events->completes++;
+  gst_sdrjfm_src_rds_set(string, events->text, rds_fields[field].size);
+  gst_sdrjfm_src_rds_set(string, events->complete, rds_fields[field].size);
+  self->rds_events[field].endWrite ();
 
-  GST_OBJECT_UNLOCK (self);
+  gst_sdrjfm_src_rds_wake (self);
 }
 
 static void
@@ -374,8 +580,7 @@ gst_sdrjfm_src_rds_station_label_complete(const char *label, void *user_data)
 {
   GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
 
-  gst_sdrjfm_src_rds_complete(self, label, "station-label",
-			      self->station_label, sizeof (self->station_label));
+  gst_sdrjfm_src_rds_complete(self, label, RDS_STATION_LABEL);
 }
 
 static void
@@ -383,30 +588,516 @@ gst_sdrjfm_src_rds_radio_text_complete(const char *label, void *user_data)
 {
   GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
 
-  gst_sdrjfm_src_rds_complete(self, label, "radio-text",
-			      self->radio_text, sizeof (self->radio_text));
+  gst_sdrjfm_src_rds_complete(self, label, RDS_RADIO_TEXT);
+}
+
+/* Called by the radio with each RDS group, from its own thread, just
+ * after the RDS fields have been updated from it.  The group is queued
+ * for create, with the fields, until its audio is pushed.  When
+ * nothing takes them, the groups are dropped once the queue is full. */
+static void
+gst_sdrjfm_src_rds_group (const uint16_t *blocks, int64_t frame,
+    void *user_data)
+{
+  GstSdrjfmSrc *self = static_cast<GstSdrjfmSrc *>(user_data);
+  GstSdrjfmRdsGroup group;
+  GstSdrjfmRdsEvents events;
+
+  group.frame = frame;
+  memcpy (group.blocks, blocks, sizeof (group.blocks));
+
+  if (self->rds_events[RDS_STATION_LABEL].read (&events)
+      && events.completes != events.completes_at_clear)
+    strncpy (group.station_label, events.complete,
+        sizeof (group.station_label));
+  else
+    group.station_label[0] = '\0';
+
+  if (self->rds_events[RDS_RADIO_TEXT].read (&events)
+      && events.completes != events.completes_at_clear)
+    strncpy (group.radio_text, events.complete, sizeof (group.radio_text));
+  else
+    group.radio_text[0] = '\0';
+
+  self->rds_groups->putDataIntoBuffer (&group, 1);
+}
+
+/* Queues a tag event when the fields of the group differ from those of
+ * the last one.  The base class pushes it ahead of the next buffer,
+ * the one the group was received with. */
+static void
+gst_sdrjfm_src_rds_tag (GstSdrjfmSrc * self, const GstSdrjfmRdsGroup * group)
+{
+  gint pi = group->blocks[0];
+  gint pty = (group->blocks[1] >> 5) & 0x1f;
+  GstTagList *tags;
+
+  if (pi == self->rds_tag_pi && pty == self->rds_tag_pty
+      && strcmp (group->station_label, self->rds_tag_station_label) == 0
+      && strcmp (group->radio_text, self->rds_tag_radio_text) == 0)
+    return;
+
+  self->rds_tag_pi = pi;
+  self->rds_tag_pty = pty;
+  strcpy (self->rds_tag_station_label, group->station_label);
+  strcpy (self->rds_tag_radio_text, group->radio_text);
+
+  tags = gst_tag_list_new (TAG_RDS_PROGRAMME_IDENTIFICATION, (guint) pi,
+      TAG_RDS_PROGRAMME_TYPE, (guint) pty, NULL);
+  /* tag lists take no empty strings */
+  if (group->station_label[0] != '\0')
+    gst_tag_list_add (tags, GST_TAG_MERGE_REPLACE,
+        TAG_RDS_STATION_LABEL, group->station_label,
+        GST_TAG_ORGANIZATION, group->station_label, NULL);
+  if (group->radio_text[0] != '\0')
+    gst_tag_list_add (tags, GST_TAG_MERGE_REPLACE,
+        TAG_RDS_RADIO_TEXT, group->radio_text,
+        GST_TAG_TITLE, group->radio_text, NULL);
+
+  GST_DEBUG_OBJECT (self, "RDS tags %" GST_PTR_FORMAT, tags);
+  GST_ELEMENT_GET_CLASS (self)->send_event (GST_ELEMENT (self),
+      gst_event_new_tag (tags));
+}
+
+/* Sends the stream-start, caps and segment on a requested pad, ahead
+ * of its first buffer */
+static void
+gst_sdrjfm_src_start_pad (GstSdrjfmSrc * self, GstPad * pad, GstCaps * caps)
+{
+  gchar *stream_id = gst_pad_create_stream_id (pad, GST_ELEMENT (self),
+      GST_PAD_NAME (pad));
+
+  gst_pad_push_event (pad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+  gst_pad_push_event (pad, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+  gst_pad_push_event (pad,
+      gst_event_new_segment (&GST_BASE_SRC (self)->segment));
+}
+
+/* The time of a position in the audio, from that of the buffer it is
+ * in.  Positions of audio lost before the buffer go with its start. */
+static GstClockTime
+gst_sdrjfm_src_position_time (GstBuffer * buffer, gint64 position)
+{
+  guint64 offset = GST_BUFFER_OFFSET (buffer);
+  guint64 offset_end = GST_BUFFER_OFFSET_END (buffer);
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+  GstClockTime duration = GST_BUFFER_DURATION (buffer);
+
+  if (GST_CLOCK_TIME_IS_VALID (pts) && GST_CLOCK_TIME_IS_VALID (duration)
+      && offset_end != GST_BUFFER_OFFSET_NONE && offset_end > offset
+      && position > (gint64) offset)
+    pts += gst_util_uint64_scale (position - offset, duration,
+        offset_end - offset);
+
+  return pts;
+}
+
+/* Pushes the group on the rds pad */
+static void
+gst_sdrjfm_src_rds_push (GstSdrjfmSrc * self, GstPad * pad,
+    const GstSdrjfmRdsGroup * group, GstClockTime pts)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint b;
+
+  if (!self->rds_pad_started)
+    {
+      gst_sdrjfm_src_start_pad (self, pad,
+          gst_static_pad_template_get_caps (&sdrjfmsrc_rds_factory));
+      self->rds_pad_started = TRUE;
+    }
+
+  buffer = gst_buffer_new_allocate (NULL, sizeof (group->blocks), NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (b = 0; b < 4; b++)
+    GST_WRITE_UINT16_BE (map.data + 2 * b, group->blocks[b]);
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DURATION (buffer) = RDS_GROUP_DURATION;
+
+  /* a missing or flushing reader of the groups is no reason to stop
+   * the audio */
+  gst_pad_push (pad, buffer);
+}
+
+/* Takes the RDS groups received with the audio of the buffer off the
+ * queue, sets the tags from them and pushes them on the rds pad, with
+ * the time of their audio */
+static void
+gst_sdrjfm_src_rds_drain (GstSdrjfmSrc * self, GstBuffer * buffer)
+{
+  guint64 offset_end = GST_BUFFER_OFFSET_END (buffer);
+  GstSdrjfmRdsGroup *group;
+  GstPad *pad;
+  void *data1, *data2;
+  int32_t size1, size2;
+  gint64 position;
+
+  GST_OBJECT_LOCK (self);
+  pad = self->rds_pad ? GST_PAD (gst_object_ref (self->rds_pad)) : NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  while (self->rds_groups->GetRingBufferReadRegions (1,
+          &data1, &size1, &data2, &size2) == 1)
+    {
+      group = static_cast<GstSdrjfmRdsGroup *>(data1);
+      position = group->frame - self->frame_base;
+      if (offset_end != GST_BUFFER_OFFSET_NONE
+          && position >= (gint64) offset_end)
+        break;
+
+      gst_sdrjfm_src_rds_tag (self, group);
+
+      if (pad && gst_pad_is_linked (pad))
+        gst_sdrjfm_src_rds_push (self, pad, group,
+            gst_sdrjfm_src_position_time (buffer, position));
+
+      self->rds_groups->AdvanceRingBufferReadIndex (1);
+    }
+
+  if (pad)
+    gst_object_unref (pad);
+}
+
+/* The block \a i of the queue regions \a data1 and \a data2 */
+static mpxBlock *
+gst_sdrjfm_src_mpx_block (void *data1, int32_t size1, void *data2,
+    int32_t i)
+{
+  return i < size1 ? &static_cast<mpxBlock *>(data1)[i]
+      : &static_cast<mpxBlock *>(data2)[i - size1];
+}
+
+/* Pushes the multiplex demodulated with the audio of the buffer on the
+ * mpx pad, a buffer for each run of blocks without a gap.  The radio
+ * drops the blocks that do not fit in the queue, the blocks after a gap
+ * start a buffer of their own, flagged as a discontinuity.  The radio
+ * only queues the multiplex while the pad is linked, so it costs
+ * nothing otherwise. */
+static void
+gst_sdrjfm_src_mpx_drain (GstSdrjfmSrc * self, GstBuffer * buffer)
+{
+  guint64 offset_end = GST_BUFFER_OFFSET_END (buffer);
+  RingBuffer<mpxBlock> *queue;
+  mpxBlock *block, *first;
+  GstBuffer *out;
+  GstMapInfo map;
+  GstPad *pad;
+  gboolean linked, discont;
+  void *data1, *data2;
+  int32_t size1, size2, available, blocks, count, run, end, i;
+  gint64 next;
+  gint rate;
+
+  GST_OBJECT_LOCK (self);
+  pad = self->mpx_pad ? GST_PAD (gst_object_ref (self->mpx_pad)) : NULL;
+  queue = self->mpx_blocks;
+  GST_OBJECT_UNLOCK (self);
+
+  linked = pad && gst_pad_is_linked (pad);
+  if (linked != self->mpx_enabled)
+    {
+      /* the blocks left from an earlier link are of no use */
+      if (linked)
+        {
+          queue->skipDataInBuffer (queue->GetRingBufferReadAvailable ());
+          self->mpx_next_frame = G_MININT64;
+        }
+      self->radio->setMpxQueue (linked ? queue : NULL);
+      self->mpx_enabled = linked;
+    }
+  if (!linked)
+    {
+      if (pad)
+        gst_object_unref (pad);
+      return;
+    }
+
+  /* the blocks from before the end of the buffer */
+  available = queue->GetRingBufferReadRegions (
+      queue->GetRingBufferReadAvailable (), &data1, &size1, &data2, &size2);
+  for (blocks = 0; blocks < available; blocks++)
+    {
+      block = gst_sdrjfm_src_mpx_block (data1, size1, data2, blocks);
+      if (offset_end != GST_BUFFER_OFFSET_NONE
+          && block->frame - self->frame_base >= (gint64) offset_end)
+        break;
+    }
+
+  if (blocks > 0)
+    {
+      rate = self->radio->getMpxRate ();
+      if (!self->mpx_pad_started)
+        {
+          gst_sdrjfm_src_start_pad (self, pad, gst_caps_new_simple ("audio/x-raw",
+              "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
+              "layout", G_TYPE_STRING, "interleaved",
+              "rate", G_TYPE_INT, rate,
+              "channels", G_TYPE_INT, 1, NULL));
+          self->mpx_pad_started = TRUE;
+        }
+
+      for (run = 0; run < blocks; run = end)
+        {
+          first = gst_sdrjfm_src_mpx_block (data1, size1, data2, run);
+          discont = self->mpx_next_frame == G_MININT64
+              || ABS (first->frame - self->mpx_next_frame) > MPX_SLACK;
+
+          next = first->frame;
+          for (end = run, count = 0; end < blocks; end++)
+            {
+              block = gst_sdrjfm_src_mpx_block (data1, size1, data2, end);
+              if (end > run && ABS (block->frame - next) > MPX_SLACK)
+                break;
+              next = block->frame + gst_util_uint64_scale_int (block->count,
+                  self->audio_rate, rate);
+              count += block->count;
+            }
+
+          out = gst_buffer_new_allocate (NULL, count * sizeof (float), NULL);
+          gst_buffer_map (out, &map, GST_MAP_WRITE);
+          for (i = run, count = 0; i < end; i++)
+            {
+              block = gst_sdrjfm_src_mpx_block (data1, size1, data2, i);
+              memcpy (map.data + count * sizeof (float), block->samples,
+                  block->count * sizeof (float));
+              count += block->count;
+            }
+          gst_buffer_unmap (out, &map);
+
+          GST_BUFFER_PTS (out) = gst_sdrjfm_src_position_time (buffer,
+              first->frame - self->frame_base);
+          GST_BUFFER_DURATION (out) = gst_util_uint64_scale (count,
+              GST_SECOND, rate);
+          if (discont)
+            GST_BUFFER_FLAG_SET (out, GST_BUFFER_FLAG_DISCONT);
+          self->mpx_next_frame = next;
+          gst_pad_push (pad, out);
+        }
+
+      /* the radio may write over the blocks from here */
+      queue->AdvanceRingBufferReadIndex (blocks);
+    }
+
+  gst_object_unref (pad);
 }
 
+/* Adds the time the audio waits in the radio to the latency, it is
+ * timestamped as captured */
+static gboolean
+gst_sdrjfm_src_query (GstBaseSrc * bsrc, GstQuery * query)
+{
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (bsrc);
+  GstClockTime min, max, extra;
+  gboolean live;
+
+  if (!GST_BASE_SRC_CLASS (parent_class)->query (bsrc, query))
+    return FALSE;
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_LATENCY)
+    {
+      gst_query_parse_latency (query, &live, &min, &max);
+      extra = self->audio_depth * GST_MSECOND + CAPTURE_LATENCY;
+      min += extra;
+      if (GST_CLOCK_TIME_IS_VALID (max))
+        max += extra;
+      gst_query_set_latency (query, live, min, max);
+    }
+
+  return TRUE;
+}
+
+/* Provides the clock counting the samples captured, rather than the
+ * one of GstAudioBaseSrc, with `provide-clock` set */
+static GstClock *
+gst_sdrjfm_src_provide_clock (GstElement * element)
+{
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (element);
+
+  if (!gst_audio_base_src_get_provide_clock (GST_AUDIO_BASE_SRC (self)))
+    return NULL;
+
+  return GST_CLOCK (gst_object_ref (self->capture_clock));
+}
+
+/* Prefers the float stereo audio at 44100 Hz the radio was first made
+ * for, where downstream leaves the choice, rather than the defaults of
+ * GstAudioBaseSrc */
+static GstCaps *
+gst_sdrjfm_src_fixate (GstBaseSrc * bsrc, GstCaps * caps)
+{
+  GstStructure *s;
+
+  caps = gst_caps_make_writable (caps);
+  s = gst_caps_get_structure (caps, 0);
+  gst_structure_fixate_field_string (s, "format", GST_AUDIO_NE (F32));
+  gst_structure_fixate_field_nearest_int (s, "rate", DEFAULT_AUDIO_RATE);
+  gst_structure_fixate_field_nearest_int (s, "channels", 2);
+
+  return GST_BASE_SRC_CLASS (parent_class)->fixate (bsrc, caps);
+}
+
+static GstFlowReturn
+gst_sdrjfm_src_create (GstBaseSrc * bsrc, guint64 offset, guint length,
+    GstBuffer ** outbuf)
+{
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (bsrc);
+  GstFlowReturn ret;
+
+  ret = GST_BASE_SRC_CLASS (parent_class)->create (bsrc, offset, length,
+      outbuf);
+  if (ret == GST_FLOW_OK)
+    {
+      gst_sdrjfm_src_rds_drain (self, *outbuf);
+      gst_sdrjfm_src_mpx_drain (self, *outbuf);
+    }
+
+  return ret;
+}
+
+static GstPad *
+gst_sdrjfm_src_request_new_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * name, const GstCaps * caps)
+{
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (element);
+  const gchar *pad_name = GST_PAD_TEMPLATE_NAME_TEMPLATE (templ);
+  gboolean mpx = strcmp (pad_name, "mpx") == 0;
+  GstPad *pad;
+
+  GST_OBJECT_LOCK (self);
+  if (mpx ? self->mpx_pad : self->rds_pad)
+    {
+      GST_OBJECT_UNLOCK (self);
+      GST_WARNING_OBJECT (self, "The %s pad has already been requested",
+          pad_name);
+      return NULL;
+    }
+  pad = gst_pad_new_from_template (templ, pad_name);
+  if (mpx)
+    {
+      /* the queue is kept until finalizing, the radio may still be
+       * writing in it after the pad is gone */
+      if (self->mpx_blocks == NULL)
+        self->mpx_blocks = new RingBuffer<mpxBlock> (MPX_BLOCKS);
+      self->mpx_pad = pad;
+      self->mpx_pad_started = FALSE;
+    }
+  else
+    {
+      self->rds_pad = pad;
+      self->rds_pad_started = FALSE;
+    }
+  GST_OBJECT_UNLOCK (self);
+
+  /* pads are activated with the element, after that by hand */
+  if (GST_STATE (element) > GST_STATE_READY)
+    gst_pad_set_active (pad, TRUE);
+  gst_element_add_pad (element, pad);
+
+  return pad;
+}
+
+static void
+gst_sdrjfm_src_release_pad (GstElement * element, GstPad * pad)
+{
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (element);
+
+  GST_OBJECT_LOCK (self);
+  if (pad == self->rds_pad)
+    self->rds_pad = NULL;
+  else if (pad == self->mpx_pad)
+    self->mpx_pad = NULL;
+  else
+    {
+      GST_OBJECT_UNLOCK (self);
+      return;
+    }
+  GST_OBJECT_UNLOCK (self);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+}
+
+static void gst_sdrjfm_src_new_radio (GstSdrjfmSrc * self);
+
 static gboolean
 gst_sdrjfm_src_open (GstAudioSrc * asrc)
 {
   GstSdrjfmSrc *self = GST_SDRJFM_SRC (asrc);
 
-  self->radio = new RadioInterface(self->frequency,
+  /* the radio clears the RDS fields as it is created */
+  self->rds_due = FALSE;
+  self->rds_source = g_source_new (&rds_source_funcs, sizeof (GSource));
+  g_source_set_callback (self->rds_source, gst_sdrjfm_src_rds_post,
+      gst_object_ref (self), (GDestroyNotify) gst_object_unref);
+  g_source_attach (self->rds_source, NULL);
+
+  gst_sdrjfm_src_new_radio (self);
+
+  return TRUE;
+}
+
+/* Creates the radio, for audio at `audio_rate` */
+static void
+gst_sdrjfm_src_new_radio (GstSdrjfmSrc * self)
+{
+  RadioInterface *radio = new RadioInterface(self->frequency,
 				   gst_sdrjfm_src_rds_station_label_clear,
 				   gst_sdrjfm_src_rds_station_label_change,
 				   gst_sdrjfm_src_rds_station_label_complete,
 				   gst_sdrjfm_src_rds_radio_text_clear,
 				   gst_sdrjfm_src_rds_radio_text_change,
 				   gst_sdrjfm_src_rds_radio_text_complete,
-				   self);
-
-  GST_INFO_OBJECT (self, "Created new SDR-J FM Radio object with frequency %u",
-		   self->frequency);
+				   self,
+				   self->input_location,
+				   self->input_paced,
+				   self->iq_record_location,
+				   self->input_generator,
+				   self->audio_rate);
+
+  /* a new input counts its samples from 0 */
+  g_mutex_lock (&self->capture_lock);
+  self->radio = radio;
+  self->capture_base = G_MININT64;
+  self->capture_clock_base = G_MININT64;
+  g_mutex_unlock (&self->capture_lock);
+
+  GST_INFO_OBJECT (self, "Created new SDR-J FM Radio object with frequency %u,"
+		   " audio at %d Hz", self->frequency, self->audio_rate);
+  if (self->input_generator)
+    GST_INFO_OBJECT (self, "Demodulating a generated signal: %s", self->input_generator);
+  else if (self->input_location)
+    GST_INFO_OBJECT (self, "Playing I/Q recording %s (%s)", self->input_location,
+		     self->input_paced ? "paced" : "unpaced");
+  else if (self->iq_record_location)
+    GST_INFO_OBJECT (self, "Recording I/Q samples to %s", self->iq_record_location);
 
   self->radio->setFrequencyChangeCB (gst_sdrjfm_src_frequency_changed, self);
+  self->radio->setRdsGroupCB (gst_sdrjfm_src_rds_group, self);
+  self->mpx_enabled = FALSE;
+}
 
-  return TRUE;
+static void
+gst_sdrjfm_src_delete_radio (GstSdrjfmSrc * self)
+{
+  RadioInterface *radio = self->radio;
+
+  if (radio)
+    {
+      /* the provided clock may be asking it for the time */
+      g_mutex_lock (&self->capture_lock);
+      self->radio = 0;
+      g_mutex_unlock (&self->capture_lock);
+
+      radio->stop();
+      GST_DEBUG_OBJECT(self, "Deleting radio...");
+      delete radio;
+      GST_DEBUG_OBJECT(self, "...radio deleted");
+    }
 }
 
 static gboolean
@@ -415,14 +1106,76 @@ gst_sdrjfm_src_close (GstAudioSrc * asrc)
   GstSdrjfmSrc *self = GST_SDRJFM_SRC (asrc);
 
   GST_DEBUG_OBJECT (asrc, "Closing FM source.");
-  if (self->radio)
+  gst_sdrjfm_src_delete_radio (self);
+
+  if (self->rds_source)
     {
-      self->radio->stop();
-      GST_DEBUG_OBJECT(self, "Deleting radio...");
-      delete self->radio;
-      GST_DEBUG_OBJECT(self, "...radio deleted");
-      self->radio = 0;
+      g_source_destroy (self->rds_source);
+      g_source_unref (self->rds_source);
+      self->rds_source = NULL;
+    }
+
+  return TRUE;
+}
+
+/* Posts the latest reception telemetry on the bus, every
+ * telemetry-interval ms while the radio runs.  The radio takes a
+ * record four times per second of input, the same one is not posted
+ * twice. */
+static gboolean
+gst_sdrjfm_src_telemetry_timeout (gpointer user_data)
+{
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (user_data);
+  receptionTelemetry t;
+  GstStructure *s;
+  gboolean fresh = FALSE;
+
+  GST_OBJECT_LOCK (self);
+  if (self->radio && self->radio->getTelemetry (&t)
+      && t.sequence != self->telemetry_sequence)
+    {
+      self->telemetry_sequence = t.sequence;
+      fresh = TRUE;
     }
+  GST_OBJECT_UNLOCK (self);
+
+  if (!fresh)
+    return TRUE;
+
+  s = gst_structure_new ("sdrjfmsrc-reception",
+      "sequence", G_TYPE_UINT64, (guint64) t.sequence,
+      "signal-strength", G_TYPE_DOUBLE, (gdouble) t.signalStrength,
+      "pilot-strength", G_TYPE_DOUBLE, (gdouble) t.pilotStrength,
+      "rds-strength", G_TYPE_DOUBLE, (gdouble) t.rdsStrength,
+      "noise-strength", G_TYPE_DOUBLE, (gdouble) t.noiseStrength,
+      "dc-component", G_TYPE_DOUBLE, (gdouble) t.dcComponent,
+      "stereo", G_TYPE_BOOLEAN, (gboolean) t.stereo,
+      "rds-synchronized", G_TYPE_BOOLEAN, (gboolean) t.rdsSynchronized,
+      "rds-bit-error-rate", G_TYPE_DOUBLE, (gdouble) t.rdsBitErrorRate,
+      "rds-sync-errors", G_TYPE_INT, t.rdsSyncErrors,
+      "rds-crc-errors", G_TYPE_INT, t.rdsCrcErrors,
+      "rds-groups", G_TYPE_INT, t.rdsGroups,
+      NULL);
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self), s));
+
+  return TRUE;
+}
+
+/* Posts the health counters on the bus, every health-interval ms
+ * while the radio runs */
+static gboolean
+gst_sdrjfm_src_health_timeout (gpointer user_data)
+{
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (user_data);
+  GstStructure *s;
+
+  GST_OBJECT_LOCK (self);
+  s = gst_sdrjfm_src_health (self);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self), s));
 
   return TRUE;
 }
@@ -431,11 +1184,68 @@ static gboolean
 gst_sdrjfm_src_prepare (GstAudioSrc * asrc, GstAudioRingBufferSpec * spec)
 {
   GstSdrjfmSrc *self = GST_SDRJFM_SRC (asrc);
+  GstAudioInfo *info = &spec->info;
+
+  /* the radio demodulates at the rate negotiated, a radio made for
+   * another one goes */
+  if (GST_AUDIO_INFO_RATE (info) != self->audio_rate)
+    {
+      GST_INFO_OBJECT (self, "Audio at %d Hz negotiated, recreating the radio",
+          GST_AUDIO_INFO_RATE (info));
+      gst_sdrjfm_src_delete_radio (self);
+      self->audio_rate = GST_AUDIO_INFO_RATE (info);
+      gst_sdrjfm_src_new_radio (self);
+    }
+
+  /* the radio writes float stereo, converted as it is read for
+   * anything else, mono is demodulated as such */
+  self->channels = GST_AUDIO_INFO_CHANNELS (info);
+  self->s16 = GST_AUDIO_INFO_FORMAT (info) == GST_AUDIO_FORMAT_S16;
+  self->radio->setStereo (self->channels == 2);
+  /* an unpaced recording is read as fast as it is demodulated */
+  if (self->input_location && !self->input_paced)
+    self->radio->setAudioDepth (0);
+  else
+    self->radio->setAudioDepth (self->audio_depth * self->audio_rate / 1000);
+  g_free (self->scratch);
+  self->scratch = NULL;
+  if (self->s16 || self->channels != 2)
+    {
+      self->scratch_frames = spec->segsize / GST_AUDIO_INFO_BPF (info);
+      self->scratch = g_new (DSPFLOAT, 2 * self->scratch_frames);
+    }
+
+  /* the audio of an earlier run would offset the RDS groups */
+  self->radio->flush ();
+  self->rds_groups->FlushRingBuffer ();
+  self->frame_base = self->radio->getAudioPosition ();
+  self->rds_tag_pi = -1;
+  self->rds_pad_started = FALSE;
+  self->pace_start = GST_CLOCK_TIME_NONE;
+  g_mutex_lock (&self->capture_lock);
+  self->capture_base = G_MININT64;
+  g_mutex_unlock (&self->capture_lock);
+  /* until create finds the mpx pad linked */
+  self->radio->setMpxQueue (NULL);
+  self->mpx_enabled = FALSE;
+  self->mpx_pad_started = FALSE;
 
   GST_DEBUG_OBJECT(self, "Starting radio...");
   self->radio->start();
   GST_DEBUG_OBJECT(self, "...radio started");
 
+  GST_OBJECT_LOCK (self);
+  if (self->health_interval > 0)
+    self->health_timeout = g_timeout_add_full (G_PRIORITY_DEFAULT,
+        self->health_interval, gst_sdrjfm_src_health_timeout,
+        gst_object_ref (self), (GDestroyNotify) gst_object_unref);
+  self->telemetry_sequence = 0;
+  if (self->telemetry_interval > 0)
+    self->telemetry_timeout = g_timeout_add_full (G_PRIORITY_DEFAULT,
+        self->telemetry_interval, gst_sdrjfm_src_telemetry_timeout,
+        gst_object_ref (self), (GDestroyNotify) gst_object_unref);
+  GST_OBJECT_UNLOCK (self);
+
   return TRUE;
 }
 
@@ -444,21 +1254,35 @@ gst_sdrjfm_src_unprepare (GstAudioSrc * asrc)
 {
   GstSdrjfmSrc *self = GST_SDRJFM_SRC (asrc);
 
+  GST_OBJECT_LOCK (self);
+  if (self->health_timeout)
+    {
+      g_source_remove (self->health_timeout);
+      self->health_timeout = 0;
+    }
+  if (self->telemetry_timeout)
+    {
+      g_source_remove (self->telemetry_timeout);
+      self->telemetry_timeout = 0;
+    }
+  GST_OBJECT_UNLOCK (self);
+
   GST_DEBUG_OBJECT(self, "Stopping radio..");
   self->radio->stop();
   GST_DEBUG_OBJECT(self, "...radio stopped");
 
+  g_free (self->scratch);
+  self->scratch = NULL;
+
   return TRUE;
 }
 
-static guint
-gst_sdrjfm_src_read (GstAudioSrc * asrc, gpointer data, guint length,
-    GstClockTime * timestamp)
+/* Reads \a samplesRequired float samples of the radio, FALSE if
+ * stopped or cancelled first */
+static gboolean
+gst_sdrjfm_src_read_samples (GstSdrjfmSrc * self, DSPFLOAT * samples,
+    guint samplesRequired)
 {
-  const guint samplesRequired = length / sizeof(DSPFLOAT);
-
-  GstSdrjfmSrc *self =  GST_SDRJFM_SRC (asrc);
-  DSPFLOAT *samples = static_cast<DSPFLOAT *>(data);
   guint remaining = samplesRequired;
 
   while (remaining) {
@@ -468,19 +1292,217 @@ gst_sdrjfm_src_read (GstAudioSrc * asrc, gpointer data, guint length,
       {
 	 // Either we're stopped, or the read has been cancelled
 	 GST_TRACE_OBJECT(self, "Read cancelled or stopped");
-	 //return length - (remaining * sizeof(DSPFLOAT));
-
-	 // Work around bug in GstAudioSrc
-	 return G_MAXUINT;
+	 return FALSE;
       }
 
-    GST_TRACE_OBJECT(self, "Read %i samples out of %u remaining from %u (length: %u)",
-		     count, remaining, samplesRequired, length);
+    GST_TRACE_OBJECT(self, "Read %i samples out of %u remaining from %u",
+		     count, remaining, samplesRequired);
 
     samples += count;
     remaining -= count;
   }
 
+  return TRUE;
+}
+
+/* Waits until \a frames more can be read at the rate of the clock,
+ * `audio-depth` behind the radio: the clock of the sink then takes
+ * the audio, and the radio follows its drift by keeping the depth.
+ * The pace starts over when the radio ran dry, after tuning say.
+ * FALSE if reset while waiting, the pace then starts over */
+static gboolean
+gst_sdrjfm_src_pace (GstSdrjfmSrc * self, guint frames)
+{
+  GstClock *clock;
+  GstClockTime due;
+  GstClockID id;
+  GstClockReturn ret;
+
+  if (self->audio_depth == 0 || (self->input_location && !self->input_paced))
+    return TRUE;
+
+  clock = gst_element_get_clock (GST_ELEMENT (self));
+  if (!clock)
+    return TRUE;
+
+  if (self->radio->getWaitingSamples () == 0)
+    self->pace_start = GST_CLOCK_TIME_NONE;
+  if (!GST_CLOCK_TIME_IS_VALID (self->pace_start))
+    {
+      self->pace_start = gst_clock_get_time (clock)
+          + self->audio_depth * GST_MSECOND;
+      self->pace_frames = 0;
+    }
+  self->pace_frames += frames;
+  due = self->pace_start + gst_util_uint64_scale_int (self->pace_frames,
+      GST_SECOND, self->audio_rate);
+
+  id = gst_clock_new_single_shot_id (clock, due);
+  GST_OBJECT_LOCK (self);
+  self->pace_id = id;
+  GST_OBJECT_UNLOCK (self);
+
+  ret = gst_clock_id_wait (id, NULL);
+
+  GST_OBJECT_LOCK (self);
+  self->pace_id = NULL;
+  GST_OBJECT_UNLOCK (self);
+  gst_clock_id_unref (id);
+  gst_object_unref (clock);
+
+  if (ret == GST_CLOCK_UNSCHEDULED)
+    {
+      self->pace_start = GST_CLOCK_TIME_NONE;
+      return FALSE;
+    }
+  return TRUE;
+}
+
+/* The duration of \a samples of the input, in ns */
+static gint64
+gst_sdrjfm_src_capture_ns (gint64 samples, gint rate)
+{
+  return gst_util_uint64_scale_int (samples, GST_SECOND, rate);
+}
+
+/* The samples the input captured and the monotonic time the last of
+ * them came in at, the provided clock counting from the first of
+ * these; FALSE if the input does not count them.  Under the capture
+ * lock. */
+static gboolean
+gst_sdrjfm_src_capture_count (GstSdrjfmSrc * self, gint64 * captured,
+    gint64 * arrived, gint * rate)
+{
+  if (!self->radio || !self->radio->getCaptureTime (captured, arrived))
+    return FALSE;
+
+  *rate = self->radio->getInputRate ();
+  if (self->capture_clock_base == G_MININT64)
+    self->capture_clock_base = *arrived
+        - gst_sdrjfm_src_capture_ns (*captured, *rate);
+  return TRUE;
+}
+
+/* The time of the provided clock: the samples captured, at the input
+ * rate, run on from the last transfer for at most another one.  The
+ * monotonic time for an input that does not count them. */
+static GstClockTime
+gst_sdrjfm_src_capture_clock_time (GstClock * clock, gpointer user_data)
+{
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (user_data);
+  gint64 now = g_get_monotonic_time () * 1000;
+  gint64 captured, arrived;
+  GstClockTime time = now;
+  gint rate;
+
+  g_mutex_lock (&self->capture_lock);
+  if (gst_sdrjfm_src_capture_count (self, &captured, &arrived, &rate))
+    time = self->capture_clock_base
+        + gst_sdrjfm_src_capture_ns (captured, rate)
+        + CLAMP (now - arrived, 0,
+            gst_sdrjfm_src_capture_ns (CAPTURE_TRANSFER, rate));
+  g_mutex_unlock (&self->capture_lock);
+
+  return time;
+}
+
+/* The clock time the next frame read was captured at, in the clock of
+ * the element, or GST_CLOCK_TIME_NONE if the input does not count its
+ * samples.  In the provided clock it is the count of samples up to the
+ * frame; for another one the count follows the monotonic time the
+ * samples come in at, and goes with that clock from there. */
+static GstClockTime
+gst_sdrjfm_src_capture_timestamp (GstSdrjfmSrc * self)
+{
+  GstClock *clock;
+  GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+  gint64 position, captured, arrived, base, capture = -1;
+  gint rate;
+
+  position = self->radio->getCapturePosition (self->radio->getReadPosition ());
+  if (position < 0)
+    return GST_CLOCK_TIME_NONE;
+  clock = gst_element_get_clock (GST_ELEMENT (self));
+  if (!clock)
+    return GST_CLOCK_TIME_NONE;
+
+  g_mutex_lock (&self->capture_lock);
+  if (gst_sdrjfm_src_capture_count (self, &captured, &arrived, &rate))
+    {
+      if (clock == self->capture_clock)
+        timestamp = self->capture_clock_base
+            + gst_sdrjfm_src_capture_ns (position, rate);
+      else
+        {
+          base = arrived - gst_sdrjfm_src_capture_ns (captured, rate);
+          if (self->capture_base == G_MININT64
+              || ABS (base - self->capture_base) > (gint64) CAPTURE_RESYNC)
+            self->capture_base = base;
+          else
+            self->capture_base += (base - self->capture_base) / CAPTURE_SLEW;
+          capture = self->capture_base
+              + gst_sdrjfm_src_capture_ns (position, rate);
+        }
+    }
+  g_mutex_unlock (&self->capture_lock);
+
+  if (capture >= 0)
+    {
+      capture += (gint64) gst_clock_get_time (clock)
+          - g_get_monotonic_time () * 1000;
+      if (capture >= 0)
+        timestamp = capture;
+    }
+  gst_object_unref (clock);
+
+  return timestamp;
+}
+
+static guint
+gst_sdrjfm_src_read (GstAudioSrc * asrc, gpointer data, guint length,
+    GstClockTime * timestamp)
+{
+  GstSdrjfmSrc *self =  GST_SDRJFM_SRC (asrc);
+  guint frames, n, i;
+  gint16 *s16 = static_cast<gint16 *>(data);
+  DSPFLOAT *f32 = static_cast<DSPFLOAT *>(data);
+
+  if (!gst_sdrjfm_src_pace (self, length / (self->channels
+              * (self->s16 ? sizeof (gint16) : sizeof (DSPFLOAT)))))
+    return G_MAXUINT;
+  *timestamp = gst_sdrjfm_src_capture_timestamp (self);
+
+  // Work around bug in GstAudioSrc: G_MAXUINT rather than what was read
+  if (!self->scratch)
+    return gst_sdrjfm_src_read_samples (self, f32, length / sizeof(DSPFLOAT))
+        ? length : G_MAXUINT;
+
+  frames = length / (self->channels * (self->s16 ? sizeof (gint16)
+              : sizeof (DSPFLOAT)));
+  for (; frames > 0; frames -= n)
+    {
+      n = MIN (frames, self->scratch_frames);
+      if (!gst_sdrjfm_src_read_samples (self, self->scratch, 2 * n))
+        return G_MAXUINT;
+
+      for (i = 0; i < n; i++)
+        {
+          DSPFLOAT left = self->scratch[2 * i];
+          DSPFLOAT right = self->scratch[2 * i + 1];
+
+          if (self->channels == 1)
+            left = (left + right) / 2;
+          if (self->s16)
+            {
+              *s16++ = CLAMP (left * 32767, -32768, 32767);
+              if (self->channels == 2)
+                *s16++ = CLAMP (right * 32767, -32768, 32767);
+            }
+          else
+            *f32++ = left;
+        }
+    }
+
   return length;
 }
 
@@ -497,18 +1519,41 @@ static void
 gst_sdrjfm_src_reset (GstAudioSrc * asrc)
 {
   GstSdrjfmSrc *self =  GST_SDRJFM_SRC (asrc);
+  GST_OBJECT_LOCK (self);
+  if (self->pace_id)
+    gst_clock_id_unschedule (self->pace_id);
+  GST_OBJECT_UNLOCK (self);
   self->radio->cancelGet ();
 }
 
 static void
 gst_sdrjfm_src_dispose (GObject * object)
 {
+  GstSdrjfmSrc *self = GST_SDRJFM_SRC (object);
+
+  /* the pipeline may hold on to the clock a while longer */
+  if (self->capture_clock)
+    {
+      gst_audio_clock_invalidate (GST_AUDIO_CLOCK (self->capture_clock));
+      gst_object_unref (self->capture_clock);
+      self->capture_clock = NULL;
+    }
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
 static void
 gst_sdrjfm_src_finalize (GstSdrjfmSrc * self)
 {
+  g_free (self->input_location);
+  g_free (self->iq_record_location);
+  g_free (self->input_generator);
+  delete[] self->rds_events;
+  delete self->rds_groups;
+  delete self->mpx_blocks;
+  g_free (self->scratch);
+  g_mutex_clear (&self->capture_lock);
+
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (self));
 }
 
@@ -559,12 +1604,54 @@ gst_sdrjfm_src_init (GstSdrjfmSrc * self)
   self->frequency = FM_RADIO_SERVICE_DEF_FREQ;
   self->interval = DEFAULT_INTERVAL;
   self->threshold = DEFAULT_THRESHOLD;
+  self->input_location = NULL;
+  self->input_paced = DEFAULT_INPUT_PACED;
+  self->iq_record_location = NULL;
+  self->input_generator = NULL;
+  self->health_interval = DEFAULT_HEALTH_INTERVAL;
+  self->health_timeout = 0;
+  self->telemetry_interval = DEFAULT_TELEMETRY_INTERVAL;
+  self->telemetry_timeout = 0;
+  self->telemetry_sequence = 0;
+  self->rds_events = new seqLock<GstSdrjfmRdsEvents>[RDS_FIELDS];
+  self->rds_source = NULL;
+  self->rds_due = FALSE;
+  self->rds_window = DEFAULT_RDS_WINDOW;
+  self->rds_groups = new RingBuffer<GstSdrjfmRdsGroup> (RDS_GROUPS);
+  self->frame_base = 0;
+  self->rds_tag_pi = -1;
+  self->rds_tag_pty = 0;
+  self->rds_tag_station_label[0] = '\0';
+  self->rds_tag_radio_text[0] = '\0';
+  self->rds_pad = NULL;
+  self->rds_pad_started = FALSE;
+  self->mpx_blocks = NULL;
+  self->mpx_pad = NULL;
+  self->mpx_pad_started = FALSE;
+  self->mpx_enabled = FALSE;
+  self->mpx_next_frame = G_MININT64;
+  self->audio_rate = DEFAULT_AUDIO_RATE;
+  self->channels = 2;
+  self->s16 = FALSE;
+  self->scratch = NULL;
+  self->scratch_frames = 0;
+  self->audio_depth = DEFAULT_AUDIO_DEPTH;
+  self->pace_start = GST_CLOCK_TIME_NONE;
+  self->pace_frames = 0;
+  self->pace_id = NULL;
+  self->capture_base = G_MININT64;
+  self->capture_clock_base = G_MININT64;
+  g_mutex_init (&self->capture_lock);
+  self->capture_clock = gst_audio_clock_new ("GstSdrjfmSrcClock",
+      gst_sdrjfm_src_capture_clock_time, self, NULL);
 
   strncpy(self->station_label, DEFAULT_STATION_LABEL, sizeof (self->station_label));
   strncpy(self->radio_text, DEFAULT_RADIO_TEXT, sizeof (self->radio_text));
 
-  basrc->buffer_time = 5000000;
+  /* the drift is taken up by the radio, keeping audio-depth */
+  basrc->buffer_time = 200000;
 
+  /* the clock, when provided, is the dongle's */
   gst_audio_base_src_set_provide_clock (basrc, FALSE);
 }
 
@@ -573,10 +1660,12 @@ gst_sdrjfm_src_class_init (GstSdrjfmSrcClass * klass)
 {
   GObjectClass *gobject_class;
   GstElementClass *gstelement_class;
+  GstBaseSrcClass *gstbasesrc_class;
   GstAudioSrcClass *gstaudiosrc_class;
 
   gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
+  gstbasesrc_class = (GstBaseSrcClass *) klass;
   gstaudiosrc_class = (GstAudioSrcClass *) klass;
 
   gobject_class->dispose = gst_sdrjfm_src_dispose;
@@ -584,6 +1673,16 @@ gst_sdrjfm_src_class_init (GstSdrjfmSrcClass * klass)
   gobject_class->get_property = gst_sdrjfm_src_get_property;
   gobject_class->set_property = gst_sdrjfm_src_set_property;
 
+  gstelement_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_sdrjfm_src_request_new_pad);
+  gstelement_class->release_pad = GST_DEBUG_FUNCPTR (gst_sdrjfm_src_release_pad);
+  gstelement_class->provide_clock =
+      GST_DEBUG_FUNCPTR (gst_sdrjfm_src_provide_clock);
+
+  gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_sdrjfm_src_create);
+  gstbasesrc_class->fixate = GST_DEBUG_FUNCPTR (gst_sdrjfm_src_fixate);
+  gstbasesrc_class->query = GST_DEBUG_FUNCPTR (gst_sdrjfm_src_query);
+
   gstaudiosrc_class->open = GST_DEBUG_FUNCPTR (gst_sdrjfm_src_open);
   gstaudiosrc_class->prepare = GST_DEBUG_FUNCPTR (gst_sdrjfm_src_prepare);
   gstaudiosrc_class->unprepare = GST_DEBUG_FUNCPTR (gst_sdrjfm_src_unprepare);
@@ -648,6 +1747,91 @@ gst_sdrjfm_src_class_init (GstSdrjfmSrcClass * klass)
 						 | GST_PARAM_MUTABLE_PLAYING
 						 | G_PARAM_STATIC_STRINGS)));
 
+  g_object_class_install_property (gobject_class, PROP_INPUT_LOCATION,
+      g_param_spec_string ("input-location", "Input Location",
+			"I/Q recording to play instead of the dongle "
+			"(raw unsigned 8-bit pairs, or 32-bit float pairs for "
+			".cf32, .fc32 and .cfile files)",
+			NULL,
+			static_cast<GParamFlags>(G_PARAM_READWRITE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_INPUT_PACED,
+      g_param_spec_boolean ("input-paced", "Input Paced",
+			"Play the I/Q recording at its real rate, rather than "
+			"as fast as it can be demodulated",
+			DEFAULT_INPUT_PACED,
+			static_cast<GParamFlags>(G_PARAM_READWRITE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_IQ_RECORD_LOCATION,
+      g_param_spec_string ("iq-record-location", "I/Q Record Location",
+			"File to record the raw I/Q samples from the dongle in "
+			"(with frequency and gain changes in <location>.meta)",
+			NULL,
+			static_cast<GParamFlags>(G_PARAM_READWRITE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_IQ_RECORD_DROPPED,
+      g_param_spec_int ("iq-record-dropped", "I/Q Record Dropped",
+			"Number of sample blocks the I/Q recording could not keep up with",
+			0, G_MAXINT, 0,
+			static_cast<GParamFlags>(G_PARAM_READABLE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_INPUT_GENERATOR,
+      g_param_spec_string ("input-generator", "Input Generator",
+			"Synthetic FM signal to demodulate instead of the dongle's, "
+			"as key=value pairs separated by ';' "
+			"(e.g. \"ps=TEST FM;rt=Hello;snr=30\")",
+			NULL,
+			static_cast<GParamFlags>(G_PARAM_READWRITE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_HEALTH,
+      g_param_spec_boxed ("health", "Health",
+			"Counts of lost USB transfers, dropped samples and audio "
+			"underruns, and the buffer fill levels, as a "
+			"sdrjfmsrc-health structure",
+			GST_TYPE_STRUCTURE,
+			static_cast<GParamFlags>(G_PARAM_READABLE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_HEALTH_INTERVAL,
+      g_param_spec_uint ("health-interval", "Health Interval",
+			"Interval between sdrjfmsrc-health bus messages while "
+			"playing, in milliseconds, 0 for none",
+			0, G_MAXUINT, DEFAULT_HEALTH_INTERVAL,
+			static_cast<GParamFlags>(G_PARAM_READWRITE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_TELEMETRY_INTERVAL,
+      g_param_spec_uint ("telemetry-interval", "Telemetry Interval",
+			"Interval between sdrjfmsrc-reception bus messages while "
+			"playing, in milliseconds, 0 for none",
+			0, G_MAXUINT, DEFAULT_TELEMETRY_INTERVAL,
+			static_cast<GParamFlags>(G_PARAM_READWRITE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_RDS_WINDOW,
+      g_param_spec_uint ("rds-window", "RDS Window",
+			"Time over which the RDS changes of the station label "
+			"and the radio text are coalesced into one bus message "
+			"each, in milliseconds",
+			0, G_MAXUINT, DEFAULT_RDS_WINDOW,
+			static_cast<GParamFlags>(G_PARAM_READWRITE
+						 | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_AUDIO_DEPTH,
+      g_param_spec_uint ("audio-depth", "Audio Depth",
+			"Audio held waiting in the radio, in milliseconds, the "
+			"radio trims its audio rate to keep it as the audio is "
+			"read at the rate of the clock; 0 to read the audio as "
+			"it comes, set before starting",
+			0, 500, DEFAULT_AUDIO_DEPTH,
+			static_cast<GParamFlags>(G_PARAM_READWRITE
+						 | G_PARAM_STATIC_STRINGS)));
+
   signals[SIGNAL_SEEK_UP] =
       g_signal_new ("seek-up", G_TYPE_FROM_CLASS (klass),
 		    static_cast<GSignalFlags>( G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
@@ -673,5 +1857,22 @@ gst_sdrjfm_src_class_init (GstSdrjfmSrcClass * klass)
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&sdrjfmsrc_src_factory));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sdrjfmsrc_rds_factory));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sdrjfmsrc_mpx_factory));
+
+  gst_tag_register (TAG_RDS_PROGRAMME_IDENTIFICATION, GST_TAG_FLAG_META,
+      G_TYPE_UINT, "RDS programme identification",
+      "RDS programme identification code of the station", NULL);
+  gst_tag_register (TAG_RDS_PROGRAMME_TYPE, GST_TAG_FLAG_META,
+      G_TYPE_UINT, "RDS programme type",
+      "RDS programme type code of the programme", NULL);
+  gst_tag_register (TAG_RDS_STATION_LABEL, GST_TAG_FLAG_META,
+      G_TYPE_STRING, "RDS station label",
+      "RDS label of the station", NULL);
+  gst_tag_register (TAG_RDS_RADIO_TEXT, GST_TAG_FLAG_META,
+      G_TYPE_STRING, "RDS radio text",
+      "RDS text of the station", NULL);
 }
 
@@ -27,13 +27,80 @@
 #include <gst/audio/gstaudiosrc.h>
 
 #include <gui.h>
+#include <seqlock.h>
 
 //typedef struct _GstSdrjfmSrc GstSdrjfmSrc;
 typedef struct _GstSdrjfmSrcClass GstSdrjfmSrcClass;
 
+/** \brief The RDS events of one field, the station label or the
+ * radio text, as written by the radio.
+ *
+ * The counts only ever go up, the events not yet posted are those
+ * counted since the last posting.
+ */
+struct GstSdrjfmRdsEvents {
+  guint clears;
+  guint changes;
+  guint completes;
+  /** The changes and completes counted before the last clear */
+  guint changes_at_clear;
+  guint completes_at_clear;
+  /** The field after the last change or complete */
+  gchar text[65];
+  /** The field at the last complete */
+  gchar complete[65];
+};
+
+/** \brief An RDS group as received by the radio, with the RDS fields
+ * as they were once it was decoded.
+ */
+struct GstSdrjfmRdsGroup {
+  /** The position of the group in the audio, in frames */
+  gint64 frame;
+  /** The blocks A to D, without their check words */
+  guint16 blocks[4];
+  /** The last complete station label and radio text, or empty */
+  gchar station_label[9];
+  gchar radio_text[65];
+};
+
 /** \brief The SDR-J FM source element.
  *
- * This element will send a variety of bus messages.
+ * The audio is demodulated at the rate negotiated, 32000, 44100 or
+ * 48000 Hz, as mono or stereo floats or 16-bit integers.  Float stereo
+ * at 44100 Hz is preferred when downstream leaves the choice.  The
+ * dongle is read at 24 times 44100 Hz whatever the audio rate, which
+ * is also the rate an `input-location` recording is taken to be at;
+ * the demodulator resamples to the audio rate in its audio filter.
+ *
+ * The audio is read at the rate of the pipeline clock, `audio-depth`
+ * milliseconds behind the radio, and the radio trims its audio rate
+ * by up to 1000 ppm to keep that depth, so the crystal of the dongle
+ * and the clock of the audio sink may drift apart without the audio
+ * ever running dry or over.
+ *
+ * The audio is timestamped with the time its first frame was
+ * captured, found from the dongle's count of the samples it delivered
+ * at the nominal input rate, rather than with the time it is read.  In
+ * the pipeline clock that count follows the time the samples come in,
+ * slowly, for the drift of the crystal.  With `provide-clock` set, the
+ * element provides a clock counting the samples captured instead, the
+ * pipeline then runs at the rate of the dongle.  The generator, paced,
+ * counts its samples too; the audio of a recording is timestamped by
+ * GstAudioBaseSrc.
+ *
+ * The error of the dongle's crystal is measured while a stereo station
+ * plays, from the offset of its carrier and of its 19 kHz pilot, and
+ * corrected for, in whole ppm.  The correction is kept per serial
+ * number of the dongle, in `sdrjfm/crystals.conf` in the user's
+ * configuration directory, and applied when the dongle is opened
+ * again, also by rtlsdrsrc.  Dongles that share a serial number share
+ * the correction.
+ *
+ * This element will send a variety of bus messages.  The RDS
+ * messages of a field are coalesced over `rds-window` milliseconds:
+ * within a window a clear is posted once and only the last change of
+ * the field, and its last completion, are posted.
  * <DL>
  * 
  * <DT>`sdrjfmsrc-frequency-changed`</DT>
@@ -139,7 +206,100 @@ typedef struct _GstSdrjfmSrcClass GstSdrjfmSrcClass;
  * </TABLE>
  * </DD>
  * 
+ * <DT>`sdrjfmsrc-health`</DT>
+ * <DD>Emitted every `health-interval` milliseconds while playing, with
+ * the counts of samples lost so far and the fill levels of the
+ * buffers.  The same structure is the value of the `health` property.
+ * <P><B>Properties</B>
+ * <TABLE>
+ * <TR>
+ * <TD>Name</TD><TD>Type</TD><TD>Description</TD><TD>Example</TD>
+ * </TR>
+ * <TR><TD>`usb-short-transfers`</TD><TD>`G_TYPE_UINT64`</TD><TD>USB
+ * transfers dropped for not having the expected length</TD><TD>0</TD></TR>
+ * <TR><TD>`usb-dropped-samples`</TD><TD>`G_TYPE_UINT64`</TD><TD>I/Q
+ * samples dropped because the input buffer was full</TD><TD>0</TD></TR>
+ * <TR><TD>`audio-dropped-frames`</TD><TD>`G_TYPE_UINT64`</TD><TD>Audio
+ * frames dropped because the audio buffer was full</TD><TD>0</TD></TR>
+ * <TR><TD>`audio-underruns`</TD><TD>`G_TYPE_UINT64`</TD><TD>Reads
+ * that found the audio buffer empty and had to wait</TD><TD>12</TD></TR>
+ * <TR><TD>`recorder-dropped-blocks`</TD><TD>`G_TYPE_UINT64`</TD><TD>Blocks
+ * the I/Q recording could not keep up with</TD><TD>0</TD></TR>
+ * <TR><TD>`input-fill`</TD><TD>`G_TYPE_INT`</TD><TD>I/Q samples
+ * waiting in the input buffer, 0 without a dongle</TD><TD>8192</TD></TR>
+ * <TR><TD>`input-size`</TD><TD>`G_TYPE_INT`</TD><TD>Size of the input
+ * buffer in I/Q samples, 0 without a dongle</TD><TD>524288</TD></TR>
+ * <TR><TD>`audio-fill`</TD><TD>`G_TYPE_INT`</TD><TD>Audio frames
+ * waiting in the audio buffer</TD><TD>512</TD></TR>
+ * <TR><TD>`audio-size`</TD><TD>`G_TYPE_INT`</TD><TD>Size of the audio
+ * buffer in frames</TD><TD>32768</TD></TR>
+ * <TR><TD>`audio-rate-correction`</TD><TD>`G_TYPE_DOUBLE`</TD><TD>Trim
+ * of the audio rate holding the `audio-depth`, in ppm, the drift of
+ * the clock against the dongle once settled</TD><TD>-42.5</TD></TR>
+ * <TR><TD>`crystal-correction`</TD><TD>`G_TYPE_INT`</TD><TD>Correction
+ * of the crystal of the dongle, in ppm, 0 without one</TD><TD>57</TD></TR>
+ * </TABLE>
+ * </DD>
+ *
+ * <DT>`sdrjfmsrc-reception`</DT>
+ * <DD>Emitted every `telemetry-interval` milliseconds while playing,
+ * when the radio has taken a new record of the quality of the
+ * reception.  The radio takes four records per second of input.  The
+ * strengths are in dB above the noise around them, the noise in dB
+ * above silence.
+ * <P><B>Properties</B>
+ * <TABLE>
+ * <TR>
+ * <TD>Name</TD><TD>Type</TD><TD>Description</TD><TD>Example</TD>
+ * </TR>
+ * <TR><TD>`sequence`</TD><TD>`G_TYPE_UINT64`</TD><TD>Number of the
+ * record, a gap means records were not posted</TD><TD>42</TD></TR>
+ * <TR><TD>`signal-strength`</TD><TD>`G_TYPE_DOUBLE`</TD><TD>Strength
+ * of the audio, the signal to noise ratio</TD><TD>30.1</TD></TR>
+ * <TR><TD>`pilot-strength`</TD><TD>`G_TYPE_DOUBLE`</TD><TD>Strength
+ * of the 19 kHz stereo pilot</TD><TD>18.5</TD></TR>
+ * <TR><TD>`rds-strength`</TD><TD>`G_TYPE_DOUBLE`</TD><TD>Strength of
+ * the 57 kHz RDS subcarrier</TD><TD>9.2</TD></TR>
+ * <TR><TD>`noise-strength`</TD><TD>`G_TYPE_DOUBLE`</TD><TD>Level of
+ * the noise around the pilot and the RDS subcarrier</TD>
+ * <TD>12.0</TD></TR>
+ * <TR><TD>`dc-component`</TD><TD>`G_TYPE_DOUBLE`</TD><TD>Mean of the
+ * demodulated signal, an offset of the tuning</TD><TD>0.01</TD></TR>
+ * <TR><TD>`stereo`</TD><TD>`G_TYPE_BOOLEAN`</TD><TD>Whether the
+ * pilot is found and stereo is decoded</TD><TD>true</TD></TR>
+ * <TR><TD>`rds-synchronized`</TD><TD>`G_TYPE_BOOLEAN`</TD><TD>Whether
+ * the RDS decoder is synchronized on the blocks</TD><TD>true</TD></TR>
+ * <TR><TD>`rds-bit-error-rate`</TD><TD>`G_TYPE_DOUBLE`</TD><TD>Fraction
+ * of the RDS bits corrected, while synchronized</TD><TD>0.002</TD></TR>
+ * <TR><TD>`rds-sync-errors`</TD><TD>`G_TYPE_INT`</TD><TD>Failed RDS
+ * synchronizations since tuning</TD><TD>3</TD></TR>
+ * <TR><TD>`rds-crc-errors`</TD><TD>`G_TYPE_INT`</TD><TD>RDS blocks
+ * with errors that could not be corrected, since tuning</TD>
+ * <TD>1</TD></TR>
+ * <TR><TD>`rds-groups`</TD><TD>`G_TYPE_INT`</TD><TD>RDS groups
+ * received since tuning</TD><TD>215</TD></TR>
+ * </TABLE>
+ * </DD>
+ *
  * </DL>
+ *
+ * The RDS programme identification, programme type, station label and
+ * radio text also go downstream in tag events, ahead of the audio
+ * received with the group that changed them.  The tags are
+ * `rds-programme-identification` and `rds-programme-type`, unsigned
+ * integers, and `rds-station-label` and `rds-radio-text`, strings,
+ * with the label as `organization` and the text as `title` as well.
+ *
+ * An `rds` pad can be requested for the RDS groups themselves, caps
+ * `application/x-rds`: each buffer is one group, the blocks A to D as
+ * big endian 16-bit words without their check words, timestamped as
+ * the audio it was received with.  It is pushed from the streaming
+ * thread of the audio, so it should be linked through a queue.
+ *
+ * An `mpx` pad can be requested for the demodulated multiplex, mono
+ * F32 audio at the rate of the demodulator, 176400 Hz, timestamped as
+ * the audio made from it.  The multiplex is only kept while the pad
+ * is linked, and it is pushed like the RDS groups.
  */
 struct GstSdrjfmSrc {
   GstAudioSrc    src;
@@ -178,6 +338,113 @@ struct GstSdrjfmSrc {
    * trailing whitespace.
    */
   gchar radio_text[65];
+  /** \brief A recording to play instead of the dongle, or NULL.
+   *
+   * Raw unsigned 8-bit I/Q pairs, or interleaved 32-bit float pairs
+   * for a `.cf32`, `.fc32` or `.cfile` name, at the dongle's sample rate.
+   */
+  gchar *input_location;
+  /** Whether the recording plays at its real rate, or as fast as
+   * the demodulator can process it
+   */
+  gboolean input_paced;
+  /** \brief File to record the dongle's raw I/Q samples in, or NULL.
+   *
+   * Frequency and gain changes and dropped blocks go into a
+   * `.meta` file next to it.
+   */
+  gchar *iq_record_location;
+  /** \brief Description of a synthetic signal to demodulate
+   * instead of the dongle's, or NULL.
+   *
+   * `key=value` pairs separated by `;`, see signal-generator.h.
+   */
+  gchar *input_generator;
+  /** Milliseconds between two `sdrjfmsrc-health` messages, 0 for none */
+  guint health_interval;
+  /** The source posting the `sdrjfmsrc-health` messages, or 0 */
+  guint health_timeout;
+  /** Milliseconds between two `sdrjfmsrc-reception` messages, 0 for none */
+  guint telemetry_interval;
+  /** The source posting the `sdrjfmsrc-reception` messages, or 0 */
+  guint telemetry_timeout;
+  /** The sequence number of the last record posted */
+  guint64 telemetry_sequence;
+  /** \brief The RDS events of the station label and the radio text.
+   *
+   * Written by the radio without taking the object lock and read by
+   * `rds_source`, which posts them.
+   */
+  seqLock<GstSdrjfmRdsEvents> *rds_events;
+  /** The RDS events as far as they have been posted */
+  GstSdrjfmRdsEvents rds_posted[2];
+  /** The source posting the RDS events, on the default main context */
+  GSource *rds_source;
+  /** Whether `rds_source` has been set to run */
+  gint rds_due;
+  /** Milliseconds over which the RDS events of a field are coalesced */
+  guint rds_window;
+  /** The RDS groups received and not yet pushed, written by the radio */
+  RingBuffer<GstSdrjfmRdsGroup> *rds_groups;
+  /** The position in the audio of the first frame read since preparing */
+  gint64 frame_base;
+  /** The RDS fields as in the last tag event, programme identification
+   * -1 for none yet */
+  gint rds_tag_pi;
+  gint rds_tag_pty;
+  gchar rds_tag_station_label[9];
+  gchar rds_tag_radio_text[65];
+  /** The requested `rds` pad, or NULL */
+  GstPad *rds_pad;
+  /** Whether the stream-start, caps and segment are sent on `rds_pad` */
+  gboolean rds_pad_started;
+  /** The multiplex demodulated and not yet pushed, written by the
+   * radio while `mpx_enabled`, NULL until the `mpx` pad is requested */
+  RingBuffer<mpxBlock> *mpx_blocks;
+  /** The requested `mpx` pad, or NULL */
+  GstPad *mpx_pad;
+  gboolean mpx_pad_started;
+  /** Whether the radio writes in `mpx_blocks`, while `mpx_pad` is linked */
+  gboolean mpx_enabled;
+  /** The audio frame the multiplex pushed last ends at, G_MININT64
+   * before the first block since linking */
+  gint64 mpx_next_frame;
+  /** The audio rate the radio demodulates at, the one last negotiated */
+  gint audio_rate;
+  /** The channels and sample format negotiated */
+  gint channels;
+  gboolean s16;
+  /** The float stereo audio of the radio, to be converted as it is
+   * read, NULL when it is read as it is */
+  DSPFLOAT *scratch;
+  guint scratch_frames;
+  /** Milliseconds of audio held waiting in the radio, 0 to read it
+   * as it comes */
+  guint audio_depth;
+  /** \brief The clock time of the first read, and the frames read
+   * since, to read them at the rate of the clock.
+   *
+   * GST_CLOCK_TIME_NONE until the first read after preparing or after
+   * the radio ran dry.
+   */
+  GstClockTime pace_start;
+  guint64 pace_frames;
+  /** The wait for the next read, to be unscheduled by reset, under
+   * the object lock */
+  GstClockID pace_id;
+  /** \brief The monotonic time, in ns, of capture index 0, from the
+   * count of the samples captured, G_MININT64 until found.
+   *
+   * `capture_base` follows the time the samples come in, for the
+   * timestamps in a clock other than `capture_clock`, which counts
+   * from `capture_clock_base`.  Both, and `radio` as it changes,
+   * under `capture_lock`.
+   */
+  gint64 capture_base;
+  gint64 capture_clock_base;
+  GMutex capture_lock;
+  /** The clock provided with `provide-clock` set */
+  GstClock *capture_clock;
 
   RadioInterface *radio;
 };
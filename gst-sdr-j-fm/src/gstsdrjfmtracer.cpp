@@ -0,0 +1,293 @@
+/* GStreamer
+ * Copyright (C) 2014 Collabora <info@collabora.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+/**
+ * SECTION:tracer-sdrjfm
+ *
+ * Logs and prints the time taken by each stage of the demodulation in
+ * the sdrjfmsrc elements.
+ *
+ * <refsect2>
+ * <title>Example</title>
+ * |[
+ * GST_TRACERS=sdrjfm GST_DEBUG=GST_TRACER:7 gst-launch-1.0 sdrjfmsrc ! fakesink
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstsdrjfmtracer.h"
+
+#if GST_CHECK_VERSION(1, 8, 0)
+
+#include "gstsdrjfmsrc.h"
+
+GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
+#define GST_CAT_DEFAULT sdrjfm_debug
+
+#define DEFAULT_INTERVAL GST_SECOND
+
+#define gst_sdrjfm_tracer_parent_class parent_class
+
+extern "C" {
+G_DEFINE_TYPE (GstSdrjfmTracer, gst_sdrjfm_tracer, GST_TYPE_TRACER);
+}
+
+static GstTracerRecord *tr_stage;
+
+/* the time of the last record logged for an element */
+static GQuark last_log_quark;
+
+static gchar *
+gst_sdrjfm_tracer_histogram (const stageProfile::histogram * h)
+{
+  GString *s = g_string_new (NULL);
+  gint k;
+
+  for (k = 0; k < PROFILE_BUCKETS; k++)
+    if (h->buckets[k] > 0)
+      g_string_append_printf (s, "%s%" G_GUINT64_FORMAT ":%" G_GINT64_FORMAT,
+          s->len > 0 ? "," : "", (guint64) 1 << k, h->buckets[k]);
+
+  return g_string_free (s, FALSE);
+}
+
+static void
+gst_sdrjfm_tracer_log (GstSdrjfmSrc * src, const stageProfile::snapshot * p)
+{
+  gint s;
+
+  for (s = 0; s <= stageProfile::STAGES; s++) {
+    const stageProfile::histogram *h =
+        s < stageProfile::STAGES ? &p->stage[s] : &p->block;
+    gchar *histogram;
+
+    if (h->count == 0)
+      continue;
+
+    histogram = gst_sdrjfm_tracer_histogram (h);
+    gst_tracer_record_log (tr_stage, GST_OBJECT_NAME (src),
+        stageProfile::name (s), (guint64) h->count,
+        (guint64) (h->total / h->count),
+        (guint64) stageProfile::percentile (h, 0.5),
+        (guint64) stageProfile::percentile (h, 0.99),
+        (guint64) h->max, histogram);
+    g_free (histogram);
+  }
+}
+
+/* Printed when the element closes, so that GST_TRACERS=sdrjfm on its
+ * own shows where the time went */
+static void
+gst_sdrjfm_tracer_print (GstSdrjfmSrc * src, const stageProfile::snapshot * p)
+{
+  gint s, k;
+
+  g_printerr ("%s: %" G_GINT64_FORMAT " blocks, time per block in us\n",
+      GST_OBJECT_NAME (src), p->blocks);
+  g_printerr ("  %-10s %8s %9s %9s %9s %9s\n", "stage", "blocks", "mean",
+      "p50", "p99", "max");
+
+  for (s = 0; s <= stageProfile::STAGES; s++) {
+    const stageProfile::histogram *h =
+        s < stageProfile::STAGES ? &p->stage[s] : &p->block;
+
+    if (h->count == 0)
+      continue;
+
+    g_printerr ("  %-10s %8" G_GINT64_FORMAT " %9.1f %9.1f %9.1f %9.1f\n",
+        stageProfile::name (s), h->count, h->total / (h->count * 1e3),
+        stageProfile::percentile (h, 0.5) / 1e3,
+        stageProfile::percentile (h, 0.99) / 1e3, h->max / 1e3);
+    /* the histogram, one line per power of two */
+    for (k = 0; k < PROFILE_BUCKETS; k++)
+      if (h->buckets[k] > 0)
+        g_printerr ("  %10s < %8.1f %8" G_GINT64_FORMAT "\n", "",
+            ((gint64) 2 << k) / 1e3, h->buckets[k]);
+  }
+}
+
+static void
+do_push_buffer_pre (GstTracer * tracer, GstClockTime ts, GstPad * pad,
+    GstBuffer * buffer)
+{
+  GstSdrjfmTracer *self = GST_SDRJFM_TRACER (tracer);
+  GstObject *parent = GST_OBJECT_PARENT (pad);
+  GstSdrjfmSrc *src;
+  stageProfile::snapshot profile;
+  GstClockTime *last;
+
+  if (parent == NULL || !GST_IS_SDRJFM_SRC (parent))
+    return;
+  src = GST_SDRJFM_SRC (parent);
+  if (src->radio == NULL)
+    return;
+
+  /* the first buffer only starts the interval */
+  last = (GstClockTime *) g_object_get_qdata (G_OBJECT (src), last_log_quark);
+  if (last == NULL) {
+    last = g_new (GstClockTime, 1);
+    *last = ts;
+    g_object_set_qdata_full (G_OBJECT (src), last_log_quark, last, g_free);
+    return;
+  }
+  if (ts - *last < self->interval)
+    return;
+
+  *last = ts;
+  src->radio->getProfile (&profile);
+  gst_sdrjfm_tracer_log (src, &profile);
+}
+
+static void
+do_element_change_state_pre (GstTracer * tracer, GstClockTime ts,
+    GstElement * element, GstStateChange transition)
+{
+  GstSdrjfmSrc *src;
+  stageProfile::snapshot profile;
+
+  if (transition != GST_STATE_CHANGE_READY_TO_NULL ||
+      !GST_IS_SDRJFM_SRC (element))
+    return;
+  src = GST_SDRJFM_SRC (element);
+  if (src->radio == NULL)
+    return;
+
+  /* the radio is deleted in this state change */
+  src->radio->getProfile (&profile);
+  if (profile.blocks == 0)
+    return;
+  gst_sdrjfm_tracer_log (src, &profile);
+  gst_sdrjfm_tracer_print (src, &profile);
+  g_object_set_qdata (G_OBJECT (src), last_log_quark, NULL);
+}
+
+static void
+gst_sdrjfm_tracer_constructed (GObject * object)
+{
+  GstSdrjfmTracer *self = GST_SDRJFM_TRACER (object);
+  gchar *params, *desc;
+  GstStructure *s;
+  gdouble interval;
+  gint seconds;
+
+  g_object_get (self, "params", &params, NULL);
+  if (params == NULL)
+    goto done;
+
+  desc = g_strdup_printf ("sdrjfm,%s", params);
+  s = gst_structure_from_string (desc, NULL);
+  if (s == NULL)
+    GST_WARNING_OBJECT (self, "Can't parse tracer parameters `%s'", params);
+  else {
+    /* interval=5 parses as an int, interval=0.5 as a double */
+    if (gst_structure_get_int (s, "interval", &seconds))
+      interval = seconds;
+    else if (!gst_structure_get_double (s, "interval", &interval))
+      interval = 0;
+    if (interval > 0)
+      self->interval = (GstClockTime) (interval * GST_SECOND);
+    gst_structure_free (s);
+  }
+  g_free (desc);
+  g_free (params);
+
+done:
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
+static void
+gst_sdrjfm_tracer_class_init (GstSdrjfmTracerClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->constructed = gst_sdrjfm_tracer_constructed;
+
+  last_log_quark = g_quark_from_static_string ("sdrjfm-tracer-last-log");
+
+  /* The times are in nanoseconds, the histogram gives the number of
+   * blocks per power of two: "1024:3,2048:120" is 3 blocks that took
+   * from 1024 to 2047 ns and 120 from 2048 to 4095 ns */
+  tr_stage = gst_tracer_record_new ("sdrjfm-stage.class",
+      "element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "stage", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "Stage of the demodulation",
+          NULL),
+      "blocks", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "Blocks that went through the stage",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "mean", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "Mean time per block in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "p50", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "Median time per block in ns, "
+          "rounded up to a power of two",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "p99", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "99th percentile of the time per "
+          "block in ns, rounded up to a power of two",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "max", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "Longest time for a block in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "histogram", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "Blocks per power of two ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      NULL);
+#if GST_CHECK_VERSION(1, 10, 0)
+  GST_OBJECT_FLAG_SET (tr_stage, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+#endif
+}
+
+static void
+gst_sdrjfm_tracer_init (GstSdrjfmTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  self->interval = DEFAULT_INTERVAL;
+
+  gst_tracing_register_hook (tracer, "pad-push-pre",
+      G_CALLBACK (do_push_buffer_pre));
+  gst_tracing_register_hook (tracer, "element-change-state-pre",
+      G_CALLBACK (do_element_change_state_pre));
+}
+
+#endif /* GST_CHECK_VERSION(1, 8, 0) */
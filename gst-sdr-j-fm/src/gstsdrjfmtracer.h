@@ -0,0 +1,66 @@
+/* GStreamer
+ * Copyright (C) 2014 Collabora <info@collabora.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_SDRJFM_TRACER_H__
+#define __GST_SDRJFM_TRACER_H__
+
+#include <gst/gst.h>
+
+#if GST_CHECK_VERSION(1, 8, 0)
+
+#include <gst/gsttracer.h>
+
+/** \brief A tracer for the time taken by each stage of the demodulation.
+ *
+ * Enabled with `GST_TRACERS=sdrjfm`, or `GST_TRACERS="sdrjfm(interval=5)"`
+ * for a record every 5 seconds rather than every second.  For every
+ * `sdrjfmsrc` it logs, while streaming, a `sdrjfm-stage` record per
+ * stage (seen with `GST_DEBUG=GST_TRACER:7`) and, when the element is
+ * closed, it prints a table of the stages with their histograms on
+ * stderr.
+ *
+ * The stages are those of the stageProfile kept by the fmProcessor,
+ * which also feeds the `sdrjfm:stage` and `sdrjfm:block` USDT probes.
+ */
+struct GstSdrjfmTracer {
+  GstTracer parent;
+
+  /** Time between two records for an element, in nanoseconds */
+  GstClockTime interval;
+};
+
+typedef struct _GstSdrjfmTracerClass GstSdrjfmTracerClass;
+
+struct _GstSdrjfmTracerClass {
+  GstTracerClass parent_class;
+};
+
+extern "C" {
+
+#define GST_TYPE_SDRJFM_TRACER           (gst_sdrjfm_tracer_get_type())
+#define GST_SDRJFM_TRACER(obj)           (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SDRJFM_TRACER,GstSdrjfmTracer))
+#define GST_IS_SDRJFM_TRACER(obj)        (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SDRJFM_TRACER))
+
+GType gst_sdrjfm_tracer_get_type(void);
+
+}
+
+#endif /* GST_CHECK_VERSION(1, 8, 0) */
+
+#endif /* __GST_SDRJFM_TRACER_H__ */
@@ -123,5 +123,21 @@ DSPFLOAT	PI_Constrain (DSPFLOAT val) {
 	   return val + 2 * M_PI;
 	return 2 * M_PI - fmod (- val, 2 * M_PI);
 }
+//
+//	Phase accumulators are kept as fractions of a full turn
+//	in an unsigned 32 bit word: 2^32 is 2 * M_PI, so wrapping
+//	comes for free with the overflow and no fmod is needed
+typedef	uint32_t	DSPPHASE;
+#define	PHASE_TURN	4294967296.0
+
+static inline
+DSPPHASE	toPhase (double radians) {
+	return (DSPPHASE)(int64_t)(radians * (PHASE_TURN / (2 * M_PI)));
+}
+
+static inline
+DSPFLOAT	toRadians (DSPPHASE phase) {
+	return phase * (2 * M_PI / PHASE_TURN);
+}
 #endif
 
@@ -32,6 +32,8 @@
 #include	"sincos.h"
 #include	"pllC.h"
 #include	"Xtan2.h"
+#include	"sample-block.h"
+#include	"dsp-kernels.h"
 
 #define	PLL_PILOT_GAIN	3000
 
@@ -57,10 +59,24 @@ private:
 	int32_t		ArcsineSize;
 	DSPFLOAT	*Arcsine;
 	compAtan	myAtan;
+	const dspKernels	*kernels;
 	DSPFLOAT	Imin1;
 	DSPFLOAT	Qmin1;
 	DSPFLOAT	Imin2;
 	DSPFLOAT	Qmin2;
+	void	demodulate	(const DSPFLOAT *, const DSPFLOAT *,
+	                         DSPFLOAT *, int32_t);
+	void	demodulateFM1	(const DSPFLOAT *, const DSPFLOAT *,
+	                         DSPFLOAT *, int32_t);
+	void	demodulateFM2	(const DSPFLOAT *, const DSPFLOAT *,
+	                         DSPFLOAT *, int32_t);
+	void	demodulateFM3	(const DSPFLOAT *, const DSPFLOAT *,
+	                         DSPFLOAT *, int32_t);
+	void	demodulateFM4	(const DSPFLOAT *, const DSPFLOAT *,
+	                         DSPFLOAT *, int32_t);
+	void	demodulateFM5	(const DSPFLOAT *, const DSPFLOAT *,
+	                         DSPFLOAT *, int32_t);
+	void	removeDC	(DSPFLOAT *, int32_t);
 public:
 		fm_Demodulator	(int32_t	Rate_in,
 	                         SinCos		*mySinCos,
@@ -69,7 +85,12 @@ public:
 	void	setDecoder	(int8_t);
 const	char	*nameofDecoder	(void);
 	DSPFLOAT	demodulate	(DSPCOMPLEX);
+	void		demodulate	(const DSPCOMPLEX *, DSPFLOAT *, int32_t);
+	void		demodulate	(const sampleBlock *, DSPFLOAT *);
 	DSPFLOAT	get_DcComponent	(void);
+//	the dc component as the offset of the carrier, in Hz; false
+//	if the decoder does not give it
+	bool		get_DcFrequency	(DSPFLOAT *);
 };
 #endif
 
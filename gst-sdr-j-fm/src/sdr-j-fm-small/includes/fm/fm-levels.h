@@ -30,6 +30,7 @@
 
 #include	"fm-constants.h"
 #include	"fft.h"
+#include	"dsp-kernels.h"
 
 class	fmLevels {
 public:
@@ -65,7 +66,9 @@ private:
 	common_fft	*compute;
 	DSPCOMPLEX	*buffer;
 	DSPFLOAT	*inputBuffer;
+	DSPFLOAT	*windowed;
 	int16_t		bufferPointer;
+	const dspKernels	*kernels;
 	int32_t		counter;
 };
 
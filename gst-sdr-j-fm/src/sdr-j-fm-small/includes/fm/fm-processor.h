@@ -34,14 +34,38 @@
 #include	"fir-filters.h"
 #include	"fft-filters.h"
 #include	"sincos.h"
+#include	"sample-block.h"
 #include	"pllC.h"
 #include	"fm-levels.h"
 #include	"ringbuffer.h"
 #include	"oscillator.h"
 #include	"resampler.h"
 #include	"rds-groupdecoder.h"
+#include	"stage-profile.h"
+#include	"seqlock.h"
 
 #define SCAN_BLOCK_SIZE 1024
+//	the number of telemetry records per second (of samples)
+#define	TELEMETRY_RATE	4
+
+/** A record of the quality of the reception, taken by the processor
+ * TELEMETRY_RATE times per second of input, the strengths are in dB
+ * above the noise around them, the noise in dB above silence
+ */
+struct	receptionTelemetry {
+	uint64_t	sequence;	// 1 for the first record
+	float		signalStrength;	// the audio band, a signal to noise
+	float		pilotStrength;
+	float		rdsStrength;
+	float		noiseStrength;
+	float		dcComponent;
+	bool		stereo;		// pilot found, decoding stereo
+	bool		rdsSynchronized;
+	float		rdsBitErrorRate;
+	int32_t		rdsSyncErrors;	// since the last tuning
+	int32_t		rdsCrcErrors;
+	int32_t		rdsGroups;
+};
 
 /** Callback type for scanning
  * \param frequency The frequency on which a station has been found, in Hz
@@ -49,13 +73,52 @@
  */
 typedef void (*StationCallback) (int32_t frequency, void *userdata);
 
+/** Callback type for the raw RDS groups, called from the processor
+ * \param blocks The blocks A to D of the group, without check words
+ * \param frame The audio frames written to the sink before the group
+ * \param userdata A pointer provided with the callback
+ */
+typedef void (*RdsGroupCallback) (const uint16_t *blocks, int64_t frame,
+	                          void *userdata);
+
+//	the samples of the multiplex in a block of the queue
+#define	MPX_BLOCK_SIZE	1024
+
+/** A block of the demodulated multiplex, at the fmRate, as queued
+ * for a reader by the processor
+ */
+struct	mpxBlock {
+	int64_t		frame;		// audio frames written before it
+	int32_t		count;		// samples in the block
+	float		samples [MPX_BLOCK_SIZE];
+};
+
+/** Where in the input the audio came from: the audio frames written
+ * after a block of input, and the capture index, as the input counts
+ * its samples, of the sample following the block
+ */
+struct	captureMark {
+	int64_t		frame;
+	int64_t		position;	// -1 for none
+};
+
+/** The offsets a crystal error of the input shows as, averaged over
+ * a few seconds with the pilot locked: the carrier is off by the
+ * error times the tuned frequency, the pilot by the error times
+ * its 19 KHz, both the other way round */
+struct	crystalEstimate {
+	uint64_t	sequence;	// 1 for the first estimate
+	bool		carrier;	// the decoder gave the dcOffset
+	float		dcOffset;	// of the carrier, in Hz
+	float		pilotOffset;	// of the pilot, in Hz
+};
+
 class		rigInterface;
 class		virtualInput;
 class		RadioInterface;
 class		fm_Demodulator;
 class		rdsDecoder;
 class		audioSink;
-class		newConverter;
 
 class	fmProcessor {
 public:
@@ -101,6 +164,33 @@ public:
 	void		stopScanning		(void);
 	bool		isScanning		(void);
 	const char *	nameofDecoder	(void);
+	/** Copy the timing of the stages of the processing so far */
+	void		getProfile	(stageProfile::snapshot *);
+	/** Copy the latest reception telemetry, without locking
+	 * \return false if there is none yet */
+	bool		getTelemetry	(receptionTelemetry *);
+	/** Have every RDS group received passed to a callback */
+	void		setRdsGroupCallback	(RdsGroupCallback, void *);
+	/** Have the multiplex put in a queue, or not for NULL.  Blocks
+	 * that do not fit are dropped, the queue must outlive the
+	 * processor */
+	void		setMpxQueue	(RingBuffer<mpxBlock> *);
+	/** Trim the audio rate to hold the frames waiting in the sink
+	 * at a depth, to follow the clock of its reader, 0 to not */
+	void		setAudioDepth	(int32_t);
+	/** The trim of the audio rate, relative, 0 if not following */
+	DSPFLOAT	get_rateCorrection	(void);
+	/** Copy the latest capture mark, without locking
+	 * \return false if there is none, the input may not count */
+	bool		getCaptureMark	(captureMark *);
+	/** Forget the capture mark, the frames it counts were flushed */
+	void		resetCaptureMark	(void);
+	/** Copy the latest estimate of the crystal error, without locking
+	 * \return false if there is none yet */
+	bool		getCrystalEstimate	(crystalEstimate *);
+	/** Start the next estimate over, the tuning or the correction
+	 * of the crystal changed */
+	void		resetCrystalEstimate	(void);
 
 	enum Channels {
 	   S_STEREO		= 0,
@@ -140,8 +230,8 @@ private:
 	pthread_mutex_t scanLock;
 	void		lockScan();
 	void		unlockScan();
-	/** Run the scan check for a single sample */
-	bool            checkStation(DSPCOMPLEX);
+	/** Run the scan check for a block of samples */
+	bool            checkStation(const sampleBlock *);
 	/** Add a found station to the list of found frequencies */
 	void            addStation(float);
 	/** Locate the central frequency of those found and issue
@@ -156,11 +246,37 @@ private:
 	DSPFLOAT	getSignal	(DSPCOMPLEX *, int32_t);
 	DSPFLOAT	getNoise	(DSPCOMPLEX *, int32_t);
 	bool		squelchOn;
+	int32_t		audioDepth;
+	int32_t		old_audioDepth;
+	DSPFLOAT	depthAverage;
+	DSPFLOAT	depthIntegral;
+	DSPFLOAT	rateCorrection;
+	void		followDepth	(int32_t);
+	stageProfile	profile;
+	seqLock<receptionTelemetry>	telemetry;
+	seqLock<captureMark>	captureMarks;
+	seqLock<crystalEstimate>	crystalEstimates;
+	uint64_t	crystalCount;
+	int32_t		crystalResets;
+	int32_t		old_crystalResets;
+	int32_t		crystalSamples;
+	bool		crystalSettled;
+	bool		dcValid;
+	double		dcSum;
+	void		trackCrystal	(int32_t, bool);
+	uint64_t	telemetryCount;
+	int32_t		telemetrySamples;
+	void		publishTelemetry	(bool);
+	static void	rdsGroup	(const uint16_t *, void *);
+	RdsGroupCallback	rdsGroupCallback;
+	void		*rdsGroupUserdata;
+	RingBuffer<mpxBlock>	*mpxQueue;
+	void		putMpx		(RingBuffer<mpxBlock> *,
+	                                 const DSPFLOAT *, int32_t, int64_t);
 	
 	void		sendSampletoOutput	(DSPCOMPLEX);
-	DecimatingFIR	*fmBandfilter;
+	DecimatingRealFIR	*fmBandfilter;
 	Oscillator	*localOscillator;
-	newConverter	*theConverter;
 	int32_t		lo_frequency;
 	bool		running;
 	SinCos		*mySinCos;
@@ -178,23 +294,23 @@ private:
 
 	rdsDecoder	*myRdsDecoder;
 
-	void		stereo	(DSPCOMPLEX *, DSPCOMPLEX *, DSPFLOAT *);
-	void		mono	(DSPCOMPLEX *, DSPCOMPLEX *, DSPFLOAT *);
+	void		stereo	(DSPFLOAT, DSPFLOAT *, DSPFLOAT *, DSPFLOAT *);
+	void		mono	(DSPFLOAT, DSPFLOAT *, DSPFLOAT *);
 	fftFilter	*pilotBandFilter;
 	fftFilter	*rdsBandFilter;
 //	fftFilter	*rdsLowPassFilter;
-	DecimatingFIR	*rdsLowPassFilter;
+	DecimatingRealFIR	*rdsLowPassFilter;
 	HilbertFilter	*rdsHilbertFilter;
 
 	fmLevels	*fm_Levels;
-	DSPFLOAT	pilotDelay;
+	DSPPHASE	pilotDelay;
 	DSPCOMPLEX	audioGainCorrection	(DSPCOMPLEX);
 	DSPFLOAT	Volume;
 	DSPFLOAT	audioGain;
 	int32_t		max_freq_deviation;
 	int32_t		norm_freq_deviation;
 	DSPFLOAT	omega_demod;
-	LowPassFIR	*fmAudioFilter;
+	ResamplingRealFIR	*fmAudioFilter;
 
 	int16_t		balance;
 	DSPFLOAT	leftChannel;
@@ -217,15 +333,16 @@ private:
 	class	pilotRecovery {
 	   private:
 	      int32_t	Rate_in;
-	      DSPFLOAT	pilot_OscillatorPhase;
+	      DSPPHASE	pilot_OscillatorPhase;
 	      DSPFLOAT	pilot_oldValue;
 	      DSPFLOAT	omega;
+	      DSPPHASE	omegaPhase;
 	      DSPFLOAT	gain;
 	      SinCos	*mySinCos;
 	      DSPFLOAT	pilot_Lock;
 	      bool	pll_isLocked;
 	      DSPFLOAT	quadRef;
-	      DSPFLOAT	accumulator;
+	      double		accumulator;
 	      int32_t	count;
 	   public:
 	      pilotRecovery (int32_t	Rate_in,
@@ -234,12 +351,15 @@ private:
 	                     SinCos	*mySinCos) {
 	         this	-> Rate_in	= Rate_in;
 	         this	-> omega	= omega;
+	         this	-> omegaPhase	= toPhase (omega);
 	         this	-> gain		= gain;
 	         this	-> mySinCos	= mySinCos;
 	         pll_isLocked		= false;
 	         pilot_Lock		= 0;
 	         pilot_oldValue		= 0;
 	         pilot_OscillatorPhase	= 0;
+	         accumulator		= 0;
+	         count			= 0;
 	      }
 
 	      ~pilotRecovery (void) {
@@ -248,17 +368,35 @@ private:
 	      bool	isLocked (void) {
 	         return pll_isLocked;
 	      }
+//
+//	the loop is first order, locked the corrections of the phase
+//	average to the offset of the pilot from 19 KHz. The offset,
+//	in Hz, over the samples it was locked since the previous call,
+//	false if it was not
+	      bool	getOffset (DSPFLOAT *offset) {
+	         bool	locked	= count > 0;
+	         if (locked)
+	            *offset = accumulator / count * Rate_in / (2 * M_PI);
+	         accumulator	= 0;
+	         count		= 0;
+	         return locked;
+	      }
 
-	      DSPFLOAT	getPilotPhase	(DSPFLOAT pilot) {
+//	the phase is returned as fixed point fraction of a turn,
+//	multiples of it (for the 38 and 57 KHz carriers) then wrap by itself
+	      DSPPHASE	getPilotPhase	(DSPFLOAT pilot) {
 	      DSPFLOAT	OscillatorValue =
 	                  mySinCos -> getCos (pilot_OscillatorPhase);
 	      DSPFLOAT	PhaseError	= pilot * OscillatorValue;
-	      DSPFLOAT	currentPhase;
-	         pilot_OscillatorPhase += PhaseError * gain;
-	         currentPhase		= PI_Constrain (pilot_OscillatorPhase);
+	      DSPPHASE	currentPhase;
+	         pilot_OscillatorPhase += toPhase (PhaseError * gain);
+	         if (pll_isLocked) {
+	            accumulator	+= PhaseError * gain;
+	            count ++;
+	         }
+	         currentPhase		= pilot_OscillatorPhase;
 
-	         pilot_OscillatorPhase =
-	                   PI_Constrain (pilot_OscillatorPhase + omega);
+	         pilot_OscillatorPhase += omegaPhase;
 	         
 	         quadRef	= (OscillatorValue - pilot_oldValue) / omega;
 //	         quadRef	= PI_Constrain (quadRef);
@@ -43,6 +43,17 @@ public:
 	int32_t	        getSamples              (DSPFLOAT *, uint32_t);
 	int32_t		capacity		(void);
 	int32_t		waiting			(void);
+	int32_t		bufferSize		(void);
+//	frames that did not fit in the buffer, and reads that found it
+//	empty, since the sink was created
+	int64_t		framesDropped		(void);
+	int64_t		underruns		(void);
+//	frames put in the buffer and not flushed since the sink was
+//	created, the position of the writer in the audio as it is read
+	int64_t		framesWritten		(void);
+//	frames read since the sink was created, the position of the
+//	next one in the same count
+	int64_t		framesRead		(void);
 	void		cancelGet		(void);
 	void		flush			(void);
 private:
@@ -55,6 +66,10 @@ private:
 	pthread_mutex_t	lock;
 	pthread_cond_t	sig;
 	bool		cancelled;
+	int64_t		droppedCount;
+	int64_t		underrunCount;
+	int64_t		writtenCount;
+	int64_t		readCount;
 };
 
 #endif
@@ -0,0 +1,64 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	Writes the (stereo, interleaved) float samples of an audioSink
+ *	to a WAV file, either as 32 bit float or as 16 bit PCM.
+ *	The header is written with zero lengths on opening, the
+ *	lengths are filled in when the writer is deleted.
+ *	Next to appending, frames can be written at (and read back
+ *	from) any position, from several threads at the same time:
+ *	that is how the parts of a segmented decode are put together.
+ */
+
+#ifndef	__WAV_WRITER
+#define	__WAV_WRITER
+
+#include	"fm-constants.h"
+#include	<pthread.h>
+#include	<string>
+
+class	wavWriter {
+public:
+			wavWriter	(const std::string &,
+	                                 int32_t,	// rate
+	                                 int16_t,	// channels
+	                                 bool,		// float samples
+	                                 bool *);
+			~wavWriter	(void);
+//	n frames, i.e. n * channels samples
+	bool		write		(const float *, int32_t);
+	bool		writeAt		(int64_t, const float *, int32_t);
+	int32_t		readAt		(int64_t, float *, int32_t);
+	int64_t		framesWritten	(void);
+private:
+	int		fd;
+	int32_t		rate;
+	int16_t		channels;
+	bool		floatSamples;
+	int16_t		sampleBytes;
+	int32_t		headerSize;
+	int64_t		frames;
+	bool		failed;
+	pthread_mutex_t	lock;
+	bool		writeHeader	(void);
+};
+#endif
+
@@ -65,6 +65,7 @@ public:
 	int16_t		getNumCRCErrors		(void);
 	void		resync			(void);
 	DSPFLOAT	getBitErrorRate		(void);
+	bool		isSynchronized		(void);
 
 private:
 	RadioInterface	*MyRadioInterface;
@@ -48,6 +48,9 @@
 #include	"sincos.h"
 
 class	RadioInterface;
+//
+//	called with the blocks A to D of every group received
+typedef void (*GroupCallback) (const uint16_t *blocks, void *userdata);
 
 class	rdsDecoder {
 public:
@@ -61,8 +64,18 @@ public:
 	   RDS1		= 1,
 	   RDS2		= 2
 	};
+	struct statistics {
+	   bool		synchronized;	// on the blocks of the groups
+	   DSPFLOAT	bitErrorRate;	// while synchronized
+	   int32_t	syncErrors;	// since the last reset
+	   int32_t	crcErrors;
+	   int32_t	groups;
+	};
 	void	doDecode	(DSPFLOAT, DSPFLOAT *, RdsMode);
 	void	reset		(void);
+//	only to be called from the thread doing the decoding
+	void	getStatistics	(statistics *);
+	void	setGroupCallback	(GroupCallback, void *);
 private:
 	void	processBit	(bool);
 	void			doDecode1 (DSPFLOAT, DSPFLOAT *);
@@ -74,12 +87,12 @@ private:
 	RDSGroup		*my_rdsGroup;
 	rdsBlockSynchronizer	*my_rdsBlockSync;
 	rdsGroupDecoder		*my_rdsGroupDecoder;
-	DSPFLOAT		omegaRDS;
+	DSPPHASE		omegaRDS;
 	int32_t			symbolCeiling;
 	int32_t			symbolFloor;
 	bool			prevBit;
 	DSPFLOAT		bitIntegrator;
-	DSPFLOAT		bitClkPhase;
+	DSPPHASE		bitClkPhase;
 	DSPFLOAT		prev_clkState;
 	bool			Resync;
 
@@ -94,7 +107,15 @@ private:
 	DSPFLOAT		rdsLastData;
 	bool			previousBit;
 	DSPFLOAT		*syncBuffer;
+	int32_t			syncLength;
+	int32_t			syncFill;
 	int16_t			p;
+	int32_t			bitsWithoutGroup;
+	int32_t			syncErrors;
+	int32_t			crcErrors;
+	int32_t			groups;
+	GroupCallback		groupCallback;
+	void			*groupUserData;
 	void			synchronizeOnBitClk	(DSPFLOAT *, int16_t);
 	//signals:
 	void			setCRCErrors		(int);
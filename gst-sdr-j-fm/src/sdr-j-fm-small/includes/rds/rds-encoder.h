@@ -0,0 +1,63 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	The transmitting side of the rds decoder, used by the signal
+ *	generator. It produces the (differentially encoded) bit stream
+ *	for a scripted station: a cycle of 0A groups with the station
+ *	label and 2A groups with the radio text, and, when asked for,
+ *	now and then a 4A group with the (system) time.
+ */
+
+#ifndef	__RDS_ENCODER
+#define	__RDS_ENCODER
+
+#include	"fm-constants.h"
+#include	"rds-group.h"
+#include	<string>
+
+class	rdsEncoder {
+public:
+		rdsEncoder	(uint16_t, uint8_t,	// pi, pty
+	                         const std::string &,	// station label
+	                         const std::string &,	// radio text
+	                         bool);			// clock time
+		~rdsEncoder	(void);
+	bool	nextBit		(void);
+	int32_t	groupsSent	(void);
+private:
+	void	nextGroup	(void);
+	void	setBlock	(RDSGroup::RdsBlock, uint16_t);
+	uint32_t	checkWord	(uint16_t, uint32_t);
+	uint16_t	piCode;
+	uint8_t		ptyCode;
+	char		stationLabel	[8];
+	char		radioText	[64];
+	int16_t		textSegments;
+	bool		clockTime;
+	uint32_t	blocks		[RDSGroup::NUM_BLOCKS_PER_RDSGROUP];
+	int16_t		bitIndex;
+	int32_t		groupCount;
+	int16_t		labelSegment;
+	int16_t		textSegment;
+	bool		previousBit;
+};
+#endif
+
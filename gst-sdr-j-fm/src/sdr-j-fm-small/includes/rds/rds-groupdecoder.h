@@ -83,7 +83,7 @@ private:
 //	Group 2 members 
 	uint32_t textSegmentRegister;
 	int32_t  textABflag;
-	char   textBuffer [NUM_OF_CHARS_RADIOTEXT];
+	char   textBuffer [NUM_OF_CHARS_RADIOTEXT + 1];
 
 	// Callback members
 	ClearCallback labelClearCallback;
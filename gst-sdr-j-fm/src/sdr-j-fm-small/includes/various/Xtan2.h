@@ -14,6 +14,26 @@
 #include	<limits>
 #include	"fm-constants.h"
 #
+//
+//	A polynomial approximation (max error around 2e-6 radian),
+//	no tables and no branches, so a loop calling it can be
+//	vectorized by the compiler
+static inline
+float	fastAtan2 (float y, float x) {
+float	ax	= fabsf (x);
+float	ay	= fabsf (y);
+float	mx	= ax > ay ? ax : ay;
+float	mn	= ax > ay ? ay : ax;
+float	a	= mn / (mx + 1e-30f);
+float	s	= a * a;
+float	r	= (((((- 0.01172120f * s + 0.05265332f) * s
+	                  - 0.11643287f) * s + 0.19354346f) * s
+	                  - 0.33262347f) * s + 0.99997726f) * a;
+	r	= ay > ax ? (float)M_PI_2 - r : r;
+	r	= x < 0 ? (float)M_PI - r : r;
+	return y < 0 ? - r : r;
+}
+
 class	compAtan {
 public:
 		compAtan	(void);
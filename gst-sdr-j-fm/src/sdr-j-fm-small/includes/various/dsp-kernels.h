@@ -0,0 +1,72 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	The inner loops of the dsp chain, written once in plain C++
+ *	and once for each instruction set we know about (sse2, avx2
+ *	with fma, neon). The set to use is picked once, at load time,
+ *	from what the cpu supports; the plain version is always there,
+ *	both as fallback and as reference to verify the others against.
+ *	Setting SDRJFM_KERNELS (to "scalar", "sse2", "avx2" or "neon")
+ *	in the environment overrides the choice.
+ *	All kernels work on separate I and Q arrays (see sample-block.h)
+ *	and accept any length and any alignment.
+ */
+
+#ifndef	__DSP_KERNELS
+#define	__DSP_KERNELS
+
+#include	"fm-constants.h"
+
+struct	dspKernels {
+	const char	*name;
+//	sum of taps [i] * v [i]
+	DSPFLOAT	(*dotReal)	(const DSPFLOAT *taps,
+	                                 const DSPFLOAT *v, int32_t n);
+//	the same taps applied to I and to Q
+	void		(*dotComplex)	(const DSPFLOAT *taps,
+	                                 const DSPFLOAT *I, const DSPFLOAT *Q,
+	                                 int32_t n,
+	                                 DSPFLOAT *outI, DSPFLOAT *outQ);
+//	(I, Q) [i] *= (c [i], s [i]), in place
+	void		(*rotate)	(DSPFLOAT *I, DSPFLOAT *Q,
+	                                 const DSPFLOAT *c, const DSPFLOAT *s,
+	                                 int32_t n);
+	void		(*magnitude)	(const DSPFLOAT *I, const DSPFLOAT *Q,
+	                                 DSPFLOAT *out, int32_t n);
+//	the polynomial of fastAtan2 (Xtan2.h), applied to arrays
+	void		(*atan2)	(const DSPFLOAT *y, const DSPFLOAT *x,
+	                                 DSPFLOAT *out, int32_t n);
+//	n interleaved unsigned I/Q byte pairs to floats in [-1, 1)
+	void		(*u8ToFloat)	(const uint8_t *in,
+	                                 DSPFLOAT *I, DSPFLOAT *Q, int32_t n);
+//	out [i] = w [i] * in [i]
+	void		(*window)	(const DSPFLOAT *w, const DSPFLOAT *in,
+	                                 DSPFLOAT *out, int32_t n);
+};
+//
+//	the kernels selected for this cpu
+const dspKernels	*getKernels	(void);
+//
+//	a particular set, NULL if it is not built in or the cpu
+//	does not support it
+const dspKernels	*getKernels	(const char *);
+
+#endif
@@ -32,7 +32,10 @@
 #include	"fm-constants.h"
 #include	<stdlib.h>
 #include	<math.h>
+#include	<string.h>
 #include	"fft.h"
+#include	"sample-block.h"
+#include	"dsp-kernels.h"
 
 class	HilbertFilter;
 
@@ -149,6 +152,160 @@ public:
 private:
 };
 
+//
+//	Filters with real and symmetric (i.e. linear phase) taps.
+//	The delay line is kept twice, so the last filterSize samples
+//	are always found, oldest first, from Buffer [ip] on, as one
+//	contiguous vector for the dot product kernels.
+//	The symmetry is not used to fold the two halves of the delay
+//	line: all taps are multiplied, as a full dot product. Folding
+//	halves the multiplications, but the second half has to be read
+//	backwards, and reversing the vectors costs the kernels more than
+//	the multiplications saved; the phases of the polyphase filter
+//	are not symmetric anyway, so the kernels take any taps.
+//	The kernel is padded with zero taps to a multiple of 8, so the
+//	kernels never need a scalar tail; the delay lines get room for
+//	the few samples read (and multiplied by zero) past their end.
+//	Complex samples are kept as separate I and Q lines, with real
+//	taps that is two real filters rather than one complex one
+class	Basic_RealFIR	{
+	public:
+	int16_t		filterSize;
+	int16_t		paddedSize;
+	DSPFLOAT	*filterKernel;
+	DSPFLOAT	*BufferI;
+	DSPFLOAT	*BufferQ;
+	int16_t		ip;
+	int32_t		sampleRate;
+	const dspKernels	*kernels;
+
+			Basic_RealFIR (int16_t size) {
+	filterSize	= size;
+	paddedSize	= (size + 7) & ~07;
+	kernels		= getKernels ();
+	filterKernel	= new DSPFLOAT [paddedSize];
+	BufferI		= new DSPFLOAT [filterSize + paddedSize];
+	BufferQ		= new DSPFLOAT [filterSize + paddedSize];
+	ip		= 0;
+
+	memset (filterKernel, 0, paddedSize * sizeof (DSPFLOAT));
+	memset (BufferI, 0, (filterSize + paddedSize) * sizeof (DSPFLOAT));
+	memset (BufferQ, 0, (filterSize + paddedSize) * sizeof (DSPFLOAT));
+}
+
+			~Basic_RealFIR (void) {
+	delete[]	filterKernel;
+	delete[]	BufferI;
+	delete[]	BufferQ;
+}
+
+	void		push	(DSPFLOAT v) {
+	BufferI [ip]			= v;
+	BufferI [ip + filterSize]	= v;
+	if (++ip >= filterSize)
+	   ip = 0;
+}
+
+//	real samples leave the Q line as it was
+	void		clearQ	(void) {
+	memset (BufferQ, 0, (filterSize + paddedSize) * sizeof (DSPFLOAT));
+}
+
+	void		push	(DSPCOMPLEX z) {
+	BufferI [ip]			= real (z);
+	BufferI [ip + filterSize]	= real (z);
+	BufferQ [ip]			= imag (z);
+	BufferQ [ip + filterSize]	= imag (z);
+	if (++ip >= filterSize)
+	   ip = 0;
+}
+//
+//	a full dot product, with symmetric taps it does not matter that
+//	the samples are oldest first and the taps newest first
+	DSPFLOAT	apply	(const DSPFLOAT *w) {
+	return kernels -> dotReal (filterKernel, w, paddedSize);
+}
+
+	DSPCOMPLEX	apply	(const DSPFLOAT *wI, const DSPFLOAT *wQ) {
+DSPFLOAT	outI, outQ;
+
+	kernels -> dotComplex (filterKernel, wI, wQ, paddedSize,
+	                                             &outI, &outQ);
+	return DSPCOMPLEX (outI, outQ);
+}
+
+	DSPFLOAT	Pass (DSPFLOAT v) {
+	push (v);
+	return apply (&BufferI [ip]);
+}
+
+	DSPCOMPLEX	Pass (DSPCOMPLEX z) {
+	push (z);
+	return apply (&BufferI [ip], &BufferQ [ip]);
+}
+};
+
+class	LowPassRealFIR : public Basic_RealFIR {
+public:
+			LowPassRealFIR (int16_t,	// order
+	                                int32_t, 	// cutoff frequency
+	                                int32_t		// samplerate
+	                               );
+			~LowPassRealFIR (void);
+	DSPFLOAT	*getKernel	(void);
+	void		newKernel	(int32_t);	// cutoff
+};
+//
+//	Only every decimationFactor'th sample the output is computed,
+//	the others are only pushed into the delay line
+class	DecimatingRealFIR: public Basic_RealFIR {
+public:
+		         DecimatingRealFIR	(int16_t, int32_t,
+	                                         int32_t, int16_t);
+			~DecimatingRealFIR	(void);
+	void		newKernel	(int32_t);
+	bool		Pass	(DSPCOMPLEX, DSPCOMPLEX *);
+	bool		Pass	(DSPFLOAT, DSPFLOAT *);
+	int32_t		Pass	(const sampleBlock *, sampleBlock *);
+private:
+	int16_t	decimationFactor;
+	int16_t	decimationCounter;
+};
+//
+//	Polyphase resampling by the rational factor outRate / fs, that
+//	is interpolation by L followed by decimation by M, in one pass.
+//	The low pass is designed at L * fs and split into L phases of
+//	firSize taps each, an output only takes the firSize taps
+//	of the phase it falls on. With L == 1 this is exactly the
+//	DecimatingRealFIR, so the integer rates come out the same.
+//	position is where the next output falls, in 1 / L input samples
+//	after the newest one in the delay line, with 32 bits of fraction.
+//	The rate can be trimmed by a few hundred ppm, an output falling
+//	in between two phases is then interpolated linearly between
+//	them; the delay line is kept a sample longer for that, as
+//	the phase before the first one is the last one a sample back
+class	ResamplingRealFIR: public Basic_RealFIR {
+public:
+		         ResamplingRealFIR	(int16_t, int32_t,
+	                                         int32_t, int32_t);
+			~ResamplingRealFIR	(void);
+	void		newKernel	(int32_t);
+//	outputs come at outRate * (1 + correction)
+	void		setRateCorrection	(DSPFLOAT);
+	bool		Pass	(DSPCOMPLEX, DSPCOMPLEX *);
+	bool		Pass	(DSPFLOAT, DSPFLOAT *);
+private:
+	int16_t		phaseSize;
+	int32_t		interpolation;
+	int32_t		decimation;
+	int64_t		position;
+	int64_t		step;
+	DSPFLOAT	*phaseKernels;
+	bool		nextPhase	(int32_t *, DSPFLOAT *);
+	DSPFLOAT	applyPhase	(int32_t);
+	DSPCOMPLEX	applyPhaseIQ	(int32_t);
+};
+
 class	adaptiveFilter {
 public:
 		adaptiveFilter	(int);
@@ -0,0 +1,74 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	Recording of the raw samples as they come from the stick.
+ *	putSamples is called from the usb callback and never waits:
+ *	the bytes go into a lock free ringbuffer, and a writer thread
+ *	takes them out and writes them, in big chunks, to a file that
+ *	is preallocated ahead of the writing. When the ringbuffer is
+ *	full, the block is dropped and counted.
+ *	Next to the recording a text file (name.meta) is kept with the
+ *	sample rate and, per sample number, the changes in frequency
+ *	and gain and the dropped blocks.
+ */
+
+#ifndef	__IQ_RECORDER
+#define	__IQ_RECORDER
+
+#include	"fm-constants.h"
+#include	"ringbuffer.h"
+#include	<pthread.h>
+#include	<semaphore.h>
+#include	<stdio.h>
+#include	<string>
+#include	<vector>
+
+class	iqRecorder {
+public:
+			iqRecorder	(const std::string &, int32_t, bool *);
+			~iqRecorder	(void);
+//	from the usb callback
+	void		putSamples	(const uint8_t *, int32_t);
+//	from the controlling thread, frequency in Hz, gain in 0.1 dB
+	void		setFrequency	(int32_t);
+	void		setGain		(int32_t);
+	int32_t		droppedBlocks	(void);
+private:
+	RingBuffer<uint8_t>	*buffer;
+	sem_t		dataAvailable;
+	pthread_t	writer;
+	volatile bool	running;
+	int		fd;
+	FILE		*metaFile;
+	int64_t		bytesAccepted;
+	int64_t		bytesWritten;
+	int64_t		bytesAllocated;
+	int32_t		dropped;
+	int32_t		droppedReported;
+	pthread_mutex_t	metaLock;
+	std::vector<std::string>	metaPending;
+	void		addMeta		(const char *, int32_t);
+	void		writeMeta	(void);
+	void		writeSamples	(bool);
+	static void	*c_run		(void *);
+	void		run		(void);
+};
+#endif
@@ -37,8 +37,10 @@
 class	pllC {
 private:
 	DSPFLOAT	omega;
-	DSPFLOAT	NcoPhase;
-	DSPFLOAT	NcoPhaseIncr;
+	DSPPHASE	NcoPhase;
+//	the corrections of the frequency are far below the resolution
+//	of a float at the value of the frequency, so it is kept in a double
+	double		NcoPhaseIncr;
 	DSPFLOAT	NcoHLimit;
 	DSPFLOAT	NcoLLimit;
 	DSPFLOAT	freq_f;
@@ -29,14 +29,13 @@
 #define	__RESAMPLER
 
 #include	"fm-constants.h"
-#include	"newconverter.h"
+#include	"fir-filters.h"
 //
 //	simple resampler.
 //	in case the decimation constant is an integer, we
 //	use the simple "delete" mechanism. In case the
-//	decimation constant is a fractional, we split up
-//	into an integer trabsform, followed by a fractional
-//	transform.
+//	decimation constant is a fractional, a polyphase
+//	filter interpolates and decimates in one pass.
 
 //
 //	Decent upconversions still to be done
@@ -96,9 +95,7 @@ public:
 	int32_t		getOutputsize		(void);
 
 private:
-	int32_t		intRatio;
-	int32_t		inCount;
-	newConverter	*fracDecimator_C;
+	ResamplingRealFIR	*fracDecimator;
 };
 #endif
 
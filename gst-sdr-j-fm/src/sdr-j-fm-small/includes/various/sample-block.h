@@ -0,0 +1,63 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	A block of complex samples, kept as two separate arrays
+ *	for I and Q (a "struct of arrays") rather than as an array
+ *	of DSPCOMPLEX. Operations on the samples (gain, magnitude,
+ *	rotation) then work on consecutive floats, which the compiler
+ *	(or a simd kernel) can process a vector at a time.
+ */
+
+#ifndef	__SAMPLE_BLOCK
+#define	__SAMPLE_BLOCK
+
+#include	"fm-constants.h"
+
+//	alignment, in bytes, of the I and Q arrays (enough for avx)
+#define	SAMPLE_ALIGNMENT	32
+
+class	sampleBlock {
+public:
+			sampleBlock	(int32_t);	// capacity
+			~sampleBlock	(void);
+	DSPFLOAT	*I;
+	DSPFLOAT	*Q;
+	int32_t		size;		// capacity, in samples
+	int32_t		count;		// number of valid samples
+
+	DSPCOMPLEX	at		(int32_t i) {
+	   return DSPCOMPLEX (I [i], Q [i]);
+	}
+	void		set		(int32_t i, DSPCOMPLEX z) {
+	   I [i]	= real (z);
+	   Q [i]	= imag (z);
+	}
+	void		fromInterleaved	(const DSPCOMPLEX *, int32_t);
+	void		toInterleaved	(DSPCOMPLEX *);
+	void		fromU8		(const uint8_t *, int32_t);
+	void		scale		(DSPFLOAT);
+	void		clear		(void);
+	DSPFLOAT	maxMagnitude	(void);
+private:
+	DSPFLOAT	*allocate	(int32_t);
+};
+
+#endif
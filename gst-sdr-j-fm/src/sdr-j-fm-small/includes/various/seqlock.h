@@ -0,0 +1,93 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	A sequence lock: a record written by one thread, the writer, is
+ *	read by any other thread without either of them ever waiting on
+ *	a lock. The writer makes the sequence odd while it changes the
+ *	record and even again after it, a reader copies the record and
+ *	tries again when the sequence was odd, or changed, meanwhile.
+ *	The record is copied as plain memory, so it should hold nothing
+ *	but plain values.
+ *	A record changed in place, with beginWrite and endWrite, may
+ *	have several writers, they wait on each other, never on readers.
+ */
+
+#ifndef	__SEQLOCK
+#define	__SEQLOCK
+
+#include	<stdint.h>
+#include	<string.h>
+
+template <class elementtype>
+class	seqLock {
+public:
+	seqLock (void) {
+	sequence	= 0;
+	memset (&record, 0, sizeof (elementtype));
+}
+
+	~seqLock (void) {
+}
+//
+//	replaces the record
+void	write	(const elementtype *r) {
+	memcpy (beginWrite (), r, sizeof (elementtype));
+	endWrite ();
+}
+//
+//	returns the record, to be changed in place until endWrite,
+//	the sequence is made odd with a compare and exchange, so a
+//	second writer waits until the first one is done
+elementtype	*beginWrite	(void) {
+uint32_t	s	= __atomic_load_n (&sequence, __ATOMIC_RELAXED);
+
+	while ((s & 01) ||
+	       !__atomic_compare_exchange_n (&sequence, &s, s + 1, true,
+	                                     __ATOMIC_RELAXED,
+	                                     __ATOMIC_RELAXED))
+	   s	= __atomic_load_n (&sequence, __ATOMIC_RELAXED);
+	__atomic_thread_fence (__ATOMIC_ACQ_REL);
+	return &record;
+}
+
+void	endWrite	(void) {
+	__atomic_add_fetch (&sequence, 1, __ATOMIC_RELEASE);
+}
+//
+//	returns false, with a cleared record, if nothing was written yet
+bool	read	(elementtype *r) {
+uint32_t	before, after;
+
+	do {
+	   before	= __atomic_load_n (&sequence, __ATOMIC_ACQUIRE);
+	   memcpy (r, &record, sizeof (elementtype));
+	   __atomic_thread_fence (__ATOMIC_ACQUIRE);
+	   after	= __atomic_load_n (&sequence, __ATOMIC_RELAXED);
+	} while ((before & 01) || (before != after));
+	return before != 0;
+}
+
+private:
+	uint32_t	sequence;
+	elementtype	record;
+};
+
+#endif
@@ -38,6 +38,9 @@ public:
 	DSPFLOAT	getSin		(DSPFLOAT);
 	DSPFLOAT	getCos		(DSPFLOAT);
 	DSPCOMPLEX	getComplex	(DSPFLOAT);
+	DSPFLOAT	getSin		(DSPPHASE);
+	DSPFLOAT	getCos		(DSPPHASE);
+	DSPCOMPLEX	getComplex	(DSPPHASE);
 	
 private:
 	DSPCOMPLEX	*Table;
@@ -45,6 +48,7 @@ private:
 	bool		localTable;
 	double		C;
 	int32_t		fromPhasetoIndex	(DSPFLOAT);
+	int32_t		fromPhasetoIndex	(DSPPHASE);
 };
 
 #endif
@@ -0,0 +1,87 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	Timing of the stages of the fmProcessor. For every block the
+ *	processor marks the end of each stage it went through, the time
+ *	since the previous mark is the time of that stage. At the end of
+ *	the block the times go into a histogram per stage, with buckets
+ *	of powers of two nanoseconds, and out through the USDT probes
+ *	sdrjfm:stage (stage, ns) and sdrjfm:block (samples, ns), for perf
+ *	and bpftrace. The probes are a nop until something attaches to
+ *	them and the clock is read once per stage per block, so the
+ *	profile is always kept.
+ */
+
+#ifndef	__STAGE_PROFILE
+#define	__STAGE_PROFILE
+
+#include	<stdint.h>
+#include	<pthread.h>
+
+#define	PROFILE_BUCKETS	32
+
+class	stageProfile {
+public:
+	enum Stage {
+	   DECIMATE	= 0,
+	   SCAN		= 1,
+	   DEMOD	= 2,
+	   LEVELS	= 3,
+	   MULTIPLEX	= 4,
+	   AUDIO	= 5,
+	   RDS		= 6,
+	   STAGES	= 7
+	};
+//	bucket k counts the times in [2^k, 2^(k + 1)) ns
+	struct histogram {
+	   int64_t	count;
+	   int64_t	total;
+	   int64_t	max;
+	   int64_t	buckets [PROFILE_BUCKETS];
+	};
+	struct snapshot {
+	   int64_t	blocks;
+	   histogram	stage [STAGES];
+	   histogram	block;
+	};
+			stageProfile	(void);
+			~stageProfile	(void);
+//	from the processor thread
+	void		begin		(void);
+	void		mark		(Stage);
+	void		end		(int32_t);
+//	from any thread
+	void		get		(snapshot *);
+	void		reset		(void);
+	static const char	*name	(int);
+//	the upper bound of the bucket holding the given fraction
+	static int64_t	percentile	(const histogram *, double);
+private:
+	pthread_mutex_t	lock;
+	snapshot	data;
+	int64_t		blockStart;
+	int64_t		last;
+	int64_t		pending	[STAGES];
+	bool		marked	[STAGES];
+	static int64_t	now	(void);
+	static void	add	(histogram *, int64_t);
+};
+#endif
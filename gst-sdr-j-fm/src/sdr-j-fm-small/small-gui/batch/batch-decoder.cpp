@@ -0,0 +1,606 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"batch-decoder.h"
+#include	"file-reader.h"
+#include	"fm-processor.h"
+#include	"fm-demodulator.h"
+#include	"rds-decoder.h"
+#include	"audiosink.h"
+#include	"wav-writer.h"
+#include	<time.h>
+#include	<map>
+
+#define	FM_RATE		(4 * BATCH_AUDIO_RATE)
+#define	DECIMATION	(BATCH_INPUT_RATE / BATCH_AUDIO_RATE)
+//
+//	the processor reads blocks of 16384 samples, segments start
+//	on a multiple of both that and the decimation, so the blocks
+//	and the audio frames of all segments line up with those of a
+//	decode of the whole recording
+#define	ALIGNMENT	(3 * 16384)
+//
+//	the audio of one input block is well below this many frames
+#define	DRAIN_FRAMES	4096
+//
+//	a validation passes when the audio after each boundary is
+//	at least this close (in dB) to that of a single threaded decode
+#define	VALIDATE_SNR	40
+
+static
+double	now (void) {
+struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts. tv_sec + ts. tv_nsec * 1e-9;
+}
+
+	batchSettings::batchSettings (void) {
+	stereo		= true;
+	rdsMode		= rdsDecoder::RDS2;
+	decoder		= fm_Demodulator::FM1DECODER;
+	floatSamples	= false;
+	segments	= 1;
+	warmUp		= 4;
+	validate	= false;
+}
+
+	batchDecoder::batchDecoder (const std::string &input,
+	                            const batchSettings &settings,
+	                            bool *success) {
+bool	ok;
+
+	sink		= NULL;
+	processor	= NULL;
+	done		= false;
+	failed		= false;
+	nextFrame	= 0;
+	audio		= new float [2 * DRAIN_FRAMES];
+	sem_init (&finished, 0, 0);
+
+	source	= new fileReader (input, BATCH_INPUT_RATE, false, &ok);
+	*success	= ok;
+	if (!ok)
+	   return;
+
+	sink		= new audioSink ();
+	processor	= new fmProcessor (this, NULL, sink,
+	                                   BATCH_INPUT_RATE, FM_RATE,
+	                                   BATCH_AUDIO_RATE, 20,
+	                                   NULL, NULL, labelComplete,
+	                                   NULL, NULL, textComplete,
+	                                   this);
+	processor	-> setfmMode (settings. stereo);
+	processor	-> setfmRdsSelector (settings. rdsMode);
+	processor	-> setFMdecoder (settings. decoder);
+}
+
+	batchDecoder::~batchDecoder (void) {
+	if (processor != NULL)
+	   delete processor;
+	if (sink != NULL)
+	   delete sink;
+	delete	source;
+	sem_destroy (&finished);
+	delete[]	audio;
+}
+
+void	batchDecoder::start (int64_t first, int64_t last) {
+	source		-> setRange (first, last);
+	nextFrame	= first / DECIMATION;
+	source		-> restartReader ();
+	processor	-> start ();
+}
+//
+//	the processor runs on a thread of its own, we just wait for
+//	it to ask for samples beyond the end of its range
+bool	batchDecoder::wait (void) {
+	while (sem_wait (&finished) != 0)
+	   ;
+	processor	-> stop ();
+	drain ();
+	return !failed;
+}
+
+bool	batchDecoder::decode (void) {
+	start (0, length ());
+	return wait ();
+}
+
+int64_t	batchDecoder::length (void) {
+	return source -> length ();
+}
+//
+//	The processor asks for the available samples before each
+//	block, all audio of the previous block is in the sink by then
+int32_t	batchDecoder::Samples (void) {
+	drain ();
+	if (source -> atEnd ()) {
+	   if (!done) {
+	      done	= true;
+	      sem_post (&finished);
+	   }
+	   return 0;
+	}
+	return source -> Samples ();
+}
+
+int32_t	batchDecoder::getSamples (sampleBlock *b,
+	                          int32_t size, uint8_t mode) {
+	return source -> getSamples (b, size, mode);
+}
+
+void	batchDecoder::drain (void) {
+int32_t	n;
+
+	while (sink -> waiting () > 0) {
+	   n	= sink -> getSamples (audio, 2 * DRAIN_FRAMES) / 2;
+	   if (n <= 0)
+	      break;
+	   if (!failed && !putAudio (nextFrame, audio, n))
+	      failed	= true;
+	   nextFrame	+= n;
+	}
+}
+//
+//	the callbacks come from the processor thread, while it
+//	handles the block most recently read
+void	batchDecoder::labelComplete (const char *label, void *userdata) {
+batchDecoder	*d	= static_cast<batchDecoder *>(userdata);
+
+	d -> putRds (d -> source -> samplesRead (), "PS", label);
+}
+
+void	batchDecoder::textComplete (const char *text, void *userdata) {
+batchDecoder	*d	= static_cast<batchDecoder *>(userdata);
+
+	d -> putRds (d -> source -> samplesRead (), "RT", text);
+}
+
+static
+void	writeRds (FILE *f, int64_t sample, const char *kind, const char *s) {
+	fprintf (f, "%.3f\t%s\t%s\n",
+	            (double)sample / BATCH_INPUT_RATE, kind, s);
+}
+
+	fileDecoder::fileDecoder (const std::string &input,
+	                          const std::string &output,
+	                          const batchSettings &settings,
+	                          bool *success):
+	                             batchDecoder (input, settings, success) {
+bool	ok;
+
+	wav	= NULL;
+	rdsLog	= NULL;
+	if (!*success)
+	   return;
+	*success	= false;
+
+	wav	= new wavWriter (output + ".wav", BATCH_AUDIO_RATE, 2,
+	                         settings. floatSamples, &ok);
+	if (!ok)
+	   return;
+
+	rdsLog	= fopen ((output + ".rds"). c_str (), "w");
+	if (rdsLog == NULL) {
+	   fprintf (stderr, "Could not create %s.rds\n", output. c_str ());
+	   return;
+	}
+	*success	= true;
+}
+
+	fileDecoder::~fileDecoder (void) {
+	if (rdsLog != NULL)
+	   fclose (rdsLog);
+	if (wav != NULL)
+	   delete wav;
+}
+
+int64_t	fileDecoder::framesWritten (void) {
+	return wav -> framesWritten ();
+}
+
+bool	fileDecoder::putAudio (int64_t frame, const float *v, int32_t n) {
+	(void)frame;
+	return wav -> write (v, n);
+}
+
+void	fileDecoder::putRds (int64_t sample, const char *kind, const char *s) {
+	writeRds (rdsLog, sample, kind, s);
+}
+
+	segmentDecoder::segmentDecoder (const std::string &input,
+	                                const batchSettings &settings,
+	                                wavWriter *wav,
+	                                int64_t first, int64_t last,
+	                                bool *success):
+	                             batchDecoder (input, settings, success) {
+	this	-> wav		= wav;
+	this	-> first	= first;
+	this	-> last		= last;
+}
+
+	segmentDecoder::~segmentDecoder (void) {
+}
+//
+//	only the frames of our own part are written, the warm-up and
+//	what is decoded beyond the part (to get its last frames out
+//	of the processor) are dropped
+bool	segmentDecoder::putAudio (int64_t frame, const float *v, int32_t n) {
+int64_t	from	= first / DECIMATION;
+int64_t	to	= last / DECIMATION;
+
+	if (frame < from) {
+	   v	+= 2 * (from - frame);
+	   n	-= from - frame;
+	   frame	= from;
+	}
+	if (frame + n > to)
+	   n	= to - frame;
+	if (n <= 0)
+	   return true;
+	return wav -> writeAt (frame, v, n);
+}
+
+void	segmentDecoder::putRds (int64_t sample,
+	                        const char *kind, const char *s) {
+rdsEvent	e;
+
+	if (sample <= first || sample > last)
+	   return;
+	e. sample	= sample;
+	e. kind		= kind;
+	e. text		= s;
+	events. push_back (e);
+}
+//
+//	The single threaded decode for the validation, its audio is
+//	compared with what is in the file, per second after each
+//	boundary and overall
+class	checkDecoder: public batchDecoder {
+public:
+	checkDecoder (const std::string &input,
+	              const batchSettings &settings,
+	              wavWriter *wav,
+	              const std::vector<int64_t> &boundaries,
+	              bool *success):
+	                 batchDecoder (input, settings, success) {
+	   this	-> wav		= wav;
+	   this	-> boundaries	= boundaries;
+	   stitched	= new float [2 * DRAIN_FRAMES];
+	   frames	= 0;
+	   signal	= 0;
+	   noise	= 0;
+	   maxError	= 0;
+	   windowSignal. resize (boundaries. size (), 0);
+	   windowNoise. resize (boundaries. size (), 0);
+	}
+	~checkDecoder (void) {
+	   delete[] stitched;
+	}
+	std::vector<rdsEvent>	events;
+	int64_t		frames;
+	double		signal;
+	double		noise;
+	float		maxError;
+	std::vector<double>	windowSignal;
+	std::vector<double>	windowNoise;
+private:
+	wavWriter	*wav;
+	std::vector<int64_t>	boundaries;
+	float		*stitched;
+
+	bool	putAudio (int64_t frame, const float *v, int32_t n) {
+	int32_t	got	= wav -> readAt (frame, stitched, n);
+	int64_t	i;
+	size_t	b;
+
+	   for (i = 0; i < 2 * got; i ++) {
+	      float	e	= stitched [i] - v [i];
+	      signal	+= (double)v [i] * v [i];
+	      noise	+= (double)e * e;
+	      if (fabs (e) > maxError)
+	         maxError	= fabs (e);
+	   }
+	   for (b = 0; b < boundaries. size (); b ++) {
+	      int64_t	from	= boundaries [b] / DECIMATION;
+	      int64_t	to	= from + BATCH_AUDIO_RATE;
+	      if (from < frame)
+	         from	= frame;
+	      if (to > frame + got)
+	         to	= frame + got;
+	      for (i = 2 * (from - frame); i < 2 * (to - frame); i ++) {
+	         float	e	= stitched [i] - v [i];
+	         windowSignal [b]	+= (double)v [i] * v [i];
+	         windowNoise [b]	+= (double)e * e;
+	      }
+	   }
+	   frames	= frame + n;
+	   return true;
+	}
+
+	void	putRds (int64_t sample, const char *kind, const char *s) {
+	rdsEvent	e;
+
+	   e. sample	= sample;
+	   e. kind	= kind;
+	   e. text	= s;
+	   events. push_back (e);
+	}
+};
+
+static
+double	toDb (double signal, double noise) {
+	if (noise <= 0)
+	   return 200;
+	if (signal <= 0)
+	   return -200;
+	return 10 * log10 (signal / noise);
+}
+
+	splitDecoder::splitDecoder (const std::string &input,
+	                            const std::string &output,
+	                            const batchSettings &settings,
+	                            bool *success) {
+bool	ok;
+
+	this	-> recording	= input;
+	this	-> settings	= settings;
+	wav		= NULL;
+	rdsLog		= NULL;
+	samples		= 0;
+	*success	= false;
+
+	fileReader	reader (input, BATCH_INPUT_RATE, false, &ok);
+	if (!ok)
+	   return;
+	samples	= reader. length ();
+
+	wav	= new wavWriter (output + ".wav", BATCH_AUDIO_RATE, 2,
+	                         settings. floatSamples, &ok);
+	if (!ok)
+	   return;
+
+	rdsLog	= fopen ((output + ".rds"). c_str (), "w");
+	if (rdsLog == NULL) {
+	   fprintf (stderr, "Could not create %s.rds\n", output. c_str ());
+	   return;
+	}
+	*success	= true;
+}
+
+	splitDecoder::~splitDecoder (void) {
+	if (rdsLog != NULL)
+	   fclose (rdsLog);
+	if (wav != NULL)
+	   delete wav;
+}
+
+int64_t	splitDecoder::framesWritten (void) {
+	return wav -> framesWritten ();
+}
+//
+//	The parts are of equal length (but for the last one), each
+//	segment decodes from a warm-up before its part to an aligned
+//	stretch beyond it, so the audio buffered in the processor at
+//	the end of the part is out as well
+bool	splitDecoder::decode (void) {
+std::vector<segmentDecoder *>	decoders;
+int64_t	part	= (samples + settings. segments - 1) / settings. segments;
+int64_t	warmUp	= (int64_t)(settings. warmUp * BATCH_INPUT_RATE);
+bool	ok	= true;
+int64_t	first;
+size_t	i, j;
+
+	part	= (part + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	warmUp	= (warmUp + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	boundaries. clear ();
+	for (first = 0; first < samples; first += part) {
+	   int64_t	last	= first + part < samples ?
+	                                     first + part : samples;
+	   segmentDecoder *d	= new segmentDecoder (recording, settings,
+	                                              wav, first, last, &ok);
+	   decoders. push_back (d);
+	   if (!ok)
+	      break;
+	   if (first > 0)
+	      boundaries. push_back (first);
+	}
+
+	if (ok) {
+	   for (i = 0; i < decoders. size (); i ++) {
+	      first	= i * part;
+	      decoders [i] -> start (first > warmUp ? first - warmUp : 0,
+	                             first + part + ALIGNMENT);
+	   }
+	   for (i = 0; i < decoders. size (); i ++)
+	      if (!decoders [i] -> wait ())
+	         ok	= false;
+	}
+//
+//	the parts follow each other, so do their events
+	events. clear ();
+	for (i = 0; i < decoders. size (); i ++) {
+	   for (j = 0; j < decoders [i] -> events. size (); j ++) {
+	      const rdsEvent &e	= decoders [i] -> events [j];
+	      writeRds (rdsLog, e. sample, e. kind, e. text. c_str ());
+	      events. push_back (e);
+	   }
+	   delete decoders [i];
+	}
+	return ok;
+}
+
+bool	splitDecoder::validate (batchCheck *check) {
+std::map<std::string, int32_t>	unmatched;
+bool	ok;
+size_t	i;
+std::map<std::string, int32_t>::iterator it;
+
+	checkDecoder	reference (recording, settings, wav, boundaries, &ok);
+	if (!ok || !reference. decode ())
+	   return false;
+
+	check -> frames		= reference. frames;
+	check -> stitchedFrames	= wav -> framesWritten ();
+	check -> snr		= toDb (reference. signal, reference. noise);
+	check -> maxError	= reference. maxError;
+	check -> worstSnr	= 200;
+	for (i = 0; i < boundaries. size (); i ++) {
+	   double snr	= toDb (reference. windowSignal [i],
+	                        reference. windowNoise [i]);
+	   if (snr < check -> worstSnr)
+	      check -> worstSnr = snr;
+	}
+//
+//	an event is matched by one at the same sample, of the same
+//	kind and with the same text
+	for (i = 0; i < reference. events. size (); i ++) {
+	   const rdsEvent &e	= reference. events [i];
+	   char	key [32];
+	   snprintf (key, sizeof (key), "%lld %s ", (long long)e. sample, e. kind);
+	   unmatched [key + e. text] ++;
+	}
+	for (i = 0; i < events. size (); i ++) {
+	   const rdsEvent &e	= events [i];
+	   char	key [32];
+	   snprintf (key, sizeof (key), "%lld %s ", (long long)e. sample, e. kind);
+	   unmatched [key + e. text] --;
+	}
+	check -> rdsEvents	= reference. events. size ();
+	check -> rdsMismatches	= 0;
+	for (it = unmatched. begin (); it != unmatched. end (); it ++)
+	   check -> rdsMismatches += abs (it -> second);
+
+//
+//	the rds events are not part of the verdict: with a noisy signal
+//	the bit clock of a segment may settle on another phase than
+//	that of the single decode, and other bits are then wrong
+	check -> passed	= check -> frames == check -> stitchedFrames &&
+	                  check -> worstSnr >= VALIDATE_SNR;
+	return true;
+}
+
+	batchPool::batchPool (int16_t workers,
+	                      const batchSettings &settings) {
+	this	-> workers	= workers < 1 ? 1 : workers;
+	this	-> settings	= settings;
+	this	-> nextJob	= 0;
+	pthread_mutex_init (&lock, NULL);
+}
+
+	batchPool::~batchPool (void) {
+	pthread_mutex_destroy (&lock);
+}
+
+void	batchPool::add (const std::string &input,
+	                const std::string &output) {
+result	job;
+
+	job. input		= input;
+	job. output		= output;
+	job. ok			= false;
+	job. audioSeconds	= 0;
+	job. elapsed		= 0;
+	job. checked		= false;
+	jobs. push_back (job);
+}
+
+const std::vector<batchPool::result> &batchPool::results (void) {
+	return jobs;
+}
+
+int32_t	batchPool::run (void) {
+std::vector<pthread_t>	threads;
+int32_t	failed	= 0;
+int16_t	i;
+size_t	j;
+
+	nextJob	= 0;
+	for (i = 0; i < workers && (size_t)i < jobs. size (); i ++) {
+	   pthread_t	thread;
+	   if (pthread_create (&thread, NULL, c_work, this) != 0) {
+	      fprintf (stderr, "Could not create worker %d\n", i);
+	      break;
+	   }
+	   threads. push_back (thread);
+	}
+//	should no worker have started, we do the work ourselves
+	if (threads. empty ())
+	   work ();
+	for (j = 0; j < threads. size (); j ++)
+	   pthread_join (threads [j], NULL);
+
+	for (j = 0; j < jobs. size (); j ++)
+	   if (!jobs [j]. ok || (jobs [j]. checked && !jobs [j]. check. passed))
+	      failed ++;
+	return failed;
+}
+
+void	*batchPool::c_work (void *userdata) {
+	static_cast<batchPool *>(userdata) -> work ();
+	return NULL;
+}
+//
+//	The jobs are taken in order, the vector is not changed while
+//	the workers run, so only the index needs the lock
+void	batchPool::work (void) {
+	while (true) {
+	   pthread_mutex_lock (&lock);
+	   size_t	current	= nextJob ++;
+	   pthread_mutex_unlock (&lock);
+	   if (current >= jobs. size ())
+	      return;
+
+	   result	&job	= jobs [current];
+	   double	start	= now ();
+	   int64_t	frames	= 0;
+	   bool		ok;
+	   if (settings. segments > 1) {
+	      splitDecoder decoder (job. input, job. output, settings, &ok);
+	      if (ok)
+	         ok	= decoder. decode ();
+	      if (ok)
+	         frames	= decoder. framesWritten ();
+	      job. elapsed	= now () - start;
+//	a validation asked for that could not be done fails the job
+	      if (ok && settings. validate) {
+	         job. checked	= decoder. validate (&job. check);
+	         if (!job. checked) {
+	            fprintf (stderr, "Could not validate %s\n",
+	                                         job. input. c_str ());
+	            ok	= false;
+	         }
+	      }
+	   }
+	   else {
+	      fileDecoder decoder (job. input, job. output, settings, &ok);
+	      if (ok)
+	         ok	= decoder. decode ();
+	      if (ok)
+	         frames	= decoder. framesWritten ();
+	      job. elapsed	= now () - start;
+	   }
+	   job. ok		= ok;
+	   job. audioSeconds	= (double)frames / BATCH_AUDIO_RATE;
+	}
+}
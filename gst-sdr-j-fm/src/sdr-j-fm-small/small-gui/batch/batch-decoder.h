@@ -0,0 +1,215 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	Decoding of recordings, without a RadioInterface and as fast
+ *	as the machine allows.
+ *	A batchDecoder is a complete chain of its own (file reader,
+ *	fmProcessor and audio sink) sharing no state with other
+ *	chains, so any number of them can run next to each other.
+ *	The decoder is the input of its processor: each time the
+ *	processor asks for a new block, the audio of the previous one is
+ *	taken from the sink and handed out, so nothing is lost and the
+ *	output does not depend on the timing of threads.
+ *	The audio frames are numbered from the start of the recording
+ *	(a frame per 24 input samples), the station labels and radio
+ *	texts carry the sample number at which they were complete.
+ *
+ *	A fileDecoder writes the audio of a recording to "output.wav"
+ *	and the labels and texts to "output.rds".
+ *	A splitDecoder does the same, with the recording split in
+ *	segments that are decoded in parallel. Each segment starts
+ *	decoding a warm-up ahead of its part, so filters, plls, the rds
+ *	synchronisation and the gain have settled when its part starts,
+ *	and its audio is written into its place in the output file.
+ *	Optionally, the result is compared with a single threaded
+ *	decode.
+ *	The batchPool decodes a list of recordings on a number of
+ *	worker threads, each decoding one recording at a time.
+ */
+
+#ifndef	__BATCH_DECODER
+#define	__BATCH_DECODER
+
+#include	"fm-constants.h"
+#include	"virtual-input.h"
+#include	<pthread.h>
+#include	<semaphore.h>
+#include	<stdio.h>
+#include	<string>
+#include	<vector>
+
+//	the rates as set up by the RadioInterface
+#define	BATCH_AUDIO_RATE	44100
+#define	BATCH_INPUT_RATE	(24 * BATCH_AUDIO_RATE)
+
+class	fileReader;
+class	fmProcessor;
+class	audioSink;
+class	wavWriter;
+class	sampleBlock;
+
+class	batchSettings {
+public:
+			batchSettings	(void);
+	bool		stereo;
+	int8_t		rdsMode;
+	int8_t		decoder;
+	bool		floatSamples;
+//	more than one: each recording is decoded in this many segments
+	int16_t		segments;
+	float		warmUp;		// seconds
+	bool		validate;
+};
+
+class	batchDecoder: private virtualInput {
+public:
+			batchDecoder	(const std::string &,	// recording
+	                                 const batchSettings &,
+	                                 bool *);
+virtual			~batchDecoder	(void);
+//	decodes the samples [first, last) of the recording, first
+//	being a multiple of 24, on the thread of the processor;
+//	wait returns when that is done, false if the output failed
+	void		start		(int64_t, int64_t);
+	bool		wait		(void);
+	bool		decode		(void);		// all of it
+	int64_t		length		(void);
+protected:
+virtual	bool		putAudio	(int64_t, const float *, int32_t) = 0;
+virtual	void		putRds		(int64_t, const char *,
+	                                 const char *) = 0;
+private:
+	fileReader	*source;
+	audioSink	*sink;
+	fmProcessor	*processor;
+	sem_t		finished;
+	bool		done;
+	bool		failed;
+	float		*audio;
+	int64_t		nextFrame;
+	void		drain		(void);
+	static void	labelComplete	(const char *, void *);
+	static void	textComplete	(const char *, void *);
+//	as virtualInput, for the processor
+	int32_t		Samples		(void);
+	int32_t		getSamples	(sampleBlock *, int32_t, uint8_t);
+};
+
+class	fileDecoder: public batchDecoder {
+public:
+			fileDecoder	(const std::string &,	// recording
+	                                 const std::string &,	// output base
+	                                 const batchSettings &,
+	                                 bool *);
+			~fileDecoder	(void);
+	int64_t		framesWritten	(void);
+private:
+	wavWriter	*wav;
+	FILE		*rdsLog;
+	bool		putAudio	(int64_t, const float *, int32_t);
+	void		putRds		(int64_t, const char *, const char *);
+};
+
+struct	rdsEvent {
+	int64_t		sample;
+	const char	*kind;
+	std::string	text;
+};
+
+struct	batchCheck {
+	int64_t		frames;		// of the single threaded decode
+	int64_t		stitchedFrames;
+	double		snr;		// dB, over all of the audio
+	double		worstSnr;	// dB, the worst second after a boundary
+	float		maxError;
+	int32_t		rdsEvents;
+	int32_t		rdsMismatches;
+	bool		passed;
+};
+
+class	segmentDecoder: public batchDecoder {
+public:
+			segmentDecoder	(const std::string &,
+	                                 const batchSettings &,
+	                                 wavWriter *,
+	                                 int64_t,	// first sample kept
+	                                 int64_t,	// last sample kept
+	                                 bool *);
+			~segmentDecoder	(void);
+	std::vector<rdsEvent>	events;
+private:
+	wavWriter	*wav;
+	int64_t		first;
+	int64_t		last;
+	bool		putAudio	(int64_t, const float *, int32_t);
+	void		putRds		(int64_t, const char *, const char *);
+};
+
+class	splitDecoder {
+public:
+			splitDecoder	(const std::string &,	// recording
+	                                 const std::string &,	// output base
+	                                 const batchSettings &,
+	                                 bool *);
+			~splitDecoder	(void);
+	bool		decode		(void);
+//	decodes the recording again, on a single thread, and compares
+	bool		validate	(batchCheck *);
+	int64_t		framesWritten	(void);
+private:
+	std::string	recording;
+	batchSettings	settings;
+	wavWriter	*wav;
+	FILE		*rdsLog;
+	int64_t		samples;
+	std::vector<int64_t>	boundaries;
+	std::vector<rdsEvent>	events;
+};
+
+class	batchPool {
+public:
+	struct result {
+	   std::string	input;
+	   std::string	output;
+	   bool		ok;
+	   double	audioSeconds;
+	   double	elapsed;
+	   bool		checked;
+	   batchCheck	check;
+	};
+			batchPool	(int16_t, const batchSettings &);
+			~batchPool	(void);
+	void		add		(const std::string &,	// recording
+	                                 const std::string &);	// output base
+//	decodes all recordings added, returns the number that failed
+	int32_t		run		(void);
+	const std::vector<result> &results	(void);
+private:
+	int16_t		workers;
+	batchSettings	settings;
+	std::vector<result>	jobs;
+	size_t		nextJob;
+	pthread_mutex_t	lock;
+	static void	*c_work		(void *);
+	void		work		(void);
+};
+#endif
+
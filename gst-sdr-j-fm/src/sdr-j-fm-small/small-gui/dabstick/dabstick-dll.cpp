@@ -34,11 +34,14 @@
 
 #include	"rtl-sdr.h"
 #include	"dabstick-dll.h"
+#include	"iq-recorder.h"
 #include	<gst/gst.h>
 #include	<pthread.h>
 #include	<sstream>
 #include	<stdexcept>
 #include	<iostream>
+#include	<time.h>
+#include	<errno.h>
 
 #ifdef	__MINGW32__
 #define	GETPROCADDRESS	GetProcAddress
@@ -47,10 +50,29 @@
 #endif
 
 #define	READLEN_DEFAULT	8192
+//
+//	the corrections of the crystals, in ppm, are kept in a key file
+//	in the user's configuration directory, a group per serial number
+#define	CORRECTION_DIRECTORY	"sdrjfm"
+#define	CORRECTION_FILE		"crystals.conf"
+#define	CORRECTION_KEY		"ppm"
 
 GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 #define GST_CAT_DEFAULT sdrjfm_debug
 
+static
+int64_t	monotonicTime (void) {
+struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts. tv_sec * 1000000000 + ts. tv_nsec;
+}
+
+static
+gchar	*correctionFile (void) {
+	return g_build_filename (g_get_user_config_dir (),
+	                         CORRECTION_DIRECTORY, CORRECTION_FILE, NULL);
+}
 //
 //	For the callback, we do need some environment which
 //	is passed through the ctx parameter
@@ -60,14 +82,33 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 static
 void	RTLSDRCallBack (uint8_t *buf, uint32_t len, void *ctx) {
 dabstick_dll	*theStick	= (dabstick_dll *)ctx;
-int32_t	tmp;
+int32_t	tmp	= 0;
+captureCount	*count;
 
-	if ((theStick == NULL) || (len != READLEN_DEFAULT))
+	if (theStick == NULL)
 	   return;
-
-	tmp = theStick -> _I_Buffer -> putDataIntoBuffer (buf, len);
-	if ((len - tmp) > 0)
-	   theStick	-> sampleCounter += len - tmp;
+	if (len != READLEN_DEFAULT)
+	   __atomic_add_fetch (&theStick -> transferCounter, 1,
+	                                          __ATOMIC_RELAXED);
+	else {
+	   if (theStick -> recorder != NULL)
+	      theStick -> recorder -> putSamples (buf, len);
+	   tmp = theStick -> _I_Buffer -> putDataIntoBuffer (buf, len);
+//	the counter is in I/Q samples, two bytes each
+	   if ((int32_t)len > tmp)
+	      __atomic_add_fetch (&theStick -> sampleCounter, (len - tmp) / 2,
+	                                          __ATOMIC_RELAXED);
+	}
+//
+//	every transfer counts for the capture time, the samples not
+//	put in the buffer as lost
+	count	= theStick -> captureCounts. beginWrite ();
+	count -> captured	+= len / 2;
+	count -> lost		+= (len - tmp) / 2;
+	count -> time		= monotonicTime ();
+	theStick -> captureCounts. endWrite ();
+	if (theStick -> samplesArrived != NULL)
+	   theStick -> samplesArrived (theStick -> samplesArrivedUserData);
 }
 //
 //	for handling the events in libusb, we need a controlthread
@@ -132,8 +173,15 @@ int16_t	i;
 	_I_Buffer			= NULL;
 	lastFrequency			= KHz (96700);	// just a dummy
 	this	-> sampleCounter	= 0;
+	this	-> transferCounter	= 0;
+	this	-> consumed		= 0;
 	this	-> vfoOffset		= 0;
+	this	-> recorder		= NULL;
+	this	-> samplesArrived	= NULL;
 	gains				= NULL;
+	currentGain			= 0;
+	serial [0]			= 0;
+	correction			= 0;
 
 #ifdef	__MINGW32__
 	const char *libraryString = "rtlsdr.dll";
@@ -170,6 +218,16 @@ int16_t	i;
 	   return;
 	}
 	open			= true;
+//
+//	the correction from the last time, before the rate and the
+//	frequency are set, they are corrected with it
+	if (this -> rtlsdr_get_device_usb_strings (deviceIndex,
+	                                           NULL, NULL, serial) < 0)
+	   serial [0] = 0;
+	if (loadCorrection (&r)) {
+	   GST_INFO ("Correcting the crystal of %s by %d ppm", serial, r);
+	   freqCorrection (r);
+	}
 	r			= this -> rtlsdr_set_sample_rate (device,
 	                                                          rateIn);
 	if (r < 0) {
@@ -230,6 +288,8 @@ void	dabstick_dll::setVFOFrequency	(int32_t f) {
 		GST_ERROR("Error while setting DAB stick VFO frequency, retrying");
 
 	GST_DEBUG("Set reception frequency of DAB stick to %u", f);
+	if (recorder != NULL)
+	   recorder -> setFrequency (f);
 	if (this -> vfoFrequencyChanged)
 		this -> vfoFrequencyChanged (this -> vfoFrequencyChangedUserData, f);
 }
@@ -316,22 +376,92 @@ int32_t	r;
 }
 
 int32_t	dabstick_dll::setExternalGain	(int32_t gain) {
-static int	oldGain	= 0;
-
-	if (gain == oldGain)
-	   return gains [oldGain];
+	if (gain == currentGain)
+	   return gains [currentGain];
 	if ((gain < 0) || (gain >= gainsCount))
-	   return gains [oldGain];
+	   return gains [currentGain];
 
-	oldGain	= gain;
+	currentGain	= gain;
 	rtlsdr_set_tuner_gain (device, gains [gainsCount - gain]);
+	if (recorder != NULL)
+	   recorder -> setGain (gains [gainsCount - gain]);
 //	return rtlsdr_get_tuner_gain (device);
 	return gain;
 }
 //
-//	correction is in Hz
+//	correction is in ppm, of the frequency as well as of the rate
 void	dabstick_dll::freqCorrection	(int32_t ppm) {
-	this -> rtlsdr_set_freq_correction (device, ppm);
+	if (ppm < - MAX_CORRECTION || ppm > MAX_CORRECTION)
+	   return;
+	if (this -> rtlsdr_set_freq_correction (device, ppm) < 0 &&
+	                                             ppm != correction)
+	   return;
+	correction	= ppm;
+}
+
+bool	dabstick_dll::getCorrection	(int32_t *ppm) {
+	*ppm	= correction;
+	return open;
+}
+//
+//	without a serial number there is nothing to tell sticks apart by.
+//	Many cheap ones share the same (e.g. 00000001), they then
+//	share the correction as well
+bool	dabstick_dll::loadCorrection	(int32_t *ppm) {
+GKeyFile	*keys;
+gchar		*file;
+GError		*error	= NULL;
+bool		found	= false;
+
+	if (serial [0] == 0)
+	   return false;
+	keys	= g_key_file_new ();
+	file	= correctionFile ();
+	if (g_key_file_load_from_file (keys, file, G_KEY_FILE_NONE, NULL)) {
+	   *ppm	= g_key_file_get_integer (keys, serial,
+	                                  CORRECTION_KEY, &error);
+	   found	= error == NULL;
+	   if (error != NULL)
+	      g_error_free (error);
+	}
+	g_free (file);
+	g_key_file_free (keys);
+	return found;
+}
+
+void	dabstick_dll::storeCorrection	(void) {
+GKeyFile	*keys;
+gchar		*file;
+gchar		*directory;
+gchar		*data;
+gsize		length;
+GError		*error	= NULL;
+
+	if (serial [0] == 0)
+	   return;
+	keys	= g_key_file_new ();
+	file	= correctionFile ();
+	directory	= g_path_get_dirname (file);
+//	the other sticks in there are kept
+	g_key_file_load_from_file (keys, file, G_KEY_FILE_KEEP_COMMENTS, NULL);
+	g_key_file_set_integer (keys, serial, CORRECTION_KEY, correction);
+	data	= g_key_file_to_data (keys, &length, NULL);
+	if (g_mkdir_with_parents (directory, 0700) < 0)
+	   GST_WARNING ("Could not create %s: %s",
+	                directory, g_strerror (errno));
+	else
+	if (!g_file_set_contents (file, data, length, &error)) {
+	   GST_WARNING ("Could not store the crystal correction: %s",
+	                error -> message);
+	   g_error_free (error);
+	}
+	else
+	   GST_DEBUG ("Stored a crystal correction of %d ppm for %s",
+	              correction, serial);
+	g_free (data);
+	g_free (directory);
+	g_free (file);
+	g_key_file_free (keys);
 }
 
 //
@@ -346,6 +476,7 @@ uint8_t	*tempBuffer = (uint8_t *)alloca (2 * size * sizeof (uint8_t));
 	for (i = 0; i < amount / 2; i ++)
 	    V [i] = DSPCOMPLEX ((float (tempBuffer [2 * i] - 128)) / 128.0,
 	                        (float (tempBuffer [2 * i + 1] - 128)) / 128.0);
+	__atomic_add_fetch (&consumed, amount / 2, __ATOMIC_RELAXED);
 	return amount / 2;
 }
 
@@ -355,6 +486,24 @@ int32_t	dabstick_dll::getSamples 	(DSPCOMPLEX  *V,
 	return getSamples (V, size);
 }
 
+//
+//	the sample block version converts the bytes straight into
+//	the I and Q arrays
+int32_t	dabstick_dll::getSamples	(sampleBlock *b,
+	                                 int32_t size, uint8_t M) {
+int32_t	amount;
+uint8_t	*tempBuffer;
+
+	(void)M;
+	if (size > b -> size)
+	   size = b -> size;
+	tempBuffer	= (uint8_t *)alloca (2 * size * sizeof (uint8_t));
+	amount = _I_Buffer	-> getDataFromBuffer (tempBuffer, 2 * size);
+	b -> fromU8 (tempBuffer, amount / 2);
+	__atomic_add_fetch (&consumed, amount / 2, __ATOMIC_RELAXED);
+	return amount / 2;
+}
+
 int32_t	dabstick_dll::Samples	(void) {
 	return _I_Buffer	-> GetRingBufferReadAvailable () / 2;
 }
@@ -363,10 +512,53 @@ uint8_t	dabstick_dll::myIdentity		(void) {
 	return DAB_STICK;
 }
 
+//
+//	the recorder is owned by the caller, who should delete it
+//	only after the stick
+void	dabstick_dll::recordTo	(iqRecorder *r) {
+	recorder	= r;
+	recorder	-> setFrequency (lastFrequency);
+	recorder	-> setGain (rtlsdr_get_tuner_gain (device));
+}
+
+void	dabstick_dll::setSamplesCallback (samplesArrivedCB cb, void *userData) {
+	samplesArrived		= cb;
+	samplesArrivedUserData	= userData;
+}
+
+//	the counters are reset on reading, the usb thread may be
+//	adding to them meanwhile
 int32_t	dabstick_dll::getSamplesMissed		(void) {
-int32_t	tmp	= sampleCounter;
-	sampleCounter	= 0;
-	return tmp;
+	return __atomic_exchange_n (&sampleCounter, 0, __ATOMIC_RELAXED);
+}
+
+int32_t	dabstick_dll::getTransfersMissed	(void) {
+	return __atomic_exchange_n (&transferCounter, 0, __ATOMIC_RELAXED);
+}
+
+int32_t	dabstick_dll::bufferSize		(void) {
+	return (_I_Buffer -> GetRingBufferReadAvailable () +
+	        _I_Buffer -> GetRingBufferWriteAvailable ()) / 2;
+}
+//
+//	The samples lost are behind those in the buffer, they only
+//	count as they come in, so right after a loss the position is
+//	ahead by (at most) what was still in the buffer
+int64_t	dabstick_dll::capturePosition	(void) {
+captureCount	count;
+
+	captureCounts. read (&count);
+	return __atomic_load_n (&consumed, __ATOMIC_RELAXED) + count. lost;
+}
+
+bool	dabstick_dll::captureTime	(int64_t *captured, int64_t *when) {
+captureCount	count;
+
+	if (!captureCounts. read (&count))
+	   return false;
+	*captured	= count. captured;
+	*when		= count. time;
+	return true;
 }
 
 bool	dabstick_dll::load_rtlFunctions (void) {
@@ -490,12 +682,26 @@ bool	dabstick_dll::load_rtlFunctions (void) {
 	   return false;
 	}
 
+	rtlsdr_get_device_usb_strings = (pfnrtlsdr_get_device_usb_strings)
+	              GETPROCADDRESS (Handle, "rtlsdr_get_device_usb_strings");
+	if (rtlsdr_get_device_usb_strings == NULL) {
+	   fprintf (stderr, "Could not find rtlsdr_get_device_usb_strings\n");
+	   return false;
+	}
+
 	fprintf (stderr, "OK, functions seem to be loaded\n");
 	return true;
 }
 
+//
+//	only the samples counted are skipped, those the usb thread puts
+//	in meanwhile stay and are read, so the count stays right
 void	dabstick_dll::resetBuffer (void) {
-	_I_Buffer -> FlushRingBuffer ();
+int32_t	skipped;
+
+	skipped	= _I_Buffer -> skipDataInBuffer
+	                 (_I_Buffer -> GetRingBufferReadAvailable () & ~01);
+	__atomic_add_fetch (&consumed, skipped / 2, __ATOMIC_RELAXED);
 }
 
 int16_t	dabstick_dll::maxGain	(void) {
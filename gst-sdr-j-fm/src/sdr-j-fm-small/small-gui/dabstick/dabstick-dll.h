@@ -32,13 +32,16 @@
 #include	"ringbuffer.h"
 #include	"fir-filters.h"
 #include	"virtual-input.h"
+#include	"seqlock.h"
 
 class	dll_driver;
+class	iqRecorder;
 //
 //	create typedefs for the library functions
 typedef	struct rtlsdr_dev rtlsdr_dev_t;
 
 typedef	void (*rtlsdr_read_async_cb_t) (uint8_t *buf, uint32_t len, void *ctx);
+typedef	void (*samplesArrivedCB) (void *);
 typedef	 int (*  pfnrtlsdr_open )(rtlsdr_dev_t **, uint32_t);
 typedef	int (*  pfnrtlsdr_close) (rtlsdr_dev_t *);
 typedef	int (*  pfnrtlsdr_set_center_freq) (rtlsdr_dev_t *, uint32_t);
@@ -60,6 +63,16 @@ typedef int (*  pfnrtlsdr_set_direct_sampling) (rtlsdr_dev_t *, int);
 typedef uint32_t (*  pfnrtlsdr_get_device_count) (void);
 typedef	int (* pfnrtlsdr_set_freq_correction)(rtlsdr_dev_t *, int);
 typedef	char *(* pfnrtlsdr_get_device_name)(int);
+typedef	int (* pfnrtlsdr_get_device_usb_strings)(uint32_t,
+	                                         char *, char *, char *);
+//
+//	the samples that came from the stick, with those it had to drop,
+//	up to the transfer that came in last, at time (monotonic, in ns)
+struct	captureCount {
+	int64_t		captured;
+	int64_t		lost;
+	int64_t		time;
+};
 //	This class is a simple wrapper around the
 //	rtlsdr library that is read is as dll
 //	It does not do any processing
@@ -80,20 +93,41 @@ public:
 	void		stopReader	(void);
 	int32_t		getSamples	(DSPCOMPLEX *, int32_t);
 	int32_t		getSamples	(DSPCOMPLEX *, int32_t, uint8_t);
+	int32_t		getSamples	(sampleBlock *, int32_t, uint8_t);
 	int32_t		Samples		(void);
 	void		freqCorrection	(int32_t);
+	bool		getCorrection	(int32_t *);
+	void		storeCorrection	(void);
 	int32_t		getSamplesMissed	(void);
+	int32_t		getTransfersMissed	(void);
+	int32_t		bufferSize	(void);
+	int64_t		capturePosition	(void);
+	bool		captureTime	(int64_t *, int64_t *);
 	void		resetBuffer	(void);
 	int16_t		maxGain		(void);
 	int16_t		bitDepth	(void);
+//	tee the samples, as they come from the stick, into a recording
+//	(to be set before the reader is started)
+	void		recordTo	(iqRecorder *);
+//	called on the usb thread after each transfer is put in the buffer
+//	(to be set before the reader is started)
+	void		setSamplesCallback	(samplesArrivedCB, void *);
 //
 //	These need to be visible for the separate usb handling thread
 	RingBuffer<uint8_t>	*_I_Buffer;
 	pfnrtlsdr_read_async	rtlsdr_read_async;
 	struct rtlsdr_dev	*device;
 	int32_t		sampleCounter;
+	int32_t		transferCounter;
+	seqLock<captureCount>	captureCounts;
+	iqRecorder	*recorder;
+	samplesArrivedCB	samplesArrived;
+	void		*samplesArrivedUserData;
 private:
 	int32_t		rateIn;
+//	the samples read or skipped, by the processor and the tuning
+//	threads, so added to atomically
+	int64_t		consumed;
 	int32_t		deviceCount;
 	HINSTANCE	Handle;
 	dll_driver	*workerHandle;
@@ -102,6 +136,12 @@ private:
 	bool		open;
 	int		*gains;
 	int16_t		gainsCount;
+	int32_t		currentGain;
+//	the serial number in the eeprom of the stick, the correction
+//	of its crystal is kept under it
+	char		serial	[256];
+	int32_t		correction;
+	bool		loadCorrection	(int32_t *);
 //	here we need to load functions from the dll
 	bool		load_rtlFunctions	(void);
 	pfnrtlsdr_open	rtlsdr_open;
@@ -121,6 +161,7 @@ private:
 	pfnrtlsdr_get_device_count rtlsdr_get_device_count;
 	pfnrtlsdr_set_freq_correction rtlsdr_set_freq_correction;
 	pfnrtlsdr_get_device_name rtlsdr_get_device_name;
+	pfnrtlsdr_get_device_usb_strings rtlsdr_get_device_usb_strings;
 
 	vfoFrequencyChangedCB vfoFrequencyChanged;
 	void *vfoFrequencyChangedUserData;
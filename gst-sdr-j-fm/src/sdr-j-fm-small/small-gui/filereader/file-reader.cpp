@@ -0,0 +1,267 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include	"file-reader.h"
+#include	"sample-block.h"
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+#include	<fcntl.h>
+#include	<stdio.h>
+#include	<string.h>
+#include	<time.h>
+#include	<unistd.h>
+
+//	pages already read are given back to the kernel per
+//	RELEASE_CHUNK bytes, a long recording does not end up resident
+#define	RELEASE_CHUNK	(4 * 1024 * 1024)
+
+static
+int64_t	monotonicTime (void) {
+struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts. tv_sec * 1000000000 + ts. tv_nsec;
+}
+
+//
+//	The conversions between nanoseconds and samples are split in
+//	whole seconds and a remainder, the plain product overflows
+//	an int64_t after a few hours at the higher rates
+static
+int64_t	samplesIn (int64_t ns, int32_t rate) {
+	return ns / 1000000000 * rate + ns % 1000000000 * rate / 1000000000;
+}
+
+static
+int64_t	timeOf (int64_t samples, int32_t rate) {
+	return samples / rate * 1000000000 +
+	       samples % rate * 1000000000 / rate;
+}
+
+static
+bool	hasSuffix (const std::string &s, const char *suffix) {
+size_t	l	= strlen (suffix);
+
+	return s. size () >= l &&
+	       s. compare (s. size () - l, l, suffix) == 0;
+}
+
+	fileReader::fileReader (const std::string &fileName,
+	                        int32_t rate,
+	                        bool paced,
+	                        bool *success) {
+int	fd;
+struct stat	st;
+
+	this	-> rateIn	= rate;
+	this	-> paced	= paced;
+	running			= false;
+	data			= NULL;
+	fileLength		= 0;
+	totalSamples		= 0;
+	currentSample		= 0;
+	releasedSample		= 0;
+	lastRequest		= 1;
+	startTime		= 0;
+	*success		= false;
+
+	if (hasSuffix (fileName, ".cf32") ||
+	    hasSuffix (fileName, ".fc32") ||
+	    hasSuffix (fileName, ".cfile")) {
+	   format		= CF32_FILE;
+	   bytesPerSample	= 2 * sizeof (float);
+	}
+	else {
+	   format		= U8_FILE;
+	   bytesPerSample	= 2;
+	}
+
+	fd	= open (fileName. c_str (), O_RDONLY);
+	if (fd < 0) {
+	   fprintf (stderr, "Could not open %s\n", fileName. c_str ());
+	   return;
+	}
+
+	if (fstat (fd, &st) < 0 || st. st_size < bytesPerSample) {
+	   fprintf (stderr, "%s is empty\n", fileName. c_str ());
+	   close (fd);
+	   return;
+	}
+
+	fileLength	= st. st_size;
+	data	= (uint8_t *)mmap (NULL, fileLength,
+	                           PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (data == MAP_FAILED) {
+	   fprintf (stderr, "Could not map %s\n", fileName. c_str ());
+	   data	= NULL;
+	   return;
+	}
+//
+//	we read front to back, so the kernel can read ahead aggressively
+	madvise (data, fileLength, MADV_SEQUENTIAL);
+	totalSamples	= fileLength / bytesPerSample;
+	*success	= true;
+}
+
+	fileReader::~fileReader	(void) {
+	if (data != NULL)
+	   munmap (data, fileLength);
+}
+
+uint8_t	fileReader::myIdentity	(void) {
+	return FILEREADER;
+}
+//
+//	When paced, the clock is set such that the samples handed out
+//	so far were due now, a pause does not produce a burst
+bool	fileReader::restartReader	(void) {
+	if (data == NULL)
+	   return false;
+	startTime	= monotonicTime () - timeOf (currentSample, rateIn);
+	running		= true;
+	return true;
+}
+
+void	fileReader::stopReader	(void) {
+	running		= false;
+}
+
+int64_t	fileReader::available	(void) {
+int64_t	due;
+
+	if (!running)
+	   return 0;
+	if (!paced)
+	   return totalSamples - currentSample;
+
+	due	= samplesIn (monotonicTime () - startTime, rateIn);
+	if (due > totalSamples)
+	   due = totalSamples;
+	return due - currentSample;
+}
+
+int32_t	fileReader::Samples	(void) {
+int64_t	n	= available ();
+
+	return n > 0x7FFFFFFF ? 0x7FFFFFFF : (int32_t)n;
+}
+
+void	fileReader::release	(void) {
+int64_t	page	= sysconf (_SC_PAGESIZE);
+int64_t	from	= (releasedSample * bytesPerSample) & ~(page - 1);
+int64_t	to	= (currentSample * bytesPerSample) & ~(page - 1);
+
+	if (to - from < RELEASE_CHUNK)
+	   return;
+	madvise (data + from, to - from, MADV_DONTNEED);
+	releasedSample	= to / bytesPerSample;
+}
+
+int32_t	fileReader::getSamples	(DSPCOMPLEX *V, int32_t size) {
+int64_t	avail	= available ();
+int32_t	i;
+
+	lastRequest	= size;
+	if (size > avail)
+	   size = avail;
+	if (size <= 0)
+	   return 0;
+
+	if (format == CF32_FILE)
+	   memcpy (V, data + currentSample * bytesPerSample,
+	                           size * bytesPerSample);
+	else {
+	   const uint8_t *p	= data + currentSample * bytesPerSample;
+	   for (i = 0; i < size; i ++)
+	      V [i] = DSPCOMPLEX ((float (p [2 * i] - 128)) / 128.0,
+	                          (float (p [2 * i + 1] - 128)) / 128.0);
+	}
+	currentSample	+= size;
+	release ();
+	return size;
+}
+
+int32_t	fileReader::getSamples	(DSPCOMPLEX *V,
+	                         int32_t size, uint8_t M) {
+	(void)M;
+	return getSamples (V, size);
+}
+//
+//	straight from the mapping into the I and Q arrays
+int32_t	fileReader::getSamples	(sampleBlock *b,
+	                         int32_t size, uint8_t M) {
+int64_t	avail	= available ();
+const uint8_t	*p	= data + currentSample * bytesPerSample;
+
+	(void)M;
+	if (size > b -> size)
+	   size = b -> size;
+	lastRequest	= size;
+	if (size > avail)
+	   size = avail;
+	if (size <= 0) {
+	   b -> count = 0;
+	   return 0;
+	}
+
+	if (format == CF32_FILE)
+	   b -> fromInterleaved ((const DSPCOMPLEX *)p, size);
+	else
+	   b -> fromU8 (p, size);
+	currentSample	+= size;
+	release ();
+	return size;
+}
+//
+//	the equivalent of flushing the stick's buffer: when paced,
+//	skip what would have accumulated
+void	fileReader::resetBuffer	(void) {
+	if (!paced || !running)
+	   return;
+	currentSample	+= available ();
+}
+
+bool	fileReader::atEnd	(void) {
+	return totalSamples - currentSample < lastRequest;
+}
+
+int64_t	fileReader::samplesRead	(void) {
+	return currentSample;
+}
+
+int64_t	fileReader::length	(void) {
+	return fileLength / bytesPerSample;
+}
+
+void	fileReader::setRange	(int64_t first, int64_t last) {
+	if (last > length ())
+	   last = length ();
+	if (first > last)
+	   first = last;
+	if (first < 0)
+	   first = 0;
+	totalSamples	= last;
+	currentSample	= first;
+	releasedSample	= first;
+}
@@ -0,0 +1,83 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	A virtual input that plays a recording rather than a stick.
+ *	The file is memory mapped. Two formats are understood:
+ *	raw unsigned 8 bit I/Q pairs, as delivered by the dabstick
+ *	(.cu8, .u8, .raw, the default), and interleaved 32 bit
+ *	float I/Q pairs (.cf32, .fc32, .cfile).
+ *	The recording should be at the input rate of the fmProcessor.
+ *	Paced, the samples become available at that rate, as with a
+ *	stick; unpaced, all of them are available at once, and the
+ *	dsp chain runs as fast as it can.
+ */
+
+#ifndef	__FILE_READER
+#define	__FILE_READER
+
+#include	"fm-constants.h"
+#include	"virtual-input.h"
+#include	<string>
+
+class	fileReader: public virtualInput {
+public:
+	enum fileFormat {
+	   U8_FILE	= 0,
+	   CF32_FILE	= 1
+	};
+			fileReader	(const std::string &,
+	                                 int32_t, bool, bool *);
+			~fileReader	(void);
+	uint8_t		myIdentity	(void);
+	bool		restartReader	(void);
+	void		stopReader	(void);
+	int32_t		getSamples	(DSPCOMPLEX *, int32_t);
+	int32_t		getSamples	(DSPCOMPLEX *, int32_t, uint8_t);
+	int32_t		getSamples	(sampleBlock *, int32_t, uint8_t);
+	int32_t		Samples		(void);
+	void		resetBuffer	(void);
+//
+//	the file is exhausted: what is left (if anything) is shorter
+//	than the reads the consumer does, it will not be handed out
+	bool		atEnd		(void);
+	int64_t		samplesRead	(void);
+//
+//	the number of samples in the file, and restricting the reading
+//	to the samples [first, last) of it (before reading starts)
+	int64_t		length		(void);
+	void		setRange	(int64_t, int64_t);
+private:
+	int32_t		rateIn;
+	bool		paced;
+	volatile bool	running;
+	uint8_t		format;
+	int32_t		bytesPerSample;
+	uint8_t		*data;
+	size_t		fileLength;
+	int64_t		totalSamples;
+	int64_t		currentSample;
+	int64_t		releasedSample;
+	int32_t		lastRequest;
+	int64_t		startTime;
+	int64_t		available	(void);
+	void		release		(void);
+};
+#endif
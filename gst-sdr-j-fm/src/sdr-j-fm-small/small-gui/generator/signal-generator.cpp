@@ -0,0 +1,439 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include	"signal-generator.h"
+#include	"sample-block.h"
+#include	"sincos.h"
+#include	"rds-encoder.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<time.h>
+
+#define	PILOT_HZ	19000
+#define	DEVIATION_HZ	75000
+#define	ADJACENT_TONE	700
+//
+//	levels in the multiplex, the sum of them is just under
+//	full deviation
+#define	AUDIO_LEVEL	0.40
+#define	PILOT_LEVEL	0.10
+#define	RDS_LEVEL	0.05
+//
+//	a station is only there if its spectrum fits in the input band
+#define	STATION_WIDTH	100000
+
+static
+int64_t	monotonicTime (void) {
+struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts. tv_sec * 1000000000 + ts. tv_nsec;
+}
+
+//
+//	As in the file reader, the conversions between nanoseconds and
+//	samples are split in whole seconds and a remainder
+static
+int64_t	samplesIn (int64_t ns, int32_t rate) {
+	return ns / 1000000000 * rate + ns % 1000000000 * rate / 1000000000;
+}
+
+static
+int64_t	timeOf (int64_t samples, int32_t rate) {
+	return samples / rate * 1000000000 +
+	       samples % rate * 1000000000 / rate;
+}
+
+static
+DSPPHASE	toIncrement (double f, double rate) {
+	return toPhase (2 * M_PI * f / rate);
+}
+
+	signalGenerator::signalGenerator (const std::string &script,
+	                                  int32_t rate,
+	                                  bool *success) {
+const char	*s;
+char	*end;
+int16_t	i;
+
+	this	-> rateIn	= rate;
+	mySinCos		= new SinCos (1 << 16);
+	numStations		= 0;
+	running			= false;
+	currentSample		= 0;
+	startTime		= 0;
+	vfoFrequencyChanged	= NULL;
+	vfoFrequencyChangedUserData	= NULL;
+
+	mainFrequency		= Khz (96700);
+	leftTone		= 1000;
+	rightTone		= 3000;
+	stereo			= true;
+	rds			= true;
+	clockTime		= false;
+	piCode			= 0x1234;
+	ptyCode			= 10;
+	stationLabel		= "SDR-J FM";
+	radioText		= "Test transmission";
+	snr			= 60;
+	adjacentLevel		= 0;
+	crystalError		= 0;
+	correction		= 0;
+	paced			= true;
+	noiseState		= 0x12345678;
+	*success		= false;
+
+	if (!parse (script))
+	   return;
+
+	for (i = 0; i < GENERATOR_STATIONS; i ++)
+	   memset (&stations [i], 0, sizeof (station));
+
+	stations [0]. frequency	= mainFrequency;
+	stations [0]. amplitude	= 0.5;
+	stations [0]. stereo	= stereo;
+	stations [0]. leftIncr	= toIncrement (leftTone, rate);
+	stations [0]. rightIncr	= toIncrement (rightTone, rate);
+	if (rds)
+	   stations [0]. encoder = new rdsEncoder (piCode, ptyCode,
+	                                           stationLabel,
+	                                           radioText, clockTime);
+	numStations	= 1;
+
+	s	= adjacent. c_str ();
+	while (*s != 0 && numStations < GENERATOR_STATIONS) {
+	   station *st	= &stations [numStations ++];
+	   st -> frequency	= mainFrequency + strtol (s, &end, 10);
+	   st -> amplitude	= 0.5 * pow (10, adjacentLevel / 20);
+	   st -> stereo		= false;
+	   st -> leftIncr	= toIncrement (ADJACENT_TONE, rate);
+	   st -> rightIncr	= st -> leftIncr;
+	   s	= *end == ':' ? end + 1 : end + strlen (end);
+	}
+//
+//	the noise is complex, half of its power in I, half in Q
+	noiseLevel	= stations [0]. amplitude *
+	                      sqrt (pow (10, - snr / 10) / 2);
+	vfoFrequency	= mainFrequency;
+	retune ();
+	*success	= true;
+}
+
+	signalGenerator::~signalGenerator	(void) {
+int16_t	i;
+
+	for (i = 0; i < numStations; i ++)
+	   if (stations [i]. encoder != NULL)
+	      delete stations [i]. encoder;
+	delete	mySinCos;
+}
+
+bool	signalGenerator::parse	(const std::string &script) {
+std::string	rest	= script;
+
+	while (!rest. empty ()) {
+	   size_t	end	= rest. find (';');
+	   std::string	item	= rest. substr (0, end);
+	   rest	= end == std::string::npos ? "" : rest. substr (end + 1);
+	   if (item. empty ())
+	      continue;
+
+	   size_t	eq	= item. find ('=');
+	   if (eq == std::string::npos) {
+	      fprintf (stderr, "generator: no value for %s\n", item. c_str ());
+	      return false;
+	   }
+	   std::string	key	= item. substr (0, eq);
+	   std::string	value	= item. substr (eq + 1);
+	   const char	*v	= value. c_str ();
+
+	   if (key == "frequency")
+	      mainFrequency	= atoi (v);
+	   else
+	   if (key == "left")
+	      leftTone		= atoi (v);
+	   else
+	   if (key == "right")
+	      rightTone		= atoi (v);
+	   else
+	   if (key == "stereo")
+	      stereo		= atoi (v) != 0;
+	   else
+	   if (key == "rds")
+	      rds		= atoi (v) != 0;
+	   else
+	   if (key == "pi")
+	      piCode		= strtol (v, NULL, 0);
+	   else
+	   if (key == "pty")
+	      ptyCode		= atoi (v);
+	   else
+	   if (key == "ps")
+	      stationLabel	= value;
+	   else
+	   if (key == "rt")
+	      radioText		= value;
+	   else
+	   if (key == "ct")
+	      clockTime		= atoi (v) != 0;
+	   else
+	   if (key == "snr")
+	      snr		= atof (v);
+	   else
+	   if (key == "adjacent")
+	      adjacent		= value;
+	   else
+	   if (key == "adjacentlevel")
+	      adjacentLevel	= atof (v);
+	   else
+	   if (key == "paced")
+	      paced		= atoi (v) != 0;
+	   else
+	   if (key == "seed")
+	      noiseState	= strtoul (v, NULL, 0) | 1;
+	   else
+	   if (key == "ppm")
+	      crystalError	= atof (v);
+	   else {
+	      fprintf (stderr, "generator: unknown key %s\n", key. c_str ());
+	      return false;
+	   }
+	}
+	return true;
+}
+//
+//	the position of the stations relative to the vfo. A crystal
+//	off by some ppm (the part not corrected for) has the vfo off
+//	by as many, and takes the samples that much faster
+void	signalGenerator::retune	(void) {
+double	error	= (crystalError - correction) / 1000000;
+double	rate	= rateIn * (1 + error);
+int16_t	i;
+
+	pilotIncr	= toIncrement (PILOT_HZ, rate);
+	deviation	= DEVIATION_HZ / rate * PHASE_TURN;
+	for (i = 0; i < numStations; i ++) {
+	   int32_t offset	= stations [i]. frequency - vfoFrequency;
+	   stations [i]. active	= abs (offset) < rateIn / 2 - STATION_WIDTH;
+	   stations [i]. offset	= toIncrement (offset - vfoFrequency * error,
+	                                                              rate);
+	}
+}
+
+void	signalGenerator::setVFOFrequency	(int32_t f) {
+	vfoFrequency	= f;
+	retune ();
+	if (vfoFrequencyChanged != NULL)
+	   vfoFrequencyChanged (vfoFrequencyChangedUserData, f);
+}
+
+int32_t	signalGenerator::getVFOFrequency	(void) {
+	return vfoFrequency;
+}
+
+void	signalGenerator::setVFOFrequencyChangeCallback (vfoFrequencyChangedCB cb,
+	                                                void *userData) {
+	vfoFrequencyChanged		= cb;
+	vfoFrequencyChangedUserData	= userData;
+}
+
+int32_t	signalGenerator::defaultFrequency	(void) {
+	return mainFrequency;
+}
+
+uint8_t	signalGenerator::myIdentity	(void) {
+	return GENERATOR;
+}
+
+bool	signalGenerator::restartReader	(void) {
+	startTime	= monotonicTime () - timeOf (currentSample, rateIn);
+	running		= true;
+	return true;
+}
+
+void	signalGenerator::stopReader	(void) {
+	running		= false;
+}
+
+int64_t	signalGenerator::available	(void) {
+	if (!running)
+	   return 0;
+	if (!paced)
+	   return 0x7FFFFFFF;
+	return samplesIn (monotonicTime () - startTime, rateIn) -
+	                                                 currentSample;
+}
+
+int32_t	signalGenerator::Samples	(void) {
+int64_t	n	= available ();
+
+	return n > 0x7FFFFFFF ? 0x7FFFFFFF : (int32_t)n;
+}
+
+void	signalGenerator::resetBuffer	(void) {
+	if (paced && running)
+	   currentSample += available ();
+}
+
+//
+//	paced, the samples are captured as their time comes; unpaced,
+//	they have no time to speak of
+int64_t	signalGenerator::capturePosition	(void) {
+	return paced ? currentSample : -1;
+}
+
+bool	signalGenerator::captureTime	(int64_t *captured, int64_t *when) {
+	if (!paced || !running)
+	   return false;
+	*when		= monotonicTime ();
+	*captured	= (*when - startTime) / 1000 * rateIn / 1000000;
+	return true;
+}
+
+int64_t	signalGenerator::samplesGenerated	(void) {
+	return currentSample;
+}
+//
+//	as the stick does, the correction takes the ppm off the crystal
+void	signalGenerator::freqCorrection	(int32_t ppm) {
+	correction	= ppm;
+	retune ();
+}
+
+bool	signalGenerator::getCorrection	(int32_t *ppm) {
+	*ppm	= correction;
+	return true;
+}
+//
+//	a gaussian (enough) sample with unit variance, the sum of
+//	four uniform ones, from a xorshift generator
+DSPFLOAT	signalGenerator::noise	(void) {
+int32_t	sum	= 0;
+int16_t	i;
+
+	for (i = 0; i < 4; i ++) {
+	   noiseState ^= noiseState << 13;
+	   noiseState ^= noiseState >> 17;
+	   noiseState ^= noiseState << 5;
+	   sum	+= (int32_t)(noiseState >> 16) - 32768;
+	}
+	return sum * (sqrt (3.0) / 2 / 32768);
+}
+//
+//	The multiplex of a station, one sample
+//	L + R, (L - R) on a suppressed 38 KHz carrier, the pilot and
+//	the RDS subcarrier, phase locked to the pilot. The RDS symbols
+//	are biphase: a full cycle of the bit clock per bit, the sign
+//	given by the (differentially encoded) data
+DSPFLOAT	signalGenerator::mpx	(station *s) {
+DSPFLOAT left	= mySinCos -> getSin (s -> leftPhase);
+DSPFLOAT right	= mySinCos -> getSin (s -> rightPhase);
+DSPFLOAT res;
+
+	s -> leftPhase	+= s -> leftIncr;
+	s -> rightPhase	+= s -> rightIncr;
+	if (!s -> stereo)
+	   return AUDIO_LEVEL * (left + right);
+
+	res	= AUDIO_LEVEL * (left + right) +
+	          AUDIO_LEVEL * (left - right) *
+	                 mySinCos -> getSin (2 * s -> pilotPhase) +
+	          PILOT_LEVEL * mySinCos -> getSin (s -> pilotPhase);
+	if (s -> encoder != NULL) {
+	   res	+= RDS_LEVEL * s -> symbol *
+	                 mySinCos -> getSin (s -> bitPhase) *
+	                 mySinCos -> getSin (3 * s -> pilotPhase);
+	   DSPPHASE next	= s -> bitPhase + pilotIncr / 16;
+	   if (next < s -> bitPhase)
+	      s -> symbol = s -> encoder -> nextBit () ? 1 : -1;
+	   s -> bitPhase	= next;
+	}
+	s -> pilotPhase	+= pilotIncr;
+	return res;
+}
+
+void	signalGenerator::generate	(DSPFLOAT *I, DSPFLOAT *Q,
+	                                 int32_t n) {
+int32_t	i;
+int16_t	k;
+
+	for (i = 0; i < n; i ++) {
+	   DSPFLOAT re	= noiseLevel * noise ();
+	   DSPFLOAT im	= noiseLevel * noise ();
+	   for (k = 0; k < numStations; k ++) {
+	      station *s	= &stations [k];
+	      DSPFLOAT m	= mpx (s);
+	      if (!s -> active)
+	         continue;
+	      DSPCOMPLEX c	= mySinCos -> getComplex (s -> carrierPhase);
+	      re	+= s -> amplitude * real (c);
+	      im	+= s -> amplitude * imag (c);
+	      s -> carrierPhase	+= s -> offset +
+	                             (DSPPHASE)(int32_t)(m * deviation);
+	   }
+	   I [i]	= re;
+	   Q [i]	= im;
+	}
+	currentSample	+= n;
+}
+
+int32_t	signalGenerator::getSamples	(DSPCOMPLEX *V, int32_t size) {
+DSPFLOAT	I [1024], Q [1024];
+int64_t		avail	= available ();
+int32_t		done, i;
+
+	if (size > avail)
+	   size = avail;
+	for (done = 0; done < size; done += 1024) {
+	   int32_t n	= size - done < 1024 ? size - done : 1024;
+	   generate (I, Q, n);
+	   for (i = 0; i < n; i ++)
+	      V [done + i] = DSPCOMPLEX (I [i], Q [i]);
+	}
+	return size > 0 ? size : 0;
+}
+
+int32_t	signalGenerator::getSamples	(DSPCOMPLEX *V,
+	                                 int32_t size, uint8_t M) {
+	(void)M;
+	return getSamples (V, size);
+}
+
+int32_t	signalGenerator::getSamples	(sampleBlock *b,
+	                                 int32_t size, uint8_t M) {
+int64_t	avail	= available ();
+
+	(void)M;
+	if (size > b -> size)
+	   size = b -> size;
+	if (size > avail)
+	   size = avail;
+	if (size <= 0) {
+	   b -> count = 0;
+	   return 0;
+	}
+	generate (b -> I, b -> Q, size);
+	b -> count	= size;
+	return size;
+}
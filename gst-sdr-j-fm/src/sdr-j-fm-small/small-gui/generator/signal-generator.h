@@ -0,0 +1,136 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	A virtual input that makes up its own signal: one or more
+ *	FM stations, with a full multiplex (a tone in the left
+ *	and one in the right channel, the 19 KHz pilot and a 57 KHz
+ *	RDS subcarrier carrying a scripted station label and radio text),
+ *	plus white noise at a given signal to noise ratio.
+ *	The signal is described by a string of "key=value" pairs,
+ *	separated by ';', e.g.
+ *	    "frequency=96700000;ps=TEST FM;rt=Hello;snr=30"
+ *	keys (and defaults) are
+ *	    frequency		the main station's frequency (96.7 MHz)
+ *	    left, right		tone frequencies, 0 for silence (1000, 3000)
+ *	    stereo		send the pilot and L - R (1)
+ *	    rds			send RDS (1)
+ *	    pi, pty		RDS programme identification and type
+ *	    ps, rt		RDS station label and radio text
+ *	    ct			send RDS clock time groups (0)
+ *	    snr			carrier to noise over the whole input
+ *				band, in dB (60)
+ *	    adjacent		offsets (in Hz) of other stations, separated
+ *				by ':'; these send a mono 700 Hz tone
+ *	    adjacentlevel	their level relative to the main one (0 dB)
+ *	    paced		samples become available at their rate (1)
+ *	    seed		for the noise generator
+ *	    ppm			error of the crystal to simulate, the
+ *				stations come out off tune and the
+ *				multiplex at a slightly other rate (0)
+ *	Tuning works as with a stick: only stations within the input
+ *	band around the vfo frequency end up in the samples.
+ */
+
+#ifndef	__SIGNAL_GENERATOR
+#define	__SIGNAL_GENERATOR
+
+#include	"fm-constants.h"
+#include	"virtual-input.h"
+#include	<string>
+
+class	SinCos;
+class	rdsEncoder;
+
+#define	GENERATOR_STATIONS	8
+
+class	signalGenerator: public virtualInput {
+public:
+			signalGenerator	(const std::string &,
+	                                 int32_t, bool *);
+			~signalGenerator	(void);
+	void		setVFOFrequency	(int32_t);
+	int32_t		getVFOFrequency	(void);
+	void		setVFOFrequencyChangeCallback (vfoFrequencyChangedCB,
+	                                                       void *);
+	int32_t		defaultFrequency	(void);
+	uint8_t		myIdentity	(void);
+	bool		restartReader	(void);
+	void		stopReader	(void);
+	int32_t		getSamples	(DSPCOMPLEX *, int32_t);
+	int32_t		getSamples	(DSPCOMPLEX *, int32_t, uint8_t);
+	int32_t		getSamples	(sampleBlock *, int32_t, uint8_t);
+	int32_t		Samples		(void);
+	void		resetBuffer	(void);
+	int64_t		capturePosition	(void);
+	bool		captureTime	(int64_t *, int64_t *);
+	int64_t		samplesGenerated	(void);
+	void		freqCorrection	(int32_t);
+	bool		getCorrection	(int32_t *);
+private:
+	struct station {
+	   int32_t	frequency;
+	   DSPFLOAT	amplitude;
+	   bool		stereo;
+	   bool		active;
+	   DSPPHASE	offset;		// per sample, relative to the vfo
+	   DSPPHASE	carrierPhase;
+	   DSPPHASE	leftPhase, leftIncr;
+	   DSPPHASE	rightPhase, rightIncr;
+	   DSPPHASE	pilotPhase;
+	   DSPPHASE	bitPhase;
+	   rdsEncoder	*encoder;
+	   DSPFLOAT	symbol;
+	};
+	bool		parse		(const std::string &);
+	void		retune		(void);
+	void		generate	(DSPFLOAT *, DSPFLOAT *, int32_t);
+	DSPFLOAT	mpx		(station *);
+	DSPFLOAT	noise		(void);
+	int64_t		available	(void);
+	int32_t		rateIn;
+	SinCos		*mySinCos;
+	station		stations	[GENERATOR_STATIONS];
+	int16_t		numStations;
+	int32_t		vfoFrequency;
+	DSPPHASE	pilotIncr;
+	double		deviation;	// phase per unit of mpx
+	DSPFLOAT	noiseLevel;
+	uint32_t	noiseState;
+	bool		paced;
+	volatile bool	running;
+	int64_t		currentSample;
+	int64_t		startTime;
+	vfoFrequencyChangedCB	vfoFrequencyChanged;
+	void		*vfoFrequencyChangedUserData;
+//	the script, as parsed
+	int32_t		mainFrequency;
+	int32_t		leftTone, rightTone;
+	bool		stereo, rds, clockTime;
+	int32_t		piCode, ptyCode;
+	std::string	stationLabel, radioText;
+	double		snr;
+	std::string	adjacent;
+	double		adjacentLevel;
+	double		crystalError;
+	int32_t		correction;
+};
+#endif
+
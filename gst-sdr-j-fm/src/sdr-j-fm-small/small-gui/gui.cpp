@@ -30,6 +30,9 @@
 #include	"audiosink.h"
 #include	"virtual-input.h"
 #include	"dabstick-dll.h"
+#include	"file-reader.h"
+#include	"iq-recorder.h"
+#include	"signal-generator.h"
 
 #ifdef __MINGW32__
 #include	<iostream>
@@ -45,6 +48,16 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 #define	PAUSED		0101
 #define	RUNNING		0102
 #define	STOPPING	0103
+//
+//	the estimate of the crystal error is looked at every
+//	CALIBRATION_INTERVAL ms. The carrier of a station is on its
+//	frequency to a few Hz, a fraction of a ppm, its pilot to a few
+//	tenths of a Hz, some ppm of 19 KHz. They should then agree
+//	within CRYSTAL_AGREEMENT ppm, if not the station is not quite
+//	where it was tuned to, or not quite as it should be
+#define	CALIBRATION_INTERVAL	1000
+#define	PILOT_FREQUENCY		19000
+#define	CRYSTAL_AGREEMENT	5
 /*
  *	We use the creation function merely to set up the
  *	user interface and make the connections between the
@@ -58,32 +71,52 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 					ClearCallback		textClearCallback,
 					StringCallback	textChangeCallback,
 					StringCallback	textCompleteCallback,
-					void *		callbackUserData): myFMprocessor(0) {
+					void *		callbackUserData,
+					const char *	inputFile,
+					bool		inputPaced,
+					const char *	recordFile,
+					const char *	generatorSpec,
+					int32_t		audioRate): myFMprocessor(0) {
 std::string h;
 bool	success;
 
 	runMode			= IDLE;
 	squelchMode		= false;
 //
-//	not used - other than as dummy parameters - in the "mini"
-	this		-> audioRate	= 44100;
-
-	if (audioRate == 22050) {
-	   this -> inputRate = 48 * audioRate;
-	   this -> fmRate    = 8 * audioRate;
-	}
+//	the input is decimated by an integer factor to the fm rate,
+//	the audio is resampled from there to whatever rate, so the
+//	dongle and the recordings always run at the same rate
+	if (audioRate != 22050 && audioRate != 32000 && audioRate != 44100)
+	   audioRate = 48000;
+	this		-> audioRate	= audioRate;
+	this		-> inputRate	= 1058400;
+	this		-> fmRate	= 176400;
+
+	myRecorder	= NULL;
+	pthread_mutex_init (&healthLock, NULL);
+	pthread_mutex_init (&tuningLock, NULL);
+	usbShortTransfers	= 0;
+	usbDroppedSamples	= 0;
+	if (generatorSpec != NULL)
+	   myRig = new signalGenerator (generatorSpec, inputRate, &success);
 	else
-	if (audioRate == 44100) {
-	   this -> inputRate = 24 * audioRate;
-	   this -> fmRate    = 4  * audioRate;
-	}
+	if (inputFile != NULL)
+	   myRig = new fileReader (inputFile, inputRate, inputPaced, &success);
 	else {
-	   audioRate = 48000;
-	   fmRate    = 192000;
-	   inputRate = 960000;
+	   dabstick_dll *stick = new dabstick_dll (inputRate, &success);
+	   if (success && recordFile != NULL) {
+	      bool recording;
+	      myRecorder = new iqRecorder (recordFile, inputRate, &recording);
+	      if (recording)
+	         stick -> recordTo (myRecorder);
+	      else {
+	         GST_WARNING ("Could not record to %s", recordFile);
+	         delete myRecorder;
+	         myRecorder = NULL;
+	      }
+	   }
+	   myRig = stick;
 	}
-
-	myRig = new dabstick_dll (inputRate, &success);
 	
 	if (!success) {
 	  // FIXME: Need new method of error reporting
@@ -102,6 +135,9 @@ bool	success;
 	systemClock             = gst_system_clock_obtain ();
 	periodicClockId         = 0;
 	resetSeekMembers ();
+	calibrationClockId	= 0;
+	crystalSequence		= 0;
+	crystalStored		= true;
 
 //
 //
@@ -128,11 +164,21 @@ bool	success;
 }
 
 	RadioInterface::~RadioInterface () {
+	cancelCalibration ();
 	if (myFMprocessor != NULL)
 	   delete myFMprocessor;
 	gst_object_unref (GST_OBJECT (systemClock));
 	delete		our_audioSink;
 	delete myRig;
+//	only now the usb thread is gone
+	if (myRecorder != NULL)
+	   delete myRecorder;
+	pthread_mutex_destroy (&healthLock);
+	pthread_mutex_destroy (&tuningLock);
+}
+
+int32_t	RadioInterface::recordingDropped (void) {
+	return myRecorder != NULL ? myRecorder -> droppedBlocks () : 0;
 }
 
 void	RadioInterface::start	(void) {
@@ -141,6 +187,7 @@ void	RadioInterface::start	(void) {
 
 	myRig		-> restartReader ();
 	myFMprocessor   -> start ();
+	startCalibration ();
 
 	runMode = RUNNING;
 }
@@ -151,6 +198,7 @@ void	RadioInterface::stop	(void) {
 
 	// FIXME: This is a workaround for old libusb on Tizen
 	//myRig		-> stopReader ();
+	cancelCalibration ();
 	myFMprocessor	-> stop ();
 
 	runMode = PAUSED;
@@ -207,7 +255,9 @@ void	RadioInterface::abortSystem (int d) {
 //
 //
 void	RadioInterface::setGainSelector (int g) {
+	pthread_mutex_lock (&tuningLock);
 	myRig	-> setExternalGain (g);
+	pthread_mutex_unlock (&tuningLock);
 }
 
 void	RadioInterface::setfmChannelSelector (const std::string &s) {
@@ -240,14 +290,42 @@ void	RadioInterface::setAttenuation (int n) {
 //
 //	The generic setTuner.
 void	RadioInterface::setTuner (int32_t n) {
+	pthread_mutex_lock (&tuningLock);
 	myRig		-> setVFOFrequency		(n);
-	if (myFMprocessor != NULL)
+	if (myFMprocessor != NULL) {
 	   myFMprocessor	-> resetRds	();
+	   myFMprocessor	-> resetCrystalEstimate ();
+	}
+	pthread_mutex_unlock (&tuningLock);
 }
 
 void	RadioInterface::setFrequencyChangeCB (vfoFrequencyChangedCB cb, void *userData) {
 	myRig		-> setVFOFrequencyChangeCallback	(cb, userData);
 }
+
+void	RadioInterface::setRdsGroupCB (RdsGroupCallback cb, void *userData) {
+	myFMprocessor	-> setRdsGroupCallback	(cb, userData);
+}
+
+void	RadioInterface::setMpxQueue (RingBuffer<mpxBlock> *queue) {
+	myFMprocessor	-> setMpxQueue	(queue);
+}
+
+int32_t	RadioInterface::getMpxRate (void) {
+	return fmRate;
+}
+
+int32_t	RadioInterface::getAudioRate (void) {
+	return audioRate;
+}
+
+void	RadioInterface::setStereo (bool stereo) {
+	myFMprocessor	-> setfmMode (stereo);
+}
+
+void	RadioInterface::setAudioDepth (int32_t frames) {
+	myFMprocessor	-> setAudioDepth (frames);
+}
 //
 void	RadioInterface::seek (int16_t threshold,
 			      int32_t minFrequency, int32_t maxFrequency,
@@ -287,12 +365,15 @@ void	RadioInterface::cancelSeek () {
 
 	cancelSeekTimeout ();
 	myFMprocessor -> stopScanning ();
+	pthread_mutex_lock (&tuningLock);
 	myRig -> setVFOFrequency (preSeekFrequency);
+	pthread_mutex_unlock (&tuningLock);
 
 	resetSeekMembers();
 }
 
 void	RadioInterface::iterateSeekFrequency() {
+	pthread_mutex_lock (&tuningLock);
 	int32_t nextFrequency = myRig -> getVFOFrequency() + seekStep;
 	if (nextFrequency > seekMax)
 		nextFrequency = seekMin;
@@ -300,6 +381,7 @@ void	RadioInterface::iterateSeekFrequency() {
 		nextFrequency = seekMax;
 
 	myRig -> setVFOFrequency (nextFrequency);
+	pthread_mutex_unlock (&tuningLock);
 }
 
 void	RadioInterface::cancelSeekTimeout() {
@@ -347,6 +429,95 @@ gboolean RadioInterface::seekTimeout () {
 
 	return TRUE;
 }
+//
+//	only inputs that take a correction are calibrated
+void	RadioInterface::startCalibration () {
+int32_t	ppm;
+
+	if (calibrationClockId != 0 || !myRig -> getCorrection (&ppm))
+	   return;
+
+	GST_DEBUG ("Calibrating the crystal, corrected by %d ppm", ppm);
+	myFMprocessor	-> resetCrystalEstimate ();
+	calibrationClockId	= gst_clock_new_periodic_id (systemClock,
+					gst_clock_get_time (systemClock),
+					CALIBRATION_INTERVAL * 1000000);
+	gst_clock_id_wait_async (calibrationClockId,
+	                         &RadioInterface::calibrationTimeout,
+	                         this, NULL);
+}
+
+void	RadioInterface::cancelCalibration () {
+	if (calibrationClockId == 0)
+	   return;
+
+	gst_clock_id_unschedule (calibrationClockId);
+	gst_clock_id_unref (calibrationClockId);
+	calibrationClockId	= 0;
+//	a calibration under way is waited for
+	pthread_mutex_lock (&tuningLock);
+	pthread_mutex_unlock (&tuningLock);
+}
+
+gboolean RadioInterface::calibrationTimeout (GstClock *clock, GstClockTime time,
+				      GstClockID id, gpointer user_data) {
+RadioInterface	*radio = static_cast<RadioInterface *>(user_data);
+
+	pthread_mutex_lock (&radio -> tuningLock);
+	radio -> calibrate ();
+	pthread_mutex_unlock (&radio -> tuningLock);
+	return TRUE;
+}
+//
+//	A new estimate of the error, what is left after the correction
+//	so far, that rounds to a ppm or more is added to the correction,
+//	and the estimates start over. The first one that rounds to
+//	nothing after a change has the correction stored, for the next
+//	time the device is opened.
+//	It runs on the clock thread, with the tuningLock held, so the
+//	correction does not cross a retuning
+void	RadioInterface::calibrate () {
+crystalEstimate	e;
+int32_t		correction;
+DSPFLOAT	error;
+
+	if (myFMprocessor -> isScanning () ||
+	    !myFMprocessor -> getCrystalEstimate (&e) ||
+	    e. sequence == crystalSequence ||
+	    !myRig -> getCorrection (&correction))
+	   return;
+	crystalSequence	= e. sequence;
+
+	error	= - 1e6 * e. pilotOffset / PILOT_FREQUENCY;
+	if (e. carrier) {
+	   DSPFLOAT carrier = - 1e6 * e. dcOffset / myRig -> getVFOFrequency ();
+	   if (fabs (carrier - error) > CRYSTAL_AGREEMENT) {
+	      GST_DEBUG ("Crystal off by %.1f ppm from the carrier, but %.1f"
+	                 " ppm from the pilot, not correcting", carrier, error);
+	      return;
+	   }
+	   error	= carrier;
+	}
+
+	if (lrint (error) == 0) {
+	   if (!crystalStored)
+	      myRig	-> storeCorrection ();
+	   crystalStored	= true;
+	   return;
+	}
+
+	correction	+= lrint (error);
+	if (abs (correction) > MAX_CORRECTION) {
+	   GST_WARNING ("Crystal off by %d ppm, too far to correct",
+	                correction);
+	   return;
+	}
+	GST_INFO ("Crystal off by %.1f ppm more, correcting by %d ppm",
+	          error, correction);
+	myRig		-> freqCorrection (correction);
+	myFMprocessor	-> resetCrystalEstimate ();
+	crystalStored	= false;
+}
 	
 	
 //	Deemphasis	= 50 usec (3183 Hz, Europe)
@@ -461,6 +632,61 @@ uint32_t RadioInterface::getWaitingSamples () {
 	return our_audioSink -> waiting ();
 }
 
+int64_t	RadioInterface::getAudioPosition (void) {
+	return our_audioSink -> framesWritten ();
+}
+
+int64_t	RadioInterface::getReadPosition (void) {
+	return our_audioSink -> framesRead ();
+}
+//
+//	from the latest block of input demodulated, at the nominal
+//	rates, the trim of the audio rate is too small to matter here
+int64_t	RadioInterface::getCapturePosition (int64_t position) {
+captureMark	m;
+
+	if (!myFMprocessor -> getCaptureMark (&m))
+	   return -1;
+	return m. position - (m. frame - position) * inputRate / audioRate;
+}
+
+bool	RadioInterface::getCaptureTime (int64_t *captured, int64_t *time) {
+	return myRig -> captureTime (captured, time);
+}
+
+int32_t	RadioInterface::getInputRate (void) {
+	return inputRate;
+}
+
+void	RadioInterface::getProfile (stageProfile::snapshot *s) {
+	myFMprocessor -> getProfile (s);
+}
+
+bool	RadioInterface::getTelemetry (receptionTelemetry *t) {
+	return myFMprocessor -> getTelemetry (t);
+}
+
+void	RadioInterface::getHealth (healthCounters *h) {
+	pthread_mutex_lock (&healthLock);
+	usbShortTransfers	+= myRig -> getTransfersMissed ();
+	usbDroppedSamples	+= myRig -> getSamplesMissed ();
+	h -> usbShortTransfers	= usbShortTransfers;
+	h -> usbDroppedSamples	= usbDroppedSamples;
+	pthread_mutex_unlock (&healthLock);
+
+	h -> audioDroppedFrames	= our_audioSink -> framesDropped ();
+	h -> audioUnderruns	= our_audioSink -> underruns ();
+	h -> recorderDroppedBlocks	= recordingDropped ();
+//	recordings and generators have no buffer to fill
+	h -> inputSize		= myRig -> bufferSize ();
+	h -> inputFill		= h -> inputSize > 0 ? myRig -> Samples () : 0;
+	h -> audioFill		= our_audioSink -> waiting ();
+	h -> audioSize		= our_audioSink -> bufferSize ();
+	h -> audioRateCorrection	= 1e6 * myFMprocessor -> get_rateCorrection ();
+	if (!myRig -> getCorrection (&h -> crystalCorrection))
+	   h -> crystalCorrection	= 0;
+}
+
 void	RadioInterface::cancelGet (void) {
 	GST_DEBUG("Cancelling get in audio sink");
 	our_audioSink -> cancelGet ();
@@ -469,4 +695,5 @@ void	RadioInterface::cancelGet (void) {
 
 void	RadioInterface::flush (void) {
 	our_audioSink -> flush ();
+	myFMprocessor -> resetCaptureMark ();
 }
@@ -36,10 +36,42 @@
 #include	"virtual-input.h"
 #include	"fm-processor.h"
 #include	<gst/gst.h>
+#include	<pthread.h>
 
 class	rdsDecoder;
+class	iqRecorder;
 class	audioSink;
 
+/** \brief Counts of the samples lost, or waited for, on their way
+ * through the radio.
+ *
+ * The counts are totals since the RadioInterface was created.
+ */
+struct	healthCounters {
+	/** USB transfers dropped for not having the expected length */
+	int64_t		usbShortTransfers;
+	/** I/Q samples dropped because the input buffer was full */
+	int64_t		usbDroppedSamples;
+	/** Audio frames dropped because the audio buffer was full */
+	int64_t		audioDroppedFrames;
+	/** Reads of audio that found the audio buffer empty */
+	int64_t		audioUnderruns;
+	/** Blocks the I/Q recording could not keep up with */
+	int64_t		recorderDroppedBlocks;
+	/** I/Q samples waiting in the input buffer */
+	int32_t		inputFill;
+	/** Size of the input buffer in I/Q samples, 0 if there is none */
+	int32_t		inputSize;
+	/** Audio frames waiting in the audio buffer */
+	int32_t		audioFill;
+	/** Size of the audio buffer in frames */
+	int32_t		audioSize;
+	/** Trim of the audio rate holding the audio buffer depth, in ppm */
+	float		audioRateCorrection;
+	/** Correction of the crystal of the input, in ppm */
+	int32_t		crystalCorrection;
+};
+
 /** \brief This is the main interface for the FM radio.
  * 
  * Originally this class was the main GUI class.
@@ -53,7 +85,12 @@ public:
 					 ClearCallback = 0,	// rds radio text clear callback
 					 StringCallback = 0,	// rds radio text change callback
 					 StringCallback = 0,	// rds radio text complete callback
-					 void * = 0); // rds callbacks userdata
+					 void * = 0, // rds callbacks userdata
+					 const char * = 0, // recording to play instead of the stick
+					 bool = true, // play the recording at its real rate
+					 const char * = 0, // file to record the stick's samples in
+					 const char * = 0, // signal to generate instead of the stick
+					 int32_t = 44100); // audio rate: 32000, 44100 or 48000
 		~RadioInterface		();
 
 	/** \brief Get demodulated stereo interleaved audio samples.
@@ -65,9 +102,43 @@ public:
 	 */
 	int32_t		getSamples		(DSPFLOAT *data, uint32_t length);
 
+	/** \brief Get the number of sample blocks the I/Q recording had to drop */
+	int32_t		recordingDropped	(void);
+
 	/** \brief Get the number of samples waiting in the audio output buffer */
 	uint32_t	getWaitingSamples	(void);
 
+	/** \brief Get the number of audio frames written to the output
+	 * buffer and not flushed, the position of the next one in the
+	 * audio read with getSamples */
+	int64_t		getAudioPosition	(void);
+
+	/** \brief Get the number of audio frames read with getSamples,
+	 * the position of the next one read */
+	int64_t		getReadPosition		(void);
+
+	/** \brief Get the capture index of the input sample the audio
+	 * frame at \a position was made from, counted in samples since
+	 * the input started, -1 if the input does not count them */
+	int64_t		getCapturePosition	(int64_t position);
+
+	/** \brief Get the input samples captured so far, and the
+	 * monotonic time, in ns, the last of them came in at
+	 * \returns false if the input does not count them */
+	bool		getCaptureTime		(int64_t *captured, int64_t *time);
+
+	/** \brief Get the rate of the input, in samples per second */
+	int32_t		getInputRate		(void);
+
+	/** \brief Get the time taken by each stage of the demodulation so far */
+	void		getProfile		(stageProfile::snapshot *);
+
+	/** \brief Get the counts of lost samples and the buffer fill levels */
+	void		getHealth		(healthCounters *);
+
+	/** \brief Get the latest reception telemetry, false if none yet */
+	bool		getTelemetry		(receptionTelemetry *);
+
 	/** \brief Cancel any wait in getSamples */
 	void		cancelGet		(void);
 
@@ -78,6 +149,28 @@ public:
 	void		setTuner		(int32_t frequency);
 
 	void		setFrequencyChangeCB	(vfoFrequencyChangedCB, void *);
+
+	/** \brief Have every RDS group received passed to \a callback,
+	 * from the thread of the demodulator, set before starting */
+	void		setRdsGroupCB		(RdsGroupCallback, void *);
+
+	/** \brief Have the demodulated multiplex put in \a queue, at
+	 * the rate given by getMpxRate, or no more for NULL */
+	void		setMpxQueue		(RingBuffer<mpxBlock> *queue);
+
+	/** \brief Get the sample rate of the multiplex, in Hz */
+	int32_t		getMpxRate		(void);
+
+	/** \brief Get the sample rate of the audio, in Hz */
+	int32_t		getAudioRate		(void);
+
+	/** \brief Decode stereo when the pilot is found, or mono only */
+	void		setStereo		(bool);
+
+	/** \brief Trim the audio rate so \a frames stay waiting in the
+	 * output buffer, following the clock getSamples is called at,
+	 * or not for 0 */
+	void		setAudioDepth		(int32_t frames);
 	
 	/** \brief Start seeking for a station.
 	 * 
@@ -121,6 +214,14 @@ private:
 	int32_t		audioRate;
 	audioSink	*our_audioSink;
 	virtualInput	*myRig;
+	iqRecorder	*myRecorder;
+//	the input counts are reset on reading, so they are summed here
+	pthread_mutex_t	healthLock;
+	int64_t		usbShortTransfers;
+	int64_t		usbDroppedSamples;
+//	the application, the seek and the calibration clock all tune,
+//	one at a time
+	pthread_mutex_t	tuningLock;
 
 	uint8_t		HFviewMode;
 	uint8_t		inputMode;
@@ -140,6 +241,17 @@ private:
 	void            cancelSeekTimeout ();
 	void            resetSeekMembers ();
 
+//	the correction of the crystal of the input follows the estimates
+//	of its error the processor makes
+	GstClockID	calibrationClockId;
+	uint64_t	crystalSequence;
+	bool		crystalStored;
+	void		startCalibration	(void);
+	void		cancelCalibration	(void);
+	static gboolean	calibrationTimeout	(GstClock *, GstClockTime,
+						 GstClockID, gpointer);
+	void		calibrate		(void);
+
 	static void	stationCallback(int32_t frequency, void *userdata);
 	void		stationCallback(int32_t frequency);
 	
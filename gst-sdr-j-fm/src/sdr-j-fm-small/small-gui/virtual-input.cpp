@@ -27,6 +27,7 @@
  * 	virtual input class
  */
 #include	"virtual-input.h"
+#include	"sample-block.h"
 
 	virtualInput::virtualInput (void) {
 	lastFrequency	= 100000;
@@ -87,6 +88,22 @@ int32_t	virtualInput::getSamples	(DSPCOMPLEX *v, int32_t amount, uint8_t M) {
 	return 0;
 }
 
+//
+//	Default for the sample block version: read interleaved and
+//	split. Devices that can fill the I and Q arrays directly
+//	should override this one
+int32_t	virtualInput::getSamples	(sampleBlock *b, int32_t amount,
+	                                                 uint8_t M) {
+DSPCOMPLEX	*v	= (DSPCOMPLEX *)alloca (amount * sizeof (DSPCOMPLEX));
+int32_t	n;
+
+	if (amount > b -> size)
+	   amount = b -> size;
+	n	= getSamples (v, amount, M);
+	b -> fromInterleaved (v, n);
+	return n;
+}
+
 int32_t	virtualInput::Samples		(void) {
 	return 0;
 }
@@ -99,6 +116,24 @@ int32_t	virtualInput::getSamplesMissed	(void) {
 	return 0;
 }
 
+int32_t	virtualInput::getTransfersMissed	(void) {
+	return 0;
+}
+
+int32_t	virtualInput::bufferSize	(void) {
+	return 0;
+}
+
+int64_t	virtualInput::capturePosition	(void) {
+	return -1;
+}
+
+bool	virtualInput::captureTime	(int64_t *captured, int64_t *when) {
+	(void)captured;
+	(void)when;
+	return false;
+}
+
 void	virtualInput::resetBuffer	(void) {
 }
 
@@ -106,6 +141,14 @@ void	virtualInput::freqCorrection	(int32_t f) {
 	(void)f;
 }
 
+bool	virtualInput::getCorrection	(int32_t *ppm) {
+	(void)ppm;
+	return false;
+}
+
+void	virtualInput::storeCorrection	(void) {
+}
+
 int16_t	virtualInput::maxGain		(void) {
 	return 30;
 }
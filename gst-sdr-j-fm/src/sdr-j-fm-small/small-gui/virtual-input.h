@@ -43,9 +43,15 @@
 //	and non-sticks
 
 #define	someStick(x)	((x) & 03)
+//
+//	corrections of the crystal, in ppm, beyond this are not taken:
+//	a crystal that far off is broken rather than off
+#define	MAX_CORRECTION	200
 
 typedef void (*  vfoFrequencyChangedCB) (void *, int32_t);
 
+class	sampleBlock;
+
 class	virtualInput {
 public:
 			virtualInput 	(void);
@@ -60,12 +66,30 @@ virtual		bool	legalFrequency	(int32_t);
 virtual		int32_t	defaultFrequency (void);
 virtual		void	setOffset	(int32_t);
 virtual		void	freqCorrection	(int32_t);
+//	the correction, in ppm, of the crystal the device tunes and
+//	samples with; false if it cannot be corrected
+virtual		bool	getCorrection	(int32_t *);
+//	keep the correction for the next time the device is opened
+virtual		void	storeCorrection	(void);
 virtual		bool	restartReader	(void);
 virtual		void	stopReader	(void);
 virtual		int32_t	getSamples	(DSPCOMPLEX *, int32_t);
 virtual		int32_t	getSamples	(DSPCOMPLEX *, int32_t, uint8_t);
+virtual		int32_t	getSamples	(sampleBlock *, int32_t, uint8_t);
 virtual		int32_t	Samples		(void);
 virtual		int32_t	getSamplesMissed	(void);
+//	transfers from the device that had to be dropped, like the
+//	samples missed, counted since the previous call
+virtual		int32_t	getTransfersMissed	(void);
+//	the size, in samples, of the buffer Samples () reports on, or 0
+virtual		int32_t	bufferSize	(void);
+//	the capture index, counted in samples since the reader started,
+//	of the next sample getSamples gives, the samples the device lost
+//	on the way counted in; -1 if the device does not count them
+virtual		int64_t	capturePosition	(void);
+//	the samples captured so far, and the monotonic time, in ns, the
+//	last of them came in at; false if the device does not count them
+virtual		bool	captureTime	(int64_t *, int64_t *);
 virtual		void	resetBuffer	(void);
 virtual		int16_t	maxGain		(void);
 virtual		int16_t	bitDepth	(void) { return 10;}
@@ -41,6 +41,7 @@ int32_t	i;
 	         this	-> rateIn	= rateIn;
 	         this	-> mySinCos	= mySinCos;
 	         this	-> K_FM		= K_FM;
+	         this	-> kernels	= getKernels ();
 
 	         this	-> selectedDecoder	= FM4DECODER;
 	         this	-> max_freq_deviation =
@@ -89,72 +90,208 @@ const char	*fm_Demodulator::nameofDecoder (void) {
 	}
 }
 
-DSPFLOAT	fm_Demodulator::demodulate (DSPCOMPLEX z) {
-DSPFLOAT	res;
-DSPFLOAT	I, Q;
+//
+//	The demodulators work on a block of samples, so the decoder
+//	is selected once per block rather than once per sample.
+//	Normalizing the samples costs a square root and a division,
+//	it is only done by the decoders that depend on the amplitude
+//	(FM1 and FM5), the others only look at the phase
 #define	DCAlpha	0.0001
 //#define	DCAlpha	0.000001
+#define	MIN_AMPLITUDE	0.001
+
+DSPFLOAT	fm_Demodulator::demodulate (DSPCOMPLEX z) {
+DSPFLOAT	I	= real (z);
+DSPFLOAT	Q	= imag (z);
+DSPFLOAT	res;
+
+	demodulate (&I, &Q, &res, 1);
+	return res;
+}
+
+void	fm_Demodulator::demodulate (const DSPCOMPLEX *in,
+	                            DSPFLOAT *out, int32_t n) {
+DSPFLOAT	*I	= (DSPFLOAT *)alloca (n * sizeof (DSPFLOAT));
+DSPFLOAT	*Q	= (DSPFLOAT *)alloca (n * sizeof (DSPFLOAT));
+int32_t	i;
 
-	if (abs (z) <= 0.001)
-	   I = Q = 0.001;	// do not make these 0 too often
-	else { 
-	   I = real (z) / abs (z);
-	   Q = imag (z) / abs (z);
+	for (i = 0; i < n; i ++) {
+	   I [i]	= real (in [i]);
+	   Q [i]	= imag (in [i]);
 	}
+	demodulate (I, Q, out, n);
+}
+
+void	fm_Demodulator::demodulate (const sampleBlock *in, DSPFLOAT *out) {
+	demodulate (in -> I, in -> Q, out, in -> count);
+}
+
+void	fm_Demodulator::demodulate (const DSPFLOAT *I, const DSPFLOAT *Q,
+	                            DSPFLOAT *out, int32_t n) {
+	if (n <= 0)
+	   return;
 
-	z	= DSPCOMPLEX (I, Q);
 	switch (selectedDecoder) {
 	   default:
 	   case FM1DECODER:
-	      res	= Imin1 * (Q - Qmin2) - Qmin1 * (I - Imin2);
-	      res	/= Imin1 * Imin1 + Qmin1 * Qmin1;
-	      Imin2	= Imin1;
-	      Qmin2	= Qmin1;
-	      fm_afc	= (1 - DCAlpha) * fm_afc + DCAlpha * res;
-	      res	= (res - fm_afc) * fm_cvt;
-	      res	/= K_FM;
+	      demodulateFM1 (I, Q, out, n);
 	      break;
 
 	   case FM2DECODER:
-	      res	= arg (z * DSPCOMPLEX (Imin1, - Qmin1));
-	      fm_afc	= (1 - DCAlpha) * fm_afc + DCAlpha * res;
-	      res	= (res - fm_afc) * fm_cvt;
-	      res	/= K_FM;
+	      demodulateFM2 (I, Q, out, n);
 	      break;
 
 	   case FM3DECODER:
-	      res	= myAtan. atan2 (Q * Imin1- I * Qmin1,
-	                                 I * Imin1 + Q * Qmin1);
-	      fm_afc	= (1 - DCAlpha) * fm_afc + DCAlpha * res;
-	      res	= (res - fm_afc) * fm_cvt;
-	      res	/= K_FM;
+	      demodulateFM3 (I, Q, out, n);
 	      break;
-//
+
 	   case FM4DECODER:
-	      myfm_pll	-> do_pll (z);
-//	lowpass the NCO frequency term to get a DC offset
-	      fm_afc	= (1 - DCAlpha) * fm_afc +
-	                   DCAlpha * myfm_pll -> getPhaseIncr ();
-	      res	= (myfm_pll -> getPhaseIncr () - fm_afc) * fm_cvt;
-	      res	/= K_FM;
+	      demodulateFM4 (I, Q, out, n);
 	      break;
 
 	   case FM5DECODER:
-	      res	= (Imin1 * Q - Qmin1 * I + 1.0) / 2.0;
-	      res	= Arcsine [(int)(res * ArcsineSize)];
-	      fm_afc	= (1 - DCAlpha) * fm_afc + DCAlpha * res;
-	      res	= (res - fm_afc) * fm_cvt;
-	      res	/= K_FM;
+	      demodulateFM5 (I, Q, out, n);
 	      break;
 	}
+	removeDC (out, n);
+}
 //
-//	and shift ...
-	Imin1	= I;
-	Qmin1	= Q;
-	return res;
+//	the one recursive part: track the DC component (the afc)
+//	and scale the result
+void	fm_Demodulator::removeDC (DSPFLOAT *v, int32_t n) {
+int32_t	i;
+DSPFLOAT	scale	= fm_cvt / K_FM;
+
+	for (i = 0; i < n; i ++) {
+	   fm_afc	= (1 - DCAlpha) * fm_afc + DCAlpha * v [i];
+	   v [i]	= (v [i] - fm_afc) * scale;
+	}
+}
+//
+//	normalize (I, Q), very small values are not made 0 too often
+static inline
+void	normalize (DSPFLOAT i, DSPFLOAT q, DSPFLOAT *I, DSPFLOAT *Q) {
+DSPFLOAT	mag2	= i * i + q * q;
+
+	if (mag2 <= MIN_AMPLITUDE * MIN_AMPLITUDE) {
+	   *I = *Q = MIN_AMPLITUDE;
+	   return;
+	}
+	DSPFLOAT inv	= 1.0 / sqrt (mag2);
+	*I	= i * inv;
+	*Q	= q * inv;
+}
+
+//	Difference based
+void	fm_Demodulator::demodulateFM1 (const DSPFLOAT *in_I,
+	                               const DSPFLOAT *in_Q,
+	                               DSPFLOAT *out, int32_t n) {
+int32_t	i;
+DSPFLOAT	I, Q;
+
+	for (i = 0; i < n; i ++) {
+	   normalize (in_I [i], in_Q [i], &I, &Q);
+	   out [i]	= Imin1 * (Q - Qmin2) - Qmin1 * (I - Imin2);
+	   out [i]	/= Imin1 * Imin1 + Qmin1 * Qmin1;
+	   Imin2	= Imin1;
+	   Qmin2	= Qmin1;
+	   Imin1	= I;
+	   Qmin1	= Q;
+	}
+}
+//
+//	Complex baseband delay: the argument of z [i] * conj (z [i - 1])
+//	does not depend on the amplitudes
+void	fm_Demodulator::demodulateFM2 (const DSPFLOAT *I,
+	                               const DSPFLOAT *Q,
+	                               DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	out [0]	= arg (DSPCOMPLEX (I [0], Q [0]) * DSPCOMPLEX (Imin1, - Qmin1));
+	for (i = 1; i < n; i ++)
+	   out [i] = arg (DSPCOMPLEX (I [i], Q [i]) *
+	                  DSPCOMPLEX (I [i - 1], - Q [i - 1]));
+	Imin1	= I [n - 1];
+	Qmin1	= Q [n - 1];
+}
+//
+//	Mixed demodulator: as FM2, but with the polynomial atan2,
+//	taken by the kernel over the whole block at once
+void	fm_Demodulator::demodulateFM3 (const DSPFLOAT *I,
+	                               const DSPFLOAT *Q,
+	                               DSPFLOAT *out, int32_t n) {
+int32_t	i;
+DSPFLOAT	*y	= (DSPFLOAT *)alloca (n * sizeof (DSPFLOAT));
+DSPFLOAT	*x	= (DSPFLOAT *)alloca (n * sizeof (DSPFLOAT));
+
+	y [0]	= Q [0] * Imin1 - I [0] * Qmin1;
+	x [0]	= I [0] * Imin1 + Q [0] * Qmin1;
+	for (i = 1; i < n; i ++) {
+	   y [i]	= Q [i] * I [i - 1] - I [i] * Q [i - 1];
+	   x [i]	= I [i] * I [i - 1] + Q [i] * Q [i - 1];
+	}
+	kernels -> atan2 (y, x, out, n);
+	Imin1	= I [n - 1];
+	Qmin1	= Q [n - 1];
+}
+//
+//	the pll only uses the phase error, the amplitude does not matter
+void	fm_Demodulator::demodulateFM4 (const DSPFLOAT *I,
+	                               const DSPFLOAT *Q,
+	                               DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i < n; i ++) {
+	   myfm_pll	-> do_pll (DSPCOMPLEX (I [i], Q [i]));
+	   out [i]	= myfm_pll -> getPhaseIncr ();
+	}
+	Imin1	= I [n - 1];
+	Qmin1	= Q [n - 1];
+}
+
+//	Real baseband delay, the arcsine needs normalized values
+void	fm_Demodulator::demodulateFM5 (const DSPFLOAT *in_I,
+	                               const DSPFLOAT *in_Q,
+	                               DSPFLOAT *out, int32_t n) {
+int32_t	i;
+DSPFLOAT	I, Q;
+
+	for (i = 0; i < n; i ++) {
+	   normalize (in_I [i], in_Q [i], &I, &Q);
+	   int32_t index = (int32_t)((Imin1 * Q - Qmin1 * I + 1.0) / 2.0 *
+	                                                    ArcsineSize);
+	   if (index < 0)
+	      index = 0;
+	   if (index >= ArcsineSize)
+	      index = ArcsineSize - 1;
+	   out [i]	= Arcsine [index];
+	   Imin1	= I;
+	   Qmin1	= Q;
+	}
 }
 
 DSPFLOAT	fm_Demodulator::get_DcComponent (void) {
 	return fm_afc;
 }
+//
+//	FM2 and FM3 give the phase step per sample as it is, FM4 twice
+//	the increment of its nco, that runs against the signal. FM1 and
+//	FM5 give (about) its sine, over the full deviation that does not
+//	average to the sine of the average step
+bool	fm_Demodulator::get_DcFrequency (DSPFLOAT *offset) {
+DSPFLOAT	step;
 
+	switch (selectedDecoder) {
+	   case FM2DECODER:
+	   case FM3DECODER:
+	      step	= fm_afc;
+	      break;
+	   case FM4DECODER:
+	      step	= - fm_afc / 2;
+	      break;
+	   default:
+	      return false;
+	}
+	*offset	= step * rateIn / (2 * M_PI);
+	return true;
+}
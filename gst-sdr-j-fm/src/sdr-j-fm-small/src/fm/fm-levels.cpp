@@ -26,6 +26,7 @@
  */
 
 #include	"fm-levels.h"
+#include	<string.h>
 
 	fmLevels::fmLevels	(int16_t size,
 	                         int32_t rate, int16_t freq) {
@@ -43,6 +44,8 @@ float	binSize;	// size of bin in Hz
 	binSize			= (float)Rate_in / size;
 	bufferPointer		= 0;
 	inputBuffer		= new DSPFLOAT [size];
+	windowed		= new DSPFLOAT [size];
+	kernels			= getKernels ();
 	compute			= new common_fft (size);
 	buffer			= compute	-> getVector ();
 	Window			= new DSPFLOAT [size];
@@ -69,6 +72,7 @@ float	binSize;	// size of bin in Hz
 	fmLevels::~fmLevels	(void) {
 	delete	compute;
 	delete	[] inputBuffer;
+	delete	[] windowed;
 	delete	[] Window;
 }
 
@@ -80,19 +84,24 @@ DSPFLOAT	p2	= 0;
 DSPFLOAT	p3	= 0;
 DSPFLOAT	p4	= 0;
 
-	inputBuffer [bufferPointer] = v * Window [bufferPointer];
+	inputBuffer [bufferPointer] = v;
 	if (++ bufferPointer >= size)
 	   bufferPointer = 0;
 
 	counter ++;
 	if (counter <= Rate_in / freq) 
 	   return;
-
+//
+//	only now the samples are put in order, oldest first, and
+//	windowed, as one vector
 	counter		= 0;
-	for (i = 0; i < size; i ++) {
-	   buffer [i] =
-	         DSPCOMPLEX (inputBuffer [(bufferPointer + i) % size], 0);
-	}
+	memcpy (windowed, &inputBuffer [bufferPointer],
+	                  (size - bufferPointer) * sizeof (DSPFLOAT));
+	memcpy (&windowed [size - bufferPointer], inputBuffer,
+	                  bufferPointer * sizeof (DSPFLOAT));
+	kernels	-> window (Window, windowed, windowed, size);
+	for (i = 0; i < size; i ++)
+	   buffer [i] = DSPCOMPLEX (windowed [i], 0);
 
 	compute	-> do_FFT ();
 
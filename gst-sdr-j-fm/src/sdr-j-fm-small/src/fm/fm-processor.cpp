@@ -33,7 +33,6 @@
 #include	"squelchClass.h"
 #include	"sincos.h"
 #include	"virtual-input.h"
-#include	"newconverter.h"
 #include	<stdexcept>
 #include	<iostream>
 
@@ -46,6 +45,23 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 #define	OMEGA_DEMOD		2 * M_PI / fmRate
 #define	OMEGA_PILOT	((DSPFLOAT (PILOT_FREQUENCY)) / fmRate) * (2 * M_PI)
 #define	OMEGA_RDS	((DSPFLOAT) RDS_FREQUENCY / fmRate) * (2 * M_PI)
+#define	PILOT_PLL_OFFSET	0.5
+//
+//	the loop holding the audio depth: the fill of the sink is
+//	averaged over DEPTH_AVERAGING seconds, and the loop settles in
+//	a minute or two (a natural frequency of 0.05 rad/s, critically
+//	damped). The fill jumps by the blocks read and written, a faster
+//	loop passes that on to the rate. Crystals are off by less than
+//	100 ppm, the trim is limited to 1000 ppm, at which a pitch change
+//	is not heard yet
+#define	DEPTH_AVERAGING		2.0
+#define	DEPTH_KP		0.1
+#define	DEPTH_KI		0.0025
+#define	MAX_RATE_CORRECTION	0.001
+//
+//	the crystal error is estimated over CRYSTAL_WINDOW seconds of
+//	locked pilot, the dc component settles in a few hundredths
+#define	CRYSTAL_WINDOW		4
 
 //
 //	Note that no decimation done as yet: the samplestream is still
@@ -74,6 +90,11 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 	this	-> audioRate		= audioRate;
 	this	-> thresHold		= thresHold;
 	this	-> squelchOn		= false;
+	this	-> telemetryCount	= 0;
+	this	-> telemetrySamples	= 0;
+	this	-> rdsGroupCallback	= NULL;
+	this	-> rdsGroupUserdata	= NULL;
+	this	-> mpxQueue		= NULL;
 
 	pthread_mutex_init (&this -> scanLock, NULL);
 	this	-> scanning		= false;
@@ -121,7 +142,7 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 //	Since data is coming with a pretty high rate, we need to filter
 //	and decimate in an efficient way. We have an optimized
 //	decimating filter
-	fmBandfilter		= new DecimatingFIR (15,
+	fmBandfilter		= new DecimatingRealFIR (15,
 	                                             fmRate / 2,
 	                                             inputRate,
 	                                             decimatingScale);
@@ -136,11 +157,17 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 	                                             OMEGA_PILOT,
 	                                             25 * omega_demod,
 	                                             mySinCos);
-	pilotDelay	= (FFT_SIZE - PILOTFILTER_SIZE) * OMEGA_PILOT;
+//	the filtered pilot lags a block of the fft filter and the group
+//	delay of its kernel, and the pll settles a little behind it.
+//	Leaving the group delay out only came close at an fm rate of
+//	176400, the offset is where the separation peaks at any rate
+	pilotDelay	= toPhase ((FFT_SIZE - PILOTFILTER_SIZE +
+	                            (PILOTFILTER_SIZE - 1) / 2) * OMEGA_PILOT -
+	                           PILOT_PLL_OFFSET);
 
 //	rdsLowPassFilter	= new fftFilter (FFT_SIZE, RDSLOWPASS_SIZE);
 //	rdsLowPassFilter	-> setLowPass (RDS_WIDTH, fmRate);
-	rdsLowPassFilter	= new DecimatingFIR (21,
+	rdsLowPassFilter	= new DecimatingRealFIR (21,
 	                                             RDS_WIDTH / 2,
 	                                             fmRate,
 	                                             RDS_DECIMATOR);
@@ -154,7 +181,11 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 
 	TheDemodulator		= new fm_Demodulator (fmRate,
 	                                              mySinCos, K_FM);
-	fmAudioFilter		= new LowPassFIR (11, 11000, fmRate);
+//	the audio rate need not divide the fm rate, the filter
+//	resamples to it in the same pass
+	fmAudioFilter		= new ResamplingRealFIR (11, 11000,
+	                                                 fmRate,
+	                                                 audioRate);
 //
 //	In the case of mono we do not assume a pilot
 //	to be available. We borrow the approach from CuteSDR
@@ -181,8 +212,19 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 	stopScanning();
 	squelchValue		= 50;
 	old_squelchValue	= 0;
+	audioDepth		= 0;
+	old_audioDepth		= 0;
+	depthAverage		= 0;
+	depthIntegral		= 0;
+	rateCorrection		= 0;
+	crystalCount		= 0;
+	crystalResets		= 0;
+	old_crystalResets	= 0;
+	crystalSamples		= 0;
+	crystalSettled		= false;
+	dcValid			= true;
+	dcSum			= 0;
 
-	theConverter		= 0;
 	myCount			= 0;
 
 	setDeemphasis(50);
@@ -200,7 +242,9 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 	delete	pilotBandFilter;
 	delete	fm_Levels;
 	delete	mySinCos;
-	delete fmAudioFilter;
+	delete	fmAudioFilter;
+	delete	fmBandfilter;
+	delete	rdsLowPassFilter;
 
 	pthread_mutex_destroy (&this -> scanLock);
 }
@@ -255,16 +299,116 @@ void		fmProcessor::set_squelchValue	(int16_t n) {
 	squelchValue	= n;
 }
 
+void		fmProcessor::setAudioDepth	(int32_t frames) {
+	audioDepth	= frames;
+}
+
+DSPFLOAT	fmProcessor::get_rateCorrection	(void) {
+	return rateCorrection;
+}
+
 DSPFLOAT	fmProcessor::get_dcComponent	(void) {
 	if (running)
 	   return TheDemodulator	-> get_DcComponent ();
 	return 0.0;
 }
 
+//
+//	the demodulator exists from the start, so the decoder can
+//	be chosen (and named) before the processor runs
 const char  *fmProcessor::nameofDecoder	(void) {
-	if (running)
-	   return TheDemodulator -> nameofDecoder ();
-	return " ";
+	return TheDemodulator -> nameofDecoder ();
+}
+
+void	fmProcessor::getProfile	(stageProfile::snapshot *s) {
+	profile. get (s);
+}
+
+bool	fmProcessor::getTelemetry	(receptionTelemetry *t) {
+	return telemetry. read (t);
+}
+
+bool	fmProcessor::getCaptureMark	(captureMark *m) {
+	return captureMarks. read (m) && m -> position >= 0;
+}
+
+void	fmProcessor::resetCaptureMark	(void) {
+captureMark	m;
+
+	m. frame	= 0;
+	m. position	= -1;
+	captureMarks. write (&m);
+}
+
+bool	fmProcessor::getCrystalEstimate	(crystalEstimate *e) {
+	return crystalEstimates. read (e);
+}
+//
+//	taken up by the processor thread with the next block
+void	fmProcessor::resetCrystalEstimate	(void) {
+	__atomic_add_fetch (&crystalResets, 1, __ATOMIC_RELAXED);
+}
+void	fmProcessor::setRdsGroupCallback (RdsGroupCallback cb,
+	                                  void *userdata) {
+	rdsGroupUserdata	= userdata;
+	rdsGroupCallback	= cb;
+	myRdsDecoder	-> setGroupCallback (cb != NULL ? rdsGroup : NULL,
+	                                     this);
+}
+
+void	fmProcessor::setMpxQueue	(RingBuffer<mpxBlock> *q) {
+	__atomic_store_n (&mpxQueue, q, __ATOMIC_RELEASE);
+}
+//
+//	the multiplex goes out in blocks of at most MPX_BLOCK_SIZE
+//	samples, each with the position in the audio of its first one
+void	fmProcessor::putMpx	(RingBuffer<mpxBlock> *q,
+	                         const DSPFLOAT *v, int32_t n, int64_t frame) {
+void	*data1, *data2;
+int32_t	size1, size2;
+int32_t	done;
+
+	for (done = 0; done < n; done += MPX_BLOCK_SIZE) {
+	   if (q -> GetRingBufferWriteRegions (1, &data1, &size1,
+	                                          &data2, &size2) < 1)
+	      return;		// no reader keeping up
+	   mpxBlock *b	= static_cast<mpxBlock *>(data1);
+	   b -> frame	= frame + (int64_t)done * audioRate / fmRate;
+	   b -> count	= n - done < MPX_BLOCK_SIZE ? n - done : MPX_BLOCK_SIZE;
+	   memcpy (b -> samples, &v [done], b -> count * sizeof (float));
+	   q -> AdvanceRingBufferWriteIndex (1);
+	}
+}
+//
+//	the group is decoded after the audio of the block it ends in,
+//	so the frames written to the sink are its position in the audio
+void	fmProcessor::rdsGroup	(const uint16_t *blocks, void *userdata) {
+fmProcessor	*p	= static_cast<fmProcessor *>(userdata);
+
+	p -> rdsGroupCallback (blocks, p -> theSink -> framesWritten (),
+	                       p -> rdsGroupUserdata);
+}
+//
+//	called from the processor thread, that owns the levels and
+//	the rds decoder, the readers get a consistent copy
+void	fmProcessor::publishTelemetry	(bool stereoBlock) {
+receptionTelemetry	t;
+rdsDecoder::statistics	rds;
+
+	myRdsDecoder	-> getStatistics (&rds);
+	t. sequence		= ++ telemetryCount;
+	t. signalStrength	= fm_Levels -> getSignalStrength ();
+	t. pilotStrength	= fm_Levels -> getPilotStrength ();
+	t. rdsStrength		= fm_Levels -> getRdsStrength ();
+	t. noiseStrength	= fm_Levels -> getNoiseStrength ();
+	t. dcComponent		= TheDemodulator -> get_DcComponent ();
+	t. stereo		= stereoBlock;
+	t. rdsSynchronized	= rds. synchronized;
+	t. rdsBitErrorRate	= rds. bitErrorRate;
+	t. rdsSyncErrors	= rds. syncErrors;
+	t. rdsCrcErrors		= rds. crcErrors;
+	t. rdsGroups		= rds. groups;
+	telemetry. write (&t);
 }
 //
 void	fmProcessor::setfmMode (uint8_t m) {
@@ -272,8 +416,7 @@ void	fmProcessor::setfmMode (uint8_t m) {
 }
 
 void	fmProcessor::setFMdecoder (int8_t d) {
-	if (running)
-	   TheDemodulator	-> setDecoder (d);
+	TheDemodulator	-> setDecoder (d);
 }
 
 void	fmProcessor::setSoundMode (uint8_t selector) {
@@ -347,13 +490,13 @@ void	fmProcessor::unlockScan() {
 	pthread_mutex_unlock (&this -> scanLock);
 }
 
-bool	fmProcessor::checkStation(DSPCOMPLEX v) {
+bool	fmProcessor::checkStation(const sampleBlock *b) {
 	bool ret = false;
 	lockScan();
-	if (scanning) {
+	for (int32_t i = 0; scanning && i < b -> count; i ++) {
 	   ret = true;
 	   DSPCOMPLEX *scanBuffer = scan_fft -> getVector ();
-	   scanBuffer [scanPointer ++] = v;
+	   scanBuffer [scanPointer ++] = DSPCOMPLEX (b -> I [i], b -> Q [i]);
 	   if (scanPointer >= SCAN_BLOCK_SIZE) {
 	      scanPointer	= 0;
 	      scan_fft -> do_FFT ();
@@ -426,9 +569,14 @@ void	fmProcessor::finishScan() {
 
 void	fmProcessor::run (void) {
 DSPCOMPLEX	result;
-DSPFLOAT 	rdsData;
 int32_t		bufferSize	= 16384;
-DSPCOMPLEX	dataBuffer [bufferSize];
+sampleBlock	dataBlock (bufferSize);
+sampleBlock	fmBlock (bufferSize / decimatingScale + 1);
+DSPFLOAT	demodBuffer [bufferSize / decimatingScale + 1];
+DSPFLOAT	lrPlus	[bufferSize / decimatingScale + 1];
+DSPFLOAT	lrDiff	[bufferSize / decimatingScale + 1];
+DSPFLOAT	rdsData	[bufferSize / decimatingScale + 1];
+int32_t		fmSamples;
 int32_t		i;
 DSPCOMPLEX	out;
 DSPCOMPLEX	pcmSample;
@@ -438,6 +586,8 @@ float		audioGainAverage	= 0;
 bool		pilotExists;
 DSPCOMPLEX	pcmSamples [256];
 int16_t		audioIndex	= 0;
+int64_t		blockPosition;
+bool		stereoBefore	= false;
 
 	running	= true;		// will be set elsewhere
 
@@ -459,8 +609,10 @@ int16_t		audioIndex	= 0;
 	      old_squelchValue = squelchValue;
 	   }
 	
+	   blockPosition	= myRig -> capturePosition ();
 	   bufferSize = a =
-	            myRig -> getSamples (dataBuffer, bufferSize, inputMode);
+	            myRig -> getSamples (&dataBlock, bufferSize, inputMode);
+	   profile. begin ();
 
 	   //std::cerr << now() << " got " << bufferSize << " samples from dongle" << std::endl;
 
@@ -470,44 +622,83 @@ int16_t		audioIndex	= 0;
 //	We assume that if/when the pilot is no more than 3 db's above
 //	the noise around it, it is better to decode mono
 	   pilotExists	= fm_Levels -> getPilotStrength () > 3;
-	   for (i = 0; i < bufferSize; i ++) {
-	      DSPCOMPLEX v = dataBuffer [i];
-//		first step: decimating, filtering and attenuation
-	      if (!fmBandfilter -> Pass (v, &v))
-	         continue;
-
-	      v = v * DSPFLOAT (Gain);
+//
+//	first step: decimating, filtering and attenuation, the
+//	samples are processed as blocks of separate I and Q arrays
+	   fmSamples	= fmBandfilter -> Pass (&dataBlock, &fmBlock);
+	   fmBlock. scale (DSPFLOAT (Gain));
+	   profile. mark (stageProfile::DECIMATE);
 //	second step: if we are scanning, do the scan
-	      if (checkStation (v))
-		 v = 0;
+	   if (checkStation (&fmBlock)) {
+	      fmBlock. clear ();
+	      profile. mark (stageProfile::SCAN);
+	   }
 
 //	Now we have the signal ready for decoding
 //	keep track of the peaklevel, we take segments
-	      if (abs (v) > peakLevel)
-	         peakLevel = abs (v);
-	      if (++peakLevelcnt >= fmRate / 2) {
-	         DSPFLOAT	ratio	= 
-	                          max_freq_deviation / norm_freq_deviation;
-	         if (peakLevel > 0)
-	            this -> audioGain	= 
-	                  (ratio / peakLevel) / AUDIO_FREQ_DEV_PROPORTION;
-	         if (audioGain <= 0.1)
-	            audioGain = 0.1;
+	   DSPFLOAT blockPeak	= fmBlock. maxMagnitude ();
+	   if (blockPeak > peakLevel)
+	      peakLevel = blockPeak;
+	   peakLevelcnt	+= fmSamples;
+	   if (peakLevelcnt >= fmRate / 2) {
+	      DSPFLOAT	ratio	= 
+	                       max_freq_deviation / norm_freq_deviation;
+	      if (peakLevel > 0)
+	         this -> audioGain	= 
+	               (ratio / peakLevel) / AUDIO_FREQ_DEV_PROPORTION;
+	      if (audioGain <= 0.1)
+	         audioGain = 0.1;
+//	the first measurement starts the average, rather than a
+//	fade in from silence over several seconds
+	      if (audioGainAverage > 0)
 	         audioGain	= 0.8 * audioGainAverage + 0.2 * audioGain;
-	         audioGainAverage = audioGain;
-	         peakLevelcnt	= 0;
-	         peakLevel	= -100;
-	      }
+	      audioGainAverage = audioGain;
+	      peakLevelcnt	= 0;
+	      peakLevel	= -100;
+	   }
+//
+//	third step: the decimated samples are demodulated as a block
+	   TheDemodulator -> demodulate (&fmBlock, demodBuffer);
+	   profile. mark (stageProfile::DEMOD);
+//
+//	the multiplex, for a reader if there is one, positioned before
+//	the audio made from it
+	   RingBuffer<mpxBlock> *mpx =
+	                  __atomic_load_n (&mpxQueue, __ATOMIC_ACQUIRE);
+	   if (mpx != NULL)
+	      putMpx (mpx, demodBuffer, fmSamples,
+	              theSink -> framesWritten () + audioIndex);
+
+	   for (i = 0; i < fmSamples; i ++)
+	      fm_Levels -> addItem (demodBuffer [i]);
+	   profile. mark (stageProfile::LEVELS);
+//
+//	the rest is done in a loop per stage over the block, rather
+//	than all stages per sample, each stage keeps its own state, so
+//	the outcome is the same and each stage can be timed
+	   bool stereoBlock	= (fmModus == FM_STEREO) && pilotExists;
+	   for (i = 0; i < fmSamples; i ++)
+	      if (stereoBlock)
+	         stereo (demodBuffer [i], &lrPlus [i], &lrDiff [i], &rdsData [i]);
+	      else
+	         mono (demodBuffer [i], &lrPlus [i], &rdsData [i]);
+	   profile. mark (stageProfile::MULTIPLEX);
+	   trackCrystal (fmSamples, stereoBlock);
+//
+//	the mono blocks leave the L - R line of the audio filter as the
+//	last stereo block had it, it starts from silence again
+	   if (stereoBlock && !stereoBefore)
+	      fmAudioFilter -> clearQ ();
+	   stereoBefore	= stereoBlock;
 
-	      if ((fmModus == FM_STEREO) && pilotExists) {
-	         stereo (&v, &result, &rdsData);
-	         result = audioGainCorrection (result);
-	         result = fmAudioFilter -> Pass (result);
+	   for (i = 0; i < fmSamples; i ++) {
 //
-//	for reasons of efficiency, we decimate inline
-	         static int a_cnt = 0;
-	         if (++a_cnt >= fmRate / audioRate) {
-	            a_cnt = 0;
+//	the audio is real valued from here, fmAudioFilter resamples
+//	it to the audiorate and the gain is applied on its output
+	      if (stereoBlock) {
+	         if (fmAudioFilter -> Pass (DSPCOMPLEX (lrPlus [i], lrDiff [i]),
+	                                                        &result)) {
+	            result = audioGainCorrection (result);
 	            if (squelchOn)
 	               result = mySquelch. do_squelch (result);
 	            switch (selector) {
@@ -543,13 +734,11 @@ int16_t		audioIndex	= 0;
 	         }
 	      }
 	      else {
-	         mono (&v, &result, &rdsData);
-	         result = audioGainCorrection (result);
-	         result = fmAudioFilter -> Pass (result);
-
-	         static int b_cnt = 0;
-	         if (++b_cnt >= fmRate / audioRate) {
-	            b_cnt = 0;
+//	in mono, left and right are the same, so we filter only once
+	         DSPFLOAT	lrFiltered;
+	         if (fmAudioFilter -> Pass (lrPlus [i], &lrFiltered)) {
+	            result = audioGainCorrection (DSPCOMPLEX (lrFiltered,
+	                                                      lrFiltered));
 	            if (squelchOn)
 	               result = mySquelch. do_squelch (result);
 	            pcmSamples [audioIndex ++] = result;
@@ -559,29 +748,127 @@ int16_t		audioIndex	= 0;
 	            }
 	         }
 	      }
-	      if ((rdsModus != rdsDecoder::NO_RDS)) {
-	         DSPFLOAT mag;
-	         if (rdsLowPassFilter -> Pass (rdsData, &rdsData)) 
-	            myRdsDecoder -> doDecode (rdsData, &mag,
+	   }
+	   profile. mark (stageProfile::AUDIO);
+//
+//	the audio made so far goes with the input up to the end of
+//	the block, the delay of the filters apart
+	   if (blockPosition >= 0) {
+	      captureMark	m;
+	      m. frame		= theSink -> framesWritten () + audioIndex;
+	      m. position	= blockPosition + a;
+	      captureMarks. write (&m);
+	   }
+
+	   if ((rdsModus != rdsDecoder::NO_RDS)) {
+	      for (i = 0; i < fmSamples; i ++) {
+	         DSPFLOAT mag, rdsValue;
+	         if (rdsLowPassFilter -> Pass (rdsData [i], &rdsValue)) 
+	            myRdsDecoder -> doDecode (rdsValue, &mag,
 	                                      (rdsDecoder::RdsMode)rdsModus);
 	      }
-
+	      profile. mark (stageProfile::RDS);
 	   }
+	   if (audioDepth != old_audioDepth || audioDepth > 0)
+	      followDepth (a);
+//
+//	the telemetry is taken in sample time, so a recording played
+//	faster than real time gives as many records per second of it
+	   telemetrySamples	+= fmSamples;
+	   if (telemetrySamples >= fmRate / TELEMETRY_RATE) {
+	      telemetrySamples -= fmRate / TELEMETRY_RATE;
+	      publishTelemetry (stereoBlock);
+	   }
+	   profile. end (a);
 	}
 }
 
-void	fmProcessor::mono (DSPCOMPLEX	*in,
-	                   DSPCOMPLEX	*audioOut,
+//
+//	The reader of the sink takes the audio at the rate of its own
+//	clock, the dongle gives it at the rate of its crystal, and the
+//	frames waiting in between drift by the difference. A PI loop
+//	on the depth, in seconds, trims the rate of the audio filter so
+//	they stay at audioDepth, and the integral ends up at the drift
+void	fmProcessor::followDepth	(int32_t samples) {
+DSPFLOAT	T	= (DSPFLOAT)samples / inputRate;
+DSPFLOAT	weight	= T < DEPTH_AVERAGING ? T / DEPTH_AVERAGING : 1;
+DSPFLOAT	error;
+
+	if (audioDepth != old_audioDepth) {
+	   old_audioDepth	= audioDepth;
+	   depthAverage		= theSink -> waiting ();
+	   depthIntegral	= 0;
+	   rateCorrection	= 0;
+	   fmAudioFilter	-> setRateCorrection (0);
+	   if (audioDepth <= 0)
+	      return;
+	}
+
+	depthAverage	+= (theSink -> waiting () - depthAverage) * weight;
+	error		= (depthAverage - audioDepth) / audioRate;
+	depthIntegral	+= error * T;
+	if (depthIntegral > MAX_RATE_CORRECTION / DEPTH_KI)
+	   depthIntegral = MAX_RATE_CORRECTION / DEPTH_KI;
+	if (depthIntegral < - MAX_RATE_CORRECTION / DEPTH_KI)
+	   depthIntegral = - MAX_RATE_CORRECTION / DEPTH_KI;
+//	too deep, fewer frames
+	rateCorrection	= - (DEPTH_KP * error + DEPTH_KI * depthIntegral);
+	if (rateCorrection > MAX_RATE_CORRECTION)
+	   rateCorrection = MAX_RATE_CORRECTION;
+	if (rateCorrection < - MAX_RATE_CORRECTION)
+	   rateCorrection = - MAX_RATE_CORRECTION;
+	fmAudioFilter	-> setRateCorrection (rateCorrection);
+}
+//
+//	The crystal of the input is off by the same ppm in the tuning
+//	and in the sampling: the carrier ends up off, the dc component
+//	of the demodulated signal, and the pilot comes out off 19 KHz.
+//	Both are averaged over a window in which the pilot stays locked,
+//	anything else (a mono block, a lost lock, a reset) starts it over.
+//	The first window after that goes, the pll is still settling
+void	fmProcessor::trackCrystal	(int32_t samples, bool stereoBlock) {
+int32_t		resets	= __atomic_load_n (&crystalResets, __ATOMIC_RELAXED);
+crystalEstimate	e;
+DSPFLOAT	dc;
+
+	if (resets != old_crystalResets || !stereoBlock ||
+	                              !pilotRecover -> isLocked ()) {
+	   old_crystalResets	= resets;
+	   crystalSamples	= 0;
+	   crystalSettled	= false;
+	   dcValid		= true;
+	   dcSum		= 0;
+	   pilotRecover		-> getOffset (&e. pilotOffset);
+	   return;
+	}
+
+	if (TheDemodulator -> get_DcFrequency (&dc))
+	   dcSum	+= dc * samples;
+	else
+	   dcValid	= false;
+	crystalSamples	+= samples;
+	if (crystalSamples < CRYSTAL_WINDOW * fmRate)
+	   return;
+
+	e. carrier	= dcValid;
+	e. dcOffset	= dcValid ? dcSum / crystalSamples : 0;
+	if (pilotRecover -> getOffset (&e. pilotOffset) && crystalSettled) {
+	   e. sequence	= ++ crystalCount;
+	   crystalEstimates. write (&e);
+	}
+	crystalSettled	= true;
+	crystalSamples	= 0;
+	dcValid		= true;
+	dcSum		= 0;
+}
+
+void	fmProcessor::mono (DSPFLOAT	demod,
+	                   DSPFLOAT	*audioOut,
 	                   DSPFLOAT	*rdsValue) {
-DSPFLOAT	Re, Im;
 DSPCOMPLEX	rdsBase;
-DSPFLOAT	demod	= TheDemodulator	-> demodulate (*in);
 
-	fm_Levels	-> addItem (demod);
 //	deemphasize
-	Re	= xkm1 = (demod - xkm1) * alpha + xkm1;
-	Im	= ykm1 = (demod - ykm1) * alpha + ykm1;
-	*audioOut	= DSPCOMPLEX (Re, Im);
+	*audioOut	= xkm1 = (demod - xkm1) * alpha + xkm1;
 
 	
 	if ((rdsModus != rdsDecoder::NO_RDS)) {
@@ -597,20 +884,18 @@ DSPFLOAT	demod	= TheDemodulator	-> demodulate (*in);
 	}
 }
 
-void	fmProcessor::stereo (DSPCOMPLEX	*in,
-	                     DSPCOMPLEX	*audioOut,
+void	fmProcessor::stereo (DSPFLOAT	demod,
+	                     DSPFLOAT	*lrPlusOut,
+	                     DSPFLOAT	*lrDiffOut,
 	                     DSPFLOAT	*rdsValue) {
 
 DSPFLOAT	LRPlus	= 0;
 DSPFLOAT	LRDiff	= 0;
 DSPFLOAT	pilot	= 0;
-DSPFLOAT	currentPilotPhase;
-DSPFLOAT	PhaseforLRDiff	= 0;
-DSPFLOAT	PhaseforRds	= 0;
-/*
- */
-	DSPFLOAT demod	= TheDemodulator  -> demodulate (*in);
-	fm_Levels	-> addItem (demod);
+DSPPHASE	currentPilotPhase;
+DSPPHASE	PhaseforLRDiff	= 0;
+DSPPHASE	PhaseforRds	= 0;
+
 	LRPlus = LRDiff = pilot	= demod;
 /*
  *	get the phase for the "carrier to be inserted" right
@@ -619,6 +904,7 @@ DSPFLOAT	PhaseforRds	= 0;
 	currentPilotPhase = pilotRecover -> getPilotPhase (5 * pilot);
 /*
  *	Now we have the right - i.e. synchronized - signal to work with
+ *	(phases are fractions of a turn, the multiplications wrap)
  */
 	PhaseforLRDiff	= 2 * (currentPilotPhase + pilotDelay);
 	PhaseforRds	= 3 * (currentPilotPhase + pilotDelay);
@@ -633,9 +919,8 @@ DSPFLOAT	PhaseforRds	= 0;
 	}
 
 //	apply deemphasis
-	LRPlus		= xkm1	= (LRPlus - xkm1) * alpha + xkm1;
-	LRDiff		= ykm1	= (LRDiff - ykm1) * alpha + ykm1;
-        *audioOut		= DSPCOMPLEX (LRPlus, LRDiff);
+	*lrPlusOut	= xkm1	= (LRPlus - xkm1) * alpha + xkm1;
+	*lrDiffOut	= ykm1	= (LRDiff - ykm1) * alpha + ykm1;
 }
 
 void	fmProcessor::setLFcutoff (int32_t Hz) {
@@ -644,7 +929,8 @@ void	fmProcessor::setLFcutoff (int32_t Hz) {
 	   delete	fmAudioFilter;
 	fmAudioFilter	= NULL;
 	if (Hz > 0)
-	   fmAudioFilter	= new LowPassFIR (11, Hz, fmRate);
+	   fmAudioFilter	= new ResamplingRealFIR (11, Hz, fmRate,
+	                                                 audioRate);
 }
 
 bool	fmProcessor::isLocked (void) {
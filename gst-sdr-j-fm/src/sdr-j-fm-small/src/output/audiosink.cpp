@@ -42,6 +42,10 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 	pthread_mutex_init (&lock, NULL);
 	pthread_cond_init (&sig, NULL);
 	cancelled		= false;
+	droppedCount		= 0;
+	underrunCount		= 0;
+	writtenCount		= 0;
+	readCount		= 0;
 }
 
 	audioSink::~audioSink	(void) {
@@ -63,6 +67,26 @@ int32_t	audioSink::capacity	(void) {
 int32_t	audioSink::waiting	(void) {
 	return _O_Buffer -> GetRingBufferReadAvailable () / 2;
 }
+int32_t	audioSink::bufferSize	(void) {
+	return (_O_Buffer -> GetRingBufferReadAvailable () +
+	        _O_Buffer -> GetRingBufferWriteAvailable ()) / 2;
+}
+
+int64_t	audioSink::framesDropped	(void) {
+	return __atomic_load_n (&droppedCount, __ATOMIC_RELAXED);
+}
+
+int64_t	audioSink::framesWritten	(void) {
+	return __atomic_load_n (&writtenCount, __ATOMIC_RELAXED);
+}
+
+int64_t	audioSink::framesRead	(void) {
+	return __atomic_load_n (&readCount, __ATOMIC_RELAXED);
+}
+
+int64_t	audioSink::underruns	(void) {
+	return __atomic_load_n (&underrunCount, __ATOMIC_RELAXED);
+}
 //
 //	putSample output comes from the FM receiver
 int32_t	audioSink::putSample	(DSPCOMPLEX v) {
@@ -74,8 +98,11 @@ float	*buffer = (float *)alloca (2 * n * sizeof (float));
 int32_t	i;
 int32_t	available = _O_Buffer -> GetRingBufferWriteAvailable ();
 
-	if (2 * n > available)
+	if (2 * n > available) {
+	   __atomic_add_fetch (&droppedCount,
+	                       n - ((available / 2) & ~01), __ATOMIC_RELAXED);
 	   n = (available / 2) & ~01;
+	}
 	for (i = 0; i < n; i ++) {
 	   buffer [2 * i] = real (V [i]);
 	   buffer [2 * i + 1] = imag (V [i]);
@@ -89,6 +116,7 @@ int32_t	available = _O_Buffer -> GetRingBufferWriteAvailable ();
 	
 
 	_O_Buffer	-> putDataIntoBuffer (buffer, 2 * n);
+	__atomic_add_fetch (&writtenCount, n, __ATOMIC_RELAXED);
 	signal ();
 	return n;
 }
@@ -102,6 +130,7 @@ int32_t available = _O_Buffer -> GetRingBufferReadAvailable ();
 
 	if (available < 1) {
 		GST_TRACE("No samples in SDR-J RingBuffer, waiting");
+		__atomic_add_fetch (&underrunCount, 1, __ATOMIC_RELAXED);
 		int err = wait ();
 
 		if (err == -1) {
@@ -113,7 +142,9 @@ int32_t available = _O_Buffer -> GetRingBufferReadAvailable ();
 		}
 	}
 
-	return _O_Buffer -> getDataFromBuffer (data, count);
+	available	= _O_Buffer -> getDataFromBuffer (data, count);
+	__atomic_add_fetch (&readCount, available / 2, __ATOMIC_RELAXED);
+	return available;
 }
 
 void	audioSink::cancelGet (void) {
@@ -123,6 +154,11 @@ void	audioSink::cancelGet (void) {
 }
 
 void	audioSink::flush (void) {
+//	the frames thrown away will never be read, the next frame
+//	written is the next one read
+	__atomic_sub_fetch (&writtenCount,
+	                    _O_Buffer -> GetRingBufferReadAvailable () / 2,
+	                    __ATOMIC_RELAXED);
 	_O_Buffer -> FlushRingBuffer ();
 	GST_DEBUG("SDR-J RingBuffer flushed");
 }
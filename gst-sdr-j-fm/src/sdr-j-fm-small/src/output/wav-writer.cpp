@@ -0,0 +1,205 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"wav-writer.h"
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<stdio.h>
+#include	<string.h>
+#include	<errno.h>
+
+#define	WAVE_FORMAT_PCM		1
+#define	WAVE_FORMAT_IEEE_FLOAT	3
+//
+//	the samples are converted in chunks of this many floats
+#define	CHUNK	4096
+
+//
+//	WAV is little endian, the header is written byte by byte,
+//	the samples are written as they are in memory (so this assumes
+//	a little endian machine)
+static
+void	put16 (uint8_t *p, uint16_t v) {
+	p [0]	= v & 0xFF;
+	p [1]	= v >> 8;
+}
+
+static
+void	put32 (uint8_t *p, uint32_t v) {
+	put16 (p, v & 0xFFFF);
+	put16 (p + 2, v >> 16);
+}
+
+	wavWriter::wavWriter (const std::string &fileName,
+	                      int32_t rate,
+	                      int16_t channels,
+	                      bool floatSamples,
+	                      bool *success) {
+	this	-> rate		= rate;
+	this	-> channels	= channels;
+	this	-> floatSamples	= floatSamples;
+	this	-> sampleBytes	= floatSamples ? 4 : 2;
+//	for float samples there is the extended fmt and a fact chunk
+	this	-> headerSize	= floatSamples ? 58 : 44;
+	this	-> frames	= 0;
+	this	-> failed	= false;
+	pthread_mutex_init (&lock, NULL);
+
+	fd	= open (fileName. c_str (), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0) {
+	   fprintf (stderr, "Could not create %s: %s\n",
+	                     fileName. c_str (), strerror (errno));
+	   *success	= false;
+	   return;
+	}
+	*success	= writeHeader ();
+}
+
+	wavWriter::~wavWriter (void) {
+	if (fd >= 0) {
+//	now the lengths are known
+	   writeHeader ();
+	   close (fd);
+	}
+	pthread_mutex_destroy (&lock);
+}
+//
+//	For float samples the fmt chunk is the extended one (with
+//	an empty extension) and a fact chunk with the number of
+//	frames is required, for PCM the plain fmt chunk will do.
+bool	wavWriter::writeHeader (void) {
+uint8_t	header [58];
+int32_t	fmtSize		= floatSamples ? 18 : 16;
+int32_t	dataSize	= frames * channels * sampleBytes;
+int32_t	p		= 12;
+
+	memcpy (&header [0], "RIFF", 4);
+	put32 (&header [4], headerSize - 8 + dataSize);
+	memcpy (&header [8], "WAVE", 4);
+	memcpy (&header [p], "fmt ", 4);
+	put32 (&header [p + 4], fmtSize);
+	put16 (&header [p + 8], floatSamples ? WAVE_FORMAT_IEEE_FLOAT :
+	                                       WAVE_FORMAT_PCM);
+	put16 (&header [p + 10], channels);
+	put32 (&header [p + 12], rate);
+	put32 (&header [p + 16], rate * channels * sampleBytes);
+	put16 (&header [p + 20], channels * sampleBytes);
+	put16 (&header [p + 22], 8 * sampleBytes);
+	if (floatSamples)
+	   put16 (&header [p + 24], 0);
+	p	+= 8 + fmtSize;
+	if (floatSamples) {
+	   memcpy (&header [p], "fact", 4);
+	   put32 (&header [p + 4], 4);
+	   put32 (&header [p + 8], frames);
+	   p	+= 12;
+	}
+	memcpy (&header [p], "data", 4);
+	put32 (&header [p + 4], dataSize);
+
+	return pwrite (fd, header, headerSize, 0) == headerSize;
+}
+
+bool	wavWriter::write (const float *samples, int32_t n) {
+int64_t	frame;
+
+	pthread_mutex_lock (&lock);
+	frame	= frames;
+	pthread_mutex_unlock (&lock);
+	return writeAt (frame, samples, n);
+}
+//
+//	the parts written may be in any order, the length of the
+//	file is up to the last frame written
+bool	wavWriter::writeAt (int64_t frame, const float *samples, int32_t n) {
+int16_t	pcm [CHUNK];
+int32_t	count	= n * channels;
+off_t	offset	= headerSize + frame * channels * sampleBytes;
+bool	ok	= true;
+int32_t	i, j;
+
+	if (failed)
+	   return false;
+
+	for (i = 0; ok && i < count; i += CHUNK) {
+	   int32_t	amount	= count - i < CHUNK ? count - i : CHUNK;
+	   const void	*out	= &samples [i];
+	   if (!floatSamples) {
+	      for (j = 0; j < amount; j ++) {
+	         float v	= samples [i + j] * 32767;
+	         pcm [j]	= v >= 32767 ? 32767 :
+	                          v <= -32768 ? -32768 : (int16_t) lrintf (v);
+	      }
+	      out	= pcm;
+	   }
+	   ok	= pwrite (fd, out, amount * sampleBytes,
+	                  offset + (off_t)i * sampleBytes) ==
+	                                       amount * sampleBytes;
+	}
+
+	pthread_mutex_lock (&lock);
+	if (!ok && !failed) {
+	   fprintf (stderr, "Writing audio failed: %s\n", strerror (errno));
+	   failed	= true;
+	}
+	if (ok && frame + n > frames)
+	   frames	= frame + n;
+	pthread_mutex_unlock (&lock);
+	return ok;
+}
+//
+//	returns the number of frames read, as floats whatever the
+//	format of the file is
+int32_t	wavWriter::readAt (int64_t frame, float *samples, int32_t n) {
+int16_t	pcm [CHUNK];
+off_t	offset	= headerSize + frame * channels * sampleBytes;
+int32_t	count;
+int32_t	i, j;
+
+	pthread_mutex_lock (&lock);
+	if (frame + n > frames)
+	   n	= frame < frames ? frames - frame : 0;
+	pthread_mutex_unlock (&lock);
+	count	= n * channels;
+
+	for (i = 0; i < count; i += CHUNK) {
+	   int32_t	amount	= count - i < CHUNK ? count - i : CHUNK;
+	   void		*in	= floatSamples ? (void *)&samples [i] :
+	                                         (void *)pcm;
+	   if (pread (fd, in, amount * sampleBytes,
+	              offset + (off_t)i * sampleBytes) != amount * sampleBytes)
+	      return i / channels;
+	   if (!floatSamples)
+	      for (j = 0; j < amount; j ++)
+	         samples [i + j] = pcm [j] / 32767.0;
+	}
+	return n;
+}
+
+int64_t	wavWriter::framesWritten (void) {
+int64_t	n;
+
+	pthread_mutex_lock (&lock);
+	n	= frames;
+	pthread_mutex_unlock (&lock);
+	return n;
+}
@@ -114,6 +114,10 @@ DSPFLOAT	rdsBlockSynchronizer::getBitErrorRate	(void) {
 	return rdsbitErrorRate;
 }
 
+bool	rdsBlockSynchronizer::isSynchronized	(void) {
+	return rdsIsSynchronized;
+}
+
 void	rdsBlockSynchronizer::resync	(void) {
 	rdsCurrentBlock		= RDSGroup::BLOCK_A;
 	rdsIsSynchronized	= false;
@@ -36,6 +36,13 @@ GST_DEBUG_CATEGORY_EXTERN (sdrjfm_debug);
 #define GST_CAT_DEFAULT sdrjfm_debug
 
 const DSPFLOAT	RDS_BITCLK_HZ =	1187.5;
+//
+//	the bit clock (of the second decoder) is synchronized on the
+//	last SYNC_SYMBOLS symbols, trying SYNC_PHASES phases. When no
+//	group was complete for RESYNC_BITS bits, it is done again
+#define	SYNC_SYMBOLS	16
+#define	SYNC_PHASES	16
+#define	RESYNC_BITS	(4 * 104)
 /*
  *	RDS is a bpsk-like signal, with a baudrate 1187.5
  *	on a carrier of  3 * 19 k.
@@ -62,15 +69,23 @@ int16_t	length;
 	this	-> MyRadioInterface	= myRadio;
 	this	-> sampleRate	= rate;
 	this	-> mySinCos	= mySinCos;
-	omegaRDS		= (2 * M_PI * RDS_BITCLK_HZ) / (DSPFLOAT)rate;
+	omegaRDS		= toPhase ((2 * M_PI * RDS_BITCLK_HZ) / rate);
 //
 //	for the decoder a la FMStack we need:
 	synchronizerSamples	= sampleRate / (DSPFLOAT)RDS_BITCLK_HZ;
 	symbolCeiling		= ceil (synchronizerSamples);
 	symbolFloor		= floor (synchronizerSamples);
-	syncBuffer		= new DSPFLOAT [symbolCeiling];
-	memset (syncBuffer, 0, symbolCeiling * sizeof (DSPFLOAT));
+	syncLength		= SYNC_SYMBOLS * symbolCeiling;
+	syncBuffer		= new DSPFLOAT [syncLength];
+	memset (syncBuffer, 0, syncLength * sizeof (DSPFLOAT));
 	p			= 0;
+	syncFill		= 0;
+	bitsWithoutGroup	= 0;
+	syncErrors		= 0;
+	crcErrors		= 0;
+	groups			= 0;
+	groupCallback		= NULL;
+	groupUserData		= NULL;
 	bitIntegrator		= 0;
 	bitClkPhase		= 0;
 	prev_clkState		= 0;
@@ -143,6 +158,24 @@ int16_t	length;
 
 void	rdsDecoder::reset	(void) {
 	my_rdsGroupDecoder	-> reset ();
+	syncErrors	= 0;
+	crcErrors	= 0;
+	groups		= 0;
+}
+//
+//	the counters of the block synchronizer are reset to trigger a
+//	resync, so the errors are counted here as well
+void	rdsDecoder::getStatistics	(statistics *s) {
+	s -> synchronized	= my_rdsBlockSync -> isSynchronized ();
+	s -> bitErrorRate	= my_rdsBlockSync -> getBitErrorRate ();
+	s -> syncErrors		= syncErrors;
+	s -> crcErrors		= crcErrors;
+	s -> groups		= groups;
+}
+
+void	rdsDecoder::setGroupCallback	(GroupCallback cb, void *userdata) {
+	groupUserData	= userdata;
+	groupCallback	= cb;
 }
 
 DSPFLOAT	rdsDecoder::Match	(DSPFLOAT v) {
@@ -202,15 +235,20 @@ DSPFLOAT clkState;
 
 	syncBuffer [p]	= v;
 	*mag		= syncBuffer [p] + 1;
-	p		= (p + 1) % symbolCeiling;
-	v		= syncBuffer [p];	// an old one
-
-	if (Resync ||
-	   (my_rdsBlockSync -> getNumSyncErrors () > 3)) {
+	p		= (p + 1) % syncLength;
+	v		= syncBuffer [p];	// the oldest one
+	if (syncFill < syncLength)
+	   syncFill ++;
+//
+//	the first synchronization waits for a buffer full of signal
+	if ((Resync && syncFill >= syncLength) ||
+	   (my_rdsBlockSync -> getNumSyncErrors () > 3) ||
+	   (bitsWithoutGroup > RESYNC_BITS)) {
 	   synchronizeOnBitClk (syncBuffer, p);
 	   my_rdsBlockSync -> resync ();
 	   my_rdsBlockSync -> resetResyncErrorCounter ();
 	   Resync = false;
+	   bitsWithoutGroup	= 0;
 	}
 
 	clkState	= mySinCos -> getSin (bitClkPhase);
@@ -225,10 +263,11 @@ DSPFLOAT clkState;
 	}
 
 	prev_clkState	= clkState;
-	bitClkPhase	= fmod (bitClkPhase + omegaRDS, 2 * M_PI);
+	bitClkPhase	+= omegaRDS;	// fixed point, wraps by itself
 }
 
 void	rdsDecoder::processBit (bool bit) {
+	bitsWithoutGroup ++;
 	switch (my_rdsBlockSync -> pushBit (bit, my_rdsGroup)) {
 	   case rdsBlockSynchronizer::RDS_WAITING_FOR_BLOCK_A:
 	      break;		// still waiting in block A
@@ -238,63 +277,70 @@ void	rdsDecoder::processBit (bool bit) {
 
 	   case rdsBlockSynchronizer::RDS_NO_SYNC:
 //	      resync if the last sync failed
-		   // FIXME: Signals needed
-		   //setSyncErrors (my_rdsBlockSync -> getNumSyncErrors ());
-		   //GST_DEBUG("RDS sync error count: %d",
-		   //my_rdsBlockSync -> getNumSyncErrors ());
+	      syncErrors ++;
 	      my_rdsBlockSync -> resync ();
 	      break;
 
 	   case rdsBlockSynchronizer::RDS_NO_CRC:
-		   // FIXME: Signals needed
-		   //setCRCErrors (my_rdsBlockSync -> getNumCRCErrors ());
+	      crcErrors ++;
 	      my_rdsBlockSync -> resync ();
 	      break;
 
 	   case rdsBlockSynchronizer::RDS_COMPLETE_GROUP:
+	      bitsWithoutGroup	= 0;
+	      groups ++;
 	      if (!my_rdsGroupDecoder -> decode (my_rdsGroup)) {
 	          ;	// error decoding the rds group
 	      }
+//	the raw group goes out after the decoder has handled it, so
+//	the labels are up to date with it
+	      if (groupCallback != NULL) {
+	         uint16_t blocks [RDSGroup::NUM_BLOCKS_PER_RDSGROUP];
+	         for (int16_t b = 0; b < RDSGroup::NUM_BLOCKS_PER_RDSGROUP; b ++)
+	            blocks [b] = my_rdsGroup -> getBlock ((RDSGroup::RdsBlock)b);
+	         groupCallback (blocks, groupUserData);
+	      }
 
 	      my_rdsGroup -> clear ();
 	      break;
 	}
 }
 
+//
+//	The bits are integrated over a period of the clock, from one
+//	rising edge to the next. With the clock in phase with the
+//	symbols, the magnitudes of the integrals are largest, so we try
+//	a number of phases on the samples in the buffer (the oldest one,
+//	at "first", is the next to be handled) and take the best one
 void	rdsDecoder::synchronizeOnBitClk (DSPFLOAT *v, int16_t first) {
-bool	isHigh	= false;
-int32_t	k = 0;
-int32_t	i;
-DSPFLOAT	phase;
-DSPFLOAT *correlationVector =
-	(DSPFLOAT *)alloca (symbolCeiling * sizeof (DSPFLOAT));
-
-	memset (correlationVector, 0, symbolCeiling * sizeof (DSPFLOAT));
-
-//	synchronizerSamples	= sampleRate / (DSPFLOAT)RDS_BITCLK_HZ;
-	for (i = 0; i < symbolCeiling; i ++) {
-	   phase = fmod (i * (omegaRDS / 2), 2 * M_PI);
-//	reset index on phase change
-	   if (mySinCos -> getSin (phase) > 0 && !isHigh) {
-	      isHigh = true;
-	      k = 0;
+DSPPHASE	bestPhase	= 0;
+DSPFLOAT	best		= -1;
+int16_t		k;
+int32_t		i;
+
+	for (k = 0; k < SYNC_PHASES; k ++) {
+	   DSPPHASE	start	= (DSPPHASE)(k * (PHASE_TURN / SYNC_PHASES));
+	   DSPPHASE	phase	= start;
+	   DSPFLOAT	previous	= mySinCos -> getSin (phase - omegaRDS);
+	   DSPFLOAT	integrator	= 0;
+	   DSPFLOAT	metric		= 0;
+	   for (i = 0; i < syncLength; i ++) {
+	      DSPFLOAT clk	= mySinCos -> getSin (phase);
+	      integrator	+= v [(first + i) % syncLength] * clk;
+	      if (previous <= 0 && clk > 0) {
+	         metric		+= fabs (integrator);
+	         integrator	= 0;
+	      }
+	      previous	= clk;
+	      phase	+= omegaRDS;
 	   }
-	   else
-	   if (mySinCos -> getSin (phase) < 0 && isHigh) {
-	      isHigh = false;
-	      k = 0;
+	   if (metric > best) {
+	      best	= metric;
+	      bestPhase	= start;
 	   }
-
-	   correlationVector [k ++] += v [(first + i) % symbolCeiling];
 	}
 
-//	detect rising edge in correlation window
-	int32_t iMin	= 0;
-	while (iMin < symbolFloor && correlationVector [iMin ++] > 0);
-	while (iMin < symbolFloor && correlationVector [iMin ++] < 0);
-
-//	set the phase, previous sample (iMin - 1) is obviously the one
-	bitClkPhase = fmod (-omegaRDS * (iMin - 1), 2 * M_PI);
-	while (bitClkPhase < 0) bitClkPhase += 2 * M_PI;
+	bitClkPhase	= bestPhase;
+	prev_clkState	= mySinCos -> getSin (bestPhase - omegaRDS);
+	bitIntegrator	= 0;
 }
-
@@ -0,0 +1,154 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include	"rds-encoder.h"
+#include	<string.h>
+#include	<time.h>
+
+//	x^10 + x^8 + x^7 + x^5 + x^4 + x^3 + 1, as in the synchronizer
+#define	CRC_POLY	0x5B9
+#define	BITS_PER_BLOCK	26
+//
+//	offset words for the blocks A, B, C and D (we only send
+//	type A groups, so C' is never needed)
+static
+const uint32_t offsetWords [] = {0xFC, 0x198, 0x168, 0x1B4};
+
+	rdsEncoder::rdsEncoder (uint16_t pi, uint8_t pty,
+	                        const std::string &label,
+	                        const std::string &text,
+	                        bool clockTime) {
+size_t	l;
+
+	this	-> piCode	= pi;
+	this	-> ptyCode	= pty & 037;
+	this	-> clockTime	= clockTime;
+
+	memset (stationLabel, ' ', sizeof (stationLabel));
+	l	= label. size () < 8 ? label. size () : 8;
+	memcpy (stationLabel, label. c_str (), l);
+//
+//	a text shorter than 64 characters is ended by a carriage return,
+//	only the segments up to and including that one are sent
+	memset (radioText, ' ', sizeof (radioText));
+	l	= text. size () < 64 ? text. size () : 64;
+	memcpy (radioText, text. c_str (), l);
+	if (l == 0)
+	   textSegments	= 0;
+	else
+	if (l < 64) {
+	   radioText [l]	= '\r';
+	   textSegments	= l / 4 + 1;
+	}
+	else
+	   textSegments	= 16;
+
+	groupCount	= 0;
+	labelSegment	= 0;
+	textSegment	= 0;
+	previousBit	= false;
+	nextGroup ();
+}
+
+	rdsEncoder::~rdsEncoder	(void) {
+}
+
+int32_t	rdsEncoder::groupsSent	(void) {
+	return groupCount;
+}
+//
+//	the checkword is the remainder of the payload (times x^10)
+//	after division by the generator polynomial, with the offset
+//	word of the block added
+uint32_t	rdsEncoder::checkWord	(uint16_t data, uint32_t offset) {
+uint32_t	reg	= (uint32_t)data << 10;
+int16_t		k;
+
+	for (k = BITS_PER_BLOCK - 1; k >= 10; k --)
+	   if (reg & (1 << k))
+	      reg ^= CRC_POLY << (k - 10);
+
+	return (reg & 0x3FF) ^ offset;
+}
+
+void	rdsEncoder::setBlock	(RDSGroup::RdsBlock b, uint16_t data) {
+	blocks [b]	= ((uint32_t)data << 10) | checkWord (data, offsetWords [b]);
+}
+//
+//	Label and text groups alternate, with a clock time group
+//	every 32 groups
+void	rdsEncoder::nextGroup	(void) {
+uint16_t	typeBits;
+
+	setBlock (RDSGroup::BLOCK_A, piCode);
+	typeBits	= ptyCode << 5;
+
+	if (clockTime && groupCount % 32 == 31) {
+	   time_t now	= time (NULL);
+	   struct tm t;
+	   gmtime_r (&now, &t);
+	   uint32_t mjd	= 40587 + now / 86400;
+	   setBlock (RDSGroup::BLOCK_B,
+	             (RDSGroup::CLOCKTIME_AND_DATE << 12) |
+	                       typeBits | ((mjd >> 15) & 03));
+	   setBlock (RDSGroup::BLOCK_C,
+	             ((mjd & 0x7FFF) << 1) | (t. tm_hour >> 4));
+	   setBlock (RDSGroup::BLOCK_D,
+	             ((t. tm_hour & 0xF) << 12) | (t. tm_min << 6));
+	}
+	else
+	if (textSegments == 0 || (groupCount & 01) == 0) {
+	   setBlock (RDSGroup::BLOCK_B,
+	             (RDSGroup::BASIC_TUNING_AND_SWITCHING << 12) |
+	                       typeBits | labelSegment);
+	   setBlock (RDSGroup::BLOCK_C, 0xE0CD);	// no alternative frequencies
+	   setBlock (RDSGroup::BLOCK_D,
+	             ((uint8_t)stationLabel [2 * labelSegment] << 8) |
+	              (uint8_t)stationLabel [2 * labelSegment + 1]);
+	   labelSegment	= (labelSegment + 1) & 03;
+	}
+	else {
+	   const uint8_t *p = (const uint8_t *)&radioText [4 * textSegment];
+	   setBlock (RDSGroup::BLOCK_B,
+	             (RDSGroup::RADIO_TEXT << 12) | typeBits | textSegment);
+	   setBlock (RDSGroup::BLOCK_C, (p [0] << 8) | p [1]);
+	   setBlock (RDSGroup::BLOCK_D, (p [2] << 8) | p [3]);
+	   textSegment	= (textSegment + 1) % textSegments;
+	}
+
+	groupCount ++;
+	bitIndex	= 0;
+}
+//
+//	the bits go out msb first, block after block, and are
+//	differentially encoded: a "1" is a change of level
+bool	rdsEncoder::nextBit	(void) {
+int16_t	block	= bitIndex / BITS_PER_BLOCK;
+int16_t	bit	= BITS_PER_BLOCK - 1 - bitIndex % BITS_PER_BLOCK;
+bool	b	= (blocks [block] >> bit) & 01;
+
+	previousBit	= previousBit ^ b;
+	if (++ bitIndex == RDSGroup::NUM_BLOCKS_PER_RDSGROUP * BITS_PER_BLOCK)
+	   nextGroup ();
+	return previousBit;
+}
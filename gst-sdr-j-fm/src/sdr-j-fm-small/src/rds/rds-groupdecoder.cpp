@@ -58,6 +58,7 @@ rdsGroupDecoder::rdsGroupDecoder (ClearCallback labelClearCallback,
 	this -> textCompleteCallback = textCompleteCallback;
 	this -> callbackUserData = callbackUserData;
 	stationLabel[STATION_LABEL_LENGTH] = '\0';
+	textBuffer[NUM_OF_CHARS_RADIOTEXT] = '\0';
 	reset ();
 }
 
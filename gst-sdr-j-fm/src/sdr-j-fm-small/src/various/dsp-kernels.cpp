@@ -0,0 +1,694 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include	"dsp-kernels.h"
+#include	"Xtan2.h"
+#include	<pthread.h>
+#include	<string.h>
+#include	<stdlib.h>
+
+#if defined (__x86_64__) || defined (__i386__)
+#define	HAVE_X86_KERNELS
+#include	<immintrin.h>
+//	the simd versions are compiled for their own instruction set,
+//	independent of the flags the rest of the file is built with
+#define	SSE2_TARGET	__attribute__ ((target ("sse2")))
+#define	AVX2_TARGET	__attribute__ ((target ("avx2,fma")))
+#endif
+
+//	neon as such is optional on 32 bit arm, and lacks the vector
+//	divide and square root there; we only use it on aarch64
+#if defined (__aarch64__)
+#define	HAVE_NEON_KERNELS
+#include	<arm_neon.h>
+#endif
+
+#define	ATAN_C0		0.99997726f
+#define	ATAN_C1		(-0.33262347f)
+#define	ATAN_C2		0.19354346f
+#define	ATAN_C3		(-0.11643287f)
+#define	ATAN_C4		0.05265332f
+#define	ATAN_C5		(-0.01172120f)
+
+//====================================================================
+//	the plain versions
+static
+DSPFLOAT	dotReal_scalar (const DSPFLOAT *taps,
+	                        const DSPFLOAT *v, int32_t n) {
+int32_t	i;
+DSPFLOAT	sum	= 0;
+
+	for (i = 0; i < n; i ++)
+	   sum	+= taps [i] * v [i];
+	return sum;
+}
+
+static
+void	dotComplex_scalar (const DSPFLOAT *taps,
+	                   const DSPFLOAT *I, const DSPFLOAT *Q,
+	                   int32_t n, DSPFLOAT *outI, DSPFLOAT *outQ) {
+int32_t	i;
+DSPFLOAT	sumI	= 0;
+DSPFLOAT	sumQ	= 0;
+
+	for (i = 0; i < n; i ++) {
+	   sumI	+= taps [i] * I [i];
+	   sumQ	+= taps [i] * Q [i];
+	}
+	*outI	= sumI;
+	*outQ	= sumQ;
+}
+
+static
+void	rotate_scalar (DSPFLOAT *I, DSPFLOAT *Q,
+	               const DSPFLOAT *c, const DSPFLOAT *s, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i < n; i ++) {
+	   DSPFLOAT re	= I [i] * c [i] - Q [i] * s [i];
+	   DSPFLOAT im	= I [i] * s [i] + Q [i] * c [i];
+	   I [i]	= re;
+	   Q [i]	= im;
+	}
+}
+
+static
+void	magnitude_scalar (const DSPFLOAT *I, const DSPFLOAT *Q,
+	                  DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i < n; i ++)
+	   out [i]	= sqrtf (I [i] * I [i] + Q [i] * Q [i]);
+}
+
+static
+void	atan2_scalar (const DSPFLOAT *y, const DSPFLOAT *x,
+	              DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i < n; i ++)
+	   out [i]	= fastAtan2 (y [i], x [i]);
+}
+
+static
+void	u8ToFloat_scalar (const uint8_t *in,
+	                  DSPFLOAT *I, DSPFLOAT *Q, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i < n; i ++) {
+	   I [i]	= (in [2 * i] - 128) / 128.0f;
+	   Q [i]	= (in [2 * i + 1] - 128) / 128.0f;
+	}
+}
+
+static
+void	window_scalar (const DSPFLOAT *w, const DSPFLOAT *in,
+	               DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i < n; i ++)
+	   out [i]	= w [i] * in [i];
+}
+
+static const dspKernels	scalarKernels = {
+	"scalar",
+	dotReal_scalar,
+	dotComplex_scalar,
+	rotate_scalar,
+	magnitude_scalar,
+	atan2_scalar,
+	u8ToFloat_scalar,
+	window_scalar
+};
+
+#ifdef	HAVE_X86_KERNELS
+//====================================================================
+//	sse2, four floats at a time
+static inline SSE2_TARGET
+float	hsum_sse2 (__m128 v) {
+__m128	sh	= _mm_shuffle_ps (v, v, _MM_SHUFFLE (2, 3, 0, 1));
+	v	= _mm_add_ps (v, sh);
+	sh	= _mm_movehl_ps (sh, v);
+	v	= _mm_add_ss (v, sh);
+	return _mm_cvtss_f32 (v);
+}
+
+static SSE2_TARGET
+DSPFLOAT	dotReal_sse2 (const DSPFLOAT *taps,
+	                      const DSPFLOAT *v, int32_t n) {
+int32_t	i;
+__m128	acc	= _mm_setzero_ps ();
+DSPFLOAT	sum;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	   acc	= _mm_add_ps (acc, _mm_mul_ps (_mm_loadu_ps (&taps [i]),
+	                                       _mm_loadu_ps (&v [i])));
+	sum	= hsum_sse2 (acc);
+	for (; i < n; i ++)
+	   sum	+= taps [i] * v [i];
+	return sum;
+}
+
+static SSE2_TARGET
+void	dotComplex_sse2 (const DSPFLOAT *taps,
+	                 const DSPFLOAT *I, const DSPFLOAT *Q,
+	                 int32_t n, DSPFLOAT *outI, DSPFLOAT *outQ) {
+int32_t	i;
+__m128	accI	= _mm_setzero_ps ();
+__m128	accQ	= _mm_setzero_ps ();
+DSPFLOAT	sumI, sumQ;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+	   __m128 t	= _mm_loadu_ps (&taps [i]);
+	   accI	= _mm_add_ps (accI, _mm_mul_ps (t, _mm_loadu_ps (&I [i])));
+	   accQ	= _mm_add_ps (accQ, _mm_mul_ps (t, _mm_loadu_ps (&Q [i])));
+	}
+	sumI	= hsum_sse2 (accI);
+	sumQ	= hsum_sse2 (accQ);
+	for (; i < n; i ++) {
+	   sumI	+= taps [i] * I [i];
+	   sumQ	+= taps [i] * Q [i];
+	}
+	*outI	= sumI;
+	*outQ	= sumQ;
+}
+
+static SSE2_TARGET
+void	rotate_sse2 (DSPFLOAT *I, DSPFLOAT *Q,
+	             const DSPFLOAT *c, const DSPFLOAT *s, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+	   __m128 vi	= _mm_loadu_ps (&I [i]);
+	   __m128 vq	= _mm_loadu_ps (&Q [i]);
+	   __m128 vc	= _mm_loadu_ps (&c [i]);
+	   __m128 vs	= _mm_loadu_ps (&s [i]);
+	   _mm_storeu_ps (&I [i], _mm_sub_ps (_mm_mul_ps (vi, vc),
+	                                      _mm_mul_ps (vq, vs)));
+	   _mm_storeu_ps (&Q [i], _mm_add_ps (_mm_mul_ps (vi, vs),
+	                                      _mm_mul_ps (vq, vc)));
+	}
+	rotate_scalar (&I [i], &Q [i], &c [i], &s [i], n - i);
+}
+
+static SSE2_TARGET
+void	magnitude_sse2 (const DSPFLOAT *I, const DSPFLOAT *Q,
+	                DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+	   __m128 vi	= _mm_loadu_ps (&I [i]);
+	   __m128 vq	= _mm_loadu_ps (&Q [i]);
+	   _mm_storeu_ps (&out [i],
+	                  _mm_sqrt_ps (_mm_add_ps (_mm_mul_ps (vi, vi),
+	                                           _mm_mul_ps (vq, vq))));
+	}
+	magnitude_scalar (&I [i], &Q [i], &out [i], n - i);
+}
+//
+//	the selects of fastAtan2 become masks
+static inline SSE2_TARGET
+__m128	select_sse2 (__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b));
+}
+
+static SSE2_TARGET
+void	atan2_sse2 (const DSPFLOAT *y, const DSPFLOAT *x,
+	            DSPFLOAT *out, int32_t n) {
+int32_t	i;
+const __m128	sign	= _mm_set1_ps (-0.0f);
+const __m128	zero	= _mm_setzero_ps ();
+
+	for (i = 0; i + 4 <= n; i += 4) {
+	   __m128 vy	= _mm_loadu_ps (&y [i]);
+	   __m128 vx	= _mm_loadu_ps (&x [i]);
+	   __m128 ax	= _mm_andnot_ps (sign, vx);
+	   __m128 ay	= _mm_andnot_ps (sign, vy);
+	   __m128 a	= _mm_div_ps (_mm_min_ps (ax, ay),
+	                      _mm_add_ps (_mm_max_ps (ax, ay),
+	                                  _mm_set1_ps (1e-30f)));
+	   __m128 s	= _mm_mul_ps (a, a);
+	   __m128 r	= _mm_set1_ps (ATAN_C5);
+	   r	= _mm_add_ps (_mm_mul_ps (r, s), _mm_set1_ps (ATAN_C4));
+	   r	= _mm_add_ps (_mm_mul_ps (r, s), _mm_set1_ps (ATAN_C3));
+	   r	= _mm_add_ps (_mm_mul_ps (r, s), _mm_set1_ps (ATAN_C2));
+	   r	= _mm_add_ps (_mm_mul_ps (r, s), _mm_set1_ps (ATAN_C1));
+	   r	= _mm_add_ps (_mm_mul_ps (r, s), _mm_set1_ps (ATAN_C0));
+	   r	= _mm_mul_ps (r, a);
+	   r	= select_sse2 (_mm_cmpgt_ps (ay, ax),
+	                   _mm_sub_ps (_mm_set1_ps ((float)M_PI_2), r), r);
+	   r	= select_sse2 (_mm_cmplt_ps (vx, zero),
+	                   _mm_sub_ps (_mm_set1_ps ((float)M_PI), r), r);
+	   r	= _mm_xor_ps (r, _mm_and_ps (_mm_cmplt_ps (vy, zero), sign));
+	   _mm_storeu_ps (&out [i], r);
+	}
+	atan2_scalar (&y [i], &x [i], &out [i], n - i);
+}
+//
+//	eight pairs, i.e. sixteen bytes, at a time
+static SSE2_TARGET
+void	u8ToFloat_sse2 (const uint8_t *in,
+	                DSPFLOAT *I, DSPFLOAT *Q, int32_t n) {
+int32_t	i;
+const __m128i	zero	= _mm_setzero_si128 ();
+const __m128	offset	= _mm_set1_ps (128.0f);
+const __m128	scale	= _mm_set1_ps (1.0f / 128);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+	   __m128i b	= _mm_loadu_si128 ((const __m128i *)&in [2 * i]);
+	   __m128i lo	= _mm_unpacklo_epi8 (b, zero);
+	   __m128i hi	= _mm_unpackhi_epi8 (b, zero);
+	   __m128 f0	= _mm_cvtepi32_ps (_mm_unpacklo_epi16 (lo, zero));
+	   __m128 f1	= _mm_cvtepi32_ps (_mm_unpackhi_epi16 (lo, zero));
+	   __m128 f2	= _mm_cvtepi32_ps (_mm_unpacklo_epi16 (hi, zero));
+	   __m128 f3	= _mm_cvtepi32_ps (_mm_unpackhi_epi16 (hi, zero));
+	   __m128 i0	= _mm_shuffle_ps (f0, f1, _MM_SHUFFLE (2, 0, 2, 0));
+	   __m128 q0	= _mm_shuffle_ps (f0, f1, _MM_SHUFFLE (3, 1, 3, 1));
+	   __m128 i1	= _mm_shuffle_ps (f2, f3, _MM_SHUFFLE (2, 0, 2, 0));
+	   __m128 q1	= _mm_shuffle_ps (f2, f3, _MM_SHUFFLE (3, 1, 3, 1));
+	   _mm_storeu_ps (&I [i],
+	                  _mm_mul_ps (_mm_sub_ps (i0, offset), scale));
+	   _mm_storeu_ps (&Q [i],
+	                  _mm_mul_ps (_mm_sub_ps (q0, offset), scale));
+	   _mm_storeu_ps (&I [i + 4],
+	                  _mm_mul_ps (_mm_sub_ps (i1, offset), scale));
+	   _mm_storeu_ps (&Q [i + 4],
+	                  _mm_mul_ps (_mm_sub_ps (q1, offset), scale));
+	}
+	u8ToFloat_scalar (&in [2 * i], &I [i], &Q [i], n - i);
+}
+
+static SSE2_TARGET
+void	window_sse2 (const DSPFLOAT *w, const DSPFLOAT *in,
+	             DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	   _mm_storeu_ps (&out [i], _mm_mul_ps (_mm_loadu_ps (&w [i]),
+	                                        _mm_loadu_ps (&in [i])));
+	window_scalar (&w [i], &in [i], &out [i], n - i);
+}
+
+static const dspKernels	sse2Kernels = {
+	"sse2",
+	dotReal_sse2,
+	dotComplex_sse2,
+	rotate_sse2,
+	magnitude_sse2,
+	atan2_sse2,
+	u8ToFloat_sse2,
+	window_sse2
+};
+
+//====================================================================
+//	avx2 with fma, eight floats at a time
+static inline AVX2_TARGET
+float	hsum_avx2 (__m256 v) {
+__m128	s	= _mm_add_ps (_mm256_castps256_ps128 (v),
+	                      _mm256_extractf128_ps (v, 1));
+__m128	sh	= _mm_shuffle_ps (s, s, _MM_SHUFFLE (2, 3, 0, 1));
+	s	= _mm_add_ps (s, sh);
+	sh	= _mm_movehl_ps (sh, s);
+	s	= _mm_add_ss (s, sh);
+	return _mm_cvtss_f32 (s);
+}
+
+static AVX2_TARGET
+DSPFLOAT	dotReal_avx2 (const DSPFLOAT *taps,
+	                      const DSPFLOAT *v, int32_t n) {
+int32_t	i;
+__m256	acc	= _mm256_setzero_ps ();
+DSPFLOAT	sum;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	   acc	= _mm256_fmadd_ps (_mm256_loadu_ps (&taps [i]),
+	                           _mm256_loadu_ps (&v [i]), acc);
+	sum	= hsum_avx2 (acc);
+	for (; i < n; i ++)
+	   sum	+= taps [i] * v [i];
+	return sum;
+}
+
+static AVX2_TARGET
+void	dotComplex_avx2 (const DSPFLOAT *taps,
+	                 const DSPFLOAT *I, const DSPFLOAT *Q,
+	                 int32_t n, DSPFLOAT *outI, DSPFLOAT *outQ) {
+int32_t	i;
+__m256	accI	= _mm256_setzero_ps ();
+__m256	accQ	= _mm256_setzero_ps ();
+DSPFLOAT	sumI, sumQ;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+	   __m256 t	= _mm256_loadu_ps (&taps [i]);
+	   accI	= _mm256_fmadd_ps (t, _mm256_loadu_ps (&I [i]), accI);
+	   accQ	= _mm256_fmadd_ps (t, _mm256_loadu_ps (&Q [i]), accQ);
+	}
+	sumI	= hsum_avx2 (accI);
+	sumQ	= hsum_avx2 (accQ);
+	for (; i < n; i ++) {
+	   sumI	+= taps [i] * I [i];
+	   sumQ	+= taps [i] * Q [i];
+	}
+	*outI	= sumI;
+	*outQ	= sumQ;
+}
+
+static AVX2_TARGET
+void	rotate_avx2 (DSPFLOAT *I, DSPFLOAT *Q,
+	             const DSPFLOAT *c, const DSPFLOAT *s, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+	   __m256 vi	= _mm256_loadu_ps (&I [i]);
+	   __m256 vq	= _mm256_loadu_ps (&Q [i]);
+	   __m256 vc	= _mm256_loadu_ps (&c [i]);
+	   __m256 vs	= _mm256_loadu_ps (&s [i]);
+	   _mm256_storeu_ps (&I [i],
+	                  _mm256_fmsub_ps (vi, vc, _mm256_mul_ps (vq, vs)));
+	   _mm256_storeu_ps (&Q [i],
+	                  _mm256_fmadd_ps (vi, vs, _mm256_mul_ps (vq, vc)));
+	}
+	rotate_scalar (&I [i], &Q [i], &c [i], &s [i], n - i);
+}
+
+static AVX2_TARGET
+void	magnitude_avx2 (const DSPFLOAT *I, const DSPFLOAT *Q,
+	                DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+	   __m256 vi	= _mm256_loadu_ps (&I [i]);
+	   __m256 vq	= _mm256_loadu_ps (&Q [i]);
+	   _mm256_storeu_ps (&out [i],
+	                     _mm256_sqrt_ps (_mm256_fmadd_ps (vi, vi,
+	                                     _mm256_mul_ps (vq, vq))));
+	}
+	magnitude_scalar (&I [i], &Q [i], &out [i], n - i);
+}
+
+static AVX2_TARGET
+void	atan2_avx2 (const DSPFLOAT *y, const DSPFLOAT *x,
+	            DSPFLOAT *out, int32_t n) {
+int32_t	i;
+const __m256	sign	= _mm256_set1_ps (-0.0f);
+const __m256	zero	= _mm256_setzero_ps ();
+
+	for (i = 0; i + 8 <= n; i += 8) {
+	   __m256 vy	= _mm256_loadu_ps (&y [i]);
+	   __m256 vx	= _mm256_loadu_ps (&x [i]);
+	   __m256 ax	= _mm256_andnot_ps (sign, vx);
+	   __m256 ay	= _mm256_andnot_ps (sign, vy);
+	   __m256 a	= _mm256_div_ps (_mm256_min_ps (ax, ay),
+	                         _mm256_add_ps (_mm256_max_ps (ax, ay),
+	                                        _mm256_set1_ps (1e-30f)));
+	   __m256 s	= _mm256_mul_ps (a, a);
+	   __m256 r	= _mm256_set1_ps (ATAN_C5);
+	   r	= _mm256_fmadd_ps (r, s, _mm256_set1_ps (ATAN_C4));
+	   r	= _mm256_fmadd_ps (r, s, _mm256_set1_ps (ATAN_C3));
+	   r	= _mm256_fmadd_ps (r, s, _mm256_set1_ps (ATAN_C2));
+	   r	= _mm256_fmadd_ps (r, s, _mm256_set1_ps (ATAN_C1));
+	   r	= _mm256_fmadd_ps (r, s, _mm256_set1_ps (ATAN_C0));
+	   r	= _mm256_mul_ps (r, a);
+	   r	= _mm256_blendv_ps (r,
+	                   _mm256_sub_ps (_mm256_set1_ps ((float)M_PI_2), r),
+	                   _mm256_cmp_ps (ay, ax, _CMP_GT_OQ));
+	   r	= _mm256_blendv_ps (r,
+	                   _mm256_sub_ps (_mm256_set1_ps ((float)M_PI), r),
+	                   _mm256_cmp_ps (vx, zero, _CMP_LT_OQ));
+	   r	= _mm256_xor_ps (r, _mm256_and_ps (
+	                   _mm256_cmp_ps (vy, zero, _CMP_LT_OQ), sign));
+	   _mm256_storeu_ps (&out [i], r);
+	}
+	atan2_scalar (&y [i], &x [i], &out [i], n - i);
+}
+//
+//	eight pairs at a time: widen to eight ints per four pairs,
+//	split the even (I) and odd (Q) lanes and restore the order
+//	the in-lane shuffle left behind
+static AVX2_TARGET
+void	u8ToFloat_avx2 (const uint8_t *in,
+	                DSPFLOAT *I, DSPFLOAT *Q, int32_t n) {
+int32_t	i;
+const __m256	offset	= _mm256_set1_ps (128.0f);
+const __m256	scale	= _mm256_set1_ps (1.0f / 128);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+	   __m256 f0	= _mm256_cvtepi32_ps (_mm256_cvtepu8_epi32 (
+	                   _mm_loadl_epi64 ((const __m128i *)&in [2 * i])));
+	   __m256 f1	= _mm256_cvtepi32_ps (_mm256_cvtepu8_epi32 (
+	                   _mm_loadl_epi64 ((const __m128i *)&in [2 * i + 8])));
+	   __m256 vi	= _mm256_shuffle_ps (f0, f1, _MM_SHUFFLE (2, 0, 2, 0));
+	   __m256 vq	= _mm256_shuffle_ps (f0, f1, _MM_SHUFFLE (3, 1, 3, 1));
+	   vi	= _mm256_castpd_ps (_mm256_permute4x64_pd (
+	                   _mm256_castps_pd (vi), _MM_SHUFFLE (3, 1, 2, 0)));
+	   vq	= _mm256_castpd_ps (_mm256_permute4x64_pd (
+	                   _mm256_castps_pd (vq), _MM_SHUFFLE (3, 1, 2, 0)));
+	   _mm256_storeu_ps (&I [i],
+	                     _mm256_mul_ps (_mm256_sub_ps (vi, offset), scale));
+	   _mm256_storeu_ps (&Q [i],
+	                     _mm256_mul_ps (_mm256_sub_ps (vq, offset), scale));
+	}
+	u8ToFloat_scalar (&in [2 * i], &I [i], &Q [i], n - i);
+}
+
+static AVX2_TARGET
+void	window_avx2 (const DSPFLOAT *w, const DSPFLOAT *in,
+	             DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	   _mm256_storeu_ps (&out [i],
+	                     _mm256_mul_ps (_mm256_loadu_ps (&w [i]),
+	                                    _mm256_loadu_ps (&in [i])));
+	window_scalar (&w [i], &in [i], &out [i], n - i);
+}
+
+static const dspKernels	avx2Kernels = {
+	"avx2",
+	dotReal_avx2,
+	dotComplex_avx2,
+	rotate_avx2,
+	magnitude_avx2,
+	atan2_avx2,
+	u8ToFloat_avx2,
+	window_avx2
+};
+#endif
+
+#ifdef	HAVE_NEON_KERNELS
+//====================================================================
+//	neon (aarch64), four floats at a time
+static
+DSPFLOAT	dotReal_neon (const DSPFLOAT *taps,
+	                      const DSPFLOAT *v, int32_t n) {
+int32_t	i;
+float32x4_t	acc	= vdupq_n_f32 (0);
+DSPFLOAT	sum;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	   acc	= vfmaq_f32 (acc, vld1q_f32 (&taps [i]), vld1q_f32 (&v [i]));
+	sum	= vaddvq_f32 (acc);
+	for (; i < n; i ++)
+	   sum	+= taps [i] * v [i];
+	return sum;
+}
+
+static
+void	dotComplex_neon (const DSPFLOAT *taps,
+	                 const DSPFLOAT *I, const DSPFLOAT *Q,
+	                 int32_t n, DSPFLOAT *outI, DSPFLOAT *outQ) {
+int32_t	i;
+float32x4_t	accI	= vdupq_n_f32 (0);
+float32x4_t	accQ	= vdupq_n_f32 (0);
+DSPFLOAT	sumI, sumQ;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+	   float32x4_t t	= vld1q_f32 (&taps [i]);
+	   accI	= vfmaq_f32 (accI, t, vld1q_f32 (&I [i]));
+	   accQ	= vfmaq_f32 (accQ, t, vld1q_f32 (&Q [i]));
+	}
+	sumI	= vaddvq_f32 (accI);
+	sumQ	= vaddvq_f32 (accQ);
+	for (; i < n; i ++) {
+	   sumI	+= taps [i] * I [i];
+	   sumQ	+= taps [i] * Q [i];
+	}
+	*outI	= sumI;
+	*outQ	= sumQ;
+}
+
+static
+void	rotate_neon (DSPFLOAT *I, DSPFLOAT *Q,
+	             const DSPFLOAT *c, const DSPFLOAT *s, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+	   float32x4_t vi	= vld1q_f32 (&I [i]);
+	   float32x4_t vq	= vld1q_f32 (&Q [i]);
+	   float32x4_t vc	= vld1q_f32 (&c [i]);
+	   float32x4_t vs	= vld1q_f32 (&s [i]);
+	   vst1q_f32 (&I [i], vfmsq_f32 (vmulq_f32 (vi, vc), vq, vs));
+	   vst1q_f32 (&Q [i], vfmaq_f32 (vmulq_f32 (vi, vs), vq, vc));
+	}
+	rotate_scalar (&I [i], &Q [i], &c [i], &s [i], n - i);
+}
+
+static
+void	magnitude_neon (const DSPFLOAT *I, const DSPFLOAT *Q,
+	                DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+	   float32x4_t vi	= vld1q_f32 (&I [i]);
+	   float32x4_t vq	= vld1q_f32 (&Q [i]);
+	   vst1q_f32 (&out [i],
+	              vsqrtq_f32 (vfmaq_f32 (vmulq_f32 (vq, vq), vi, vi)));
+	}
+	magnitude_scalar (&I [i], &Q [i], &out [i], n - i);
+}
+
+static
+void	atan2_neon (const DSPFLOAT *y, const DSPFLOAT *x,
+	            DSPFLOAT *out, int32_t n) {
+int32_t	i;
+const float32x4_t	zero	= vdupq_n_f32 (0);
+
+	for (i = 0; i + 4 <= n; i += 4) {
+	   float32x4_t vy	= vld1q_f32 (&y [i]);
+	   float32x4_t vx	= vld1q_f32 (&x [i]);
+	   float32x4_t ax	= vabsq_f32 (vx);
+	   float32x4_t ay	= vabsq_f32 (vy);
+	   float32x4_t a	= vdivq_f32 (vminq_f32 (ax, ay),
+	                             vaddq_f32 (vmaxq_f32 (ax, ay),
+	                                        vdupq_n_f32 (1e-30f)));
+	   float32x4_t s	= vmulq_f32 (a, a);
+	   float32x4_t r	= vdupq_n_f32 (ATAN_C5);
+	   r	= vfmaq_f32 (vdupq_n_f32 (ATAN_C4), r, s);
+	   r	= vfmaq_f32 (vdupq_n_f32 (ATAN_C3), r, s);
+	   r	= vfmaq_f32 (vdupq_n_f32 (ATAN_C2), r, s);
+	   r	= vfmaq_f32 (vdupq_n_f32 (ATAN_C1), r, s);
+	   r	= vfmaq_f32 (vdupq_n_f32 (ATAN_C0), r, s);
+	   r	= vmulq_f32 (r, a);
+	   r	= vbslq_f32 (vcgtq_f32 (ay, ax),
+	                     vsubq_f32 (vdupq_n_f32 ((float)M_PI_2), r), r);
+	   r	= vbslq_f32 (vcltq_f32 (vx, zero),
+	                     vsubq_f32 (vdupq_n_f32 ((float)M_PI), r), r);
+	   r	= vbslq_f32 (vcltq_f32 (vy, zero), vnegq_f32 (r), r);
+	   vst1q_f32 (&out [i], r);
+	}
+	atan2_scalar (&y [i], &x [i], &out [i], n - i);
+}
+//
+//	the de-interleaving load does the splitting in I and Q
+static
+void	u8ToFloat_neon (const uint8_t *in,
+	                DSPFLOAT *I, DSPFLOAT *Q, int32_t n) {
+int32_t	i;
+const float32x4_t	offset	= vdupq_n_f32 (128.0f);
+const float32x4_t	scale	= vdupq_n_f32 (1.0f / 128);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+	   uint8x8x2_t b	= vld2_u8 (&in [2 * i]);
+	   uint16x8_t wi	= vmovl_u8 (b. val [0]);
+	   uint16x8_t wq	= vmovl_u8 (b. val [1]);
+	   float32x4_t i0	= vcvtq_f32_u32 (vmovl_u16 (vget_low_u16 (wi)));
+	   float32x4_t i1	= vcvtq_f32_u32 (vmovl_u16 (vget_high_u16 (wi)));
+	   float32x4_t q0	= vcvtq_f32_u32 (vmovl_u16 (vget_low_u16 (wq)));
+	   float32x4_t q1	= vcvtq_f32_u32 (vmovl_u16 (vget_high_u16 (wq)));
+	   vst1q_f32 (&I [i],	  vmulq_f32 (vsubq_f32 (i0, offset), scale));
+	   vst1q_f32 (&I [i + 4], vmulq_f32 (vsubq_f32 (i1, offset), scale));
+	   vst1q_f32 (&Q [i],	  vmulq_f32 (vsubq_f32 (q0, offset), scale));
+	   vst1q_f32 (&Q [i + 4], vmulq_f32 (vsubq_f32 (q1, offset), scale));
+	}
+	u8ToFloat_scalar (&in [2 * i], &I [i], &Q [i], n - i);
+}
+
+static
+void	window_neon (const DSPFLOAT *w, const DSPFLOAT *in,
+	             DSPFLOAT *out, int32_t n) {
+int32_t	i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	   vst1q_f32 (&out [i], vmulq_f32 (vld1q_f32 (&w [i]),
+	                                   vld1q_f32 (&in [i])));
+	window_scalar (&w [i], &in [i], &out [i], n - i);
+}
+
+static const dspKernels	neonKernels = {
+	"neon",
+	dotReal_neon,
+	dotComplex_neon,
+	rotate_neon,
+	magnitude_neon,
+	atan2_neon,
+	u8ToFloat_neon,
+	window_neon
+};
+#endif
+
+//====================================================================
+const dspKernels	*getKernels (const char *name) {
+	if (strcmp (name, "scalar") == 0)
+	   return &scalarKernels;
+#ifdef	HAVE_X86_KERNELS
+	__builtin_cpu_init ();
+	if (strcmp (name, "sse2") == 0 && __builtin_cpu_supports ("sse2"))
+	   return &sse2Kernels;
+	if (strcmp (name, "avx2") == 0 &&
+	    __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+	   return &avx2Kernels;
+#endif
+#ifdef	HAVE_NEON_KERNELS
+	if (strcmp (name, "neon") == 0)
+	   return &neonKernels;
+#endif
+	return NULL;
+}
+
+static pthread_once_t	kernelsOnce	= PTHREAD_ONCE_INIT;
+static const dspKernels	*selectedKernels	= &scalarKernels;
+
+static
+void	selectKernels (void) {
+const char	*preferred []	= {"avx2", "sse2", "neon"};
+const char	*forced		= getenv ("SDRJFM_KERNELS");
+uint16_t	i;
+
+	if (forced != NULL && getKernels (forced) != NULL) {
+	   selectedKernels	= getKernels (forced);
+	   return;
+	}
+
+	for (i = 0; i < sizeof (preferred) / sizeof (preferred [0]); i ++) {
+	   const dspKernels *k = getKernels (preferred [i]);
+	   if (k != NULL) {
+	      selectedKernels	= k;
+	      return;
+	   }
+	}
+}
+
+const dspKernels	*getKernels (void) {
+	pthread_once (&kernelsOnce, selectKernels);
+	return selectedKernels;
+}
@@ -25,8 +25,13 @@
  */
 #include	"fft.h"
 #include	<cstring>
+#include	<pthread.h>
 /*
+ *	Only fftw's execute is thread safe, making and destroying plans
+ *	is not: with several processors (each with its own filters)
+ *	in one process, the planner is used under this lock
  */
+static pthread_mutex_t	plannerLock	= PTHREAD_MUTEX_INITIALIZER;
 
 	common_fft::common_fft (int32_t fft_size) {
 int32_t	i;
@@ -36,14 +41,18 @@ int32_t	i;
 	vector	= (DSPCOMPLEX *) FFTW_MALLOC (sizeof (DSPCOMPLEX) * fft_size);
 	for (i = 0; i < fft_size; i ++)
 	   vector [i] = 0;
+	pthread_mutex_lock (&plannerLock);
 	plan	= FFTW_PLAN_DFT_1D (fft_size,
 	                            reinterpret_cast <fftwf_complex *>(vector),
 	                            reinterpret_cast <fftwf_complex *>(vector),
 	                            FFTW_FORWARD, FFTW_ESTIMATE);
+	pthread_mutex_unlock (&plannerLock);
 }
 
 	common_fft::~common_fft () {
+	   pthread_mutex_lock (&plannerLock);
 	   FFTW_DESTROY_PLAN (plan);
+	   pthread_mutex_unlock (&plannerLock);
 	   FFTW_FREE (vector);
 }
 
@@ -91,14 +100,18 @@ int32_t	i;
 	vector	= (DSPCOMPLEX *)FFTW_MALLOC (sizeof (DSPCOMPLEX) * fft_size);
 	for (i = 0; i < fft_size; i ++)
 	   vector [i] = 0;
+	pthread_mutex_lock (&plannerLock);
 	plan	= FFTW_PLAN_DFT_1D (fft_size,
 	                            reinterpret_cast <fftwf_complex *>(vector),
 	                            reinterpret_cast <fftwf_complex *>(vector),
 	                            FFTW_BACKWARD, FFTW_ESTIMATE);
+	pthread_mutex_unlock (&plannerLock);
 }
 
 	common_ifft::~common_ifft () {
+	   pthread_mutex_lock (&plannerLock);
 	   FFTW_DESTROY_PLAN (plan);
+	   pthread_mutex_unlock (&plannerLock);
 	   FFTW_FREE (vector);
 }
 
@@ -457,6 +457,250 @@ bool	DecimatingFIR::Pass (DSPFLOAT z, DSPFLOAT *z_out) {
 }
 
 
+//====================================================================
+/*
+ *	The real filters need symmetric taps. The Blackman window
+ *	is therefore taken over filterSize + 1 points, centered on the
+ *	middle of the kernel (the outer taps are not 0 this way).
+ *	The kernel is computed for one half and mirrored
+ */
+static
+void	symmetricLowPass (DSPFLOAT *v, int16_t fsize, DSPFLOAT f) {
+int16_t	i;
+DSPFLOAT	sum	= 0;
+
+	for (i = 0; i < (fsize + 1) / 2; i ++) {
+	   DSPFLOAT t	= i - (fsize - 1) / 2.0;
+	   if (t == 0)
+	      v [i] = 2 * M_PI * f;
+	   else
+	      v [i] = sin (2 * M_PI * f * t) / t;
+
+	   v [i] *= (0.42 -
+	        0.5 * cos (2 * M_PI * (DSPFLOAT)(i + 1) / (DSPFLOAT)(fsize + 1)) +
+	        0.08 * cos (4 * M_PI * (DSPFLOAT)(i + 1) / (DSPFLOAT)(fsize + 1)));
+	   v [fsize - 1 - i] = v [i];
+	}
+
+	for (i = 0; i < fsize; i ++)
+	   sum += v [i];
+	for (i = 0; i < fsize; i ++)
+	   v [i] /= sum;
+}
+
+	LowPassRealFIR::LowPassRealFIR (int16_t firsize,
+	                                int32_t Fc,
+	                                int32_t fs):Basic_RealFIR (firsize) {
+	sampleRate	= fs;
+	newKernel (Fc);
+}
+
+	LowPassRealFIR::~LowPassRealFIR (void) {
+}
+
+void	LowPassRealFIR::newKernel (int32_t Fc) {
+	symmetricLowPass (filterKernel, filterSize,
+	                  (DSPFLOAT)Fc / sampleRate);
+}
+
+DSPFLOAT	*LowPassRealFIR::getKernel (void) {
+	return filterKernel;
+}
+
+	DecimatingRealFIR::DecimatingRealFIR (int16_t firSize,
+	                                      int32_t low,
+	                                      int32_t fs,
+	                                      int16_t Dm):
+	                                         Basic_RealFIR (firSize) {
+	sampleRate		= fs;
+	decimationFactor	= Dm;
+	decimationCounter	= 0;
+	newKernel (low);
+}
+
+	DecimatingRealFIR::~DecimatingRealFIR (void) {
+}
+
+void	DecimatingRealFIR::newKernel (int32_t low) {
+	symmetricLowPass (filterKernel, filterSize,
+	                  (DSPFLOAT)low / sampleRate);
+}
+
+bool	DecimatingRealFIR::Pass (DSPCOMPLEX z, DSPCOMPLEX *z_out) {
+	push (z);
+	if (++decimationCounter < decimationFactor)
+	   return false;
+
+	decimationCounter = 0;
+	*z_out	= apply (&BufferI [ip], &BufferQ [ip]);
+	return true;
+}
+
+bool	DecimatingRealFIR::Pass (DSPFLOAT v, DSPFLOAT *v_out) {
+	push (v);
+	if (++decimationCounter < decimationFactor)
+	   return false;
+
+	decimationCounter = 0;
+	*v_out	= apply (&BufferI [ip]);
+	return true;
+}
+
+//
+//	The block version, the decimated samples are appended to out
+int32_t	DecimatingRealFIR::Pass (const sampleBlock *in, sampleBlock *out) {
+int32_t	i;
+int32_t	n	= 0;
+
+	for (i = 0; i < in -> count; i ++) {
+	   BufferI [ip]			= in -> I [i];
+	   BufferI [ip + filterSize]	= in -> I [i];
+	   BufferQ [ip]			= in -> Q [i];
+	   BufferQ [ip + filterSize]	= in -> Q [i];
+	   if (++ip >= filterSize)
+	      ip = 0;
+	   if (++decimationCounter < decimationFactor)
+	      continue;
+
+	   decimationCounter = 0;
+	   if (n < out -> size) {
+	      kernels -> dotComplex (filterKernel,
+	                             &BufferI [ip], &BufferQ [ip], paddedSize,
+	                             &out -> I [n], &out -> Q [n]);
+	      n ++;
+	   }
+	}
+	out -> count	= n;
+	return n;
+}
+
+static
+int32_t	gcd	(int32_t a, int32_t b) {
+	while (b != 0) {
+	   int32_t t = a % b;
+	   a	= b;
+	   b	= t;
+	}
+	return a;
+}
+//
+//	outRate should stay below fs, Pass gives at most one sample
+	ResamplingRealFIR::ResamplingRealFIR (int16_t firSize,
+	                                      int32_t low,
+	                                      int32_t fs,
+	                                      int32_t outRate):
+	                                         Basic_RealFIR (firSize + 1) {
+int32_t	g	= gcd (fs, outRate);
+
+	sampleRate	= fs;
+	phaseSize	= firSize;
+	interpolation	= outRate / g;
+	decimation	= fs / g;
+	position	= (int64_t)decimation << 32;
+	step		= (int64_t)decimation << 32;
+	phaseKernels	= new DSPFLOAT [interpolation * paddedSize];
+	newKernel (low);
+}
+
+	ResamplingRealFIR::~ResamplingRealFIR (void) {
+	delete[]	phaseKernels;
+}
+//
+//	Tap j of the prototype, at L * fs, multiplies the sample j / L
+//	input samples back from the output. Phase p takes the taps
+//	p, p + L, ... and the delay line runs oldest first, so it is
+//	stored reversed. The gain of L makes up for the zeros the
+//	interpolation would have put in between the samples
+void	ResamplingRealFIR::newKernel (int32_t low) {
+int32_t	L	= interpolation;
+int32_t	p;
+int16_t	j;
+DSPFLOAT	*h	= new DSPFLOAT [phaseSize * L];
+
+	symmetricLowPass (h, phaseSize * L,
+	                  (DSPFLOAT)low / ((DSPFLOAT)L * sampleRate));
+	memset (phaseKernels, 0, L * paddedSize * sizeof (DSPFLOAT));
+	for (p = 0; p < L; p ++)
+	   for (j = 0; j < phaseSize; j ++)
+	      phaseKernels [p * paddedSize + j] =
+	                            L * h [p + (phaseSize - 1 - j) * L];
+	delete[]	h;
+}
+
+void	ResamplingRealFIR::setRateCorrection (DSPFLOAT correction) {
+	step	= llround ((double)((int64_t)decimation << 32) /
+	                                        (1 + correction));
+}
+//
+//	called once a sample was pushed, tells whether an output falls
+//	before the newest phase of it, and which phase comes before it.
+//	Phase -1 is the last one over the samples a step back. With the
+//	rate not corrected the fraction is always 0, and the outputs come
+//	as they would without the extra sample in the delay line
+bool	ResamplingRealFIR::nextPhase (int32_t *phase, DSPFLOAT *fraction) {
+	position	-= (int64_t)interpolation << 32;
+	if (position > ((int64_t)(interpolation - 1) << 32))
+	   return false;
+
+	*phase		= (int32_t)(position >> 32);
+	*fraction	= (uint32_t)position / 4294967296.0;
+	position	+= step;
+	return true;
+}
+//
+//	the newest phaseSize samples start a sample after the oldest
+DSPFLOAT	ResamplingRealFIR::applyPhase (int32_t phase) {
+	if (phase < 0)
+	   return kernels -> dotReal (&phaseKernels [(interpolation - 1) *
+	                                                     paddedSize],
+	                              &BufferI [ip], paddedSize);
+	return kernels -> dotReal (&phaseKernels [phase * paddedSize],
+	                           &BufferI [ip + 1], paddedSize);
+}
+
+DSPCOMPLEX	ResamplingRealFIR::applyPhaseIQ (int32_t phase) {
+DSPFLOAT	outI, outQ;
+
+	if (phase < 0)
+	   kernels -> dotComplex (&phaseKernels [(interpolation - 1) *
+	                                                     paddedSize],
+	                          &BufferI [ip], &BufferQ [ip], paddedSize,
+	                          &outI, &outQ);
+	else
+	   kernels -> dotComplex (&phaseKernels [phase * paddedSize],
+	                          &BufferI [ip + 1], &BufferQ [ip + 1],
+	                          paddedSize, &outI, &outQ);
+	return DSPCOMPLEX (outI, outQ);
+}
+
+bool	ResamplingRealFIR::Pass (DSPCOMPLEX z, DSPCOMPLEX *z_out) {
+int32_t	phase;
+DSPFLOAT	f;
+
+	push (z);
+	if (!nextPhase (&phase, &f))
+	   return false;
+
+	*z_out	= applyPhaseIQ (phase);
+	if (f != 0)
+	   *z_out	+= f * (applyPhaseIQ (phase + 1) - *z_out);
+	return true;
+}
+
+bool	ResamplingRealFIR::Pass (DSPFLOAT v, DSPFLOAT *v_out) {
+int32_t	phase;
+DSPFLOAT	f;
+
+	push (v);
+	if (!nextPhase (&phase, &f))
+	   return false;
+
+	*v_out	= applyPhase (phase);
+	if (f != 0)
+	   *v_out	+= f * (applyPhase (phase + 1) - *v_out);
+	return true;
+}
+
 //====================================================================
 /*
  *	The Hilbertfilter is derived from QEX Mar/April 1998
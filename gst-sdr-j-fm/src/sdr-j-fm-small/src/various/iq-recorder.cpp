@@ -0,0 +1,207 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include	"iq-recorder.h"
+#include	<fcntl.h>
+#include	<string.h>
+#include	<errno.h>
+
+//	4 Mbyte is about two seconds of samples at the usual rates
+#define	RING_SIZE	(4 * 1024 * 1024)
+//	the writer waits for this much before writing (unless stopping)
+#define	WRITE_CHUNK	(256 * 1024)
+//	the file is grown in steps of this size, ahead of the writing
+#define	ALLOCATE_STEP	((int64_t)256 * 1024 * 1024)
+
+	iqRecorder::iqRecorder (const std::string &fileName,
+	                        int32_t rate, bool *success) {
+std::string	metaName	= fileName + ".meta";
+
+	buffer		= NULL;
+	metaFile	= NULL;
+	running		= false;
+	bytesAccepted	= 0;
+	bytesWritten	= 0;
+	bytesAllocated	= 0;
+	dropped		= 0;
+	droppedReported	= 0;
+	*success	= false;
+
+	fd	= open (fileName. c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+	   fprintf (stderr, "Could not create %s\n", fileName. c_str ());
+	   return;
+	}
+
+	metaFile	= fopen (metaName. c_str (), "w");
+	if (metaFile == NULL) {
+	   fprintf (stderr, "Could not create %s\n", metaName. c_str ());
+	   close (fd);
+	   fd	= -1;
+	   return;
+	}
+	fprintf (metaFile, "format cu8\nrate %d\n", rate);
+	fflush (metaFile);
+
+	if (posix_fallocate (fd, 0, ALLOCATE_STEP) == 0)
+	   bytesAllocated	= ALLOCATE_STEP;
+
+	buffer		= new RingBuffer<uint8_t> (RING_SIZE);
+	pthread_mutex_init (&metaLock, NULL);
+	sem_init (&dataAvailable, 0, 0);
+	running		= true;
+	if (pthread_create (&writer, NULL, &iqRecorder::c_run, this) != 0) {
+	   running	= false;
+	   return;
+	}
+	*success	= true;
+}
+
+	iqRecorder::~iqRecorder (void) {
+	if (running) {
+	   running	= false;
+	   sem_post (&dataAvailable);
+	   pthread_join (writer, NULL);
+	}
+
+	if (buffer != NULL) {
+	   sem_destroy (&dataAvailable);
+	   pthread_mutex_destroy (&metaLock);
+	   delete buffer;
+	}
+	if (metaFile != NULL) {
+	   fprintf (metaFile, "end %lld\n", (long long)(bytesWritten / 2));
+	   fclose (metaFile);
+	}
+	if (fd >= 0) {
+//	give back what was allocated but not used
+	   if (ftruncate (fd, bytesWritten) < 0)
+	      fprintf (stderr, "Could not truncate recording\n");
+	   close (fd);
+	}
+}
+//
+//	The one function called from the usb callback: all or nothing,
+//	a partial block would shift the I/Q pairs
+void	iqRecorder::putSamples	(const uint8_t *buf, int32_t len) {
+	if (buffer -> GetRingBufferWriteAvailable () < (uint32_t)len) {
+	   __atomic_add_fetch (&dropped, 1, __ATOMIC_RELAXED);
+	   return;
+	}
+	buffer	-> putDataIntoBuffer (buf, len);
+	__atomic_add_fetch (&bytesAccepted, len, __ATOMIC_RELEASE);
+	if (buffer -> GetRingBufferReadAvailable () >= WRITE_CHUNK)
+	   sem_post (&dataAvailable);
+}
+
+int32_t	iqRecorder::droppedBlocks	(void) {
+	return __atomic_load_n (&dropped, __ATOMIC_RELAXED);
+}
+//
+//	the sample number is the number of samples accepted so far,
+//	the changes are written out by the writer thread
+void	iqRecorder::addMeta	(const char *key, int32_t value) {
+char	line [80];
+
+	snprintf (line, sizeof (line), "sample %lld %s %d\n",
+	          (long long)(__atomic_load_n (&bytesAccepted,
+	                                       __ATOMIC_ACQUIRE) / 2),
+	          key, value);
+	pthread_mutex_lock (&metaLock);
+	metaPending. push_back (line);
+	pthread_mutex_unlock (&metaLock);
+	sem_post (&dataAvailable);
+}
+
+void	iqRecorder::setFrequency	(int32_t f) {
+	addMeta ("frequency", f);
+}
+
+void	iqRecorder::setGain	(int32_t g) {
+	addMeta ("gain", g);
+}
+//
+//	Dropped blocks are reported at the point where the writer
+//	notices them, i.e. at most a ringbuffer length after the gap
+void	iqRecorder::writeMeta	(void) {
+std::vector<std::string>	lines;
+uint16_t	i;
+int32_t	d	= __atomic_load_n (&dropped, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock (&metaLock);
+	lines. swap (metaPending);
+	pthread_mutex_unlock (&metaLock);
+
+	if (lines. size () == 0 && d == droppedReported)
+	   return;
+
+	for (i = 0; i < lines. size (); i ++)
+	   fputs (lines [i]. c_str (), metaFile);
+	if (d != droppedReported) {
+	   fprintf (metaFile, "sample %lld dropped %d\n",
+	            (long long)(__atomic_load_n (&bytesAccepted,
+	                                         __ATOMIC_ACQUIRE) / 2),
+	            d - droppedReported);
+	   droppedReported	= d;
+	}
+	fflush (metaFile);
+}
+
+void	iqRecorder::writeSamples	(bool all) {
+void	*data1, *data2;
+int32_t	size1, size2;
+int32_t	amount	= buffer -> GetRingBufferReadAvailable ();
+
+	if (amount == 0 || (!all && amount < WRITE_CHUNK))
+	   return;
+//	an even number of bytes, the pairs are kept together in the file
+	amount	&= ~01;
+
+	if (bytesWritten + amount > bytesAllocated &&
+	    posix_fallocate (fd, bytesAllocated, ALLOCATE_STEP) == 0)
+	   bytesAllocated	+= ALLOCATE_STEP;
+
+	buffer	-> GetRingBufferReadRegions (amount,
+	                                     &data1, &size1, &data2, &size2);
+	if (write (fd, data1, size1) != size1 ||
+	    (size2 > 0 && write (fd, data2, size2) != size2))
+	   fprintf (stderr, "Writing recording failed: %s\n",
+	                                          strerror (errno));
+	buffer	-> AdvanceRingBufferReadIndex (amount);
+	bytesWritten	+= amount;
+}
+
+void	*iqRecorder::c_run	(void *userdata) {
+	static_cast<iqRecorder *>(userdata) -> run ();
+	return NULL;
+}
+
+void	iqRecorder::run	(void) {
+	while (running) {
+	   sem_wait (&dataAvailable);
+	   writeMeta ();
+	   writeSamples (false);
+	}
+	writeMeta ();
+	writeSamples (true);
+}
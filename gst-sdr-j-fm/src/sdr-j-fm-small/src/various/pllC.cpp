@@ -71,7 +71,8 @@ DSPCOMPLEX	quadRef;
 
 	NcoSignal = (mySinCos != NULL) ?
 	                  mySinCos -> getComplex (NcoPhase) : 
-                          DSPCOMPLEX (cos (NcoPhase), sin (NcoPhase));
+                          DSPCOMPLEX (cos (toRadians (NcoPhase)),
+	                              sin (toRadians (NcoPhase)));
 	    
 	pll_Delay	= NcoSignal * signal;
 	phzError	= - myAtan. atan2 (imag (pll_Delay), real (pll_Delay));
@@ -81,11 +82,8 @@ DSPCOMPLEX	quadRef;
 	if (NcoPhaseIncr > NcoHLimit)
 	   NcoPhaseIncr = NcoHLimit;
 
-	NcoPhase	+= NcoPhaseIncr + pll_Alpha * phzError;
-	if (NcoPhase >= 2 * M_PI)
-	   NcoPhase = fmod (NcoPhase, 2 * M_PI);
-	while (NcoPhase < 0)
-	   NcoPhase += 2 * M_PI;
+//	NcoPhase is a fixed point fraction of a turn, it wraps by itself
+	NcoPhase	+= toPhase (NcoPhaseIncr + pll_Alpha * phzError);
 }
 
 DSPCOMPLEX	pllC::getDelay (void) {
@@ -97,7 +95,7 @@ DSPFLOAT	pllC::getPhaseIncr(void) {
 }
 
 DSPFLOAT	pllC::getNco (void) {
-	return NcoPhase;
+	return toRadians (NcoPhase);
 }
 
 DSPFLOAT	pllC::getPhaseError (void) {
@@ -146,56 +146,35 @@ int32_t	IDecimator::getOutputsize (void) {
 //
 //
 //	The FDecimator is used whenever the ratio in/out is not
-//	integer. We split into an integer decimation, followed by
-//	a fractional part using the sinc-converter defined elsewhere
+//	integer. The polyphase filter interpolates and decimates
+//	in one pass, with its cutoff somewhat below the new nyquist
 	FDecimator::FDecimator (int32_t inRate,
 	                        int32_t outRate, int32_t insize) {
-	intRatio	= inRate / outRate;
-	inCount		= inRate / outRate;
-	fracDecimator_C	=
-	         new newConverter ((float)inRate, outRate, (float)inRate / 50, 6);
-//	         new newConverter (tempRate, outRate, insize / intRatio, 6);
+	(void)insize;
+	fracDecimator	= new ResamplingRealFIR (11, 45 * outRate / 100,
+	                                         inRate, outRate);
 }
 
 	FDecimator::~FDecimator (void) {
-	delete fracDecimator_C;
+	delete fracDecimator;
 }
 
 bool	FDecimator::doResample	(DSPCOMPLEX v,
 	                         DSPCOMPLEX *out, int32_t *amount) {
-int16_t	i, am;
-DSPCOMPLEX	tempBuf    [fracDecimator_C -> getOutputsize () + 10];
-
-//	if (--inCount > 0)
-//	   return false;
-//	inCount = intRatio;
-
-	if (!fracDecimator_C -> convert (v, tempBuf, &am)) 
+	if (!fracDecimator -> Pass (v, out))
 	   return false;
-	for (i = 0; i < am; i ++)
-	   out [i] = tempBuf [i];
-	*amount = am;
+	*amount = 1;
 	return true;
 }
 
 bool	FDecimator::doResample	(DSPFLOAT v,
 	                         DSPFLOAT *out, int32_t *amount) {
-int16_t	i, am;
-DSPCOMPLEX	tempBuf    [fracDecimator_C -> getOutputsize () + 10];
-
-//	if (--inCount > 0)
-//	   return false;
-//	inCount = intRatio;
-
-	if (!fracDecimator_C -> convert (DSPCOMPLEX (v, 0), tempBuf, &am)) 
+	if (!fracDecimator -> Pass (v, out))
 	   return false;
-	for (i = 0; i < am; i ++)
-	   out [i] = real (tempBuf [i]);
-	*amount = am;
+	*amount = 1;
 	return true;
 }
 
 int32_t	FDecimator::getOutputsize	(void) {
-	   return fracDecimator_C -> getOutputsize ();
+	   return 1;
 }
-
@@ -0,0 +1,116 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"sample-block.h"
+#include	"dsp-kernels.h"
+#include	<string.h>
+#include	<stdexcept>
+
+	sampleBlock::sampleBlock (int32_t size) {
+	this	-> size	= size;
+	this	-> count	= 0;
+	I	= allocate (size);
+	Q	= allocate (size);
+}
+
+	sampleBlock::~sampleBlock (void) {
+	free (I);
+	free (Q);
+}
+
+DSPFLOAT	*sampleBlock::allocate (int32_t n) {
+void	*p;
+//	round up to a whole number of vectors, so that kernels may
+//	read a little past count
+int32_t	bytes	= (n * sizeof (DSPFLOAT) + SAMPLE_ALIGNMENT - 1) &
+	                               ~(SAMPLE_ALIGNMENT - 1);
+
+	if (posix_memalign (&p, SAMPLE_ALIGNMENT, bytes) != 0)
+	   throw std::bad_alloc ();
+	memset (p, 0, bytes);
+	return (DSPFLOAT *)p;
+}
+
+void	sampleBlock::fromInterleaved (const DSPCOMPLEX *v, int32_t n) {
+int32_t	i;
+const DSPFLOAT	*f	= reinterpret_cast<const DSPFLOAT *>(v);
+
+	if (n > size)
+	   n = size;
+	for (i = 0; i < n; i ++) {
+	   I [i]	= f [2 * i];
+	   Q [i]	= f [2 * i + 1];
+	}
+	count	= n;
+}
+
+void	sampleBlock::toInterleaved (DSPCOMPLEX *v) {
+int32_t	i;
+DSPFLOAT	*f	= reinterpret_cast<DSPFLOAT *>(v);
+
+	for (i = 0; i < count; i ++) {
+	   f [2 * i]	= I [i];
+	   f [2 * i + 1]	= Q [i];
+	}
+}
+//
+//	the dongle delivers interleaved unsigned bytes, n is the
+//	number of I/Q pairs
+void	sampleBlock::fromU8 (const uint8_t *v, int32_t n) {
+	if (n > size)
+	   n = size;
+	getKernels () -> u8ToFloat (v, I, Q, n);
+	count	= n;
+}
+
+void	sampleBlock::scale (DSPFLOAT g) {
+int32_t	i;
+
+	for (i = 0; i < count; i ++) {
+	   I [i]	*= g;
+	   Q [i]	*= g;
+	}
+}
+
+void	sampleBlock::clear (void) {
+	memset (I, 0, count * sizeof (DSPFLOAT));
+	memset (Q, 0, count * sizeof (DSPFLOAT));
+}
+
+//
+//	the magnitudes are computed a stretch at a time in a small
+//	buffer on the stack
+DSPFLOAT	sampleBlock::maxMagnitude (void) {
+const dspKernels	*kernels	= getKernels ();
+DSPFLOAT	mag [256];
+int32_t	i, j;
+DSPFLOAT	m	= 0;
+
+	for (i = 0; i < count; i += 256) {
+	   int32_t n	= count - i < 256 ? count - i : 256;
+	   kernels -> magnitude (&I [i], &Q [i], mag, n);
+	   for (j = 0; j < n; j ++)
+	      m	= mag [j] > m ? mag [j] : m;
+	}
+	return m;
+}
+
@@ -53,43 +53,45 @@ int32_t	i;
 }
 //	Heavy code: executed millions of times
 //	we get all kinds of very strange values here, so
-//	testing over the whole domain is needed
+//	testing over the whole domain is needed.
+//	Note that a phase just below 0 (or just below 2 * M_PI in floats)
+//	would map onto index Rate, one past the table
 int32_t	SinCos::fromPhasetoIndex (DSPFLOAT Phase) {	
+int32_t	index;
 	if (Phase >= 0)
 	   return (int32_t (Phase * C)) % Rate;
-	else
-	   return Rate - (int32_t (- Phase * C)) % Rate;
+	index	= (int32_t (- Phase * C)) % Rate;
+	return index == 0 ? 0 : Rate - index;
 }
 
 DSPFLOAT	SinCos::getSin (DSPFLOAT Phase) {
-	if (Phase < 0) { 	// sin (-a) = - sin (a)
-	   if (Phase > - 2 * M_PI)
-	      return - imag (Table [(int32_t (- Phase  * C))]);
-	   return - imag (Table [(int32_t (- Phase  * C)) % Rate]);
-	}
-	if (Phase < 2 * M_PI)
-	   return imag (Table [int32_t (Phase * C)]);
-	return imag (Table [(int32_t (Phase * C)) % Rate]);
+	return imag (Table [fromPhasetoIndex (Phase)]);
 }
 
 DSPFLOAT	SinCos::getCos (DSPFLOAT Phase) {
-	if (Phase < 0)			// cos (-a) = cos (a)
-	   Phase = - Phase;
-	if (Phase < 2 * M_PI)
-	   return real (Table [(int32_t (Phase * C))]);
-	else
-	   return real (Table [(int32_t (Phase * C)) % Rate]);
+	return real (Table [fromPhasetoIndex (Phase)]);
 }
 
 DSPCOMPLEX	SinCos::getComplex (DSPFLOAT Phase) {
-	if (Phase >= 0) {
-	   if (Phase < 2 * M_PI)
-	      return Table [(int32_t (Phase * C))];
-	   else
-	      return Table [(int32_t (Phase * C)) % Rate];
-	}
-	else
-	   return Table [Rate - (int32_t ( - Phase * C)) % Rate];
+	return Table [fromPhasetoIndex (Phase)];
+}
+//
+//	The fixed point versions: a phase is a fraction of a full turn,
+//	so scaling it to the table size is a multiply and a shift,
+//	and no domain checking is needed at all
+int32_t	SinCos::fromPhasetoIndex (DSPPHASE Phase) {
+	return (int32_t)(((uint64_t)Phase * Rate) >> 32);
+}
+
+DSPFLOAT	SinCos::getSin (DSPPHASE Phase) {
+	return imag (Table [fromPhasetoIndex (Phase)]);
 }
 
+DSPFLOAT	SinCos::getCos (DSPPHASE Phase) {
+	return real (Table [fromPhasetoIndex (Phase)]);
+}
+
+DSPCOMPLEX	SinCos::getComplex (DSPPHASE Phase) {
+	return Table [fromPhasetoIndex (Phase)];
+}
 
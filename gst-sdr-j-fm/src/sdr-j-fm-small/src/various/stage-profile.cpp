@@ -0,0 +1,147 @@
+#
+/*
+ *    This file is part of the SDR-J (JSDR).
+ *    Many of the ideas as implemented in JSDR are derived from
+ *    other work, made available through the GNU general Public License. 
+ *    All copyrights of the original authors are recognized.
+ *
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef	HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include	"stage-profile.h"
+#include	<string.h>
+#include	<time.h>
+
+#ifdef	HAVE_SYS_SDT_H
+#include	<sys/sdt.h>
+#else
+#define	DTRACE_PROBE2(provider, probe, a, b)	\
+	   do { (void)(a); (void)(b); } while (0)
+#endif
+
+static
+const char *stageNames [stageProfile::STAGES] = {
+	"decimate", "scan", "demod", "levels", "multiplex", "audio", "rds"
+};
+
+	stageProfile::stageProfile (void) {
+	pthread_mutex_init (&lock, NULL);
+	memset (&data, 0, sizeof (data));
+	blockStart	= 0;
+	last		= 0;
+	memset (pending, 0, sizeof (pending));
+	memset (marked, 0, sizeof (marked));
+}
+
+	stageProfile::~stageProfile (void) {
+	pthread_mutex_destroy (&lock);
+}
+
+int64_t	stageProfile::now (void) {
+struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts. tv_sec * 1000000000 + ts. tv_nsec;
+}
+
+void	stageProfile::add (histogram *h, int64_t ns) {
+int16_t	k	= 0;
+
+	while ((k < PROFILE_BUCKETS - 1) && (ns >> (k + 1)) > 0)
+	   k ++;
+	h -> buckets [k] ++;
+	h -> count ++;
+	h -> total	+= ns;
+	if (ns > h -> max)
+	   h -> max = ns;
+}
+
+void	stageProfile::begin (void) {
+	blockStart = last = now ();
+}
+
+//	a stage that is skipped in a block is not marked, its (small)
+//	time goes to the next stage that is
+void	stageProfile::mark (Stage s) {
+int64_t	t	= now ();
+
+	pending [s]	+= t - last;
+	marked [s]	= true;
+	last		= t;
+}
+
+void	stageProfile::end (int32_t samples) {
+int16_t	i;
+
+	pthread_mutex_lock (&lock);
+	data. blocks ++;
+	for (i = 0; i < STAGES; i ++)
+	   if (marked [i])
+	      add (&data. stage [i], pending [i]);
+	add (&data. block, last - blockStart);
+	pthread_mutex_unlock (&lock);
+
+	for (i = 0; i < STAGES; i ++) {
+	   if (marked [i]) {
+	      int64_t ns	= pending [i];
+	      DTRACE_PROBE2 (sdrjfm, stage, i, ns);
+	   }
+	   pending [i]	= 0;
+	   marked [i]	= false;
+	}
+	int64_t ns	= last - blockStart;
+	DTRACE_PROBE2 (sdrjfm, block, samples, ns);
+}
+
+void	stageProfile::get (snapshot *s) {
+	pthread_mutex_lock (&lock);
+	*s	= data;
+	pthread_mutex_unlock (&lock);
+}
+
+void	stageProfile::reset (void) {
+	pthread_mutex_lock (&lock);
+	memset (&data, 0, sizeof (data));
+	pthread_mutex_unlock (&lock);
+}
+
+const char	*stageProfile::name (int s) {
+	if ((s < 0) || (s >= STAGES))
+	   return "block";
+	return stageNames [s];
+}
+
+int64_t	stageProfile::percentile (const histogram *h, double fraction) {
+int64_t	needed	= (int64_t)(fraction * h -> count + 0.5);
+int64_t	seen	= 0;
+int16_t	k;
+
+	if (h -> count == 0)
+	   return 0;
+	if (needed < 1)
+	   needed = 1;
+	for (k = 0; k < PROFILE_BUCKETS - 1; k ++) {
+	   seen += h -> buckets [k];
+	   if (seen >= needed)
+	      break;
+	}
+	int64_t bound	= ((int64_t)2 << k) - 1;
+	return bound < h -> max ? bound : h -> max;
+}
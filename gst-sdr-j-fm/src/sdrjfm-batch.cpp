@@ -0,0 +1,166 @@
+/* Decodes any number of I/Q recordings, as fast as the machine
+ * allows, on a pool of worker threads.
+ *
+ * Every recording is decoded by a chain of its own, for a recording
+ * "dir/name.cu8" the audio is written to "name.wav" and the station
+ * labels and radio texts to "name.rds", in the output directory
+ * (the directory of the recording by default). The recordings should
+ * be at the input rate of the processor, 1058400 S/s.
+ *
+ * With -S a long recording is split in that many segments, decoded
+ * in parallel, each starting a warm-up (-w seconds, 4 by default)
+ * ahead of its part, and the parts are stitched together. With -V
+ * the stitched output is compared with a single threaded decode: the
+ * SNR of the audio, overall and in the worst second after a
+ * boundary, decides; the station labels and radio texts that differ
+ * are only counted, on a noisy signal they need not be the same.
+ * A failed validation makes the exit status non zero.
+ *
+ * Per recording a line with the seconds of audio decoded, the time
+ * taken and the real time factor is printed.
+ *
+ * usage: sdrjfm-batch [-j workers] [-o directory] [-m] [-f]
+ *                     [-r none|rds1|rds2] [-d decoder]
+ *                     [-S segments [-w seconds] [-V]] recording...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include "batch-decoder.h"
+#include "fm-demodulator.h"
+#include "rds-decoder.h"
+#include <gst/gst.h>
+
+GST_DEBUG_CATEGORY (sdrjfm_debug);
+
+static void
+usage (const char *name)
+{
+  fprintf (stderr,
+      "usage: %s [-j workers] [-o directory] [-m] [-f]\n"
+      "       [-r none|rds1|rds2] [-d fm1decoder..fm5decoder]\n"
+      "       [-S segments [-w seconds] [-V]] recording...\n", name);
+}
+
+/* the output base name: the recording without its extension, in
+ * the output directory if one is given */
+static std::string
+output_base (const std::string &recording, const char *directory)
+{
+  std::string base = recording;
+  size_t slash = base.rfind ('/');
+  size_t dot = base.rfind ('.');
+
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+    base.erase (dot);
+  if (directory != NULL) {
+    if (slash != std::string::npos)
+      base.erase (0, slash + 1);
+    base = std::string (directory) + "/" + base;
+  }
+  return base;
+}
+
+int
+main (int argc, char **argv)
+{
+  batchSettings settings;
+  const char *directory = NULL;
+  long workers = sysconf (_SC_NPROCESSORS_ONLN);
+  double audio = 0, elapsed;
+  struct timespec start, end;
+  int opt, failed;
+  size_t i;
+
+  gst_init (&argc, &argv);
+  GST_DEBUG_CATEGORY_INIT (sdrjfm_debug, "sdrjfm", 0, "SDR-J FM plugin");
+
+  while ((opt = getopt (argc, argv, "j:o:mfr:d:S:w:V")) != -1) {
+    switch (opt) {
+      case 'j':
+        workers = atoi (optarg);
+        break;
+      case 'o':
+        directory = optarg;
+        break;
+      case 'm':
+        settings.stereo = false;
+        break;
+      case 'f':
+        settings.floatSamples = true;
+        break;
+      case 'r':
+        if (strcmp (optarg, "none") == 0)
+          settings.rdsMode = rdsDecoder::NO_RDS;
+        else if (strcmp (optarg, "rds1") == 0)
+          settings.rdsMode = rdsDecoder::RDS1;
+        else if (strcmp (optarg, "rds2") == 0)
+          settings.rdsMode = rdsDecoder::RDS2;
+        else {
+          usage (argv[0]);
+          return 1;
+        }
+        break;
+      case 'd':
+        if (strncmp (optarg, "fm", 2) != 0 || optarg[2] < '1' ||
+            optarg[2] > '5' || strcmp (optarg + 3, "decoder") != 0) {
+          usage (argv[0]);
+          return 1;
+        }
+        settings.decoder = fm_Demodulator::FM1DECODER + optarg[2] - '1';
+        break;
+      case 'S':
+        settings.segments = atoi (optarg);
+        break;
+      case 'w':
+        settings.warmUp = atof (optarg);
+        break;
+      case 'V':
+        settings.validate = true;
+        break;
+      default:
+        usage (argv[0]);
+        return 1;
+    }
+  }
+  if (optind >= argc || workers < 1 || settings.segments < 1 ||
+      settings.warmUp < 0) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  batchPool pool (workers, settings);
+  for (; optind < argc; optind++)
+    pool.add (argv[optind], output_base (argv[optind], directory));
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  failed = pool.run ();
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  elapsed = end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+  const std::vector<batchPool::result> &results = pool.results ();
+  for (i = 0; i < results.size (); i++) {
+    const batchPool::result &r = results[i];
+    if (r.ok)
+      printf ("%s: %.1f s of audio in %.2f s (%.1fx real time)\n",
+          r.input.c_str (), r.audioSeconds, r.elapsed,
+          r.audioSeconds / r.elapsed);
+    else
+      printf ("%s: failed\n", r.input.c_str ());
+    if (r.checked)
+      printf ("  validation %s: %lld/%lld frames, SNR %.1f dB, worst "
+          "boundary %.1f dB, max error %g, %d of %d RDS events differ\n",
+          r.check.passed ? "passed" : "FAILED",
+          (long long) r.check.stitchedFrames, (long long) r.check.frames,
+          r.check.snr, r.check.worstSnr, r.check.maxError,
+          r.check.rdsMismatches, r.check.rdsEvents);
+    audio += r.audioSeconds;
+  }
+  printf ("%zu recordings, %.1f s of audio in %.2f s on %ld workers "
+      "(%.1fx real time)\n", results.size (), audio, elapsed, workers,
+      audio / elapsed);
+
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,947 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+GST_DEBUG_CATEGORY (sdrjfm_debug);
+#define GST_CAT_DEFAULT sdrjfm_debug
+
+/* These tests run the plugin on the built in signal generator, rather
+ * than on a dongle, so they need no hardware and know what to expect.
+ */
+
+#define STATION_FREQ          97100000
+#define STATION_LABEL        "GEN TEST"
+#define RADIO_TEXT           "Generated radio text"
+#define LEFT_TONE                 1000
+#define RIGHT_TONE                3000
+#define AUDIO_RATE               44100
+#define PROGRAMME_ID            0xc201
+#define MPX_RATE      (4 * AUDIO_RATE)
+#define IQ_RATE      (24 * AUDIO_RATE)
+/* where the recording starts in the segment given to the demodulator */
+#define DEMOD_START   (10 * GST_SECOND)
+/* how fast the pipeline clock runs against the generator, in ppm, and
+ * the health messages in a row the radio has to follow it for */
+#define CLOCK_SKEW                 500
+#define RATE_SETTLED                 5
+
+typedef struct _TestData TestData;
+struct _TestData
+{
+  GstElement *pipeline;
+  GstElement *fmsrc;
+  GMainLoop *loop;
+  gint timeout;
+  const gchar *expect_label;
+  const gchar *expect_text;
+  gint expect_station;
+  gint found_station;
+  gboolean expect_health;
+  /* the crystal correction to wait for in the health, 0 for any */
+  gint expect_correction;
+  GstStructure *health;
+  /* the audio rate correction to wait for, 0 for none, the health
+   * messages in a row that had it, and the furthest the audio in the
+   * radio got from the depth */
+  gdouble expect_rate_correction;
+  gint rate_settled;
+  gint health_messages;
+  gint depth_frames;
+  gint max_fill_error;
+  gboolean expect_reception;
+  /* times of the radio text changes, in us, and the shortest gap */
+  gint64 last_text_change;
+  gint64 min_text_change_gap;
+  gint text_changes;
+  GstStructure *reception;
+  /* the RDS groups with the expected programme identification, and
+   * whether a tag event had the station label, from the streaming
+   * threads */
+  gint rds_groups;
+  gint rds_tagged;
+  /* the samples of the multiplex received */
+  gint64 mpx_samples;
+  /* the audio buffers received, and where the next one should start */
+  gint buffers;
+  GstClockTime next_pts;
+  /* whether the audio is 16-bit, rather than float */
+  gboolean s16;
+  /* Goertzel filters for both tones, on both channels */
+  gdouble coeff[2];
+  gdouble state[2][2][2];
+  gint64 skip;
+  gint64 count;
+  gint64 needed;
+};
+
+/* Follows the trim of the audio rate in the health, until it stayed
+ * within a fifth of the expected one for RATE_SETTLED messages, and
+ * how far the audio in the radio got from the depth meanwhile */
+static void
+follow_rate_correction (TestData *data, const GstStructure *s)
+{
+  gdouble correction = 0;
+  gint fill = 0;
+
+  gst_structure_get_double (s, "audio-rate-correction", &correction);
+  gst_structure_get_int (s, "audio-fill", &fill);
+
+  /* the first one comes as the radio fills up */
+  if (data->health_messages++ > 0)
+    data->max_fill_error = MAX (data->max_fill_error,
+				ABS (fill - data->depth_frames));
+
+  if (ABS (correction - data->expect_rate_correction)
+      <= ABS (data->expect_rate_correction) / 5)
+    data->rate_settled++;
+  else
+    data->rate_settled = 0;
+
+  if (data->rate_settled == RATE_SETTLED && data->health == NULL)
+    {
+      data->health = gst_structure_copy (s);
+      g_main_loop_quit (data->loop);
+    }
+}
+
+static gboolean
+bus_cb (GstBus *bus, GstMessage *message, gpointer user_data)
+{
+  TestData *data = user_data;
+  GError *error = NULL;
+
+  switch (message->type) {
+    case GST_MESSAGE_STATE_CHANGED:
+      if (GST_MESSAGE_SRC (message) == GST_OBJECT (data->pipeline)) {
+        GstState state;
+        gst_message_parse_state_changed (message, NULL, &state, NULL);
+        if (state == GST_STATE_PLAYING && data->expect_station)
+          g_signal_emit_by_name (data->fmsrc, "seek-up");
+      }
+      break;
+
+    case GST_MESSAGE_ELEMENT:
+      if (GST_MESSAGE_SRC (message) == GST_OBJECT (data->fmsrc)) {
+        const GstStructure *s = gst_message_get_structure (message);
+
+	if (gst_structure_has_name (s, "sdrjfmsrc-station-found"))
+	  {
+	    gst_structure_get_int (s, "frequency", &data->found_station);
+	    GST_DEBUG_OBJECT (data->fmsrc, "Found station at %d",
+			      data->found_station);
+	    if (data->expect_station)
+	      g_main_loop_quit (data->loop);
+	  }
+	else if (gst_structure_has_name (s, "sdrjfmsrc-rds-station-label-complete"))
+	  {
+	    const gchar *label = gst_structure_get_string (s, "station-label");
+	    GST_DEBUG_OBJECT (data->fmsrc, "RDS station label complete: `%s'", label);
+	    if (data->expect_label && g_strcmp0 (label, data->expect_label) == 0)
+	      g_main_loop_quit (data->loop);
+	  }
+	else if (gst_structure_has_name (s, "sdrjfmsrc-health"))
+	  {
+	    gint correction = 0;
+	    GST_DEBUG_OBJECT (data->fmsrc, "Health: %" GST_PTR_FORMAT, s);
+	    gst_structure_get_int (s, "crystal-correction", &correction);
+	    if (data->expect_health && data->health == NULL
+		&& (data->expect_correction == 0
+		    || correction == data->expect_correction))
+	      {
+		data->health = gst_structure_copy (s);
+		g_main_loop_quit (data->loop);
+	      }
+	    if (data->expect_rate_correction != 0)
+	      follow_rate_correction (data, s);
+	  }
+	else if (gst_structure_has_name (s, "sdrjfmsrc-reception"))
+	  {
+	    gboolean stereo = FALSE, synchronized = FALSE;
+	    GST_DEBUG_OBJECT (data->fmsrc, "Reception: %" GST_PTR_FORMAT, s);
+	    gst_structure_get_boolean (s, "stereo", &stereo);
+	    gst_structure_get_boolean (s, "rds-synchronized", &synchronized);
+	    /* wait for the pilot and the RDS to be found */
+	    if (data->expect_reception && data->reception == NULL
+		&& stereo && synchronized)
+	      {
+		data->reception = gst_structure_copy (s);
+		g_main_loop_quit (data->loop);
+	      }
+	  }
+	else if (gst_structure_has_name (s, "sdrjfmsrc-rds-radio-text-change"))
+	  {
+	    gint64 now = g_get_monotonic_time ();
+	    if (data->text_changes > 0
+		&& now - data->last_text_change < data->min_text_change_gap)
+	      data->min_text_change_gap = now - data->last_text_change;
+	    data->last_text_change = now;
+	    data->text_changes++;
+	  }
+	else if (gst_structure_has_name (s, "sdrjfmsrc-rds-radio-text-complete"))
+	  {
+	    const gchar *text = gst_structure_get_string (s, "radio-text");
+	    GST_DEBUG_OBJECT (data->fmsrc, "RDS radio text complete: `%s'", text);
+	    if (data->expect_text && g_strcmp0 (text, data->expect_text) == 0)
+	      g_main_loop_quit (data->loop);
+	  }
+      }
+      break;
+
+    case GST_MESSAGE_ERROR:
+      gst_message_parse_error (message, &error, NULL);
+      g_assert_no_error (error);
+      break;
+
+    case GST_MESSAGE_WARNING:
+      gst_message_parse_warning (message, &error, NULL);
+      GST_WARNING ("Warning: `%s'", error->message);
+      if (strcmp (error->message, "Can't record audio fast enough") == 0)
+	break;
+      g_assert_no_error (error);
+      break;
+
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+static void
+handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad, gpointer user_data)
+{
+  TestData *data = user_data;
+  GstMapInfo map;
+  const gfloat *samples;
+  const gint16 *s16;
+  gsize i, n;
+  gint tone, channel;
+
+  if (data->count >= data->needed)
+    return;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  samples = (const gfloat *) map.data;
+  s16 = (const gint16 *) map.data;
+  n = map.size / (2 * (data->s16 ? sizeof (gint16) : sizeof (gfloat)));
+
+  for (i = 0; i < n && data->count < data->needed; i++)
+    {
+      /* let the pilot pll lock first */
+      if (data->skip > 0)
+        {
+          data->skip--;
+          continue;
+        }
+      for (tone = 0; tone < 2; tone++)
+        for (channel = 0; channel < 2; channel++)
+          {
+            gdouble *s = data->state[tone][channel];
+            gdouble x = data->s16 ? s16[2 * i + channel] / 32768.0
+                : samples[2 * i + channel];
+            gdouble v = x + data->coeff[tone] * s[0] - s[1];
+            s[1] = s[0];
+            s[0] = v;
+          }
+      data->count++;
+    }
+
+  gst_buffer_unmap (buffer, &map);
+
+  if (data->count >= data->needed)
+    g_main_loop_quit (data->loop);
+}
+
+static gdouble
+tone_level (TestData *data, gint tone, gint channel)
+{
+  gdouble *s = data->state[tone][channel];
+
+  return sqrt (s[0] * s[0] + s[1] * s[1] - data->coeff[tone] * s[0] * s[1]);
+}
+
+/* Sets up the radio on the generator, with the audio in \a caps, or
+ * as the source prefers for NULL */
+static TestData *
+tearup_caps (const gchar *generator, gint freq, gboolean handoffs,
+    const gchar *caps)
+{
+  GError *error = NULL;
+  TestData *data = g_slice_new0 (TestData);
+  GstElement *sink;
+  GstBus *bus;
+  gchar *description;
+
+  description = g_strdup_printf ("sdrjfmsrc name=fmsrc ! %s ! queue"
+      " ! fakesink name=sink", caps ? caps : "identity");
+  data->pipeline = gst_parse_launch (description, &error);
+  g_free (description);
+  g_assert_no_error (error);
+  g_assert(data->pipeline != NULL);
+
+  data->fmsrc = gst_bin_get_by_name (GST_BIN (data->pipeline), "fmsrc");
+  g_assert(data->fmsrc != NULL);
+
+  g_object_set (data->fmsrc,
+      "input-generator", generator,
+      "frequency", freq,
+      NULL);
+
+  if (handoffs)
+    {
+      sink = gst_bin_get_by_name (GST_BIN (data->pipeline), "sink");
+      g_object_set (sink, "signal-handoffs", TRUE, NULL);
+      g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), data);
+      g_object_unref (sink);
+    }
+
+  data->timeout = 60;
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (data->pipeline));
+  gst_bus_add_watch (bus, bus_cb, data);
+  g_object_unref (bus);
+
+  data->loop = g_main_loop_new (NULL, FALSE);
+
+  return data;
+}
+
+static TestData *
+tearup (const gchar *generator, gint freq, gboolean handoffs)
+{
+  return tearup_caps (generator, freq, handoffs, NULL);
+}
+
+static void
+teardown (TestData *data)
+{
+  gst_element_set_state (data->pipeline, GST_STATE_NULL);
+  g_object_unref (data->fmsrc);
+  g_object_unref (data->pipeline);
+  g_main_loop_unref (data->loop);
+  if (data->health)
+    gst_structure_free (data->health);
+  if (data->reception)
+    gst_structure_free (data->reception);
+  g_slice_free (TestData, data);
+}
+
+static gboolean
+test_timed_out_cb (gpointer user_data)
+{
+  g_assert ("Test timed out" == 0);
+  return FALSE;
+}
+
+static void
+test_run (TestData *data)
+{
+  guint timeout;
+
+  timeout = g_timeout_add_seconds (data->timeout, test_timed_out_cb, data);
+
+  gst_element_set_state (data->pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (data->loop);
+  g_source_remove (timeout);
+}
+
+static void
+test_rds_station_label ()
+{
+  GST_DEBUG ("Starting generated RDS station label test");
+  TestData *data = tearup ("frequency=97100000;ps=" STATION_LABEL
+			   ";rt=" RADIO_TEXT, STATION_FREQ, FALSE);
+  data->expect_label = STATION_LABEL;
+  test_run (data);
+  teardown (data);
+}
+
+static void
+test_rds_radio_text ()
+{
+  GST_DEBUG ("Starting generated RDS radio text test");
+  TestData *data = tearup ("frequency=97100000;ps=" STATION_LABEL
+			   ";rt=" RADIO_TEXT, STATION_FREQ, FALSE);
+  data->expect_text = RADIO_TEXT;
+  test_run (data);
+  teardown (data);
+}
+
+static void
+test_rds_coalesced ()
+{
+  GST_DEBUG ("Starting generated RDS coalescing test");
+  TestData *data = tearup ("frequency=97100000;ps=" STATION_LABEL
+			   ";rt=" RADIO_TEXT, STATION_FREQ, FALSE);
+  g_object_set (data->fmsrc, "rds-window", 500, NULL);
+  data->expect_text = RADIO_TEXT;
+  data->min_text_change_gap = G_MAXINT64;
+  test_run (data);
+
+  /* the text comes in segments of four characters, at least one change
+   * is posted and no two of them closer than the window, with some
+   * slack for the main loop */
+  GST_DEBUG ("%d radio text changes, at least %" G_GINT64_FORMAT " us apart",
+	     data->text_changes, data->min_text_change_gap);
+  g_assert_cmpint (data->text_changes, >, 0);
+  g_assert_cmpint (data->min_text_change_gap, >=, 400000);
+  teardown (data);
+}
+
+static void
+test_seek ()
+{
+  GST_DEBUG ("Starting generated seek test");
+  TestData *data = tearup ("frequency=97100000;rds=0;snr=30",
+			   STATION_FREQ - 600000, FALSE);
+  data->expect_station = STATION_FREQ;
+  test_run (data);
+  g_assert_cmpint (data->found_station, ==, STATION_FREQ);
+  teardown (data);
+}
+
+/* Checks the tones the Goertzel filters found: the left tone is
+ * stronger in the left channel, the right one in the right channel, by
+ * at least 6 dB */
+static void
+check_separation (TestData *data)
+{
+  gdouble left, right;
+
+  left = tone_level (data, 0, 0);
+  right = tone_level (data, 0, 1);
+  GST_DEBUG ("%d Hz tone: left %f, right %f", LEFT_TONE, left, right);
+  g_assert_cmpfloat (left, >, 2 * right);
+
+  left = tone_level (data, 1, 0);
+  right = tone_level (data, 1, 1);
+  GST_DEBUG ("%d Hz tone: left %f, right %f", RIGHT_TONE, left, right);
+  g_assert_cmpfloat (right, >, 2 * left);
+}
+
+/* Checks the separation of the channels, with the audio in \a caps at
+ * \a rate */
+static void
+check_stereo (const gchar *caps, gint rate, gboolean s16)
+{
+  TestData *data = tearup_caps ("frequency=97100000;left=1000;right=3000;rds=0",
+				STATION_FREQ, TRUE, caps);
+  data->s16 = s16;
+  data->coeff[0] = 2 * cos (2 * G_PI * LEFT_TONE / rate);
+  data->coeff[1] = 2 * cos (2 * G_PI * RIGHT_TONE / rate);
+  data->skip = rate;
+  data->needed = 2 * rate;
+  test_run (data);
+  check_separation (data);
+  teardown (data);
+}
+
+static void
+test_stereo ()
+{
+  GST_DEBUG ("Starting generated stereo separation test");
+  check_stereo (NULL, AUDIO_RATE, FALSE);
+}
+
+static void
+test_stereo_negotiated ()
+{
+  GST_DEBUG ("Starting generated stereo separation test, 16-bit at 48 kHz");
+  check_stereo ("audio/x-raw,format=" GST_AUDIO_NE (S16) ",rate=48000,channels=2",
+		48000, TRUE);
+  GST_DEBUG ("Starting generated stereo separation test, at 32 kHz");
+  check_stereo ("audio/x-raw,rate=32000", 32000, FALSE);
+}
+
+static void
+test_health ()
+{
+  static const gchar *counters[] = {
+    "usb-short-transfers", "usb-dropped-samples", "audio-dropped-frames",
+    "audio-underruns", "recorder-dropped-blocks"
+  };
+  GstStructure *health;
+  gint size;
+  gdouble correction;
+  guint i;
+
+  GST_DEBUG ("Starting generated health counters test");
+  TestData *data = tearup ("frequency=97100000;rds=0", STATION_FREQ, FALSE);
+  g_object_set (data->fmsrc, "health-interval", 200, NULL);
+  data->expect_health = TRUE;
+  test_run (data);
+
+  /* the generator has no input buffer, the audio sink does */
+  for (i = 0; i < G_N_ELEMENTS (counters); i++)
+    g_assert (gst_structure_has_field_typed (data->health, counters[i],
+		  G_TYPE_UINT64));
+  g_assert (gst_structure_get_int (data->health, "input-size", &size));
+  g_assert_cmpint (size, ==, 0);
+  g_assert (gst_structure_get_int (data->health, "audio-size", &size));
+  g_assert_cmpint (size, >, 0);
+  /* the generator runs on the system clock, as the pipeline does */
+  g_assert (gst_structure_get_double (data->health, "audio-rate-correction",
+				      &correction));
+  g_assert_cmpfloat (ABS (correction), <=, 1000);
+
+  g_object_get (data->fmsrc, "health", &health, NULL);
+  g_assert (health != NULL);
+  g_assert (gst_structure_has_name (health, "sdrjfmsrc-health"));
+  gst_structure_free (health);
+
+  teardown (data);
+}
+
+static void
+test_rate_skew ()
+{
+  GstClock *clock;
+  GstClockTime now;
+  gdouble correction;
+  guint depth;
+
+  GST_DEBUG ("Starting audio rate following test on a skewed clock");
+  TestData *data = tearup ("frequency=97100000;rds=0", STATION_FREQ, FALSE);
+  g_object_set (data->fmsrc, "health-interval", 1000, NULL);
+  g_object_get (data->fmsrc, "audio-depth", &depth, NULL);
+
+  /* the generator is paced by the monotonic time, the audio is read
+   * at the rate of a clock running fast against it, the radio has to
+   * make that much more to keep the depth */
+  clock = GST_CLOCK (g_object_new (GST_TYPE_SYSTEM_CLOCK,
+				   "name", "SkewedClock", NULL));
+  gst_object_ref_sink (clock);
+  now = gst_clock_get_internal_time (clock);
+  gst_clock_set_calibration (clock, now, now, 1000000 + CLOCK_SKEW, 1000000);
+  gst_pipeline_use_clock (GST_PIPELINE (data->pipeline), clock);
+  gst_object_unref (clock);
+
+  data->expect_rate_correction = CLOCK_SKEW;
+  data->depth_frames = depth * AUDIO_RATE / 1000;
+  /* the loop takes about half a minute to settle */
+  data->timeout = 120;
+  test_run (data);
+
+  g_assert (gst_structure_get_double (data->health, "audio-rate-correction",
+				      &correction));
+  GST_DEBUG ("Rate correction %f ppm, audio fill at most %d frames from %d",
+	     correction, data->max_fill_error, data->depth_frames);
+  g_assert_cmpfloat (ABS (correction - CLOCK_SKEW), <=, CLOCK_SKEW / 5);
+  g_assert_cmpint (data->max_fill_error, <, data->depth_frames / 2);
+
+  teardown (data);
+}
+
+static void
+test_crystal ()
+{
+  gint correction;
+
+  GST_DEBUG ("Starting generated crystal correction test");
+  /* the generator's crystal is off by as much as a cheap dongle's,
+   * the health shows the correction once the radio found it */
+  TestData *data = tearup ("frequency=97100000;rds=0;ppm=57", STATION_FREQ,
+			   FALSE);
+  g_object_set (data->fmsrc, "health-interval", 500, NULL);
+  data->expect_health = TRUE;
+  data->expect_correction = 57;
+  test_run (data);
+
+  g_assert (gst_structure_get_int (data->health, "crystal-correction",
+				   &correction));
+  g_assert_cmpint (correction, ==, 57);
+
+  teardown (data);
+}
+
+static void
+test_reception ()
+{
+  guint64 sequence;
+  gdouble strength;
+  gint groups;
+
+  GST_DEBUG ("Starting generated reception telemetry test");
+  TestData *data = tearup ("frequency=97100000;ps=" STATION_LABEL,
+			   STATION_FREQ, FALSE);
+  data->expect_reception = TRUE;
+  test_run (data);
+
+  g_assert (gst_structure_has_field_typed (data->reception, "sequence",
+					  G_TYPE_UINT64));
+  sequence = g_value_get_uint64 (gst_structure_get_value (data->reception,
+							  "sequence"));
+  g_assert_cmpuint (sequence, >, 0);
+  g_assert (gst_structure_get_double (data->reception, "pilot-strength",
+				      &strength));
+  g_assert_cmpfloat (strength, >, 3);
+  g_assert (gst_structure_get_int (data->reception, "rds-groups", &groups));
+  g_assert_cmpint (groups, >, 0);
+
+  teardown (data);
+}
+
+static void
+rds_done (TestData *data)
+{
+  if (g_atomic_int_get (&data->rds_tagged)
+      && g_atomic_int_get (&data->rds_groups) > 0)
+    g_main_loop_quit (data->loop);
+}
+
+static GstPadProbeReturn
+tag_probe_cb (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  TestData *data = user_data;
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstTagList *tags;
+  gchar *label = NULL;
+  guint pi;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_TAG)
+    return GST_PAD_PROBE_OK;
+
+  gst_event_parse_tag (event, &tags);
+  GST_DEBUG ("Tags: %" GST_PTR_FORMAT, tags);
+  g_assert (gst_tag_list_get_uint (tags, "rds-programme-identification",
+				   &pi));
+  g_assert_cmpuint (pi, ==, PROGRAMME_ID);
+  if (gst_tag_list_get_string (tags, "rds-station-label", &label)
+      && strcmp (label, STATION_LABEL) == 0)
+    g_atomic_int_set (&data->rds_tagged, TRUE);
+  g_free (label);
+
+  rds_done (data);
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+rds_handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad,
+		gpointer user_data)
+{
+  TestData *data = user_data;
+  GstMapInfo map;
+
+  /* one group a buffer, the blocks A to D */
+  g_assert (GST_BUFFER_PTS_IS_VALID (buffer));
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  g_assert_cmpuint (map.size, ==, 8);
+  if (GST_READ_UINT16_BE (map.data) == PROGRAMME_ID)
+    g_atomic_int_inc (&data->rds_groups);
+  gst_buffer_unmap (buffer, &map);
+
+  rds_done (data);
+}
+
+static void
+test_rds_tags ()
+{
+  GstElement *queue, *sink;
+  GstPad *rds, *pad;
+
+  GST_DEBUG ("Starting generated RDS tags and groups test");
+  TestData *data = tearup ("frequency=97100000;pi=0xc201;ps=" STATION_LABEL,
+			   STATION_FREQ, FALSE);
+
+  sink = gst_bin_get_by_name (GST_BIN (data->pipeline), "sink");
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+		     tag_probe_cb, data, NULL);
+  gst_object_unref (pad);
+  g_object_unref (sink);
+
+  queue = gst_element_factory_make ("queue", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "signal-handoffs", TRUE, "async", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (rds_handoff_cb), data);
+  gst_bin_add_many (GST_BIN (data->pipeline), queue, sink, NULL);
+  g_assert (gst_element_link (queue, sink));
+
+  rds = gst_element_get_request_pad (data->fmsrc, "rds");
+  g_assert (rds != NULL);
+  pad = gst_element_get_static_pad (queue, "sink");
+  g_assert_cmpint (gst_pad_link (rds, pad), ==, GST_PAD_LINK_OK);
+  gst_object_unref (pad);
+
+  test_run (data);
+
+  gst_element_set_state (data->pipeline, GST_STATE_NULL);
+  gst_element_release_request_pad (data->fmsrc, rds);
+  gst_object_unref (rds);
+
+  teardown (data);
+}
+
+static void
+mpx_handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad,
+		gpointer user_data)
+{
+  TestData *data = user_data;
+
+  g_assert (GST_BUFFER_PTS_IS_VALID (buffer));
+  data->mpx_samples += gst_buffer_get_size (buffer) / sizeof (gfloat);
+  /* half a second of it */
+  if (data->mpx_samples >= MPX_RATE / 2)
+    g_main_loop_quit (data->loop);
+}
+
+static void
+test_mpx ()
+{
+  GstElement *queue, *sink;
+  GstPad *mpx, *pad;
+  GstCaps *caps;
+  GstStructure *s;
+  gint rate, channels;
+
+  GST_DEBUG ("Starting generated multiplex test");
+  TestData *data = tearup ("frequency=97100000;rds=0", STATION_FREQ, FALSE);
+
+  queue = gst_element_factory_make ("queue", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "signal-handoffs", TRUE, "async", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (mpx_handoff_cb), data);
+  gst_bin_add_many (GST_BIN (data->pipeline), queue, sink, NULL);
+  g_assert (gst_element_link (queue, sink));
+
+  mpx = gst_element_get_request_pad (data->fmsrc, "mpx");
+  g_assert (mpx != NULL);
+  pad = gst_element_get_static_pad (queue, "sink");
+  g_assert_cmpint (gst_pad_link (mpx, pad), ==, GST_PAD_LINK_OK);
+  gst_object_unref (pad);
+
+  test_run (data);
+
+  caps = gst_pad_get_current_caps (mpx);
+  g_assert (caps != NULL);
+  s = gst_caps_get_structure (caps, 0);
+  g_assert (gst_structure_get_int (s, "rate", &rate));
+  g_assert_cmpint (rate, ==, MPX_RATE);
+  g_assert (gst_structure_get_int (s, "channels", &channels));
+  g_assert_cmpint (channels, ==, 1);
+  gst_caps_unref (caps);
+
+  gst_element_set_state (data->pipeline, GST_STATE_NULL);
+  gst_element_release_request_pad (data->fmsrc, mpx);
+  gst_object_unref (mpx);
+
+  teardown (data);
+}
+
+static void
+timestamps_handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad,
+		       gpointer user_data)
+{
+  TestData *data = user_data;
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  /* the audio captured before playing is all at 0 */
+  g_assert (GST_BUFFER_PTS_IS_VALID (buffer));
+  if (++data->buffers > 10)
+    g_assert_cmpint (ABS (GST_CLOCK_DIFF (data->next_pts, pts)), <,
+		     GST_MSECOND);
+  data->next_pts = pts + GST_BUFFER_DURATION (buffer);
+
+  if (data->buffers >= 200)
+    g_main_loop_quit (data->loop);
+}
+
+static void
+test_capture_clock ()
+{
+  GstElement *sink;
+  GstClock *clock;
+
+  GST_DEBUG ("Starting generated capture timestamps and clock test");
+  TestData *data = tearup ("frequency=97100000;rds=0", STATION_FREQ, FALSE);
+  g_object_set (data->fmsrc, "provide-clock", TRUE, NULL);
+
+  sink = gst_bin_get_by_name (GST_BIN (data->pipeline), "sink");
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (timestamps_handoff_cb), data);
+  g_object_unref (sink);
+
+  test_run (data);
+
+  /* the pipeline runs on the samples the generator counts */
+  clock = gst_pipeline_get_clock (GST_PIPELINE (data->pipeline));
+  g_assert (clock != NULL);
+  g_assert_cmpstr (GST_OBJECT_NAME (clock), ==, "GstSdrjfmSrcClock");
+  gst_object_unref (clock);
+
+  teardown (data);
+}
+
+/* Writes \a seconds of a station at the tuned frequency to \a location,
+ * as the dongle gives it: the tones on the left and the right channel
+ * and the pilot, at the levels of the generator, without RDS */
+static void
+write_iq_recording (const gchar *location, gint seconds)
+{
+  GError *error = NULL;
+  gsize i, n = (gsize) seconds * IQ_RATE;
+  guint8 *samples = g_malloc (2 * n);
+  gdouble t, left, right, pilot, m, phase = 0;
+
+  for (i = 0; i < n; i++)
+    {
+      t = (gdouble) i / IQ_RATE;
+      left = sin (2 * G_PI * LEFT_TONE * t);
+      right = sin (2 * G_PI * RIGHT_TONE * t);
+      pilot = 2 * G_PI * 19000 * t;
+      m = 0.40 * (left + right) + 0.40 * (left - right) * sin (2 * pilot)
+          + 0.10 * sin (pilot);
+      phase = fmod (phase + 2 * G_PI * 75000 * m / IQ_RATE, 2 * G_PI);
+      samples[2 * i] = (guint8) lround (128 + 100 * cos (phase));
+      samples[2 * i + 1] = (guint8) lround (128 + 100 * sin (phase));
+    }
+
+  g_file_set_contents (location, (const gchar *) samples, 2 * n, &error);
+  g_assert_no_error (error);
+  g_free (samples);
+}
+
+/* Gives the recording a time segment and timestamps, as a live source
+ * would, from the offsets filesrc puts on the buffers */
+static GstPadProbeReturn
+demod_probe_cb (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+      GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+      buffer = gst_buffer_make_writable (buffer);
+      GST_BUFFER_PTS (buffer) = DEMOD_START
+          + gst_util_uint64_scale (GST_BUFFER_OFFSET (buffer) / 2,
+                                   GST_SECOND, IQ_RATE);
+      GST_PAD_PROBE_INFO_DATA (info) = buffer;
+    }
+  else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info))
+	   == GST_EVENT_SEGMENT)
+    {
+      GstSegment segment;
+
+      gst_segment_init (&segment, GST_FORMAT_TIME);
+      segment.start = segment.time = segment.position = DEMOD_START;
+      gst_event_unref (GST_PAD_PROBE_INFO_EVENT (info));
+      GST_PAD_PROBE_INFO_DATA (info) = gst_event_new_segment (&segment);
+    }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+demod_handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad,
+		  gpointer user_data)
+{
+  TestData *data = user_data;
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+  const GstSegment *segment;
+  GstEvent *event;
+
+  /* the audio is in the segment of the samples, it starts with the
+   * first of them and follows on without gaps */
+  g_assert (GST_BUFFER_PTS_IS_VALID (buffer));
+  if (data->buffers++ == 0)
+    {
+      event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+      g_assert (event != NULL);
+      gst_event_parse_segment (event, &segment);
+      g_assert_cmpint (segment->format, ==, GST_FORMAT_TIME);
+      g_assert_cmpuint (segment->start, ==, DEMOD_START);
+      gst_event_unref (event);
+      g_assert_cmpuint (pts, ==, DEMOD_START);
+    }
+  else
+    g_assert_cmpuint (pts, ==, data->next_pts);
+  data->next_pts = pts + GST_BUFFER_DURATION (buffer);
+
+  handoff_cb (sink, buffer, pad, user_data);
+}
+
+static void
+test_demod ()
+{
+  GError *error = NULL;
+  GstElement *sink;
+  GstPad *pad;
+  GstBus *bus;
+  gchar *location, *description;
+  gint fd;
+
+  GST_DEBUG ("Starting I/Q recording demodulation test");
+  fd = g_file_open_tmp ("sdrjfmdemod-XXXXXX.cu8", &location, &error);
+  g_assert_no_error (error);
+  close (fd);
+  write_iq_recording (location, 4);
+
+  TestData *data = g_slice_new0 (TestData);
+  description = g_strdup_printf ("filesrc location=%s"
+      " ! audio/x-iq,format=U8,rate=%d ! sdrjfmdemod name=demod"
+      " ! fakesink name=sink", location, IQ_RATE);
+  data->pipeline = gst_parse_launch (description, &error);
+  g_free (description);
+  g_assert_no_error (error);
+
+  /* the demodulator stands in for the source in the bus handler */
+  data->fmsrc = gst_bin_get_by_name (GST_BIN (data->pipeline), "demod");
+  g_assert (data->fmsrc != NULL);
+  pad = gst_element_get_static_pad (data->fmsrc, "sink");
+  gst_pad_add_probe (pad, (GstPadProbeType) (GST_PAD_PROBE_TYPE_BUFFER
+			   | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+		     demod_probe_cb, NULL, NULL);
+  gst_object_unref (pad);
+
+  sink = gst_bin_get_by_name (GST_BIN (data->pipeline), "sink");
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (demod_handoff_cb), data);
+  g_object_unref (sink);
+
+  data->timeout = 60;
+  bus = gst_pipeline_get_bus (GST_PIPELINE (data->pipeline));
+  gst_bus_add_watch (bus, bus_cb, data);
+  g_object_unref (bus);
+  data->loop = g_main_loop_new (NULL, FALSE);
+
+  data->coeff[0] = 2 * cos (2 * G_PI * LEFT_TONE / AUDIO_RATE);
+  data->coeff[1] = 2 * cos (2 * G_PI * RIGHT_TONE / AUDIO_RATE);
+  data->skip = AUDIO_RATE;
+  data->needed = 2 * AUDIO_RATE;
+  test_run (data);
+  check_separation (data);
+
+  teardown (data);
+  g_unlink (location);
+  g_free (location);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+  gst_init (&argc, &argv);
+
+  GST_DEBUG_CATEGORY_INIT (sdrjfm_debug, "sdrjfm", 0, "SDR-J FM plugin");
+  GST_DEBUG ("Running generator test");
+
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/generator/rds_station_label", test_rds_station_label);
+  g_test_add_func ("/generator/rds_radio_text", test_rds_radio_text);
+  g_test_add_func ("/generator/rds_coalesced", test_rds_coalesced);
+  g_test_add_func ("/generator/seek", test_seek);
+  g_test_add_func ("/generator/stereo", test_stereo);
+  g_test_add_func ("/generator/stereo_negotiated", test_stereo_negotiated);
+  g_test_add_func ("/generator/health", test_health);
+  g_test_add_func ("/generator/rate_skew", test_rate_skew);
+  g_test_add_func ("/generator/crystal", test_crystal);
+  g_test_add_func ("/generator/reception", test_reception);
+  g_test_add_func ("/generator/rds_tags", test_rds_tags);
+  g_test_add_func ("/generator/mpx", test_mpx);
+  g_test_add_func ("/generator/capture_clock", test_capture_clock);
+  g_test_add_func ("/generator/demod", test_demod);
+  g_test_run ();
+  return 0;
+}
@@ -76,6 +76,14 @@
 
 #define CONFIG_DIR "/fmradioservice"
 
+/** The D-Bus a{st} type of the health property */
+#define DBUS_TYPE_G_STRING_UINT64_HASHTABLE \
+    (dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_UINT64))
+
+/** The D-Bus a{sd} type of the reception signal */
+#define DBUS_TYPE_G_STRING_DOUBLE_HASHTABLE \
+    (dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_DOUBLE))
+
 /**
  * Signal enum types.
  * Signal enums are used in g_signal_new as name/id.
@@ -88,6 +96,7 @@ typedef enum {
     E_SIGNAL_ON_RDS_CLEAR,         /**< Emitted when RDS data is cleared*/
     E_SIGNAL_ON_RDS_CHANGE,        /**< Emitted when RDS data is changed*/
     E_SIGNAL_ON_RDS_COMPLETE,      /**< Emitted when RDS data is complete*/
+    E_SIGNAL_ON_RECEPTION,         /**< Emitted with reception telemetry*/
 
     E_SIGNAL_COUNT                 /**< Not an actual signal */
 } signal_enum;
@@ -103,6 +112,7 @@ typedef enum {
     E_PROP_INIT,      /**< Tells if internal radio is initialized (bool)*/
     E_PROP_ENABLED,   /**< Tells if internal radio is enabled (bool)*/
     E_PROP_FREQUENCY, /**< Holds current frequency in Hz (double)*/
+    E_PROP_HEALTH,    /**< Latest health counters of the radio (a{st})*/
 
     E_PROP_COUNT      /**< This is not an actual property */
 } prop_enum;
@@ -140,6 +150,8 @@ struct _GstData
     void (*rds_clear_cb) (GstData*, RDSStringType);
     void (*rds_change_cb) (GstData*, RDSStringType, const gchar *);
     void (*rds_complete_cb) (GstData*, RDSStringType, const gchar *);
+    void (*health_cb) (GstData*, const GstStructure *);
+    void (*reception_cb) (GstData*, const GstStructure *);
 };
 
 /** Main GObject RadioServer object. */
@@ -150,6 +162,7 @@ typedef struct {
     gboolean init;        /**< internal radio initialized state */
     gboolean enabled;     /**< internal radio enabled state */
     gdouble  frequency;   /**< frequency is in Hz */
+    GHashTable *health;   /**< health counters by name (guint64 *)*/
 
     GstData *gstData;     /**< GST element data needed throughout radio ops*/
     GMainLoop *mainloop;  /**< the Glib mainloop*/
@@ -206,7 +219,9 @@ static GstData *sdrjfm_init (RadioServer *server,
                              void (*station_found_cb) (GstData*, gint freq),
                              void (*rds_clear_cb) (GstData*, RDSStringType),
                              void (*rds_change_cb) (GstData*, RDSStringType, const gchar*),
-                             void (*rds_complete_cb) (GstData*, RDSStringType, const gchar*));
+                             void (*rds_complete_cb) (GstData*, RDSStringType, const gchar*),
+                             void (*health_cb) (GstData*, const GstStructure*),
+                             void (*reception_cb) (GstData*, const GstStructure*));
 static void radio_set_property (GObject *object, uint property_id,
                                 const GValue *value, GParamSpec *pspec);
 static void radio_get_property (GObject *object, guint property_id,
@@ -229,7 +244,8 @@ radio_server_create_signals(RadioServerClass *klass)
         SIGNAL_ON_STATION_FOUND,
         SIGNAL_ON_RDS_CLEAR,
         SIGNAL_ON_RDS_CHANGE,
-        SIGNAL_ON_RDS_COMPLETE
+        SIGNAL_ON_RDS_COMPLETE,
+        SIGNAL_ON_RECEPTION
     };
 
     guint signal_id;
@@ -317,6 +333,18 @@ radio_server_create_signals(RadioServerClass *klass)
                              G_TYPE_UINT,
                              G_TYPE_STRING);
     klass->signals[E_SIGNAL_ON_RDS_COMPLETE] = signal_id;
+
+    signal_id = g_signal_new(signal_names[E_SIGNAL_ON_RECEPTION],
+                             G_OBJECT_CLASS_TYPE(klass),
+                             G_SIGNAL_RUN_LAST,
+                             0,
+                             NULL,
+                             NULL,
+                             g_cclosure_marshal_VOID__BOXED,
+                             G_TYPE_NONE,
+                             1,
+                             DBUS_TYPE_G_STRING_DOUBLE_HASHTABLE);
+    klass->signals[E_SIGNAL_ON_RECEPTION] = signal_id;
 }
 
 /**
@@ -350,6 +378,13 @@ radio_server_create_properties(GObjectClass *gobject_class)
                              (gdouble) FM_RADIO_SERVICE_DEF_FREQ,
                              G_PARAM_CONSTRUCT | G_PARAM_READWRITE);
 
+    obj_properties[E_PROP_HEALTH] =
+        g_param_spec_boxed ("health",
+                            "health",
+                            "Tells the latest health counters of the FMRadio",
+                            DBUS_TYPE_G_STRING_UINT64_HASHTABLE,
+                            G_PARAM_READABLE);
+
     g_object_class_install_properties(gobject_class,
                                       E_PROP_COUNT,
                                       obj_properties);
@@ -428,6 +463,8 @@ radio_server_init(RadioServer *server)
                                          G_OBJECT (server));
 
     server->ongoingSeek = FALSE;
+    server->health = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            g_free, g_free);
 }
 
 /**
@@ -566,6 +603,98 @@ handle_on_rds_complete (GstData *data, RDSStringType type, const gchar *str_data
                   str_data);
 }
 
+/**
+* Copies one counter of the health structure into the health table.
+*/
+static gboolean
+copy_health_counter (GQuark field_id, const GValue *value, gpointer user_data)
+{
+    GHashTable *health = (GHashTable *) user_data;
+    guint64 *counter = g_new (guint64, 1);
+
+    if (G_VALUE_HOLDS_UINT64 (value))
+        *counter = g_value_get_uint64 (value);
+    else if (G_VALUE_HOLDS_INT (value))
+        *counter = (guint64) MAX (g_value_get_int (value), 0);
+    else {
+        g_free (counter);
+        return TRUE;
+    }
+
+    g_hash_table_replace (health, g_strdup (g_quark_to_string (field_id)),
+                          counter);
+    return TRUE;
+}
+
+/**
+* Handler called when the GST element posts its health counters.
+* @param data GstData structure.
+* @param s GstStructure sdrjfmsrc-health message structure.
+*/
+static void
+handle_on_health (GstData *data, const GstStructure *s)
+{
+    RadioServer *server;
+    server = (RadioServer *) data->server;
+
+    gst_structure_foreach (s, copy_health_counter, server->health);
+    g_object_notify_by_pspec (G_OBJECT (server),
+                              obj_properties[E_PROP_HEALTH]);
+}
+
+/**
+* Copies one value of the reception structure into the reception table,
+* booleans as 0 or 1.
+*/
+static gboolean
+copy_reception_value (GQuark field_id, const GValue *value, gpointer user_data)
+{
+    GHashTable *reception = (GHashTable *) user_data;
+    gdouble *number = g_new (gdouble, 1);
+
+    if (G_VALUE_HOLDS_DOUBLE (value))
+        *number = g_value_get_double (value);
+    else if (G_VALUE_HOLDS_INT (value))
+        *number = g_value_get_int (value);
+    else if (G_VALUE_HOLDS_UINT64 (value))
+        *number = g_value_get_uint64 (value);
+    else if (G_VALUE_HOLDS_BOOLEAN (value))
+        *number = g_value_get_boolean (value) ? 1 : 0;
+    else {
+        g_free (number);
+        return TRUE;
+    }
+
+    g_hash_table_replace (reception, g_strdup (g_quark_to_string (field_id)),
+                          number);
+    return TRUE;
+}
+
+/**
+* Handler called when the GST element posts reception telemetry.
+* @param data GstData structure.
+* @param s GstStructure sdrjfmsrc-reception message structure.
+*/
+static void
+handle_on_reception (GstData *data, const GstStructure *s)
+{
+    RadioServer *server;
+    server = (RadioServer *) data->server;
+    RadioServerClass* klass = RADIO_SERVER_GET_CLASS(server);
+    GHashTable *reception;
+
+    reception = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       g_free, g_free);
+    gst_structure_foreach (s, copy_reception_value, reception);
+
+    g_signal_emit(server,
+                  klass->signals[E_SIGNAL_ON_RECEPTION],
+                  0,
+                  reception);
+
+    g_hash_table_unref (reception);
+}
+
 // **********************************************************
 // WebFM api SERVER implementation **************************
 // The following are server implementations of all the sup-
@@ -595,7 +724,9 @@ server_enable (RadioServer *server, GError **error)
                     handle_on_station_found,
                     handle_on_rds_clear,
                     handle_on_rds_change,
-                    handle_on_rds_complete);
+                    handle_on_rds_complete,
+                    handle_on_health,
+                    handle_on_reception);
 
         // Enable the GST element now...
         gst_element_set_state (server->gstData->pipeline,
@@ -757,6 +888,10 @@ radio_get_property (GObject    *object,
             g_value_set_double(value, server->frequency);
         break;
 
+        case E_PROP_HEALTH:
+            g_value_set_boxed (value, server->health);
+        break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -827,7 +962,15 @@ bus_cb (GstBus *bus, GstMessage *message, gpointer user_data)
             if (GST_MESSAGE_SRC (message) == GST_OBJECT (data->fmsrc)) {
                 const GstStructure *s = gst_message_get_structure (message);
 
-                if (gst_structure_has_field_typed (s, "frequency", G_TYPE_INT)) {
+                if (gst_structure_has_name (s, "sdrjfmsrc-health")) {
+
+                    if (data->health_cb)
+                        data->health_cb (data, s);
+                } else if (gst_structure_has_name (s, "sdrjfmsrc-reception")) {
+
+                    if (data->reception_cb)
+                        data->reception_cb (data, s);
+                } else if (gst_structure_has_field_typed (s, "frequency", G_TYPE_INT)) {
 
                     gint freq;
                     gst_structure_get_int (s, "frequency", &freq);
@@ -902,6 +1045,8 @@ bus_cb (GstBus *bus, GstMessage *message, gpointer user_data)
 * @param frequency_changed_cb A callback function pointer when freq. is changed
 * @param station_found_cb A callback function pointer when station is found
 * @param rds_label_complete_cb A callback function pointer when rds is complete
+* @param health_cb A callback function pointer for the periodic health counters
+* @param reception_cb A callback function pointer for the reception telemetry
 * @param Pointer to GstData struct filled-in with all required fields.
 */
 static GstData *
@@ -911,7 +1056,9 @@ sdrjfm_init (RadioServer *server, void (*playing_cb) (GstData*),
                                   void (*station_found_cb) (GstData*, gint),
                                   void (*rds_clear_cb) (GstData*, RDSStringType),
                                   void (*rds_change_cb) (GstData*, RDSStringType, const gchar*),
-                                  void (*rds_complete_cb) (GstData*, RDSStringType, const gchar*))
+                                  void (*rds_complete_cb) (GstData*, RDSStringType, const gchar*),
+                                  void (*health_cb) (GstData*, const GstStructure*),
+                                  void (*reception_cb) (GstData*, const GstStructure*))
 {
     GError *error = NULL;
     GstData *data = g_slice_new0 (GstData);
@@ -920,7 +1067,8 @@ sdrjfm_init (RadioServer *server, void (*playing_cb) (GstData*),
     data->server = server;
     server->gstData = data;
     data->pipeline =
-        gst_parse_launch ("sdrjfmsrc name=sdrjfm ! audioresample ! queue"
+        gst_parse_launch ("sdrjfmsrc name=sdrjfm"
+			  " ! audio/x-raw,format=S16LE,rate=48000,channels=2 ! queue"
 			  " ! pulsesink device=AlsaPrimary stream-properties="
 			  "\"props,media.role=music,zone.name=driver\"",
         &error);
@@ -938,6 +1086,8 @@ sdrjfm_init (RadioServer *server, void (*playing_cb) (GstData*),
     data->rds_clear_cb = rds_clear_cb;
     data->rds_change_cb = rds_change_cb;
     data->rds_complete_cb = rds_complete_cb;
+    data->health_cb = health_cb;
+    data->reception_cb = reception_cb;
 
     bus = gst_pipeline_get_bus (GST_PIPELINE (data->pipeline));
     gst_bus_add_watch (bus, bus_cb, data);
@@ -1044,6 +1194,7 @@ handle_unix_termination_signal (gpointer user_data)
     if (server->configFile != NULL) {
         g_string_free(server->configFile, TRUE);
     }
+    g_hash_table_unref (server->health);
     g_main_loop_quit (loop);
     return FALSE;
 }